@@ -1090,6 +1090,8 @@ void ndDemoEntityManager::ShowMainMenuBar()
 			ImGui::RadioButton("default", &solverMode, ndWorld::ndStandardSolver);
 			ImGui::RadioButton("sse", &solverMode, ndWorld::ndSimdSoaSolver);
 			ImGui::RadioButton("avx2", &solverMode, ndWorld::ndSimdAvx2Solver);
+			ImGui::RadioButton("avx512", &solverMode, ndWorld::ndSimdAvx512Solver);
+			ImGui::RadioButton("island", &solverMode, ndWorld::ndIslandSolver);
 			ImGui::RadioButton("cuda", &solverMode, ndWorld::ndCudaSolver);
 
 			m_solverMode = ndWorld::ndSolverModes(solverMode);
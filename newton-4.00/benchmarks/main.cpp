@@ -0,0 +1,343 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+// newton_bench: runs the headless benchmark scenes for every combination of
+// thread count and solver mode and writes the ms per step percentiles as json.
+// the speedup of each run is relative to the first thread count of the list,
+// ex: --threads 1,2,4,8,16,32,64,128 --scenes pyramids,boxField for thread scaling.
+//
+// usage: newton_bench [--scenes a,b] [--threads 1,2,4] [--solvers 0,1,2,3,4,5,6]
+//                     [--frames n] [--warmup n] [--scale s] [--bvh periodic|incremental]
+//                     [--substeps n] [--collide substep|once] [--output file]
+
+#include "ndNewton.h"
+#include "ndBenchScenes.h"
+
+#define D_BENCH_MAX_LIST	64
+
+class ndBenchOptions
+{
+	public:
+	ndBenchOptions()
+		:m_output(nullptr)
+		,m_scenes(nullptr)
+		,m_scale(ndFloat32(1.0f))
+		,m_frames(300)
+		,m_warmup(30)
+		,m_threadsCount(0)
+		,m_solversCount(0)
+		,m_subSteps(1)
+		,m_incrementalBvh(false)
+		,m_collideOnce(false)
+	{
+	}
+
+	const char* m_output;
+	const char* m_scenes;
+	ndFloat32 m_scale;
+	ndInt32 m_frames;
+	ndInt32 m_warmup;
+	ndInt32 m_threadsCount;
+	ndInt32 m_solversCount;
+	ndInt32 m_threads[D_BENCH_MAX_LIST];
+	ndInt32 m_solvers[D_BENCH_MAX_LIST];
+	ndInt32 m_subSteps;
+	bool m_incrementalBvh;
+	bool m_collideOnce;
+};
+
+class ndCompareTime
+{
+	public:
+	ndCompareTime(void* const)
+	{
+	}
+
+	ndInt32 Compare(const ndFloat32 a, const ndFloat32 b) const
+	{
+		return (a < b) ? -1 : ((a > b) ? 1 : 0);
+	}
+};
+
+static ndInt32 ParseList(const char* const text, ndInt32* const list)
+{
+	ndInt32 count = 0;
+	for (const char* ptr = text; *ptr && (count < D_BENCH_MAX_LIST); )
+	{
+		list[count++] = atoi(ptr);
+		while (*ptr && (*ptr != ','))
+		{
+			ptr++;
+		}
+		if (*ptr == ',')
+		{
+			ptr++;
+		}
+	}
+	return count;
+}
+
+static bool IsSceneSelected(const char* const scenes, const char* const name)
+{
+	if (!scenes)
+	{
+		return true;
+	}
+	const size_t length = strlen(name);
+	for (const char* ptr = strstr(scenes, name); ptr; ptr = strstr(ptr + 1, name))
+	{
+		const bool start = (ptr == scenes) || (ptr[-1] == ',');
+		const bool end = (ptr[length] == 0) || (ptr[length] == ',');
+		if (start && end)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool ParseOptions(ndInt32 argc, char** argv, ndBenchOptions& options)
+{
+	for (ndInt32 i = 1; i < argc; ++i)
+	{
+		const char* const arg = argv[i];
+		const char* const value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+		if (!value)
+		{
+			return false;
+		}
+		if (!strcmp(arg, "--scenes"))
+		{
+			options.m_scenes = value;
+		}
+		else if (!strcmp(arg, "--threads"))
+		{
+			options.m_threadsCount = ParseList(value, options.m_threads);
+		}
+		else if (!strcmp(arg, "--solvers"))
+		{
+			options.m_solversCount = ParseList(value, options.m_solvers);
+		}
+		else if (!strcmp(arg, "--frames"))
+		{
+			options.m_frames = ndMax(atoi(value), 1);
+		}
+		else if (!strcmp(arg, "--warmup"))
+		{
+			options.m_warmup = ndMax(atoi(value), 0);
+		}
+		else if (!strcmp(arg, "--scale"))
+		{
+			options.m_scale = ndMax(ndFloat32(atof(value)), ndFloat32(1.0e-3f));
+		}
+		else if (!strcmp(arg, "--bvh"))
+		{
+			if (strcmp(value, "periodic") && strcmp(value, "incremental"))
+			{
+				return false;
+			}
+			options.m_incrementalBvh = !strcmp(value, "incremental");
+		}
+		else if (!strcmp(arg, "--substeps"))
+		{
+			options.m_subSteps = ndClamp(atoi(value), 1, 16);
+		}
+		else if (!strcmp(arg, "--collide"))
+		{
+			if (strcmp(value, "substep") && strcmp(value, "once"))
+			{
+				return false;
+			}
+			options.m_collideOnce = !strcmp(value, "once");
+		}
+		else if (!strcmp(arg, "--output"))
+		{
+			options.m_output = value;
+		}
+		else
+		{
+			return false;
+		}
+		i++;
+	}
+
+	if (!options.m_threadsCount)
+	{
+		for (ndInt32 threads = 1; threads <= ndThreadPool::GetMaxThreads(); threads *= 2)
+		{
+			options.m_threads[options.m_threadsCount++] = threads;
+		}
+	}
+	if (!options.m_solversCount)
+	{
+		for (ndInt32 mode = ndWorld::ndStandardSolver; mode <= ndWorld::ndIslandSolver; ++mode)
+		{
+			options.m_solvers[options.m_solversCount++] = mode;
+		}
+	}
+	return true;
+}
+
+static ndFloat32 Percentile(const ndArray<ndFloat32>& sortedTimes, ndFloat32 percentile)
+{
+	const ndInt32 count = ndInt32(sortedTimes.GetCount());
+	const ndInt32 index = ndClamp(ndInt32(ndFloat32(count - 1) * percentile + ndFloat32(0.5f)), 0, count - 1);
+	return sortedTimes[index];
+}
+
+static bool RunScene(FILE* const file, const ndBenchScene& scene, const ndBenchOptions& options, ndInt32 threads, ndInt32 solverMode, bool first, ndFloat32& baseTime)
+{
+	ndWorld world;
+	world.SelectSolver(ndWorld::ndSolverModes(solverMode));
+	if (world.GetSelectedSolver() != ndWorld::ndSolverModes(solverMode))
+	{
+		// this build does not support the mode and would run a fallback solver.
+		fprintf(stderr, "%s: solver mode %d not available, skipped\n", scene.m_name, solverMode);
+		return false;
+	}
+	world.SetThreadCount(threads);
+	if (world.GetThreadCount() != threads)
+	{
+		fprintf(stderr, "%s: %d threads not available, skipped\n", scene.m_name, threads);
+		return false;
+	}
+	world.GetScene()->SetIncrementalBvhRefit(options.m_incrementalBvh);
+	world.SetSubSteps(options.m_subSteps);
+	world.SetCollideOnce(options.m_collideOnce);
+	scene.m_build(world, options.m_scale);
+
+	const ndFloat32 timestep = ndFloat32(1.0f / 60.0f);
+	const ndInt32 warmup = options.m_warmup + scene.m_settleSteps;
+	for (ndInt32 i = 0; i < warmup; ++i)
+	{
+		world.Update(timestep);
+		world.Sync();
+	}
+
+	ndArray<ndFloat32> times;
+	ndFloat32 phaseTime[ndUpdateStatistics::m_phaseCount];
+	for (ndInt32 i = 0; i < ndUpdateStatistics::m_phaseCount; ++i)
+	{
+		phaseTime[i] = ndFloat32(0.0f);
+	}
+
+	ndFloat32 totalTime = ndFloat32(0.0f);
+	const ndUpdateStatistics& statistics = world.GetUpdateStatistics();
+	for (ndInt32 i = 0; i < options.m_frames; ++i)
+	{
+		const ndUnsigned64 startTime = ndGetTimeInMicroseconds();
+		world.Update(timestep);
+		world.Sync();
+		const ndFloat32 stepTime = ndFloat32(ndGetTimeInMicroseconds() - startTime) * ndFloat32(1.0e-3f);
+		times.PushBack(stepTime);
+		totalTime += stepTime;
+
+		const ndUpdateStatistics::ndFrame& frame = statistics.GetFrame(0);
+		for (ndInt32 j = 0; j < ndUpdateStatistics::m_phaseCount; ++j)
+		{
+			phaseTime[j] += ndFloat32(frame.m_phaseTime[j]) * ndFloat32(1.0e-3f);
+		}
+	}
+	ndSort<ndFloat32, ndCompareTime>(&times[0], ndInt32(times.GetCount()), nullptr);
+
+	const ndFloat32 frames = ndFloat32(options.m_frames);
+	const ndFloat32 meanTime = totalTime / frames;
+	baseTime = (baseTime > ndFloat32(0.0f)) ? baseTime : meanTime;
+	const ndFloat32 speedup = baseTime / ndMax(meanTime, ndFloat32(1.0e-6f));
+	const ndUpdateStatistics::ndFrame& lastFrame = statistics.GetFrame(0);
+	fprintf(file, "%s\t\t{\n", first ? "" : ",\n");
+	fprintf(file, "\t\t\t\"scene\": \"%s\",\n", scene.m_name);
+	fprintf(file, "\t\t\t\"solver\": \"%s\",\n", world.GetSolverString());
+	fprintf(file, "\t\t\t\"solverMode\": %d,\n", solverMode);
+	fprintf(file, "\t\t\t\"threads\": %d,\n", world.GetThreadCount());
+	fprintf(file, "\t\t\t\"bvh\": \"%s\",\n", options.m_incrementalBvh ? "incremental" : "periodic");
+	fprintf(file, "\t\t\t\"subSteps\": %d,\n", world.GetSubSteps());
+	fprintf(file, "\t\t\t\"collide\": \"%s\",\n", world.GetCollideOnce() ? "once" : "substep");
+	fprintf(file, "\t\t\t\"bodies\": %d,\n", ndInt32(world.GetBodyList().GetCount()));
+	fprintf(file, "\t\t\t\"contacts\": %d,\n", lastFrame.m_contactCount);
+	fprintf(file, "\t\t\t\"narrowPhasePairs\": %d,\n", lastFrame.m_narrowPhaseCount);
+	fprintf(file, "\t\t\t\"skippedPairs\": %d,\n", lastFrame.m_skippedPairCount);
+	fprintf(file, "\t\t\t\"continuePairs\": %d,\n", lastFrame.m_continuePairCount);
+	fprintf(file, "\t\t\t\"compoundPairs\": %d,\n", lastFrame.m_compoundPairCount);
+	fprintf(file, "\t\t\t\"compoundChildPairs\": %d,\n", lastFrame.m_compoundChildPairCount);
+	fprintf(file, "\t\t\t\"steps\": %d,\n", options.m_frames);
+	fprintf(file, "\t\t\t\"ms\": { \"min\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f, \"mean\": %.4f },\n",
+		times[0], Percentile(times, ndFloat32(0.5f)), Percentile(times, ndFloat32(0.9f)), Percentile(times, ndFloat32(0.99f)), times[times.GetCount() - 1], meanTime);
+	fprintf(file, "\t\t\t\"speedup\": %.3f,\n", speedup);
+	fprintf(file, "\t\t\t\"phases\": {");
+	for (ndInt32 i = 0; i < ndUpdateStatistics::m_phaseCount; ++i)
+	{
+		fprintf(file, "%s \"%s\": %.4f", i ? "," : "", ndUpdateStatistics::GetPhaseName(ndUpdateStatistics::ndPhase(i)), phaseTime[i] / frames);
+	}
+	fprintf(file, " }\n");
+	fprintf(file, "\t\t}");
+	fflush(file);
+
+	fprintf(stderr, "%-10s %-8s threads %3d  p50 %8.3f ms  p99 %8.3f ms  speedup %6.2f\n", scene.m_name, world.GetSolverString(), world.GetThreadCount(), Percentile(times, ndFloat32(0.5f)), Percentile(times, ndFloat32(0.99f)), speedup);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	ndBenchOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		fprintf(stderr, "usage: newton_bench [--scenes a,b] [--threads 1,2,4] [--solvers 0,1,2,3,4,5,6] [--frames n] [--warmup n] [--scale s] [--bvh periodic|incremental] [--substeps n] [--collide substep|once] [--output file]\n");
+		return 1;
+	}
+
+	FILE* const file = options.m_output ? fopen(options.m_output, "wb") : stdout;
+	if (!file)
+	{
+		fprintf(stderr, "can't open %s\n", options.m_output);
+		return 1;
+	}
+
+	ndInt32 scenesCount;
+	const ndBenchScene* const scenes = ndGetBenchScenes(scenesCount);
+
+	fprintf(file, "{\n");
+	#ifdef D_NEWTON_USE_DOUBLE
+	fprintf(file, "\t\"precision\": \"double\",\n");
+	#else
+	fprintf(file, "\t\"precision\": \"float\",\n");
+	#endif
+	fprintf(file, "\t\"maxThreads\": %d,\n", ndThreadPool::GetMaxThreads());
+	fprintf(file, "\t\"scale\": %g,\n", options.m_scale);
+	fprintf(file, "\t\"results\":\n\t[\n");
+
+	bool first = true;
+	for (ndInt32 i = 0; i < scenesCount; ++i)
+	{
+		if (!IsSceneSelected(options.m_scenes, scenes[i].m_name))
+		{
+			continue;
+		}
+		for (ndInt32 j = 0; j < options.m_solversCount; ++j)
+		{
+			ndFloat32 baseTime = ndFloat32(0.0f);
+			for (ndInt32 k = 0; k < options.m_threadsCount; ++k)
+			{
+				if (RunScene(file, scenes[i], options, options.m_threads[k], options.m_solvers[j], first, baseTime))
+				{
+					first = false;
+				}
+			}
+		}
+	}
+
+	fprintf(file, "\n\t]\n}\n");
+	if (file != stdout)
+	{
+		fclose(file);
+	}
+	return 0;
+}
@@ -0,0 +1,492 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndBenchScenes.h"
+
+#define D_BENCH_GRAVITY	ndFloat32(-10.0f)
+
+static ndBodyKinematic* CreateBody(const ndShapeInstance& shape, ndFloat32 mass, const ndMatrix& matrix)
+{
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetMatrix(matrix);
+	body->SetCollisionShape(shape);
+	if (mass > ndFloat32(0.0f))
+	{
+		body->SetNotifyCallback(new ndBodyNotify(ndBigVector(ndFloat32(0.0f), D_BENCH_GRAVITY, ndFloat32(0.0f), ndFloat32(0.0f))));
+		body->SetMassMatrix(mass, shape);
+	}
+	return body;
+}
+
+static ndBodyKinematic* AddBody(ndWorld& world, const ndShapeInstance& shape, ndFloat32 mass, const ndMatrix& matrix)
+{
+	ndBodyKinematic* const body = CreateBody(shape, mass, matrix);
+	world.AddBody(ndSharedPtr<ndBody>(body));
+	return body;
+}
+
+static void AddFloor(ndWorld& world, ndFloat32 size)
+{
+	ndShapeInstance box(new ndShapeBox(size, ndFloat32(1.0f), size));
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit.m_y = ndFloat32(-0.5f);
+	AddBody(world, box, ndFloat32(0.0f), matrix);
+}
+
+static ndInt32 ScaleCount(ndInt32 count, ndFloat32 scale)
+{
+	return ndMax(ndInt32(ndFloat32(count) * scale + ndFloat32(0.5f)), 1);
+}
+
+static void BuildPyramids(ndWorld& world, ndFloat32 scale)
+{
+	const ndInt32 baseCount = 20;
+	const ndInt32 pyramidsCount = ScaleCount(16, scale);
+	const ndInt32 pyramidsPerRow = ndInt32(ndCeil(ndSqrt(ndFloat32(pyramidsCount))));
+	const ndFloat32 size = ndFloat32(0.5f);
+	const ndFloat32 pyramidSpacing = ndFloat32(baseCount) * size * ndFloat32(1.5f);
+
+	AddFloor(world, ndFloat32(pyramidsPerRow + 2) * pyramidSpacing);
+	ndShapeInstance box(new ndShapeBox(size, size, size));
+	for (ndInt32 n = 0; n < pyramidsCount; ++n)
+	{
+		const ndFloat32 x0 = ndFloat32(n % pyramidsPerRow - pyramidsPerRow / 2) * pyramidSpacing;
+		const ndFloat32 z0 = ndFloat32(n / pyramidsPerRow - pyramidsPerRow / 2) * pyramidSpacing;
+		for (ndInt32 row = 0; row < baseCount; ++row)
+		{
+			const ndInt32 count = baseCount - row;
+			for (ndInt32 i = 0; i < count; ++i)
+			{
+				ndMatrix matrix(ndGetIdentityMatrix());
+				matrix.m_posit.m_x = x0 + (ndFloat32(i) + ndFloat32(row) * ndFloat32(0.5f)) * size * ndFloat32(1.01f);
+				matrix.m_posit.m_y = (ndFloat32(row) + ndFloat32(0.5f)) * size;
+				matrix.m_posit.m_z = z0;
+				AddBody(world, box, ndFloat32(1.0f), matrix);
+			}
+		}
+	}
+}
+
+static ndModelArticulation::ndNode* AddLimb(ndModelArticulation* const model, ndModelArticulation::ndNode* const parent, ndBodyKinematic* const body, ndJointBilateralConstraint* const joint)
+{
+	return model->AddLimb(parent, ndSharedPtr<ndBody>(body), ndSharedPtr<ndJointBilateralConstraint>(joint));
+}
+
+static ndBodyKinematic* CreateCapsule(ndFloat32 radius, ndFloat32 length, ndFloat32 mass, const ndMatrix& localAxis, const ndVector& posit)
+{
+	ndShapeInstance capsule(new ndShapeCapsule(radius, radius, length));
+	capsule.SetLocalMatrix(localAxis);
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit = posit;
+	return CreateBody(capsule, mass, matrix);
+}
+
+static void AddRagdoll(ndWorld& world, const ndVector& origin)
+{
+	ndModelArticulation* const model = new ndModelArticulation();
+	const ndMatrix horizontal(ndGetIdentityMatrix());
+	const ndMatrix vertical(ndRollMatrix(ndFloat32(90.0f) * ndDegreeToRad));
+
+	ndShapeInstance pelvisShape(new ndShapeBox(ndFloat32(0.3f), ndFloat32(0.2f), ndFloat32(0.2f)));
+	ndMatrix pelvisMatrix(ndGetIdentityMatrix());
+	pelvisMatrix.m_posit = origin + ndVector(ndFloat32(0.0f), ndFloat32(1.0f), ndFloat32(0.0f), ndFloat32(0.0f));
+	ndBodyKinematic* const pelvis = CreateBody(pelvisShape, ndFloat32(10.0f), pelvisMatrix);
+	ndModelArticulation::ndNode* const root = model->AddRootBody(ndSharedPtr<ndBody>(pelvis));
+
+	ndShapeInstance torsoShape(new ndShapeBox(ndFloat32(0.35f), ndFloat32(0.4f), ndFloat32(0.2f)));
+	ndMatrix torsoMatrix(ndGetIdentityMatrix());
+	torsoMatrix.m_posit = origin + ndVector(ndFloat32(0.0f), ndFloat32(1.35f), ndFloat32(0.0f), ndFloat32(0.0f));
+	ndBodyKinematic* const torso = CreateBody(torsoShape, ndFloat32(20.0f), torsoMatrix);
+
+	ndMatrix pivot(ndGetIdentityMatrix());
+	pivot.m_posit = origin + ndVector(ndFloat32(0.0f), ndFloat32(1.12f), ndFloat32(0.0f), ndFloat32(0.0f));
+	ndJointSpherical* const spine = new ndJointSpherical(ndRollMatrix(ndFloat32(90.0f) * ndDegreeToRad) * pivot, torso, pelvis);
+	spine->SetConeLimit(ndFloat32(0.4f));
+	spine->SetTwistLimits(ndFloat32(-0.3f), ndFloat32(0.3f));
+	ndModelArticulation::ndNode* const chest = AddLimb(model, root, torso, spine);
+
+	ndShapeInstance headShape(new ndShapeSphere(ndFloat32(0.12f)));
+	ndMatrix headMatrix(ndGetIdentityMatrix());
+	headMatrix.m_posit = origin + ndVector(ndFloat32(0.0f), ndFloat32(1.7f), ndFloat32(0.0f), ndFloat32(0.0f));
+	ndBodyKinematic* const head = CreateBody(headShape, ndFloat32(5.0f), headMatrix);
+	pivot.m_posit = origin + ndVector(ndFloat32(0.0f), ndFloat32(1.57f), ndFloat32(0.0f), ndFloat32(0.0f));
+	ndJointSpherical* const neck = new ndJointSpherical(ndRollMatrix(ndFloat32(90.0f) * ndDegreeToRad) * pivot, head, torso);
+	neck->SetConeLimit(ndFloat32(0.5f));
+	neck->SetTwistLimits(ndFloat32(-0.5f), ndFloat32(0.5f));
+	AddLimb(model, chest, head, neck);
+
+	for (ndInt32 i = 0; i < 2; ++i)
+	{
+		const ndFloat32 side = i ? ndFloat32(-1.0f) : ndFloat32(1.0f);
+
+		// arms stretched sideways
+		ndBodyKinematic* const upperArm = CreateCapsule(ndFloat32(0.05f), ndFloat32(0.2f), ndFloat32(2.0f), horizontal, origin + ndVector(side * ndFloat32(0.36f), ndFloat32(1.48f), ndFloat32(0.0f), ndFloat32(0.0f)));
+		pivot.m_posit = origin + ndVector(side * ndFloat32(0.2f), ndFloat32(1.48f), ndFloat32(0.0f), ndFloat32(0.0f));
+		ndJointSpherical* const shoulder = new ndJointSpherical(pivot, upperArm, torso);
+		shoulder->SetConeLimit(ndFloat32(1.0f));
+		shoulder->SetTwistLimits(ndFloat32(-0.5f), ndFloat32(0.5f));
+		ndModelArticulation::ndNode* const arm = AddLimb(model, chest, upperArm, shoulder);
+
+		ndBodyKinematic* const foreArm = CreateCapsule(ndFloat32(0.045f), ndFloat32(0.2f), ndFloat32(1.5f), horizontal, origin + ndVector(side * ndFloat32(0.68f), ndFloat32(1.48f), ndFloat32(0.0f), ndFloat32(0.0f)));
+		pivot.m_posit = origin + ndVector(side * ndFloat32(0.52f), ndFloat32(1.48f), ndFloat32(0.0f), ndFloat32(0.0f));
+		ndJointHinge* const elbow = new ndJointHinge(ndYawMatrix(ndFloat32(90.0f) * ndDegreeToRad) * pivot, foreArm, upperArm);
+		elbow->SetLimitState(true);
+		elbow->SetLimits(ndFloat32(-2.0f), ndFloat32(0.0f));
+		AddLimb(model, arm, foreArm, elbow);
+
+		// legs
+		ndBodyKinematic* const thigh = CreateCapsule(ndFloat32(0.07f), ndFloat32(0.25f), ndFloat32(8.0f), vertical, origin + ndVector(side * ndFloat32(0.1f), ndFloat32(0.7f), ndFloat32(0.0f), ndFloat32(0.0f)));
+		pivot.m_posit = origin + ndVector(side * ndFloat32(0.1f), ndFloat32(0.88f), ndFloat32(0.0f), ndFloat32(0.0f));
+		ndJointSpherical* const hip = new ndJointSpherical(ndRollMatrix(ndFloat32(-90.0f) * ndDegreeToRad) * pivot, thigh, pelvis);
+		hip->SetConeLimit(ndFloat32(0.8f));
+		hip->SetTwistLimits(ndFloat32(-0.3f), ndFloat32(0.3f));
+		ndModelArticulation::ndNode* const leg = AddLimb(model, root, thigh, hip);
+
+		ndBodyKinematic* const calf = CreateCapsule(ndFloat32(0.06f), ndFloat32(0.25f), ndFloat32(4.0f), vertical, origin + ndVector(side * ndFloat32(0.1f), ndFloat32(0.3f), ndFloat32(0.0f), ndFloat32(0.0f)));
+		pivot.m_posit = origin + ndVector(side * ndFloat32(0.1f), ndFloat32(0.5f), ndFloat32(0.0f), ndFloat32(0.0f));
+		ndJointHinge* const knee = new ndJointHinge(pivot, calf, thigh);
+		knee->SetLimitState(true);
+		knee->SetLimits(ndFloat32(-2.0f), ndFloat32(0.0f));
+		AddLimb(model, leg, calf, knee);
+	}
+
+	world.AddModel(ndSharedPtr<ndModel>(model));
+}
+
+static void BuildRagdolls(ndWorld& world, ndFloat32 scale)
+{
+	const ndInt32 count = ScaleCount(100, scale);
+	const ndInt32 perRow = ndInt32(ndCeil(ndSqrt(ndFloat32(count))));
+	const ndFloat32 spacing = ndFloat32(1.2f);
+	AddFloor(world, ndFloat32(perRow + 4) * spacing * ndFloat32(2.0f));
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		// drop them in two layers so that they pile up
+		const ndFloat32 layer = ndFloat32(i & 1) * ndFloat32(2.0f);
+		const ndVector origin(ndFloat32(i % perRow - perRow / 2) * spacing, ndFloat32(0.1f) + layer, ndFloat32(i / perRow - perRow / 2) * spacing + layer * ndFloat32(0.2f), ndFloat32(1.0f));
+		AddRagdoll(world, origin);
+	}
+}
+
+static ndFloat32 TerrainHeight(ndFloat32 x, ndFloat32 z)
+{
+	return ndFloat32(2.0f) * ndSin(x * ndFloat32(0.05f)) * ndCos(z * ndFloat32(0.07f)) + ndFloat32(0.5f) * ndSin(x * ndFloat32(0.3f) + z * ndFloat32(0.2f));
+}
+
+static void AddHeightfield(ndWorld& world, ndInt32 cells, ndFloat32 cellSize)
+{
+	ndShapeInstance heightfield(new ndShapeHeightfield(cells, cells, ndShapeHeightfield::m_invertedDiagonals, cellSize, cellSize));
+	ndShapeHeightfield* const shape = heightfield.GetShape()->GetAsShapeHeightfield();
+	ndArray<ndReal>& elevation = shape->GetElevationMap();
+
+	const ndFloat32 origin = -ndFloat32(cells - 1) * cellSize * ndFloat32(0.5f);
+	for (ndInt32 z = 0; z < cells; ++z)
+	{
+		for (ndInt32 x = 0; x < cells; ++x)
+		{
+			elevation[z * cells + x] = ndReal(TerrainHeight(origin + ndFloat32(x) * cellSize, origin + ndFloat32(z) * cellSize));
+		}
+	}
+	shape->UpdateElevationMapAabb();
+
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit.m_x = origin;
+	matrix.m_posit.m_z = origin;
+	AddBody(world, heightfield, ndFloat32(0.0f), matrix);
+}
+
+static void AddVehicle(ndWorld& world, const ndVector& origin)
+{
+	ndMultiBodyVehicle* const vehicle = new ndMultiBodyVehicle();
+
+	ndShapeInstance chassisShape(new ndShapeBox(ndFloat32(4.0f), ndFloat32(0.8f), ndFloat32(1.8f)));
+	ndMatrix chassisMatrix(ndGetIdentityMatrix());
+	chassisMatrix.m_posit = origin;
+	vehicle->AddChassis(ndSharedPtr<ndBody>(CreateBody(chassisShape, ndFloat32(1000.0f), chassisMatrix)));
+	ndBodyDynamic* const chassis = vehicle->GetChassis();
+
+	ndVector com(chassis->GetCentreOfMass());
+	com.m_y -= ndFloat32(0.3f);
+	chassis->SetCentreOfMass(com);
+
+	ndMultiBodyVehicleTireJointInfo tireInfo;
+	tireInfo.m_springK = ndFloat32(20000.0f);
+	tireInfo.m_damperC = ndFloat32(1000.0f);
+	tireInfo.m_regularizer = ndFloat32(0.2f);
+	tireInfo.m_upperStop = ndFloat32(0.1f);
+	tireInfo.m_lowerStop = ndFloat32(-0.3f);
+	tireInfo.m_brakeTorque = ndFloat32(1500.0f);
+
+	ndShapeInstance tireShape(vehicle->CreateTireShape(ndFloat32(0.4f), ndFloat32(0.3f)));
+	ndMultiBodyVehicleTireJoint* tires[4];
+	for (ndInt32 i = 0; i < 4; ++i)
+	{
+		ndMatrix tireMatrix(ndGetIdentityMatrix());
+		tireMatrix.m_posit = origin + ndVector((i & 1) ? ndFloat32(-1.4f) : ndFloat32(1.4f), ndFloat32(-0.5f), (i & 2) ? ndFloat32(-1.0f) : ndFloat32(1.0f), ndFloat32(0.0f));
+		ndSharedPtr<ndBody> tire(CreateBody(tireShape, ndFloat32(30.0f), tireMatrix));
+		tires[i] = vehicle->AddTire(tireInfo, tire);
+	}
+
+	ndMultiBodyVehicleDifferential* const rearDifferential = vehicle->AddDifferential(ndFloat32(20.0f), ndFloat32(0.25f), tires[1], tires[3], ndFloat32(100.0f) / dRadPerSecToRpm);
+	ndMultiBodyVehicleDifferential* const frontDifferential = vehicle->AddDifferential(ndFloat32(20.0f), ndFloat32(0.25f), tires[0], tires[2], ndFloat32(100.0f) / dRadPerSecToRpm);
+	ndMultiBodyVehicleDifferential* const differential = vehicle->AddDifferential(ndFloat32(20.0f), ndFloat32(0.25f), rearDifferential, frontDifferential, ndFloat32(100.0f) / dRadPerSecToRpm);
+
+	ndMultiBodyVehicleMotor* const motor = vehicle->AddMotor(ndFloat32(20.0f), ndFloat32(0.25f));
+	motor->SetMaxRpm(ndFloat32(6000.0f));
+	motor->SetFrictionLoss(ndFloat32(100.0f));
+	vehicle->AddGearBox(differential);
+
+	world.AddModel(ndSharedPtr<ndModel>(vehicle));
+}
+
+static void BuildVehicles(ndWorld& world, ndFloat32 scale)
+{
+	const ndInt32 cells = 128;
+	const ndFloat32 cellSize = ndFloat32(2.0f);
+	AddHeightfield(world, cells, cellSize);
+
+	const ndInt32 count = ScaleCount(48, scale);
+	const ndInt32 perRow = ndInt32(ndCeil(ndSqrt(ndFloat32(count))));
+	const ndFloat32 spacing = ndFloat32(8.0f);
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		const ndFloat32 x = ndFloat32(i % perRow - perRow / 2) * spacing;
+		const ndFloat32 z = ndFloat32(i / perRow - perRow / 2) * spacing;
+		AddVehicle(world, ndVector(x, TerrainHeight(x, z) + ndFloat32(2.0f), z, ndFloat32(1.0f)));
+	}
+}
+
+static void BuildCompoundPile(ndWorld& world, ndFloat32 scale)
+{
+	ndShapeInstance compound(new ndShapeCompound());
+	ndShapeCompound* const compoundShape = compound.GetShape()->GetAsShapeCompound();
+	compoundShape->BeginAddRemove();
+	{
+		// a jack made of three crossed boxes and a sphere
+		ndShapeInstance bar(new ndShapeBox(ndFloat32(1.2f), ndFloat32(0.2f), ndFloat32(0.2f)));
+		compoundShape->AddCollision(&bar);
+		bar.SetLocalMatrix(ndYawMatrix(ndFloat32(90.0f) * ndDegreeToRad));
+		compoundShape->AddCollision(&bar);
+		bar.SetLocalMatrix(ndRollMatrix(ndFloat32(90.0f) * ndDegreeToRad));
+		compoundShape->AddCollision(&bar);
+
+		ndShapeInstance ball(new ndShapeSphere(ndFloat32(0.2f)));
+		ndMatrix matrix(ndGetIdentityMatrix());
+		matrix.m_posit.m_x = ndFloat32(0.6f);
+		ball.SetLocalMatrix(matrix);
+		compoundShape->AddCollision(&ball);
+	}
+	compoundShape->EndAddRemove();
+
+	const ndInt32 count = ScaleCount(1000, scale);
+	const ndInt32 columns = 10;
+	const ndFloat32 spacing = ndFloat32(1.0f);
+	AddFloor(world, ndFloat32(100.0f));
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		const ndInt32 layer = i / (columns * columns);
+		const ndInt32 index = i % (columns * columns);
+		ndMatrix matrix(ndPitchMatrix(ndFloat32(i) * ndFloat32(0.7f)) * ndYawMatrix(ndFloat32(i) * ndFloat32(1.3f)));
+		matrix.m_posit.m_x = ndFloat32(index % columns - columns / 2) * spacing + ndFloat32(layer & 1) * ndFloat32(0.3f);
+		matrix.m_posit.m_y = ndFloat32(1.0f) + ndFloat32(layer) * ndFloat32(1.3f);
+		matrix.m_posit.m_z = ndFloat32(index / columns - columns / 2) * spacing;
+		matrix.m_posit.m_w = ndFloat32(1.0f);
+		AddBody(world, compound, ndFloat32(5.0f), matrix);
+	}
+}
+
+static void BuildBuildings(ndWorld& world, ndFloat32 scale)
+{
+	// a building is a compound of 216 bricks, like a destructible one before it breaks
+	ndShapeInstance building(new ndShapeCompound());
+	ndShapeCompound* const compoundShape = building.GetShape()->GetAsShapeCompound();
+	const ndInt32 bricks = 6;
+	const ndFloat32 brickSize = ndFloat32(0.5f);
+	compoundShape->BeginAddRemove();
+	{
+		ndShapeInstance brick(new ndShapeBox(brickSize, brickSize, brickSize));
+		for (ndInt32 i = 0; i < bricks * bricks * bricks; ++i)
+		{
+			ndMatrix matrix(ndGetIdentityMatrix());
+			matrix.m_posit.m_x = (ndFloat32(i % bricks) - ndFloat32(bricks - 1) * ndFloat32(0.5f)) * brickSize;
+			matrix.m_posit.m_y = (ndFloat32(i / (bricks * bricks)) - ndFloat32(bricks - 1) * ndFloat32(0.5f)) * brickSize;
+			matrix.m_posit.m_z = (ndFloat32((i / bricks) % bricks) - ndFloat32(bricks - 1) * ndFloat32(0.5f)) * brickSize;
+			brick.SetLocalMatrix(matrix);
+			compoundShape->AddCollision(&brick);
+		}
+	}
+	compoundShape->EndAddRemove();
+
+	// a pile of buildings dropped on top of each other
+	const ndInt32 count = ScaleCount(27, scale);
+	const ndInt32 columns = 3;
+	const ndFloat32 spacing = ndFloat32(3.5f);
+	AddFloor(world, ndFloat32(100.0f));
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		const ndInt32 layer = i / (columns * columns);
+		const ndInt32 index = i % (columns * columns);
+		ndMatrix matrix(ndYawMatrix(ndFloat32(i) * ndFloat32(0.4f)) * ndRollMatrix(ndFloat32(layer & 1) * ndFloat32(0.3f)));
+		matrix.m_posit.m_x = ndFloat32(index % columns - columns / 2) * spacing + ndFloat32(layer & 1) * ndFloat32(1.5f);
+		matrix.m_posit.m_y = ndFloat32(2.0f) + ndFloat32(layer) * ndFloat32(4.0f);
+		matrix.m_posit.m_z = ndFloat32(index / columns - columns / 2) * spacing;
+		matrix.m_posit.m_w = ndFloat32(1.0f);
+		AddBody(world, building, ndFloat32(50.0f), matrix);
+	}
+}
+
+static void BuildSleepingWorld(ndWorld& world, ndFloat32 scale)
+{
+	const ndInt32 count = ScaleCount(100000, scale);
+	const ndInt32 perRow = ndInt32(ndCeil(ndSqrt(ndFloat32(count))));
+	const ndFloat32 size = ndFloat32(0.5f);
+	const ndFloat32 spacing = ndFloat32(1.5f);
+	AddFloor(world, ndFloat32(perRow + 2) * spacing);
+
+	// every box rests on the floor on its own, after settling the whole world goes to sleep
+	ndShapeInstance box(new ndShapeBox(size, size, size));
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		ndMatrix matrix(ndGetIdentityMatrix());
+		matrix.m_posit.m_x = ndFloat32(i % perRow - perRow / 2) * spacing;
+		matrix.m_posit.m_y = size * ndFloat32(0.5f);
+		matrix.m_posit.m_z = ndFloat32(i / perRow - perRow / 2) * spacing;
+		AddBody(world, box, ndFloat32(1.0f), matrix);
+	}
+}
+
+static void BuildBoxField(ndWorld& world, ndFloat32 scale)
+{
+	const ndInt32 count = ScaleCount(1600, scale);
+	const ndInt32 perRow = ndInt32(ndCeil(ndSqrt(ndFloat32(count))));
+	const ndInt32 stackHeight = 4;
+	const ndFloat32 size = ndFloat32(0.5f);
+	const ndFloat32 spacing = ndFloat32(1.0f);
+	AddFloor(world, ndFloat32(perRow + 2) * spacing);
+
+	// a large field of short stacks, many independent islands that spread well over many threads
+	ndShapeInstance box(new ndShapeBox(size, size, size));
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		for (ndInt32 j = 0; j < stackHeight; ++j)
+		{
+			ndMatrix matrix(ndGetIdentityMatrix());
+			matrix.m_posit.m_x = ndFloat32(i % perRow - perRow / 2) * spacing;
+			matrix.m_posit.m_y = (ndFloat32(j) * ndFloat32(1.2f) + ndFloat32(1.0f)) * size;
+			matrix.m_posit.m_z = ndFloat32(i / perRow - perRow / 2) * spacing;
+			AddBody(world, box, ndFloat32(1.0f), matrix);
+		}
+	}
+}
+
+static void BuildProjectiles(ndWorld& world, ndFloat32 scale)
+{
+	const ndInt32 count = ScaleCount(256, scale);
+	const ndInt32 perRow = ndInt32(ndCeil(ndSqrt(ndFloat32(count))));
+	const ndFloat32 spacing = ndFloat32(1.0f);
+	const ndFloat32 height = ndFloat32(perRow) * spacing;
+	AddFloor(world, ndFloat32(100.0f));
+
+	// thin walls of stacked boxes, and a grid of fast projectiles that would tunnel 
+	// through them without continue collision
+	ndShapeInstance brick(new ndShapeBox(ndFloat32(0.1f), ndFloat32(1.0f), ndFloat32(1.0f)));
+	for (ndInt32 i = 0; i < perRow * perRow; ++i)
+	{
+		ndMatrix matrix(ndGetIdentityMatrix());
+		matrix.m_posit.m_y = ndFloat32(i / perRow) * ndFloat32(1.001f) + ndFloat32(0.5f);
+		matrix.m_posit.m_z = ndFloat32(i % perRow - perRow / 2) * ndFloat32(1.001f);
+		AddBody(world, brick, ndFloat32(2.0f), matrix);
+	}
+
+	ndShapeInstance sphere(new ndShapeSphere(ndFloat32(0.1f)));
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		ndMatrix matrix(ndGetIdentityMatrix());
+		matrix.m_posit.m_x = ndFloat32(-20.0f) - ndFloat32(i % 4) * ndFloat32(10.0f);
+		matrix.m_posit.m_y = ndFloat32(0.5f) + ndFloat32(i / perRow) * height / ndFloat32(perRow);
+		matrix.m_posit.m_z = ndFloat32(i % perRow - perRow / 2) * spacing;
+		ndBodyKinematic* const body = AddBody(world, sphere, ndFloat32(0.2f), matrix);
+		body->SetContinueCollision(true);
+		body->SetVelocity(ndVector(ndFloat32(200.0f), ndFloat32(0.0f), ndFloat32(0.0f), ndFloat32(0.0f)));
+	}
+}
+
+static void BuildTerrainDebris(ndWorld& world, ndFloat32 scale, bool compressed)
+{
+	const ndInt32 cells = 256;
+	const ndFloat32 cellSize = ndFloat32(1.0f);
+	const ndFloat32 origin = -ndFloat32(cells) * cellSize * ndFloat32(0.5f);
+
+	// a bumpy level mesh, the contact queries of the debris resting on it dominate the frame
+	ndPolygonSoupBuilder meshBuilder;
+	meshBuilder.Begin();
+	for (ndInt32 i = 0; i < cells * cells; ++i)
+	{
+		const ndFloat32 x0 = origin + ndFloat32(i % cells) * cellSize;
+		const ndFloat32 z0 = origin + ndFloat32(i / cells) * cellSize;
+		const ndFloat32 x1 = x0 + cellSize;
+		const ndFloat32 z1 = z0 + cellSize;
+		ndVector face[3];
+		face[0] = ndVector(x0, ndFloat32(0.5f) * ndSin(x0 * ndFloat32(0.3f)) * ndCos(z0 * ndFloat32(0.2f)), z0, ndFloat32(0.0f));
+		face[1] = ndVector(x0, ndFloat32(0.5f) * ndSin(x0 * ndFloat32(0.3f)) * ndCos(z1 * ndFloat32(0.2f)), z1, ndFloat32(0.0f));
+		face[2] = ndVector(x1, ndFloat32(0.5f) * ndSin(x1 * ndFloat32(0.3f)) * ndCos(z1 * ndFloat32(0.2f)), z1, ndFloat32(0.0f));
+		meshBuilder.AddFace(&face[0].m_x, sizeof(ndVector), 3, 0);
+		face[1] = face[2];
+		face[2] = ndVector(x1, ndFloat32(0.5f) * ndSin(x1 * ndFloat32(0.3f)) * ndCos(z0 * ndFloat32(0.2f)), z0, ndFloat32(0.0f));
+		meshBuilder.AddFace(&face[0].m_x, sizeof(ndVector), 3, 0);
+	}
+	meshBuilder.End(false);
+	ndShapeInstance terrain(new ndShapeStatic_bvh(meshBuilder, compressed));
+	AddBody(world, terrain, ndFloat32(0.0f), ndGetIdentityMatrix());
+
+	const ndInt32 count = ScaleCount(2000, scale);
+	const ndInt32 perRow = ndInt32(ndCeil(ndSqrt(ndFloat32(count))));
+	const ndFloat32 spacing = ndMin(ndFloat32(2.0f), ndFloat32(cells - 8) * cellSize / ndFloat32(perRow));
+	ndShapeInstance box(new ndShapeBox(ndFloat32(0.5f), ndFloat32(0.5f), ndFloat32(0.5f)));
+	ndShapeInstance sphere(new ndShapeSphere(ndFloat32(0.3f)));
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		ndMatrix matrix(ndYawMatrix(ndFloat32(i) * ndFloat32(0.7f)));
+		matrix.m_posit.m_x = ndFloat32(i % perRow - perRow / 2) * spacing;
+		matrix.m_posit.m_y = ndFloat32(1.5f);
+		matrix.m_posit.m_z = ndFloat32(i / perRow - perRow / 2) * spacing;
+		AddBody(world, (i & 1) ? sphere : box, ndFloat32(1.0f), matrix);
+	}
+}
+
+static void BuildTerrain(ndWorld& world, ndFloat32 scale)
+{
+	BuildTerrainDebris(world, scale, false);
+}
+
+static void BuildCompressedTerrain(ndWorld& world, ndFloat32 scale)
+{
+	BuildTerrainDebris(world, scale, true);
+}
+
+const ndBenchScene* ndGetBenchScenes(ndInt32& count)
+{
+	static ndBenchScene scenes[] =
+	{
+		{ "pyramids", BuildPyramids, 0 },
+		{ "ragdolls", BuildRagdolls, 0 },
+		{ "vehicles", BuildVehicles, 60 },
+		{ "compounds", BuildCompoundPile, 0 },
+		{ "buildings", BuildBuildings, 0 },
+		{ "sleeping", BuildSleepingWorld, 120 },
+		{ "boxField", BuildBoxField, 0 },
+		{ "projectiles", BuildProjectiles, 0 },
+		{ "terrain", BuildTerrain, 60 },
+		{ "compressedTerrain", BuildCompressedTerrain, 60 },
+	};
+	count = ndInt32(sizeof(scenes) / sizeof(scenes[0]));
+	return scenes;
+}
@@ -0,0 +1,33 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#ifndef __ND_BENCH_SCENES_H__
+#define __ND_BENCH_SCENES_H__
+
+#include "ndNewton.h"
+
+// headless versions of the sandbox workloads. 
+// scale multiplies the number of objects of each scene.
+typedef void (*ndBenchSceneBuilder)(ndWorld& world, ndFloat32 scale);
+
+class ndBenchScene
+{
+	public:
+	const char* m_name;
+	ndBenchSceneBuilder m_build;
+
+	// number of steps to run before measuring, some scenes need to settle
+	ndInt32 m_settleSteps;
+};
+
+const ndBenchScene* ndGetBenchScenes(ndInt32& count);
+
+#endif
@@ -42,6 +42,7 @@ ndBody::ndBody()
 	,m_isConstrained(0)
 	,m_sceneForceUpdate(1)
 	,m_sceneEquilibrium(0)
+	,m_sceneTreeMoved(0)
 	,m_skeletonSelfCollision(0)
 	,m_matrix(ndGetIdentityMatrix())
 	,m_rotation()
@@ -71,6 +72,7 @@ ndBody::ndBody(const ndBody& src)
 	,m_isConstrained(0)
 	,m_sceneForceUpdate(1)
 	,m_sceneEquilibrium(0)
+	,m_sceneTreeMoved(0)
 	,m_matrix(src.m_matrix)
 	,m_rotation(src.m_rotation)
 	,m_veloc(src.m_veloc)
@@ -82,6 +84,7 @@ ndBody::ndBody(const ndBody& src)
 {
 	m_uniqueIdCount++;
 	m_transformIsDirty = 1;
+	m_continueCollision = src.m_continueCollision;
 	if (src.m_notifyCallback)
 	{
 		SetNotifyCallback(src.m_notifyCallback->Clone());
@@ -111,6 +111,8 @@ class ndBody : public ndContainersFreeListAlloc<ndBody>
 			ndUnsigned32 m_contactTestOnly : 1;
 			ndUnsigned32 m_transformIsDirty : 1;
 			ndUnsigned32 m_equilibriumOverride : 1;
+			ndUnsigned32 m_staticSceneTree : 1;
+			ndUnsigned32 m_continueCollision : 1;
 		};
 	};
 
@@ -123,6 +125,7 @@ class ndBody : public ndContainersFreeListAlloc<ndBody>
 	ndUnsigned8 m_isConstrained;
 	ndUnsigned8 m_sceneForceUpdate;
 	ndUnsigned8 m_sceneEquilibrium;
+	ndUnsigned8 m_sceneTreeMoved;
 	ndUnsigned8 m_skeletonSelfCollision;
 	
 	ndMatrix m_matrix;
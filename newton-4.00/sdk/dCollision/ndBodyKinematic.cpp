@@ -41,53 +41,154 @@ ndBodyKinematic::ndContactkey::ndContactkey(ndUnsigned32 tag0, ndUnsigned32 tag1
 	ndAssert(m_tagLow < m_tagHigh);
 }
 
+ndUnsigned64 ndBodyKinematic::ndContactkey::GetTag() const
+{
+	return m_tag;
+}
+
 bool ndBodyKinematic::ndContactkey::operator== (const ndContactkey& key) const
 {
 	return m_tag == key.m_tag;
 }
 
-bool ndBodyKinematic::ndContactkey::operator< (const ndContactkey& key) const
+ndBodyKinematic::ndContactMap::ndContactMap()
+	:m_slots(nullptr)
+	,m_count(0)
+	,m_capacity(0)
 {
-	return m_tag < key.m_tag;
 }
 
-bool ndBodyKinematic::ndContactkey::operator> (const ndContactkey& key) const
+ndBodyKinematic::ndContactMap::~ndContactMap()
 {
-	return m_tag > key.m_tag;
+	if (m_slots)
+	{
+		ndMemory::Free(m_slots);
+	}
 }
 
-ndBodyKinematic::ndContactMap::ndContactMap()
-	:ndTree<ndContact*, ndContactkey, ndContainersFreeListAlloc<ndContact*>>()
+ndInt32 ndBodyKinematic::ndContactMap::GetSlot(ndUnsigned64 key) const
 {
+	// fibonacci hashing, the capacity is a power of two
+	ndAssert(m_capacity && !(m_capacity & (m_capacity - 1)));
+	const ndUnsigned64 hash = key * ndUnsigned64(0x9e3779b97f4a7c15);
+	return ndInt32((hash >> 32) & ndUnsigned64(m_capacity - 1));
 }
 
-ndBodyKinematic::ndContactMap::~ndContactMap()
+void ndBodyKinematic::ndContactMap::Resize(ndInt32 capacity)
 {
+	ndNode* const oldSlots = m_slots;
+	const ndInt32 oldCapacity = m_capacity;
+
+	m_capacity = capacity;
+	m_slots = (ndNode*)ndMemory::Malloc(size_t(capacity) * sizeof(ndNode));
+	for (ndInt32 i = 0; i < capacity; ++i)
+	{
+		m_slots[i].m_key = 0;
+		m_slots[i].m_contact = nullptr;
+	}
+
+	const ndInt32 mask = capacity - 1;
+	for (ndInt32 i = 0; i < oldCapacity; ++i)
+	{
+		if (oldSlots[i].m_contact)
+		{
+			ndInt32 slot = GetSlot(oldSlots[i].m_key);
+			for (; m_slots[slot].m_contact; slot = (slot + 1) & mask);
+			m_slots[slot] = oldSlots[i];
+		}
+	}
+
+	if (oldSlots)
+	{
+		ndMemory::Free(oldSlots);
+	}
 }
 
 ndContact* ndBodyKinematic::ndContactMap::FindContact(const ndBody* const body0, const ndBody* const body1) const
 {
-	ndContactkey key(body0->GetId(), body1->GetId());
-	ndNode* const node = Find(key);
-	return node ? node->GetInfo() : nullptr;
+	if (m_count)
+	{
+		const ndUnsigned64 key = ndContactkey(body0->GetId(), body1->GetId()).GetTag();
+		const ndInt32 mask = m_capacity - 1;
+		for (ndInt32 slot = GetSlot(key); m_slots[slot].m_contact; slot = (slot + 1) & mask)
+		{
+			if (m_slots[slot].m_key == key)
+			{
+				return m_slots[slot].m_contact;
+			}
+		}
+	}
+	return nullptr;
 }
 
 void ndBodyKinematic::ndContactMap::AttachContact(ndContact* const contact)
 {
 	ndBody* const body0 = contact->GetBody0();
 	ndBody* const body1 = contact->GetBody1();
-	ndContactkey key(body0->GetId(), body1->GetId());
-	ndAssert(!Find(key));
-	Insert(contact, key);
+	ndAssert(!FindContact(body0, body1));
+
+	// keep the load factor at one half or below
+	if ((m_count + 1) * 2 > m_capacity)
+	{
+		Resize(m_capacity ? m_capacity * 2 : 8);
+	}
+
+	const ndUnsigned64 key = ndContactkey(body0->GetId(), body1->GetId()).GetTag();
+	const ndInt32 mask = m_capacity - 1;
+	ndInt32 slot = GetSlot(key);
+	for (; m_slots[slot].m_contact; slot = (slot + 1) & mask);
+	m_slots[slot].m_key = key;
+	m_slots[slot].m_contact = contact;
+	m_count++;
 }
 
 void ndBodyKinematic::ndContactMap::DetachContact(ndContact* const contact)
 {
 	ndBody* const body0 = contact->GetBody0();
 	ndBody* const body1 = contact->GetBody1();
-	ndContactkey key(body0->GetId(), body1->GetId());
-	ndAssert(Find(key));
-	Remove(key);
+	const ndUnsigned64 key = ndContactkey(body0->GetId(), body1->GetId()).GetTag();
+
+	ndAssert(m_count);
+	const ndInt32 mask = m_capacity - 1;
+	ndInt32 slot = GetSlot(key);
+	for (; m_slots[slot].m_key != key; slot = (slot + 1) & mask)
+	{
+		ndAssert(m_slots[slot].m_contact);
+	}
+	ndAssert(m_slots[slot].m_contact == contact);
+
+	// shift back the entries of the cluster that can no longer be reached from their home slot
+	ndInt32 hole = slot;
+	for (ndInt32 next = (hole + 1) & mask; m_slots[next].m_contact; next = (next + 1) & mask)
+	{
+		const ndInt32 home = GetSlot(m_slots[next].m_key);
+		if (((next - home) & mask) >= ((next - hole) & mask))
+		{
+			m_slots[hole] = m_slots[next];
+			hole = next;
+		}
+	}
+	m_slots[hole].m_key = 0;
+	m_slots[hole].m_contact = nullptr;
+	m_count--;
+}
+
+bool ndBodyKinematic::ndContactMap::SanityCheck() const
+{
+	ndInt32 count = 0;
+	for (ndInt32 i = 0; i < m_capacity; ++i)
+	{
+		const ndContact* const contact = m_slots[i].m_contact;
+		if (contact)
+		{
+			count++;
+			if (FindContact(contact->GetBody0(), contact->GetBody1()) != contact)
+			{
+				return false;
+			}
+		}
+	}
+	return count == m_count;
 }
 
 ndBodyKinematic::ndBodyKinematic()
@@ -355,6 +456,16 @@ void ndBodyKinematic::SetAutoSleep(bool state)
 	SetSleepState(false);
 }
 
+bool ndBodyKinematic::GetContinueCollision() const
+{
+	return m_continueCollision ? true : false;
+}
+
+void ndBodyKinematic::SetContinueCollision(bool state)
+{
+	m_continueCollision = ndUnsigned32(state ? 1 : 0);
+}
+
 ndSkeletonContainer* ndBodyKinematic::GetSkeleton() const
 {
 	return m_skeletonContainer;
@@ -725,7 +836,7 @@ void ndBodyKinematic::SetMatrixUpdateScene(const ndMatrix& matrix)
 		ndUnsigned8 sceneForceUpdate = m_sceneForceUpdate;
 		if (ndUnsigned8(!m_equilibrium) | sceneForceUpdate)
 		{
-			ndBvhLeafNode* const bodyNode = scene->m_bvhSceneManager.GetLeafNode(this);
+			ndBvhLeafNode* const bodyNode = scene->GetBvhSceneManager(this).GetLeafNode(this);
 			ndAssert(bodyNode->GetAsSceneBodyNode());
 			ndAssert(!bodyNode->GetLeft());
 			ndAssert(!bodyNode->GetRight());
@@ -42,8 +42,7 @@ class ndBodyKinematic : public ndBody
 		public:
 		ndContactkey(ndUnsigned32 tag0, ndUnsigned32 tag1);
 
-		bool operator> (const ndContactkey& key) const;
-		bool operator< (const ndContactkey& key) const;
+		ndUnsigned64 GetTag() const;
 		bool operator== (const ndContactkey& key) const;
 		private:
 		union
@@ -68,16 +67,60 @@ class ndBodyKinematic : public ndBody
 		}
 	};
 
-	class ndContactMap: public ndTree<ndContact*, ndContactkey, ndContainersFreeListAlloc<ndContact*>>
+	// open addressing hash table of the contacts of a body, keyed by the ids of the 
+	// two bodies. linear probing with backward shift deletion, so there are no tombstones 
+	// and a probe touches a couple of consecutive slots at most.
+	class ndContactMap
 	{
 		public:
+		class ndNode
+		{
+			public:
+			ndContact* GetInfo() const;
+
+			private:
+			ndUnsigned64 m_key;
+			ndContact* m_contact;
+			friend class ndContactMap;
+		};
+
+		class Iterator
+		{
+			public:
+			Iterator(const ndContactMap& map);
+
+			void Begin();
+			operator ndInt32() const;
+			void operator++ ();
+			void operator++ (ndInt32);
+			ndContact* operator* () const;
+			ndNode* GetNode() const;
+
+			private:
+			void Next(ndInt32 slot);
+
+			const ndContactMap* m_map;
+			ndInt32 m_slot;
+		};
+
+		ndInt32 GetCount() const;
+		D_COLLISION_API bool SanityCheck() const;
 		D_COLLISION_API ndContact* FindContact(const ndBody* const body0, const ndBody* const body1) const;
 
 		private:
 		ndContactMap();
 		~ndContactMap();
+		ndContactMap(const ndContactMap&) = delete;
+		ndContactMap& operator=(const ndContactMap&) = delete;
+
+		ndInt32 GetSlot(ndUnsigned64 key) const;
+		void Resize(ndInt32 capacity);
 		void AttachContact(ndContact* const contact);
 		void DetachContact(ndContact* const contact);
+
+		ndNode* m_slots;
+		ndInt32 m_count;
+		ndInt32 m_capacity;
 		friend class ndBodyKinematic;
 	};
 
@@ -104,6 +147,12 @@ class ndBodyKinematic : public ndBody
 
 	D_COLLISION_API bool GetAutoSleep() const;
 	D_COLLISION_API void SetAutoSleep(bool state);
+
+	// fast bodies that can not tunnel through thin shapes, their pairs are solved 
+	// for the time of impact in the continue collision stage of the scene.
+	D_COLLISION_API bool GetContinueCollision() const;
+	D_COLLISION_API void SetContinueCollision(bool state);
+
 	D_COLLISION_API ndFloat32 GetMaxLinearStep() const;
 	D_COLLISION_API ndFloat32 GetMaxAngularStep() const;
 	D_COLLISION_API void SetDebugMaxLinearAndAngularIntegrationStep(ndFloat32 angleInRadian, ndFloat32 stepInUnitPerSeconds);
@@ -197,7 +246,7 @@ class ndBodyKinematic : public ndBody
 	ndContactMap m_contactList;
 	mutable ndSpinLock m_lock;
 	ndScene* m_scene;
-	ndBodyKinematic* m_islandParent;
+	ndAtomic<ndBodyKinematic*> m_islandParent;
 	ndBodyListView::ndNode* m_sceneNode;
 	ndSkeletonContainer* m_skeletonContainer;
 	ndSpecialList<ndBodyKinematic>::ndNode* m_spetialUpdateNode;
@@ -238,13 +287,72 @@ class ndBodyKinematic : public ndBody
 	friend class ndSkeletonContainer;
 	friend class ndModelArticulation;
 	friend class ndDynamicsUpdateSoa;
+	friend class ndDynamicsUpdateGaussSeidel;
+	friend class ndDynamicsUpdateIsland;
 	friend class ndDynamicsUpdateAvx2;
+	friend class ndDynamicsUpdateAvx512;
 	friend class ndDynamicsUpdateSycl;
 	friend class ndDynamicsUpdateCuda;
 	friend class ndJointBilateralConstraint;
 } D_GCC_NEWTON_ALIGN_32;
 
 
+inline ndContact* ndBodyKinematic::ndContactMap::ndNode::GetInfo() const
+{
+	return m_contact;
+}
+
+inline ndInt32 ndBodyKinematic::ndContactMap::GetCount() const
+{
+	return m_count;
+}
+
+inline ndBodyKinematic::ndContactMap::Iterator::Iterator(const ndContactMap& map)
+	:m_map(&map)
+	,m_slot(map.m_capacity)
+{
+}
+
+inline void ndBodyKinematic::ndContactMap::Iterator::Next(ndInt32 slot)
+{
+	for (; (slot < m_map->m_capacity) && !m_map->m_slots[slot].m_contact; ++slot);
+	m_slot = slot;
+}
+
+inline void ndBodyKinematic::ndContactMap::Iterator::Begin()
+{
+	Next(0);
+}
+
+inline ndBodyKinematic::ndContactMap::Iterator::operator ndInt32() const
+{
+	return m_slot < m_map->m_capacity;
+}
+
+inline void ndBodyKinematic::ndContactMap::Iterator::operator++ ()
+{
+	ndAssert(m_slot < m_map->m_capacity);
+	Next(m_slot + 1);
+}
+
+inline void ndBodyKinematic::ndContactMap::Iterator::operator++ (ndInt32)
+{
+	ndAssert(m_slot < m_map->m_capacity);
+	Next(m_slot + 1);
+}
+
+inline ndContact* ndBodyKinematic::ndContactMap::Iterator::operator* () const
+{
+	ndAssert(m_slot < m_map->m_capacity);
+	return m_map->m_slots[m_slot].m_contact;
+}
+
+inline ndBodyKinematic::ndContactMap::ndNode* ndBodyKinematic::ndContactMap::Iterator::GetNode() const
+{
+	ndAssert(m_slot < m_map->m_capacity);
+	return &m_map->m_slots[m_slot];
+}
+
 class ndBodySentinel : public ndBodyKinematic
 {
 	ndBodySentinel* GetAsBodySentinel() { return this; }
@@ -128,7 +128,8 @@ class ndBodySphFluid::ndWorkingBuffers
 		,m_hashGridSize(ndFloat32 (0.0f))
 		,m_hashInvGridSize(ndFloat32(0.0f))
 	{
-		for (ndInt32 i = 0; i < D_MAX_THREADS_COUNT; ++i)
+		// reserve for the threads this machine can run, the scans of any other thread are allocated by their first PushBack
+		for (ndInt32 i = 0; i < ndThreadPool::GetMaxThreads(); ++i)
 		{
 			m_partialsGridScans[i].Resize(D_SPH_BUFFER_GRANULARITY);
 		}
@@ -67,6 +67,10 @@ ndBvhInternalNode::ndBvhInternalNode()
 	:ndBvhNode(nullptr)
 	,m_left(nullptr)
 	,m_right(nullptr)
+	,m_sahCost(ndFloat32(0.0f))
+	,m_buildSahCost(ndFloat32(0.0f))
+	,m_leafCount(0)
+	,m_sahDirty(0)
 {
 #ifdef _DEBUG
 	static ndInt32 nodeId = 1000000;
@@ -79,6 +83,10 @@ ndBvhInternalNode::ndBvhInternalNode(const ndBvhInternalNode& src)
 	:ndBvhNode(src)
 	,m_left(nullptr)
 	,m_right(nullptr)
+	,m_sahCost(src.m_sahCost)
+	,m_buildSahCost(src.m_buildSahCost)
+	,m_leafCount(src.m_leafCount)
+	,m_sahDirty(src.m_sahDirty.load())
 {
 #ifdef _DEBUG
 	m_nodeId = src.m_nodeId;
@@ -185,12 +193,24 @@ void ndBvhNodeArray::Swap(ndBvhNodeArray& src)
 ndBvhSceneManager::ndBvhSceneManager()
 	:m_workingArray()
 	,m_bvhBuildState()
+	,m_degradedNodes(256)
+	,m_wideNodes(256)
+	,m_wideSourceNodes(256)
+	,m_fullRebuildCount(0)
+	,m_partialRebuildCount(0)
+	,m_wideTreeDirty(true)
 {
 }
 
 ndBvhSceneManager::ndBvhSceneManager(const ndBvhSceneManager& src)
 	:m_workingArray(src.m_workingArray)
 	,m_bvhBuildState(src.m_bvhBuildState)
+	,m_degradedNodes(256)
+	,m_wideNodes(256)
+	,m_wideSourceNodes(256)
+	,m_fullRebuildCount(src.m_fullRebuildCount)
+	,m_partialRebuildCount(src.m_partialRebuildCount)
+	,m_wideTreeDirty(true)
 {
 }
 
@@ -201,6 +221,7 @@ ndBvhSceneManager::~ndBvhSceneManager()
 
 ndBvhNode* ndBvhSceneManager::AddBody(ndBodyKinematic* const body, ndBvhNode* root)
 {
+	m_wideTreeDirty = true;
 	m_workingArray.m_isDirty = 1;
 	ndBvhLeafNode* const bodyNode = new ndBvhLeafNode(body);
 	ndBvhInternalNode* sceneNode = new ndBvhInternalNode();
@@ -213,9 +234,8 @@ ndBvhNode* ndBvhSceneManager::AddBody(ndBodyKinematic* const body, ndBvhNode* ro
 	m_workingArray.PushBack(bodyNode);
 	body->m_bodyNodeIndex = ndInt32(m_workingArray.GetCount()) - 1;
 
-	if (m_workingArray.GetCount() > 2)
+	if (root && (m_workingArray.GetCount() > 2))
 	{
-		ndAssert(root);
 		ndBvhInternalNode* childNode = sceneNode;
 		childNode->m_minBox = bodyNode->m_minBox;
 		childNode->m_maxBox = bodyNode->m_maxBox;
@@ -277,6 +297,16 @@ ndBvhNode* ndBvhSceneManager::AddBody(ndBodyKinematic* const body, ndBvhNode* ro
 				break;
 			}
 		}
+
+		// keep height, leaf count and cost of the path valid, 
+		// so that the tree can be patched without a full rebuild.
+		const ndBvhInternalNode* const right = childNode->m_right->GetAsSceneTreeNode();
+		childNode->m_depthLevel = childNode->m_right->m_depthLevel + 1;
+		childNode->m_leafCount = (right ? right->m_leafCount : 1) + 1;
+		childNode->m_sahCost = CalculateSurfaceArea(childNode) + (right ? right->m_sahCost : ndFloat32(0.0f));
+		childNode->m_buildSahCost = childNode->m_sahCost;
+		RefitAncestors(childNode);
+
 		#ifdef _DEBUG
 		//ndAssert(depth < 128);
 		if (depth >= 256)
@@ -294,6 +324,7 @@ ndBvhNode* ndBvhSceneManager::AddBody(ndBodyKinematic* const body, ndBvhNode* ro
 
 void ndBvhSceneManager::RemoveBody(ndBodyKinematic* const body)
 {
+	m_wideTreeDirty = true;
 	m_workingArray.m_isDirty = 1;
 	ndBvhLeafNode* const bodyNode = (ndBvhLeafNode*)m_workingArray[body->m_bodyNodeIndex];
 	ndBvhInternalNode* const sceneNode = (ndBvhInternalNode*)m_workingArray[body->m_sceneNodeIndex];
@@ -303,6 +334,105 @@ void ndBvhSceneManager::RemoveBody(ndBodyKinematic* const body)
 	sceneNode->Kill();
 }
 
+ndBvhNode* ndBvhSceneManager::RemoveBody(ndBodyKinematic* const body, ndBvhNode* root)
+{
+	m_wideTreeDirty = true;
+	m_workingArray.m_isDirty = 1;
+	ndBvhLeafNode* const bodyNode = (ndBvhLeafNode*)m_workingArray[body->m_bodyNodeIndex];
+	ndAssert(bodyNode->GetAsSceneBodyNode());
+
+	ndBvhInternalNode* const parent = (ndBvhInternalNode*)bodyNode->m_parent;
+	if (parent)
+	{
+		// unlink the leaf in place, its sibling takes the place of the parent.
+		ndBvhNode* const sibling = (parent->m_left == bodyNode) ? parent->m_right : parent->m_left;
+		ndBvhInternalNode* const grandParent = (ndBvhInternalNode*)parent->m_parent;
+		sibling->m_parent = grandParent;
+		if (grandParent)
+		{
+			if (grandParent->m_left == parent)
+			{
+				grandParent->m_left = sibling;
+			}
+			else
+			{
+				grandParent->m_right = sibling;
+			}
+			RefitAncestors(sibling);
+			MarkSahDirty(sibling);
+		}
+		else
+		{
+			root = sibling;
+		}
+		parent->Kill();
+	}
+	else
+	{
+		// the last leaf, the one internal node still alive goes with it.
+		ndAssert(bodyNode == root);
+		for (ndInt32 i = 0; i < ndInt32(m_workingArray.GetCount()); ++i)
+		{
+			ndBvhNode* const node = m_workingArray[i];
+			if (!node->m_isDead && node->GetAsSceneTreeNode())
+			{
+				node->Kill();
+				break;
+			}
+		}
+		root = nullptr;
+	}
+	bodyNode->Kill();
+	return root;
+}
+
+void ndBvhSceneManager::RefitAncestors(ndBvhNode* const node)
+{
+	for (ndBvhInternalNode* parent = (ndBvhInternalNode*)node->m_parent; parent; parent = (ndBvhInternalNode*)parent->m_parent)
+	{
+		const ndBvhInternalNode* const left = parent->m_left->GetAsSceneTreeNode();
+		const ndBvhInternalNode* const right = parent->m_right->GetAsSceneTreeNode();
+		parent->m_minBox = parent->m_left->m_minBox.GetMin(parent->m_right->m_minBox);
+		parent->m_maxBox = parent->m_left->m_maxBox.GetMax(parent->m_right->m_maxBox);
+		parent->m_depthLevel = ndMax(parent->m_left->m_depthLevel, parent->m_right->m_depthLevel) + 1;
+		parent->m_leafCount = (left ? left->m_leafCount : 1) + (right ? right->m_leafCount : 1);
+		parent->m_sahCost = CalculateSurfaceArea(parent) + (left ? left->m_sahCost : ndFloat32(0.0f)) + (right ? right->m_sahCost : ndFloat32(0.0f));
+	}
+}
+
+void ndBvhSceneManager::UpdateNodeLayers(ndThreadPool& threadPool, ndBvhNode* const root)
+{
+	D_TRACKTIME();
+	// delete the nodes that were unlinked in place, 
+	// and restore the internal nodes first, leaves last layout.
+	Update(threadPool);
+
+	ndBvhNodeArray& nodeArray = m_workingArray;
+	const ndInt32 baseCount = ndInt32(nodeArray.GetCount()) / 2;
+	if (baseCount)
+	{
+		// the layers skip the last internal node, so the one not linked to the tree goes there.
+		for (ndInt32 i = 0; i < baseCount; ++i)
+		{
+			if (!nodeArray[i]->m_parent && (nodeArray[i] != root))
+			{
+				ndSwap(nodeArray[i], nodeArray[baseCount - 1]);
+				break;
+			}
+		}
+		if (m_bvhBuildState.m_tempNodeBuffer.GetCount() < baseCount)
+		{
+			m_bvhBuildState.m_tempNodeBuffer.SetCount(baseCount);
+		}
+		BuildBvhTreeSetNodesDepth(threadPool);
+	}
+	else
+	{
+		nodeArray.m_scansCount = 0;
+		nodeArray.m_scans[0] = 0;
+	}
+}
+
 ndBvhLeafNode* ndBvhSceneManager::GetLeafNode(ndBodyKinematic* const body) const
 {
 	ndAssert(m_workingArray[body->m_bodyNodeIndex] && m_workingArray[body->m_bodyNodeIndex]->GetAsSceneBodyNode());
@@ -313,6 +443,9 @@ ndBvhLeafNode* ndBvhSceneManager::GetLeafNode(ndBodyKinematic* const body) const
 void ndBvhSceneManager::CleanUp()
 {
 	m_workingArray.CleanUp();
+	m_wideNodes.SetCount(0);
+	m_wideSourceNodes.SetCount(0);
+	m_wideTreeDirty = true;
 }
 
 void ndBvhSceneManager::Update(ndThreadPool& threadPool)
@@ -452,12 +585,441 @@ void ndBvhSceneManager::UpdateScene(ndThreadPool& threadPool)
 	const ndBvhNodeArray& array = m_workingArray;
 	for (ndInt32 i = 0; i < ndInt32(array.m_scansCount); ++i)
 	{
+		iterator = 0;
 		start = ndInt32(array.m_scans[i]);
 		count = ndInt32(array.m_scans[i + 1] - start);
 		threadPool.ParallelExecute(UpdateSceneBvh);
 	}
 }
 
+ndFloat32 ndBvhSceneManager::CalculateSurfaceArea(const ndBvhNode* const node)
+{
+	const ndVector size(node->m_maxBox - node->m_minBox);
+	return size.DotProduct(size.ShiftTripleRight()).GetScalar();
+}
+
+void ndBvhSceneManager::InitSahCost(ndThreadPool& threadPool)
+{
+	D_TRACKTIME();
+	ndInt32 start = 0;
+	ndInt32 count = 0;
+	ndAtomic<ndInt32> iterator(0);
+	auto CalculateSahCost = ndMakeObject::ndFunction([this, &iterator, &start, &count](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(CalculateSahCost);
+		ndBvhInternalNode** const nodes = (ndBvhInternalNode**)&m_workingArray[start];
+		const ndInt32 itemsCount = count;
+		for (ndInt32 i = iterator.fetch_add(D_WORKER_BATCH_SIZE); i < itemsCount; i = iterator.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((itemsCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : itemsCount - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				ndBvhInternalNode* const node = nodes[i + j];
+				ndAssert(node && node->GetAsSceneTreeNode());
+				const ndBvhInternalNode* const left = node->m_left->GetAsSceneTreeNode();
+				const ndBvhInternalNode* const right = node->m_right->GetAsSceneTreeNode();
+
+				node->m_leafCount = (left ? left->m_leafCount : 1) + (right ? right->m_leafCount : 1);
+				node->m_sahCost = CalculateSurfaceArea(node) + (left ? left->m_sahCost : ndFloat32(0.0f)) + (right ? right->m_sahCost : ndFloat32(0.0f));
+				node->m_buildSahCost = node->m_sahCost;
+				node->m_sahDirty = 0;
+			}
+		}
+	});
+
+	// the layers are sorted bottom up, so children always have their cost ready
+	const ndBvhNodeArray& array = m_workingArray;
+	for (ndInt32 i = 0; i < ndInt32(array.m_scansCount); ++i)
+	{
+		iterator = 0;
+		start = ndInt32(array.m_scans[i]);
+		count = ndInt32(array.m_scans[i + 1] - start);
+		threadPool.ParallelExecute(CalculateSahCost);
+	}
+}
+
+ndFloat32 ndBvhSceneManager::UpdateSahCost(ndBvhNode* const node)
+{
+	ndBvhInternalNode* const treeNode = node->GetAsSceneTreeNode();
+	if (!treeNode)
+	{
+		return ndFloat32(0.0f);
+	}
+
+	if (treeNode->m_sahDirty)
+	{
+		treeNode->m_sahDirty = 0;
+		const ndInt32 start = ndInt32(m_degradedNodes.GetCount());
+		treeNode->m_sahCost = CalculateSurfaceArea(treeNode) + UpdateSahCost(treeNode->m_left) + UpdateSahCost(treeNode->m_right);
+		if ((treeNode->m_sahCost > D_BVH_SAH_DEGRADATION * treeNode->m_buildSahCost) && (treeNode->m_leafCount <= D_BVH_MAX_PARTIAL_REBUILD_LEAVES))
+		{
+			// rebuilding this node also rebuilds all the degraded nodes below it.
+			m_degradedNodes.SetCount(start);
+			m_degradedNodes.PushBack(treeNode);
+		}
+	}
+	return treeNode->m_sahCost;
+}
+
+ndBvhNode* ndBvhSceneManager::BuildSubtree(ndBvhNode** const leafArray, ndInt32 count, ndBvhInternalNode** const nodeArray, ndInt32& nodeIndex, ndBvhNode* const parent)
+{
+	if (count == 1)
+	{
+		leafArray[0]->m_parent = parent;
+		return leafArray[0];
+	}
+
+	ndBvhInternalNode* const node = nodeArray[nodeIndex];
+	nodeIndex++;
+
+	ndVector minCenter(ndFloat32(1.0e15f));
+	ndVector maxCenter(ndFloat32(-1.0e15f));
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		const ndVector center(leafArray[i]->m_minBox + leafArray[i]->m_maxBox);
+		minCenter = minCenter.GetMin(center);
+		maxCenter = maxCenter.GetMax(center);
+	}
+
+	const ndVector extend(maxCenter - minCenter);
+	ndInt32 axis = (extend.m_x >= extend.m_y) ? 0 : 1;
+	axis = (extend[axis] >= extend.m_z) ? axis : 2;
+
+	ndInt32 split = count / 2;
+	if (extend[axis] > ndFloat32(1.0e-3f))
+	{
+		// binned surface area heuristic along the widest centroid axis
+		ndInt32 binCount[D_BVH_SAH_BINS];
+		ndVector binMinBox[D_BVH_SAH_BINS];
+		ndVector binMaxBox[D_BVH_SAH_BINS];
+		for (ndInt32 i = 0; i < D_BVH_SAH_BINS; ++i)
+		{
+			binCount[i] = 0;
+			binMinBox[i] = ndVector(ndFloat32(1.0e15f));
+			binMaxBox[i] = ndVector(ndFloat32(-1.0e15f));
+		}
+
+		const ndFloat32 origin = minCenter[axis];
+		const ndFloat32 scale = ndFloat32(D_BVH_SAH_BINS) * ndFloat32(0.999f) / extend[axis];
+		for (ndInt32 i = 0; i < count; ++i)
+		{
+			const ndBvhNode* const leaf = leafArray[i];
+			const ndInt32 bin = ndInt32(((leaf->m_minBox + leaf->m_maxBox)[axis] - origin) * scale);
+			binCount[bin]++;
+			binMinBox[bin] = binMinBox[bin].GetMin(leaf->m_minBox);
+			binMaxBox[bin] = binMaxBox[bin].GetMax(leaf->m_maxBox);
+		}
+
+		ndFloat32 rightCost[D_BVH_SAH_BINS];
+		ndVector minBox(ndFloat32(1.0e15f));
+		ndVector maxBox(ndFloat32(-1.0e15f));
+		ndInt32 rightCount = 0;
+		for (ndInt32 i = D_BVH_SAH_BINS - 1; i > 0; --i)
+		{
+			rightCount += binCount[i];
+			minBox = minBox.GetMin(binMinBox[i]);
+			maxBox = maxBox.GetMax(binMaxBox[i]);
+			const ndVector size(maxBox - minBox);
+			rightCost[i] = ndFloat32(rightCount) * size.DotProduct(size.ShiftTripleRight()).GetScalar();
+		}
+
+		ndInt32 bestBin = 0;
+		ndInt32 leftCount = 0;
+		ndFloat32 bestCost = ndFloat32(1.0e30f);
+		minBox = ndVector(ndFloat32(1.0e15f));
+		maxBox = ndVector(ndFloat32(-1.0e15f));
+		for (ndInt32 i = 0; i < D_BVH_SAH_BINS - 1; ++i)
+		{
+			leftCount += binCount[i];
+			minBox = minBox.GetMin(binMinBox[i]);
+			maxBox = maxBox.GetMax(binMaxBox[i]);
+			if (leftCount && (leftCount < count))
+			{
+				const ndVector size(maxBox - minBox);
+				const ndFloat32 cost = ndFloat32(leftCount) * size.DotProduct(size.ShiftTripleRight()).GetScalar() + rightCost[i + 1];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestBin = i + 1;
+				}
+			}
+		}
+
+		if (bestBin)
+		{
+			ndInt32 i0 = 0;
+			ndInt32 i1 = count - 1;
+			while (i0 <= i1)
+			{
+				const ndBvhNode* const leaf = leafArray[i0];
+				const ndInt32 bin = ndInt32(((leaf->m_minBox + leaf->m_maxBox)[axis] - origin) * scale);
+				if (bin < bestBin)
+				{
+					i0++;
+				}
+				else
+				{
+					ndSwap(leafArray[i0], leafArray[i1]);
+					i1--;
+				}
+			}
+			split = i0;
+		}
+	}
+	ndAssert(split > 0);
+	ndAssert(split < count);
+
+	node->m_parent = parent;
+	node->m_left = BuildSubtree(leafArray, split, nodeArray, nodeIndex, node);
+	node->m_right = BuildSubtree(&leafArray[split], count - split, nodeArray, nodeIndex, node);
+
+	const ndBvhInternalNode* const left = node->m_left->GetAsSceneTreeNode();
+	const ndBvhInternalNode* const right = node->m_right->GetAsSceneTreeNode();
+	node->m_minBox = node->m_left->m_minBox.GetMin(node->m_right->m_minBox);
+	node->m_maxBox = node->m_left->m_maxBox.GetMax(node->m_right->m_maxBox);
+	node->m_depthLevel = ndMax(node->m_left->m_depthLevel, node->m_right->m_depthLevel) + 1;
+	node->m_leafCount = count;
+	node->m_sahCost = CalculateSurfaceArea(node) + (left ? left->m_sahCost : ndFloat32(0.0f)) + (right ? right->m_sahCost : ndFloat32(0.0f));
+	node->m_buildSahCost = node->m_sahCost;
+	node->m_sahDirty = 0;
+	return node;
+}
+
+void ndBvhSceneManager::RebuildSubtree(ndBvhInternalNode* const root)
+{
+	ndBvhNode* leafArray[D_BVH_MAX_PARTIAL_REBUILD_LEAVES];
+	ndBvhInternalNode* nodeArray[D_BVH_MAX_PARTIAL_REBUILD_LEAVES];
+	ndBvhNode* stackPool[D_BVH_MAX_PARTIAL_REBUILD_LEAVES];
+
+	// collect the leaves and recycle the internal nodes, the root stays in place
+	ndInt32 leafCount = 0;
+	ndInt32 nodeCount = 1;
+	nodeArray[0] = root;
+	stackPool[0] = root->m_left;
+	stackPool[1] = root->m_right;
+	ndInt32 stack = 2;
+	while (stack)
+	{
+		stack--;
+		ndBvhNode* const node = stackPool[stack];
+		ndBvhInternalNode* const treeNode = node->GetAsSceneTreeNode();
+		if (treeNode)
+		{
+			ndAssert(stack < (D_BVH_MAX_PARTIAL_REBUILD_LEAVES - 2));
+			nodeArray[nodeCount] = treeNode;
+			nodeCount++;
+			stackPool[stack] = treeNode->m_left;
+			stackPool[stack + 1] = treeNode->m_right;
+			stack += 2;
+		}
+		else
+		{
+			ndBodyKinematic* const body = node->GetBody();
+			node->SetAabb(body->m_minAabb, body->m_maxAabb);
+			leafArray[leafCount] = node;
+			leafCount++;
+		}
+	}
+	ndAssert(leafCount == root->m_leafCount);
+	ndAssert(nodeCount == (leafCount - 1));
+
+	// the root is the first recycled node, so the rebuilt subtree hangs from it in place
+	ndInt32 nodeIndex = 0;
+	BuildSubtree(leafArray, leafCount, nodeArray, nodeIndex, root->m_parent);
+	ndAssert(root->m_left && root->m_right);
+	ndAssert(nodeIndex == nodeCount);
+}
+
+void ndBvhWideNode::UpdateBoxes()
+{
+	const ndVector farBox(ndFloat32(1.0e15f));
+	ndVector minBox[D_BVH_WIDE_NODE_CHILDREN];
+	ndVector maxBox[D_BVH_WIDE_NODE_CHILDREN];
+	for (ndInt32 i = 0; i < D_BVH_WIDE_NODE_CHILDREN; ++i)
+	{
+		const ndBvhNode* const node = m_node[i];
+		minBox[i] = node ? node->m_minBox : farBox;
+		maxBox[i] = node ? node->m_maxBox : farBox;
+	}
+
+	ndVector minW;
+	ndVector maxW;
+	ndVector::Transpose4x4(m_minX, m_minY, m_minZ, minW, minBox[0], minBox[1], minBox[2], minBox[3]);
+	ndVector::Transpose4x4(m_maxX, m_maxY, m_maxZ, maxW, maxBox[0], maxBox[1], maxBox[2], maxBox[3]);
+}
+
+void ndBvhSceneManager::BuildWideTree(ndBvhNode* const root)
+{
+	D_TRACKTIME();
+	m_wideNodes.SetCount(0);
+	m_wideSourceNodes.SetCount(0);
+	if (!root)
+	{
+		m_wideTreeDirty.store(false);
+		return;
+	}
+
+	// there are never more wide nodes than binary internal nodes, 
+	// so the array does not move and the children can be linked by address.
+	const ndInt32 maxNodes = ndInt32(m_workingArray.GetCount()) / 2 + 1;
+	m_wideNodes.SetCount(maxNodes);
+	m_wideSourceNodes.SetCount(maxNodes);
+
+	// breadth first, each wide node collapses a binary node and some of its descendants
+	ndInt32 nodeCount = 1;
+	m_wideSourceNodes[0] = root;
+	for (ndInt32 i = 0; i < nodeCount; ++i)
+	{
+		ndInt32 count = 0;
+		ndBvhNode* children[D_BVH_WIDE_NODE_CHILDREN];
+		ndBvhNode* const node = m_wideSourceNodes[i];
+		ndBvhInternalNode* const treeNode = node->GetAsSceneTreeNode();
+		if (treeNode)
+		{
+			children[0] = treeNode->m_left;
+			children[1] = treeNode->m_right;
+			count = 2;
+		}
+		else
+		{
+			// a tree with a single body
+			children[0] = node;
+			count = 1;
+		}
+
+		// keep opening the largest internal child until the node is full
+		while (count < D_BVH_WIDE_NODE_CHILDREN)
+		{
+			ndInt32 index = -1;
+			ndFloat32 maxArea = ndFloat32(-1.0f);
+			for (ndInt32 j = 0; j < count; ++j)
+			{
+				if (children[j]->GetAsSceneTreeNode())
+				{
+					const ndFloat32 area = CalculateSurfaceArea(children[j]);
+					if (area > maxArea)
+					{
+						index = j;
+						maxArea = area;
+					}
+				}
+			}
+			if (index < 0)
+			{
+				break;
+			}
+			ndBvhInternalNode* const openNode = children[index]->GetAsSceneTreeNode();
+			children[index] = openNode->m_left;
+			children[count] = openNode->m_right;
+			count++;
+		}
+
+		ndBvhWideNode& wideNode = m_wideNodes[i];
+		wideNode.m_count = count;
+		for (ndInt32 j = 0; j < D_BVH_WIDE_NODE_CHILDREN; ++j)
+		{
+			wideNode.m_node[j] = nullptr;
+			wideNode.m_body[j] = nullptr;
+			wideNode.m_child[j] = nullptr;
+			if (j < count)
+			{
+				ndBvhNode* const child = children[j];
+				wideNode.m_node[j] = child;
+				wideNode.m_body[j] = child->GetBody();
+				if (child->GetAsSceneTreeNode())
+				{
+					ndAssert(nodeCount < maxNodes);
+					m_wideSourceNodes[nodeCount] = child;
+					wideNode.m_child[j] = &m_wideNodes[nodeCount];
+					nodeCount++;
+				}
+			}
+		}
+		wideNode.UpdateBoxes();
+	}
+	m_wideNodes.SetCount(nodeCount);
+	m_wideSourceNodes.SetCount(nodeCount);
+
+	// queries outside the update only read the wide tree once it is clean, 
+	// so it is published when it is complete.
+	m_wideTreeDirty.store(false);
+}
+
+void ndBvhSceneManager::UpdateWideTree(ndThreadPool& threadPool, ndBvhNode* const root, bool refit)
+{
+	if (m_wideTreeDirty.load())
+	{
+		BuildWideTree(root);
+	}
+	else if (refit && m_wideNodes.GetCount())
+	{
+		D_TRACKTIME();
+		ndAtomic<ndInt32> iterator(0);
+		auto RefitWideNodes = ndMakeObject::ndFunction([this, &iterator](ndInt32, ndInt32)
+		{
+			D_TRACKTIME_NAMED(RefitWideNodes);
+			const ndInt32 count = ndInt32(m_wideNodes.GetCount());
+			for (ndInt32 i = iterator.fetch_add(D_WORKER_BATCH_SIZE); i < count; i = iterator.fetch_add(D_WORKER_BATCH_SIZE))
+			{
+				const ndInt32 maxSpan = ((count - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : count - i;
+				for (ndInt32 j = 0; j < maxSpan; ++j)
+				{
+					m_wideNodes[i + j].UpdateBoxes();
+				}
+			}
+		});
+		threadPool.ParallelExecute(RefitWideNodes);
+	}
+}
+
+bool ndBvhSceneManager::RebuildDegradedSubtrees(ndThreadPool& threadPool, ndBvhNode* const root)
+{
+	D_TRACKTIME();
+	ndAssert(root && root->GetAsSceneTreeNode());
+
+	m_degradedNodes.SetCount(0);
+	UpdateSahCost(root);
+
+	const ndBvhInternalNode* const rootNode = root->GetAsSceneTreeNode();
+	if (rootNode->m_sahCost > D_BVH_SAH_FULL_REBUILD * rootNode->m_buildSahCost)
+	{
+		// the whole tree is too far gone, patching it up is not worth it.
+		return false;
+	}
+
+	if (m_degradedNodes.GetCount())
+	{
+		ndAtomic<ndInt32> iterator(0);
+		auto RebuildSubtrees = ndMakeObject::ndFunction([this, &iterator](ndInt32, ndInt32)
+		{
+			D_TRACKTIME_NAMED(RebuildSubtrees);
+			const ndInt32 count = ndInt32(m_degradedNodes.GetCount());
+			for (ndInt32 i = iterator.fetch_add(1); i < count; i = iterator.fetch_add(1))
+			{
+				RebuildSubtree(m_degradedNodes[i]);
+			}
+		});
+		threadPool.ParallelExecute(RebuildSubtrees);
+
+		// the new subtrees are tighter and may be deeper,
+		// update boxes, cost and depth of all their ancestors.
+		for (ndInt32 i = 0; i < ndInt32(m_degradedNodes.GetCount()); ++i)
+		{
+			RefitAncestors(m_degradedNodes[i]);
+		}
+		m_partialRebuildCount += ndInt32(m_degradedNodes.GetCount());
+		m_wideTreeDirty = true;
+
+		if (root->m_depthLevel >= D_BVH_MAX_PARTIAL_REBUILD_DEPTH)
+		{
+			return false;
+		}
+		BuildBvhTreeSetNodesDepth(threadPool);
+		ndAssert(root->SanityCheck(0));
+	}
+	return true;
+}
+
 bool ndBvhSceneManager::BuildBvhTreeInitNodes(ndThreadPool& threadPool)
 {
 	D_TRACKTIME();
@@ -1426,6 +1988,8 @@ ndBvhNode* ndBvhSceneManager::BuildBvhTree(ndThreadPool& threadPool)
 
 	BuildBvhTreeSetNodesDepth(threadPool);
 	ndAssert(m_bvhBuildState.m_root->SanityCheck(0));
+	m_fullRebuildCount++;
+	m_wideTreeDirty = true;
 	
 	return m_bvhBuildState.m_root;
 }
@@ -24,6 +24,17 @@
 
 #include "ndCollisionStdafx.h"
 
+// incremental mode: a subtree is rebuilt when its surface area cost grows past this factor of its build cost,
+// and the whole tree is rebuilt from scratch when the root goes past the second factor.
+#define D_BVH_SAH_DEGRADATION				ndFloat32(1.5f)
+#define D_BVH_SAH_FULL_REBUILD				ndFloat32(2.5f)
+#define D_BVH_SAH_BINS						16
+#define D_BVH_MAX_PARTIAL_REBUILD_LEAVES	1024
+#define D_BVH_MAX_PARTIAL_REBUILD_DEPTH		96
+
+// the scene queries run on a four wide copy of the tree, one simd lane per child.
+#define D_BVH_WIDE_NODE_CHILDREN			4
+
 class ndBodyKinematic;
 class ndBvhLeafNode;
 class ndBvhInternalNode;
@@ -83,6 +94,10 @@ class ndBvhInternalNode: public ndBvhNode
 
 	ndBvhNode* m_left;
 	ndBvhNode* m_right;
+	ndFloat32 m_sahCost;
+	ndFloat32 m_buildSahCost;
+	ndInt32 m_leafCount;
+	ndAtomic<ndUnsigned8> m_sahDirty;
 } D_GCC_NEWTON_ALIGN_32;
 
 class ndBvhLeafNode : public ndBvhNode
@@ -99,6 +114,65 @@ class ndBvhLeafNode : public ndBvhNode
 	ndBodyKinematic* m_body;
 };
 
+// broadcast of a query box, so that it can be tested against all the children of a wide node at once.
+class ndBvhWideBox
+{
+	public:
+	ndBvhWideBox(const ndVector& minBox, const ndVector& maxBox);
+
+	ndVector m_minX;
+	ndVector m_minY;
+	ndVector m_minZ;
+	ndVector m_maxX;
+	ndVector m_maxY;
+	ndVector m_maxZ;
+};
+
+// broadcast of a fast ray. for convex casts the ray origin is offset by the cast shape box, 
+// so that the children boxes are Minkowski expanded on the fly.
+class ndBvhWideRay
+{
+	public:
+	ndBvhWideRay(const ndFastRay& ray);
+	ndBvhWideRay(const ndFastRay& ray, const ndVector& boxP0, const ndVector& boxP1);
+
+	ndVector m_minOriginX;
+	ndVector m_minOriginY;
+	ndVector m_minOriginZ;
+	ndVector m_maxOriginX;
+	ndVector m_maxOriginY;
+	ndVector m_maxOriginZ;
+	ndVector m_dpInvX;
+	ndVector m_dpInvY;
+	ndVector m_dpInvZ;
+	ndVector m_isParallelX;
+	ndVector m_isParallelY;
+	ndVector m_isParallelZ;
+	ndVector m_minT;
+	ndVector m_maxT;
+};
+
+// node of the four wide tree, the children bounds are stored as structure of arrays.
+// empty slots have a degenerated box far away, so that they never pass a test.
+class ndBvhWideNode
+{
+	public:
+	void UpdateBoxes();
+	ndInt32 OverlapTest(const ndBvhWideBox& box) const;
+	ndVector RayDistance(const ndBvhWideRay& ray) const;
+
+	ndVector m_minX;
+	ndVector m_minY;
+	ndVector m_minZ;
+	ndVector m_maxX;
+	ndVector m_maxY;
+	ndVector m_maxZ;
+	ndBvhNode* m_node[D_BVH_WIDE_NODE_CHILDREN];
+	ndBodyKinematic* m_body[D_BVH_WIDE_NODE_CHILDREN];
+	ndBvhWideNode* m_child[D_BVH_WIDE_NODE_CHILDREN];
+	ndInt32 m_count;
+};
+
 class ndBottomUpCell
 {
 	public:
@@ -174,14 +248,33 @@ class ndBvhSceneManager
 	void CleanUp();
 	ndBvhNode* AddBody(ndBodyKinematic* const body, ndBvhNode* root);
 	void RemoveBody(ndBodyKinematic* const body);
+	ndBvhNode* RemoveBody(ndBodyKinematic* const body, ndBvhNode* root);
+	void UpdateNodeLayers(ndThreadPool& threadPool, ndBvhNode* const root);
 
 	void UpdateScene(ndThreadPool& threadPool);
 	ndBvhNode* BuildBvhTree(ndThreadPool& threadPool);
 
+	void InitSahCost(ndThreadPool& threadPool);
+	void MarkSahDirty(const ndBvhNode* const node) const;
+	bool RebuildDegradedSubtrees(ndThreadPool& threadPool, ndBvhNode* const root);
+
+	void UpdateWideTree(ndThreadPool& threadPool, ndBvhNode* const root, bool refit);
+	bool IsWideTreeDirty() const;
+	const ndBvhWideNode* GetWideRoot() const;
+
 	ndBvhNodeArray& GetNodeArray();
 	ndBvhLeafNode* GetLeafNode(ndBodyKinematic* const body) const;
+	ndInt32 GetFullRebuildCount() const;
+	ndInt32 GetPartialRebuildCount() const;
 
 	private:
+	static ndFloat32 CalculateSurfaceArea(const ndBvhNode* const node);
+	ndFloat32 UpdateSahCost(ndBvhNode* const node);
+	void RefitAncestors(ndBvhNode* const node);
+	void RebuildSubtree(ndBvhInternalNode* const root);
+	void BuildWideTree(ndBvhNode* const root);
+	ndBvhNode* BuildSubtree(ndBvhNode** const leafArray, ndInt32 count, ndBvhInternalNode** const nodeArray, ndInt32& nodeIndex, ndBvhNode* const parent);
+
 	void Update(ndThreadPool& threadPool);
 	bool BuildBvhTreeInitNodes(ndThreadPool& threadPool);
 	void BuildBvhTreeSetNodesDepth(ndThreadPool& threadPool);
@@ -193,6 +286,12 @@ class ndBvhSceneManager
 
 	ndBvhNodeArray m_workingArray;
 	ndBuildBvhTreeBuildState m_bvhBuildState;
+	ndArray<ndBvhInternalNode*> m_degradedNodes;
+	ndArray<ndBvhWideNode> m_wideNodes;
+	ndArray<ndBvhNode*> m_wideSourceNodes;
+	ndInt32 m_fullRebuildCount;
+	ndInt32 m_partialRebuildCount;
+	ndAtomic<bool> m_wideTreeDirty;
 };
 
 
@@ -323,9 +422,115 @@ inline ndBvhNode* ndBvhInternalNode::GetRight() const
 	return m_right;
 }
 
+inline ndBvhWideBox::ndBvhWideBox(const ndVector& minBox, const ndVector& maxBox)
+	:m_minX(minBox.BroadcastX())
+	,m_minY(minBox.BroadcastY())
+	,m_minZ(minBox.BroadcastZ())
+	,m_maxX(maxBox.BroadcastX())
+	,m_maxY(maxBox.BroadcastY())
+	,m_maxZ(maxBox.BroadcastZ())
+{
+}
+
+inline ndBvhWideRay::ndBvhWideRay(const ndFastRay& ray)
+	:m_minOriginX(ray.m_p0.BroadcastX())
+	,m_minOriginY(ray.m_p0.BroadcastY())
+	,m_minOriginZ(ray.m_p0.BroadcastZ())
+	,m_maxOriginX(m_minOriginX)
+	,m_maxOriginY(m_minOriginY)
+	,m_maxOriginZ(m_minOriginZ)
+	,m_dpInvX(ray.m_dpInv.BroadcastX())
+	,m_dpInvY(ray.m_dpInv.BroadcastY())
+	,m_dpInvZ(ray.m_dpInv.BroadcastZ())
+	,m_isParallelX(ray.m_isParallel.BroadcastX())
+	,m_isParallelY(ray.m_isParallel.BroadcastY())
+	,m_isParallelZ(ray.m_isParallel.BroadcastZ())
+	,m_minT(ray.m_minT.BroadcastX())
+	,m_maxT(ray.m_maxT.BroadcastX())
+{
+}
+
+inline ndBvhWideRay::ndBvhWideRay(const ndFastRay& ray, const ndVector& boxP0, const ndVector& boxP1)
+	:m_minOriginX((ray.m_p0 + boxP1).BroadcastX())
+	,m_minOriginY((ray.m_p0 + boxP1).BroadcastY())
+	,m_minOriginZ((ray.m_p0 + boxP1).BroadcastZ())
+	,m_maxOriginX((ray.m_p0 + boxP0).BroadcastX())
+	,m_maxOriginY((ray.m_p0 + boxP0).BroadcastY())
+	,m_maxOriginZ((ray.m_p0 + boxP0).BroadcastZ())
+	,m_dpInvX(ray.m_dpInv.BroadcastX())
+	,m_dpInvY(ray.m_dpInv.BroadcastY())
+	,m_dpInvZ(ray.m_dpInv.BroadcastZ())
+	,m_isParallelX(ray.m_isParallel.BroadcastX())
+	,m_isParallelY(ray.m_isParallel.BroadcastY())
+	,m_isParallelZ(ray.m_isParallel.BroadcastZ())
+	,m_minT(ray.m_minT.BroadcastX())
+	,m_maxT(ray.m_maxT.BroadcastX())
+{
+}
+
+inline ndInt32 ndBvhWideNode::OverlapTest(const ndBvhWideBox& box) const
+{
+	// same strict test as ndOverlapTest, one lane per child
+	const ndVector testX((m_minX < box.m_maxX) & (m_maxX > box.m_minX));
+	const ndVector testY((m_minY < box.m_maxY) & (m_maxY > box.m_minY));
+	const ndVector testZ((m_minZ < box.m_maxZ) & (m_maxZ > box.m_minZ));
+	return (testX & testY & testZ).GetSignMask();
+}
+
+inline ndVector ndBvhWideNode::RayDistance(const ndBvhWideRay& ray) const
+{
+	// same slab test as ndFastRay::BoxIntersect, one lane per child
+	const ndVector tx0(ray.m_dpInvX * (m_minX - ray.m_minOriginX));
+	const ndVector tx1(ray.m_dpInvX * (m_maxX - ray.m_maxOriginX));
+	const ndVector ty0(ray.m_dpInvY * (m_minY - ray.m_minOriginY));
+	const ndVector ty1(ray.m_dpInvY * (m_maxY - ray.m_maxOriginY));
+	const ndVector tz0(ray.m_dpInvZ * (m_minZ - ray.m_minOriginZ));
+	const ndVector tz1(ray.m_dpInvZ * (m_maxZ - ray.m_maxOriginZ));
+
+	const ndVector t0(ray.m_minT.GetMax(tx0.GetMin(tx1)).GetMax(ty0.GetMin(ty1)).GetMax(tz0.GetMin(tz1)));
+	const ndVector t1(ray.m_maxT.GetMin(tx0.GetMax(tx1)).GetMin(ty0.GetMax(ty1)).GetMin(tz0.GetMax(tz1)));
+
+	const ndVector outsideX(((ray.m_minOriginX <= m_minX) | (ray.m_maxOriginX >= m_maxX)) & ray.m_isParallelX);
+	const ndVector outsideY(((ray.m_minOriginY <= m_minY) | (ray.m_maxOriginY >= m_maxY)) & ray.m_isParallelY);
+	const ndVector outsideZ(((ray.m_minOriginZ <= m_minZ) | (ray.m_maxOriginZ >= m_maxZ)) & ray.m_isParallelZ);
+	const ndVector hit((t0 < t1).AndNot(outsideX | outsideY | outsideZ));
+	return ndVector(ndFloat32(1.2f)).Select(t0, hit);
+}
+
+inline bool ndBvhSceneManager::IsWideTreeDirty() const
+{
+	return m_wideTreeDirty.load();
+}
+
+inline const ndBvhWideNode* ndBvhSceneManager::GetWideRoot() const
+{
+	return m_wideNodes.GetCount() ? &m_wideNodes[0] : nullptr;
+}
+
 inline ndBvhNodeArray& ndBvhSceneManager::GetNodeArray()
 {
 	return m_workingArray;
 }
 
+inline ndInt32 ndBvhSceneManager::GetFullRebuildCount() const
+{
+	return m_fullRebuildCount;
+}
+
+inline ndInt32 ndBvhSceneManager::GetPartialRebuildCount() const
+{
+	return m_partialRebuildCount;
+}
+
+inline void ndBvhSceneManager::MarkSahDirty(const ndBvhNode* const node) const
+{
+	// flag the path to the root, stop at the first node some other leaf already flagged.
+	// the leaves are refit from many threads, so the flag is set with an atomic exchange.
+	ndBvhInternalNode* parent = (ndBvhInternalNode*)node->m_parent;
+	while (parent && !parent->m_sahDirty.exchange(1))
+	{
+		parent = (ndBvhInternalNode*)parent->m_parent;
+	}
+}
+
 #endif
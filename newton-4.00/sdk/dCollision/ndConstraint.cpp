@@ -64,6 +64,13 @@ ndFloat32 ndForceImpactPair::GetInitialGuess() const
 }
 
 
+ndFloat32 ndForceImpactPair::GetWarmStart() const
+{
+	// contacts keep their points across frames, so last frame's 
+	// force is a better seed than the most conservative one.
+	return m_initialGuess[sizeof(m_initialGuess) / sizeof(m_initialGuess[0]) - 1];
+}
+
 ndConstraint::ndConstraint()
 	:ndContainersFreeListAlloc<ndConstraint>()
 	,m_forceBody0(ndVector::m_zero)
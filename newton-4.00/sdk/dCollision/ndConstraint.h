@@ -122,6 +122,7 @@ class ndForceImpactPair
 	void Clear();
 	void Push(ndFloat32 val);
 	ndFloat32 GetInitialGuess() const;
+	ndFloat32 GetWarmStart() const;
 
 	ndFloat32 m_force;
 	ndFloat32 m_impact;
@@ -255,7 +256,10 @@ class ndConstraint: public ndContainersFreeListAlloc<ndConstraint>
 	friend class ndDynamicsUpdate;
 	friend class ndSkeletonContainer;
 	friend class ndDynamicsUpdateSoa;
+	friend class ndDynamicsUpdateGaussSeidel;
+	friend class ndDynamicsUpdateIsland;
 	friend class ndDynamicsUpdateAvx2;
+	friend class ndDynamicsUpdateAvx512;
 } D_GCC_NEWTON_ALIGN_32 ;
 
 inline ndConstraint::~ndConstraint()
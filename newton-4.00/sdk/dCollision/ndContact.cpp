@@ -33,6 +33,85 @@ ndVector ndContact::m_initialSeparatingVector(ndFloat32(0.0f), ndFloat32(1.0f),
 #define D_MAX_PENETRATION_STIFFNESS		ndFloat32 (50.0f)
 #define D_DIAGONAL_REGULARIZER			ndFloat32 (1.0e-3f)
 
+ndContactPointList::ndContactPointList()
+	:m_nodes(nullptr)
+	,m_count(0)
+	,m_capacity(0)
+{
+}
+
+ndContactPointList::~ndContactPointList()
+{
+	if (m_nodes)
+	{
+		ndFreeListAlloc::operator delete(m_nodes);
+	}
+}
+
+void ndContactPointList::Reserve(ndInt32 capacity)
+{
+	ndNode* const nodes = (ndNode*)ndFreeListAlloc::operator new(size_t(capacity) * sizeof(ndNode));
+	for (ndInt32 i = 0; i < m_count; ++i)
+	{
+		new (&nodes[i]) ndNode(m_nodes[i]);
+	}
+	if (m_nodes)
+	{
+		ndFreeListAlloc::operator delete(m_nodes);
+	}
+	m_nodes = nodes;
+	m_capacity = capacity;
+}
+
+ndContactPointList::ndNode* ndContactPointList::Append()
+{
+	return Append(ndContactMaterial());
+}
+
+ndContactPointList::ndNode* ndContactPointList::Append(const ndContactMaterial& point)
+{
+	if (m_count == m_capacity)
+	{
+		// the contact solver prunes to D_MAX_CONTACT_POINTS, so this grows two or three times at most
+		ndAssert(m_count < D_MAX_CONTACT_POINTS);
+		Reserve(m_capacity ? m_capacity * 2 : 4);
+	}
+	if (m_count)
+	{
+		m_nodes[m_count - 1].m_isLast = false;
+	}
+	ndNode* const node = &m_nodes[m_count];
+	new (&node->m_info) ndContactMaterial(point);
+	node->m_isLast = true;
+	m_count++;
+	return node;
+}
+
+void ndContactPointList::Remove(ndInt32 index)
+{
+	ndAssert(index >= 0);
+	ndAssert(index < m_count);
+	m_count--;
+	for (ndInt32 i = index; i < m_count; ++i)
+	{
+		m_nodes[i].m_info = m_nodes[i + 1].m_info;
+	}
+	if (m_count)
+	{
+		m_nodes[m_count - 1].m_isLast = true;
+	}
+}
+
+void ndContactPointList::Remove(ndNode* const node)
+{
+	Remove(ndInt32(node - m_nodes));
+}
+
+void ndContactPointList::RemoveAll()
+{
+	m_count = 0;
+}
+
 ndContact::ndContact()
 	:ndConstraint()
 	,m_positAcc(ndFloat32(10.0f))
@@ -73,9 +152,9 @@ void ndContact::SetBodies(ndBodyKinematic* const body0, ndBodyKinematic* const b
 void ndContact::ClearMemory()
 {
 	ndContactPointList& contacts = GetContactPoints();
-	for (ndContactPointList::ndNode* node = contacts.GetFirst(); node; node = node->GetNext())
+	for (ndInt32 i = 0; i < contacts.GetCount(); ++i)
 	{
-		ndContactMaterial& contact = node->GetInfo();
+		ndContactMaterial& contact = contacts[i];
 		contact.m_dir0_Force.Clear();
 		contact.m_dir1_Force.Clear();
 		contact.m_normal_Force.Clear();
@@ -95,10 +174,9 @@ void ndContact::InitSurrogateContact(ndContact* const surrogate, ndBodyKinematic
 
 	surrogate->m_active = m_active;
 	surrogate->m_contacPointsList.RemoveAll();
-	for (ndContactPointList::ndNode* node = m_contacPointsList.GetFirst(); node; node = node->GetNext())
+	for (ndInt32 i = 0; i < m_contacPointsList.GetCount(); ++i)
 	{
-		const ndContactMaterial& contact = node->GetInfo();
-		surrogate->m_contacPointsList.Append(contact);
+		surrogate->m_contacPointsList.Append(m_contacPointsList[i]);
 	}
 }
 
@@ -121,13 +199,11 @@ void ndContact::JacobianDerivative(ndConstraintDescritor& desc)
 	ndInt32 frictionIndex = 0;
 	if (m_maxDof) 
 	{
-		ndInt32 i = 0;
-		frictionIndex = m_contacPointsList.GetCount();
-		for (ndContactPointList::ndNode* node = m_contacPointsList.GetFirst(); node; node = node->GetNext())
+		const ndInt32 count = m_contacPointsList.GetCount();
+		frictionIndex = count;
+		for (ndInt32 i = 0; i < count; ++i)
 		{
-			const ndContactMaterial& contact = node->GetInfo();
-			JacobianContactDerivative(desc, contact, i, frictionIndex);
-			i++;
+			JacobianContactDerivative(desc, m_contacPointsList[i], i, frictionIndex);
 		}
 	}
 	desc.m_rowsCount = frictionIndex;
@@ -172,6 +248,15 @@ void ndContact::JacobianContactDerivative(ndConstraintDescritor& desc, const ndC
 
 	ndFloat32 relSpeed = -(normalJacobian0.m_linear * veloc0 + normalJacobian0.m_angular * omega0 + normalJacobian1.m_linear * veloc1 + normalJacobian1.m_angular * omega1).AddHorizontal().GetScalar();
 	ndFloat32 penetration = ndClamp(contact.m_penetration - D_RESTING_CONTACT_PENETRATION, ndFloat32(0.0f), ndFloat32(0.5f));
+
+	// a speculative contact found by the continue collision has the gap as a negative 
+	// penetration, the row lets the bodies close that gap this step but no more.
+	const bool speculative = contact.m_speculative;
+	if (speculative)
+	{
+		relSpeed = ndFloat32(0.0f);
+		penetration = contact.m_penetration;
+	}
 	desc.m_flags[normalIndex] = ndInt32(contact.m_material.m_flags & m_isSoftContact);
 	desc.m_jointSpeed[normalIndex] = ndFloat32 (0.0f);
 	desc.m_penetration[normalIndex] = penetration;
@@ -181,9 +266,8 @@ void ndContact::JacobianContactDerivative(ndConstraintDescritor& desc, const ndC
 	desc.m_forceBounds[normalIndex].m_jointForce = (ndForceImpactPair*)&contact.m_normal_Force;
 
 	const ndFloat32 restitutionVelocity = (relSpeed > D_REST_RELATIVE_VELOCITY) ? relSpeed * restitutionCoefficient : ndFloat32(0.0f);
-	const ndFloat32 penetrationStiffness = D_MAX_PENETRATION_STIFFNESS * contact.m_material.m_softness;
-	const ndFloat32 penetrationVeloc = penetration * penetrationStiffness;
-	ndAssert(ndAbs(penetrationVeloc - D_MAX_PENETRATION_STIFFNESS * contact.m_material.m_softness * penetration) < ndFloat32(1.0e-6f));
+	const ndFloat32 penetrationStiffness = speculative ? desc.m_invTimestep : D_MAX_PENETRATION_STIFFNESS * contact.m_material.m_softness;
+	const ndFloat32 penetrationVeloc = ndMax(penetration * penetrationStiffness, ndFloat32(0.0f));
 	desc.m_penetrationStiffness[normalIndex] = penetrationStiffness;
 
 	const bool isHardContact = !(contact.m_material.m_flags & m_isSoftContact);
@@ -319,6 +403,8 @@ void ndContact::JointAccelerations(ndJointAccelerationDecriptor* const desc)
 	ndRightHandSide* const rightHandSide = desc->m_rightHandSide;
 	const ndLeftHandSide* const leftHandSide = desc->m_leftHandSide;
 
+	// the first rows are the normals of the contact points, in the same order
+	const ndInt32 pointCount = m_contacPointsList.GetCount();
 	for (ndInt32 k = 0; k < count; ++k) 
 	{
 		// note: using restitution been negative to indicate that the acceleration was override
@@ -358,6 +444,12 @@ void ndContact::JointAccelerations(ndJointAccelerationDecriptor* const desc)
 					}
 					penetrationVeloc = -(rhs->m_penetration * rhs->m_penetrationStiffness);
 				}
+				else if ((k < pointCount) && m_contacPointsList[k].m_speculative)
+				{
+					// speculative contact, the bodies can still approach by the gap this step
+					restitution = ndFloat32(1.0f);
+					penetrationVeloc = -(rhs->m_penetration * rhs->m_penetrationStiffness);
+				}
 				vRel = vRel * restitution + penetrationVeloc;
 			}
 		
@@ -32,6 +32,8 @@ class ndShapeInstance;
 
 #define D_MAX_CONTATCS					128
 #define D_CONSTRAINT_MAX_ROWS			(3 * 16)
+#define D_MAX_CONTACT_POINTS			(D_CONSTRAINT_MAX_ROWS / 3)
+#define D_CONTACT_MATCH_DISTANCE		ndFloat32 (0.05f)
 #define D_RESTING_CONTACT_PENETRATION	(D_PENETRATION_TOL + ndFloat32 (1.0f / 1024.0f))
 
 D_MSV_NEWTON_ALIGN_32
@@ -58,6 +60,7 @@ class ndContactMaterial: public ndContactPoint
 		:m_dir0(ndVector::m_zero)
 		,m_dir1(ndVector::m_zero)
 		,m_material()
+		,m_speculative(false)
 	{
 		m_dir0_Force.Clear();
 		m_dir1_Force.Clear();
@@ -82,16 +85,54 @@ class ndContactMaterial: public ndContactPoint
 	ndForceImpactPair m_dir0_Force;
 	ndForceImpactPair m_dir1_Force;
 	ndMaterial m_material;
+	// the point is not touching yet, the penetration is the negative gap the bodies can close this step
+	bool m_speculative;
 	D_MEMORY_ALIGN_FIXUP
 } D_GCC_NEWTON_ALIGN_32;
 
-class ndContactPointList : public ndList<ndContactMaterial, ndContainersFreeListAlloc<ndContactMaterial>>
+// contact points of a contact joint stored in one contiguous block, so that the jacobian setup 
+// is a linear scan. the block comes from the free list allocator, grows in steps up to the 
+// D_MAX_CONTACT_POINTS the contact solver prunes to, and is kept while the contact lives, so 
+// persistent contacts do not allocate. the nodes keep the interface of the old linked list.
+class ndContactPointList
 {
 	public:
-	ndContactPointList()
-		:ndList<ndContactMaterial, ndContainersFreeListAlloc<ndContactMaterial>>()
+	D_MSV_NEWTON_ALIGN_32
+	class ndNode
 	{
-	}
+		public:
+		ndContactMaterial& GetInfo();
+		const ndContactMaterial& GetInfo() const;
+		ndNode* GetNext() const;
+
+		private:
+		ndContactMaterial m_info;
+		bool m_isLast;
+		friend class ndContactPointList;
+	} D_GCC_NEWTON_ALIGN_32;
+
+	D_COLLISION_API ndContactPointList();
+	D_COLLISION_API ~ndContactPointList();
+
+	ndInt32 GetCount() const;
+	ndNode* GetFirst() const;
+	ndContactMaterial& operator[] (ndInt32 i);
+	const ndContactMaterial& operator[] (ndInt32 i) const;
+
+	D_COLLISION_API ndNode* Append();
+	D_COLLISION_API ndNode* Append(const ndContactMaterial& point);
+	D_COLLISION_API void Remove(ndInt32 index);
+	D_COLLISION_API void Remove(ndNode* const node);
+	D_COLLISION_API void RemoveAll();
+
+	private:
+	ndContactPointList(const ndContactPointList&) = delete;
+	ndContactPointList& operator=(const ndContactPointList&) = delete;
+	void Reserve(ndInt32 capacity);
+
+	ndNode* m_nodes;
+	ndInt32 m_count;
+	ndInt32 m_capacity;
 };
 
 D_MSV_NEWTON_ALIGN_32 
@@ -179,6 +220,45 @@ inline const ndContactPointList& ndContact::GetContactPoints() const
 	return m_contacPointsList;
 }
 
+inline ndContactMaterial& ndContactPointList::ndNode::GetInfo()
+{
+	return m_info;
+}
+
+inline const ndContactMaterial& ndContactPointList::ndNode::GetInfo() const
+{
+	return m_info;
+}
+
+inline ndContactPointList::ndNode* ndContactPointList::ndNode::GetNext() const
+{
+	return m_isLast ? nullptr : (ndNode*)this + 1;
+}
+
+inline ndInt32 ndContactPointList::GetCount() const
+{
+	return m_count;
+}
+
+inline ndContactPointList::ndNode* ndContactPointList::GetFirst() const
+{
+	return m_count ? m_nodes : nullptr;
+}
+
+inline ndContactMaterial& ndContactPointList::operator[] (ndInt32 i)
+{
+	ndAssert(i >= 0);
+	ndAssert(i < m_count);
+	return m_nodes[i].m_info;
+}
+
+inline const ndContactMaterial& ndContactPointList::operator[] (ndInt32 i) const
+{
+	ndAssert(i >= 0);
+	ndAssert(i < m_count);
+	return m_nodes[i].m_info;
+}
+
 inline bool ndContact::IsSkeletonSelftCollision() const
 {
 	return m_skeletonSelftCollision ? true : false;
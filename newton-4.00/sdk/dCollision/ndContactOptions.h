@@ -38,6 +38,7 @@ enum ndContactOptions
 	m_resetSkeletonSelfCollision = 1 << 9,
 	m_resetSkeletonIntraCollision = 1 << 10,
 	m_useBrushTireModel = 1 << 11,
+	m_disableSeparationCache = 1 << 12,
 };
 
 #endif 
@@ -25,6 +25,7 @@
 #include "ndShape.h"
 #include "ndContact.h"
 #include "ndShapePoint.h"
+#include "ndShapeBox.h"
 #include "ndShapeConvex.h"
 #include "ndShapeCompound.h"
 #include "ndBodyKinematic.h"
@@ -32,6 +33,8 @@
 #include "ndPolygonMeshDesc.h"
 #include "ndShapeStatic_bvh.h"
 #include "ndShapeStaticMesh.h"
+#include "ndShapeSphere.h"
+#include "ndShapeCapsule.h"
 #include "ndShapeHeightfield.h"
 #include "ndShapeConvexPolygon.h"
 #include "ndShapeStaticProceduralMesh.h"
@@ -341,6 +344,7 @@ ndContactSolver::ndContactSolver()
 	,m_freeFace(nullptr)
 	,m_notification(nullptr)
 	,m_contactBuffer(nullptr)
+	,m_childPairs(nullptr)
 	,m_timestep(ndFloat32 (0.0f))
 	,m_skinMargin(ndFloat32(0.0f))
 	,m_separationDistance(ndFloat32(0.0f))
@@ -362,6 +366,7 @@ ndContactSolver::ndContactSolver(ndShapeInstance* const instance, ndContactNotif
 	,m_freeFace(nullptr)
 	,m_notification(notification)
 	,m_contactBuffer(nullptr)
+	,m_childPairs(nullptr)
 	,m_timestep(timestep)
 	,m_skinMargin(ndFloat32(0.0f))
 	,m_separationDistance(ndFloat32(0.0f))
@@ -385,6 +390,7 @@ ndContactSolver::ndContactSolver(ndContact* const contact, ndContactNotify* cons
 	,m_freeFace(nullptr)
 	,m_notification(notification)
 	,m_contactBuffer(nullptr)
+	,m_childPairs(nullptr)
 	,m_timestep(timestep)
 	,m_skinMargin(ndFloat32(0.0f))
 	,m_separationDistance(ndFloat32(0.0f))
@@ -408,6 +414,7 @@ ndContactSolver::ndContactSolver(const ndContactSolver& src, const ndShapeInstan
 	,m_freeFace(nullptr)
 	,m_notification(src.m_notification)
 	,m_contactBuffer(src.m_contactBuffer)
+	,m_childPairs(nullptr)
 	,m_timestep(src.m_timestep)
 	,m_skinMargin(src.m_skinMargin)
 	,m_separationDistance(src.m_separationDistance)
@@ -2553,7 +2560,8 @@ ndInt32 ndContactSolver::ConvexToConvexContactsDiscrete()
 	ndAssert(!m_instance1.GetShape()->GetAsShapeNull());
 
 	ndInt32 count = 0;
-	bool colliding = CalculateClosestPoints();
+	const ndInt32 primitiveCount = PrimitiveContactsDiscrete();
+	bool colliding = (primitiveCount >= 0) ? true : CalculateClosestPoints();
 	ndFloat32 penetration = m_separatingVector.DotProduct(m_closestPoint1 - m_closestPoint0).GetScalar() - m_skinMargin - D_PENETRATION_TOL;
 	m_separationDistance = penetration;
 	if (m_intersectionTestOnly)
@@ -2566,7 +2574,7 @@ ndInt32 ndContactSolver::ConvexToConvexContactsDiscrete()
 		{
 			if (ndInt8 (m_instance0.GetCollisionMode()) & ndInt8(m_instance1.GetCollisionMode()))
 			{
-				count = CalculateContacts(m_closestPoint0, m_closestPoint1, m_separatingVector * ndVector::m_negOne);
+				count = (primitiveCount > 0) ? primitiveCount : CalculateContacts(m_closestPoint0, m_closestPoint1, m_separatingVector * ndVector::m_negOne);
 				// skip convex shape polygon because they could have a skirt
 				ndShapeConvexPolygon* const convexPolygon = m_instance1.GetShape()->GetAsShapeConvexPolygon();
 				if (!(count || convexPolygon))
@@ -2626,6 +2634,8 @@ ndInt32 ndContactSolver::ConvexToConvexContactsDiscrete()
 				contactOut[i].m_body1 = body1;
 				contactOut[i].m_shapeInstance0 = instance0;
 				contactOut[i].m_shapeInstance1 = instance1;
+				contactOut[i].m_shapeId0 = 0;
+				contactOut[i].m_shapeId1 = 0;
 				contactOut[i].m_penetration = -penetration;
 			}
 		}
@@ -2635,6 +2645,344 @@ ndInt32 ndContactSolver::ConvexToConvexContactsDiscrete()
 	return count;
 }
 
+//*************************************************************
+// closed form contacts for the primitive pairs that dominate 
+// most scenes. every function returns -1 when the pair has to 
+// go through the general closest simplex path.
+//*************************************************************
+ndInt32 ndContactSolver::PrimitiveContactsDiscrete()
+{
+	if ((m_instance0.m_scaleType > ndShapeInstance::m_uniform) || (m_instance1.m_scaleType > ndShapeInstance::m_uniform))
+	{
+		return -1;
+	}
+
+	ndShape* const shape0 = m_instance0.GetShape();
+	ndShape* const shape1 = m_instance1.GetShape();
+	const ndShapeSphere* const sphere0 = shape0->GetAsShapeSphere();
+	const ndShapeSphere* const sphere1 = shape1->GetAsShapeSphere();
+	const ndShapeCapsule* const capsule0 = shape0->GetAsShapeCapsule();
+	const ndShapeCapsule* const capsule1 = shape1->GetAsShapeCapsule();
+
+	if (sphere0 && sphere1)
+	{
+		const ndFloat32 radius0 = sphere0->m_radius * m_instance0.m_scale.m_x;
+		const ndFloat32 radius1 = sphere1->m_radius * m_instance1.m_scale.m_x;
+		return RoundedCoresContactsDiscrete(m_instance0.m_globalMatrix.m_posit, radius0, m_instance1.m_globalMatrix.m_posit, radius1);
+	}
+	else if ((sphere0 && capsule1) || (capsule0 && sphere1))
+	{
+		const ndShapeInstance& sphereInstance = sphere0 ? m_instance0 : m_instance1;
+		const ndShapeInstance& capsuleInstance = sphere0 ? m_instance1 : m_instance0;
+		const ndShapeCapsule* const capsule = sphere0 ? capsule1 : capsule0;
+		if (capsule->m_radius0 != capsule->m_radius1)
+		{
+			return -1;
+		}
+		const ndFloat32 sphereRadius = (sphere0 ? sphere0 : sphere1)->m_radius * sphereInstance.m_scale.m_x;
+		const ndFloat32 capsuleRadius = capsule->m_radius0 * capsuleInstance.m_scale.m_x;
+		const ndVector center(sphereInstance.m_globalMatrix.m_posit);
+
+		const ndMatrix& matrix = capsuleInstance.m_globalMatrix;
+		const ndVector p0(matrix.m_posit - matrix.m_front.Scale(capsule->m_height * capsuleInstance.m_scale.m_x));
+		const ndVector p10(matrix.m_front.Scale(ndFloat32(2.0f) * capsule->m_height * capsuleInstance.m_scale.m_x));
+		const ndFloat32 param = ndClamp(p10.DotProduct(center - p0).GetScalar() / p10.DotProduct(p10).GetScalar(), ndFloat32(0.0f), ndFloat32(1.0f));
+		const ndVector core(p0 + p10.Scale(param));
+		return sphere0 ? 
+			RoundedCoresContactsDiscrete(center, sphereRadius, core, capsuleRadius) : 
+			RoundedCoresContactsDiscrete(core, capsuleRadius, center, sphereRadius);
+	}
+	else if (capsule0 && capsule1)
+	{
+		return CapsuleToCapsuleContactsDiscrete();
+	}
+	else if (shape0->GetAsShapeBox())
+	{
+		if (shape1->GetAsShapeBox())
+		{
+			return BoxToBoxContactsDiscrete();
+		}
+		else if (sphere1)
+		{
+			return SphereToBoxContactsDiscrete(false);
+		}
+	}
+	else if (sphere0 && shape1->GetAsShapeBox())
+	{
+		return SphereToBoxContactsDiscrete(true);
+	}
+	return -1;
+}
+
+ndInt32 ndContactSolver::RoundedCoresContactsDiscrete(const ndVector& core0, ndFloat32 radius0, const ndVector& core1, ndFloat32 radius1)
+{
+	// two shapes made of a core point swept by a radius, the closest 
+	// points are along the line that join the cores.
+	const ndVector dir((core1 - core0) & ndVector::m_triplexMask);
+	const ndFloat32 dist2 = dir.DotProduct(dir).GetScalar();
+	if (dist2 < ndFloat32(1.0e-12f))
+	{
+		return -1;
+	}
+
+	m_separatingVector = dir.Scale(ndRsqrt(dist2));
+	m_closestPoint0 = core0 + m_separatingVector.Scale(radius0);
+	m_closestPoint1 = core1 - m_separatingVector.Scale(radius1);
+	m_buffer[0] = ndVector::m_half * (m_closestPoint0 + m_closestPoint1);
+	return 1;
+}
+
+ndInt32 ndContactSolver::SphereToBoxContactsDiscrete(bool sphereIsShape0)
+{
+	const ndShapeInstance& sphereInstance = sphereIsShape0 ? m_instance0 : m_instance1;
+	const ndShapeInstance& boxInstance = sphereIsShape0 ? m_instance1 : m_instance0;
+	const ndShapeSphere* const sphere = ((ndShape*)sphereInstance.GetShape())->GetAsShapeSphere();
+	const ndShapeBox* const box = ((ndShape*)boxInstance.GetShape())->GetAsShapeBox();
+
+	const ndMatrix& matrix = boxInstance.m_globalMatrix;
+	const ndFloat32 radius = sphere->m_radius * sphereInstance.m_scale.m_x;
+	const ndVector size(box->m_size[0].Scale(boxInstance.m_scale.m_x) & ndVector::m_triplexMask);
+	const ndVector center(sphereInstance.m_globalMatrix.m_posit);
+
+	const ndVector localCenter(matrix.UntransformVector(center) & ndVector::m_triplexMask);
+	ndVector boxPoint(localCenter.GetMax(size * ndVector::m_negOne).GetMin(size));
+	const ndVector diff(localCenter - boxPoint);
+	const ndFloat32 dist2 = diff.DotProduct(diff).GetScalar();
+
+	ndVector localNormal;
+	if (dist2 > ndFloat32(1.0e-12f))
+	{
+		localNormal = diff.Scale(ndRsqrt(dist2));
+	}
+	else
+	{
+		// the center is inside the box, push out along the closest face
+		const ndVector depth(size - localCenter.Abs());
+		ndInt32 index = (depth.m_y < depth.m_x) ? 1 : 0;
+		index = (depth.m_z < depth[index]) ? 2 : index;
+		const ndFloat32 side = (localCenter[index] < ndFloat32(0.0f)) ? ndFloat32(-1.0f) : ndFloat32(1.0f);
+
+		localNormal = ndVector::m_zero;
+		localNormal[index] = side;
+		boxPoint[index] = side * size[index];
+	}
+
+	const ndVector normal(matrix.RotateVector(localNormal));
+	const ndVector pointOnBox(matrix.TransformVector(boxPoint | ndVector::m_wOne));
+	const ndVector pointOnSphere(center - normal.Scale(radius));
+	if (sphereIsShape0)
+	{
+		m_separatingVector = normal * ndVector::m_negOne;
+		m_closestPoint0 = pointOnSphere;
+		m_closestPoint1 = pointOnBox;
+	}
+	else
+	{
+		m_separatingVector = normal;
+		m_closestPoint0 = pointOnBox;
+		m_closestPoint1 = pointOnSphere;
+	}
+	m_buffer[0] = ndVector::m_half * (pointOnBox + pointOnSphere);
+	return 1;
+}
+
+ndInt32 ndContactSolver::CapsuleToCapsuleContactsDiscrete()
+{
+	const ndShapeCapsule* const capsule0 = m_instance0.GetShape()->GetAsShapeCapsule();
+	const ndShapeCapsule* const capsule1 = m_instance1.GetShape()->GetAsShapeCapsule();
+	if ((capsule0->m_radius0 != capsule0->m_radius1) || (capsule1->m_radius0 != capsule1->m_radius1))
+	{
+		return -1;
+	}
+
+	const ndMatrix& matrix0 = m_instance0.m_globalMatrix;
+	const ndMatrix& matrix1 = m_instance1.m_globalMatrix;
+	const ndFloat32 radius0 = capsule0->m_radius0 * m_instance0.m_scale.m_x;
+	const ndFloat32 radius1 = capsule1->m_radius0 * m_instance1.m_scale.m_x;
+	const ndFloat32 height0 = capsule0->m_height * m_instance0.m_scale.m_x;
+	const ndFloat32 height1 = capsule1->m_height * m_instance1.m_scale.m_x;
+
+	const ndVector p0(matrix0.m_posit - matrix0.m_front.Scale(height0));
+	const ndVector p1(matrix0.m_posit + matrix0.m_front.Scale(height0));
+	const ndVector q0(matrix1.m_posit - matrix1.m_front.Scale(height1));
+	const ndVector q1(matrix1.m_posit + matrix1.m_front.Scale(height1));
+
+	const ndFastRay ray(p0, p1);
+	const ndRay closest(ray.RayDistance(q0, q1));
+	const ndInt32 count = RoundedCoresContactsDiscrete(closest.m_p0 | ndVector::m_wOne, radius0, closest.m_p1 | ndVector::m_wOne, radius1);
+	const ndFloat32 dot = matrix0.m_front.DotProduct(matrix1.m_front).GetScalar();
+	if ((count < 0) || (ndAbs(dot) < ndFloat32(0.998f)))
+	{
+		return count;
+	}
+
+	// the segments are parallel, the contacts are the ends of the overlapping interval
+	const ndVector& dir = matrix0.m_front;
+	ndFloat32 ql0 = dir.DotProduct(q0 - p0).GetScalar();
+	ndFloat32 ql1 = dir.DotProduct(q1 - p0).GetScalar();
+	if (ql0 > ql1)
+	{
+		ndSwap(ql0, ql1);
+	}
+	const ndFloat32 clip0 = ndMax(ql0, ndFloat32(0.0f));
+	const ndFloat32 clip1 = ndMin(ql1, ndFloat32(2.0f) * height0);
+	if ((clip1 - clip0) < D_PENETRATION_TOL)
+	{
+		return count;
+	}
+
+	const ndFloat32 dist = m_separatingVector.DotProduct(closest.m_p1 - closest.m_p0).GetScalar();
+	const ndVector step(m_separatingVector.Scale(ndFloat32(0.5f) * (radius0 + dist - radius1)));
+	m_buffer[0] = p0 + dir.Scale(clip0) + step;
+	m_buffer[1] = p0 + dir.Scale(clip1) + step;
+	return 2;
+}
+
+ndInt32 ndContactSolver::BoxToBoxContactsDiscrete()
+{
+	// separating axis test, the result is the axis of least penetration.
+	// the contact manifold is then clipped from the faces along that axis.
+	const ndShapeBox* const box0 = m_instance0.GetShape()->GetAsShapeBox();
+	const ndShapeBox* const box1 = m_instance1.GetShape()->GetAsShapeBox();
+	const ndMatrix& matrix0 = m_instance0.m_globalMatrix;
+	const ndMatrix& matrix1 = m_instance1.m_globalMatrix;
+	const ndVector size0(box0->m_size[0].Scale(m_instance0.m_scale.m_x) & ndVector::m_triplexMask);
+	const ndVector size1(box1->m_size[0].Scale(m_instance1.m_scale.m_x) & ndVector::m_triplexMask);
+	const ndVector offset((matrix1.m_posit - matrix0.m_posit) & ndVector::m_triplexMask);
+
+	ndVector axis[15];
+	ndInt32 axisCount = 0;
+	for (ndInt32 i = 0; i < 3; ++i)
+	{
+		axis[axisCount++] = matrix0[i] & ndVector::m_triplexMask;
+		axis[axisCount++] = matrix1[i] & ndVector::m_triplexMask;
+	}
+	const ndInt32 faceAxisCount = axisCount;
+	for (ndInt32 i = 0; i < 3; ++i)
+	{
+		for (ndInt32 j = 0; j < 3; ++j)
+		{
+			const ndVector edgeAxis(matrix0[i].CrossProduct(matrix1[j]));
+			const ndFloat32 mag2 = edgeAxis.DotProduct(edgeAxis).GetScalar();
+			if (mag2 > ndFloat32(1.0e-5f))
+			{
+				axis[axisCount++] = edgeAxis.Scale(ndRsqrt(mag2));
+			}
+		}
+	}
+
+	ndInt32 bestAxis = 0;
+	ndFloat32 bestSeparation = ndFloat32(-1.0e20f);
+	for (ndInt32 i = 0; i < axisCount; ++i)
+	{
+		const ndFloat32 radius0 = size0.DotProduct(matrix0.UnrotateVector(axis[i]).Abs()).GetScalar();
+		const ndFloat32 radius1 = size1.DotProduct(matrix1.UnrotateVector(axis[i]).Abs()).GetScalar();
+		const ndFloat32 separation = ndAbs(offset.DotProduct(axis[i]).GetScalar()) - radius0 - radius1;
+		// bias toward face axes to keep the manifold stable on resting contacts
+		const ndFloat32 bias = (i < faceAxisCount) ? ndFloat32(0.0f) : D_PENETRATION_TOL;
+		if (separation > (bestSeparation + bias))
+		{
+			bestAxis = i;
+			bestSeparation = separation;
+		}
+	}
+
+	if ((bestSeparation > ndFloat32(0.0f)) && ((bestSeparation - m_skinMargin - D_PENETRATION_TOL) <= ndFloat32(1.0e-5f)))
+	{
+		// separated by less than the skin, the separating axis is 
+		// only a lower bound, let the closest simplex get the exact distance.
+		return -1;
+	}
+
+	const ndVector& normal = axis[bestAxis];
+	m_separatingVector = (offset.DotProduct(normal).GetScalar() < ndFloat32(0.0f)) ? normal * ndVector::m_negOne : normal;
+
+	const ndVector dir0(matrix0.UnrotateVector(m_separatingVector));
+	const ndVector dir1(matrix1.UnrotateVector(m_separatingVector));
+	const ndVector support0(size0.Select(size0 * ndVector::m_negOne, dir0 < ndVector::m_zero));
+	const ndVector support1(size1.Select(size1 * ndVector::m_negOne, dir1 > ndVector::m_zero));
+	m_closestPoint0 = matrix0.TransformVector(support0 | ndVector::m_wOne);
+	m_closestPoint1 = matrix1.TransformVector(support1 | ndVector::m_wOne);
+	return 0;
+}
+
+ndInt32 ndContactSolver::PrimitiveToPolygonContactsDiscrete(const ndShapeConvexPolygon* const polygon)
+{
+	// spheres and capsules whose core projects inside the face touch it on 
+	// the face plane. anything closer to an edge goes through the skirted 
+	// polygon of the general path so that internal edges stay smooth.
+	if (m_intersectionTestOnly || (m_instance0.m_scaleType > ndShapeInstance::m_uniform))
+	{
+		return -1;
+	}
+
+	ndVector cores[2];
+	ndInt32 coreCount = 0;
+	ndFloat32 radius = ndFloat32(0.0f);
+	ndShape* const shape = m_instance0.GetShape();
+	const ndMatrix& matrix = m_instance0.m_globalMatrix;
+	if (const ndShapeSphere* const sphere = shape->GetAsShapeSphere())
+	{
+		radius = sphere->m_radius * m_instance0.m_scale.m_x;
+		cores[coreCount++] = matrix.m_posit;
+	}
+	else if (const ndShapeCapsule* const capsule = shape->GetAsShapeCapsule())
+	{
+		if (capsule->m_radius0 != capsule->m_radius1)
+		{
+			return -1;
+		}
+		radius = capsule->m_radius0 * m_instance0.m_scale.m_x;
+		const ndVector step(matrix.m_front.Scale(capsule->m_height * m_instance0.m_scale.m_x));
+		cores[coreCount++] = matrix.m_posit - step;
+		cores[coreCount++] = matrix.m_posit + step;
+	}
+	else
+	{
+		return -1;
+	}
+
+	const ndVector& normal = polygon->m_normal;
+	for (ndInt32 j = 0; j < coreCount; ++j)
+	{
+		ndInt32 i0 = polygon->m_count - 1;
+		for (ndInt32 i = 0; i < polygon->m_count; ++i)
+		{
+			const ndVector edgeBoundaryNormal(normal.CrossProduct(polygon->m_localPoly[i] - polygon->m_localPoly[i0]));
+			if (edgeBoundaryNormal.DotProduct(cores[j] - polygon->m_localPoly[i0]).GetScalar() < ndFloat32(0.0f))
+			{
+				return -1;
+			}
+			i0 = i;
+		}
+	}
+
+	ndInt32 count = 0;
+	ndFloat32 maxPenetration = ndFloat32(-1.0e10f);
+	ndContactPoint* const contactsOut = m_contactBuffer;
+	for (ndInt32 j = 0; j < coreCount; ++j)
+	{
+		const ndFloat32 dist = normal.DotProduct(cores[j] - polygon->m_localPoly[0]).GetScalar();
+		const ndFloat32 penetration = radius - dist + m_skinMargin;
+		if (penetration > maxPenetration)
+		{
+			maxPenetration = penetration;
+			m_closestPoint0 = cores[j] - normal.Scale(radius);
+			m_closestPoint1 = m_closestPoint0 + normal.Scale(penetration);
+		}
+		if (penetration >= -(D_PENETRATION_TOL * ndFloat32(5.0f)))
+		{
+			contactsOut[count].m_point = cores[j] - normal.Scale(ndFloat32(0.5f) * (radius + dist));
+			contactsOut[count].m_normal = normal;
+			contactsOut[count].m_penetration = ndMax(ndFloat32(0.0f), penetration);
+			count++;
+		}
+	}
+	m_separatingVector = normal;
+	m_separationDistance = -maxPenetration;
+	return count;
+}
+
 ndInt32 ndContactSolver::CompoundContactsDiscrete()
 {
 	ndShape* const shape0 = m_instance0.GetShape();
@@ -2932,7 +3280,6 @@ ndInt32 ndContactSolver::CompoundToConvexContactsDiscrete()
 ndInt32 ndContactSolver::CompoundToCompoundContactsDiscrete()
 {
 	ndContact* const contactJoint = m_contact;
-	ndContactPoint* const contacts = m_contactBuffer;
 	ndBodyKinematic* const compoundBody0 = contactJoint->GetBody0();
 	ndBodyKinematic* const compoundBody1 = contactJoint->GetBody1();
 	ndShapeInstance* const compoundInstance0 = &compoundBody0->GetCollisionShape();
@@ -2980,28 +3327,17 @@ ndInt32 ndContactSolver::CompoundToCompoundContactsDiscrete()
 			if (ndInt8(subShape0->GetCollisionMode()) & ndInt8(subShape1->GetCollisionMode()))
 			{
 				bool processContacts = m_notification->OnCompoundSubShapeOverlap(contactJoint, m_timestep, subShape0, subShape1);
-				if (processContacts)
+				if (processContacts && m_childPairs)
 				{
-					ndShapeInstance childInstance0(*subShape0, subShape0->GetShape());
-					ndShapeInstance childInstance1(*subShape1, subShape1->GetShape());
-					childInstance0.m_globalMatrix = childInstance0.GetLocalMatrix() * matrix0;
-					childInstance1.m_globalMatrix = childInstance1.GetLocalMatrix() * matrix1;
-
-					ndContactSolver contactSolver(*this, childInstance0, childInstance1);
-					contactSolver.m_pruneContacts = 0;
-					contactSolver.m_maxCount = D_MAX_CONTATCS - contactCount;
-					contactSolver.m_contactBuffer += contactCount;
-
-					ndInt32 count = contactSolver.ConvexContactsDiscrete();
-					ndFloat32 dist = ndMax(contactSolver.m_separationDistance, ndFloat32(0.0f));
+					AddCompoundChildPair(subShape0, subShape1, nullptr);
+				}
+				else if (processContacts)
+				{
+					ndFloat32 dist;
+					ndInt32 count = CompoundChildContactsDiscrete(subShape0, subShape1, nullptr, contactCount, dist);
 					closestDist = ndMin(closestDist, dist * dist);
 					if (!m_intersectionTestOnly)
 					{
-						for (ndInt32 i = 0; i < count; ++i)
-						{
-							contacts[contactCount + i].m_shapeInstance0 = subShape0;
-							contacts[contactCount + i].m_shapeInstance1 = subShape1;
-						}
 						contactCount += count;
 						if (contactCount > (D_MAX_CONTATCS - 2 * (D_CONSTRAINT_MAX_ROWS / 3)))
 						{
@@ -3084,7 +3420,6 @@ ndInt32 ndContactSolver::CompoundToCompoundContactsDiscrete()
 ndInt32 ndContactSolver::CompoundToShapeStaticBvhContactsDiscrete()
 {
 	ndContact* const contactJoint = m_contact;
-	ndContactPoint* const contacts = m_contactBuffer;
 	ndBodyKinematic* const compoundBody = contactJoint->GetBody0();
 	ndBodyKinematic* const bvhTreeBody = contactJoint->GetBody1();
 	ndShapeInstance* const compoundInstance = &compoundBody->GetCollisionShape();
@@ -3140,25 +3475,17 @@ ndInt32 ndContactSolver::CompoundToShapeStaticBvhContactsDiscrete()
 			if (subShape->GetCollisionMode())
 			{
 				bool processContacts = m_notification->OnCompoundSubShapeOverlap(contactJoint, m_timestep, subShape, bvhTreeInstance);
-				if (processContacts)
+				if (processContacts && m_childPairs)
 				{
-					ndShapeInstance childInstance(*subShape, subShape->GetShape());
-					childInstance.m_globalMatrix = childInstance.GetLocalMatrix() * compoundMatrix;
-
-					ndContactSolver contactSolver(*this, childInstance, m_instance1);
-					contactSolver.m_pruneContacts = 0;
-					contactSolver.m_maxCount = D_MAX_CONTATCS - contactCount;
-					contactSolver.m_contactBuffer += contactCount;
-
-					ndInt32 count = contactSolver.ConvexToSaticStaticBvhContactsNodeDescrete(collisionTreeNode);
-					ndFloat32 dist = ndMax(contactSolver.m_separationDistance, ndFloat32(0.0f));
+					AddCompoundChildPair(subShape, nullptr, collisionTreeNode);
+				}
+				else if (processContacts)
+				{
+					ndFloat32 dist;
+					ndInt32 count = CompoundChildContactsDiscrete(subShape, nullptr, collisionTreeNode, contactCount, dist);
 					closestDist = ndMin(closestDist, dist * dist);
 					if (!m_intersectionTestOnly)
 					{
-						for (ndInt32 i = 0; i < count; ++i)
-						{
-							contacts[contactCount + i].m_shapeInstance0 = subShape;
-						}
 						contactCount += count;
 						if (contactCount > (D_MAX_CONTATCS - 2 * (D_CONSTRAINT_MAX_ROWS / 3)))
 						{
@@ -3260,6 +3587,65 @@ ndInt32 ndContactSolver::CompoundToShapeStaticBvhContactsDiscrete()
 	return contactCount;
 }
 
+void ndContactSolver::AddCompoundChildPair(ndShapeInstance* const subShape0, ndShapeInstance* const subShape1, const ndAabbPolygonSoup::ndNode* const treeNode)
+{
+	ndCompoundChildPair pair;
+	pair.m_subShape0 = subShape0;
+	pair.m_subShape1 = subShape1;
+	pair.m_treeNode = treeNode;
+	pair.m_separationDistance = ndFloat32(0.0f);
+	pair.m_contactStart = 0;
+	pair.m_contactCount = 0;
+	pair.m_threadIndex = m_threadId;
+	m_childPairs->PushBack(pair);
+}
+
+ndInt32 ndContactSolver::CompoundChildContactsDiscrete(ndShapeInstance* const subShape0, ndShapeInstance* const subShape1, const ndAabbPolygonSoup::ndNode* const treeNode, ndInt32 contactCount, ndFloat32& separationDistance)
+{
+	// contacts of one leaf pair of a compound pair, the other leaf is either 
+	// a sub shape of a second compound or a node of a static bvh mesh.
+	ndContactPoint* const contacts = m_contactBuffer + contactCount;
+	const ndMatrix& matrix0 = m_contact->GetBody0()->GetCollisionShape().GetGlobalMatrix();
+	ndShapeInstance childInstance0(*subShape0, subShape0->GetShape());
+	childInstance0.m_globalMatrix = childInstance0.GetLocalMatrix() * matrix0;
+
+	ndInt32 count = 0;
+	if (subShape1)
+	{
+		ndAssert(!treeNode);
+		const ndMatrix& matrix1 = m_contact->GetBody1()->GetCollisionShape().GetGlobalMatrix();
+		ndShapeInstance childInstance1(*subShape1, subShape1->GetShape());
+		childInstance1.m_globalMatrix = childInstance1.GetLocalMatrix() * matrix1;
+
+		ndContactSolver contactSolver(*this, childInstance0, childInstance1);
+		contactSolver.m_pruneContacts = 0;
+		contactSolver.m_maxCount = D_MAX_CONTATCS - contactCount;
+		contactSolver.m_contactBuffer = contacts;
+		count = contactSolver.ConvexContactsDiscrete();
+		separationDistance = ndMax(contactSolver.m_separationDistance, ndFloat32(0.0f));
+		for (ndInt32 i = 0; i < count; ++i)
+		{
+			contacts[i].m_shapeInstance0 = subShape0;
+			contacts[i].m_shapeInstance1 = subShape1;
+		}
+	}
+	else
+	{
+		ndAssert(treeNode);
+		ndContactSolver contactSolver(*this, childInstance0, m_instance1);
+		contactSolver.m_pruneContacts = 0;
+		contactSolver.m_maxCount = D_MAX_CONTATCS - contactCount;
+		contactSolver.m_contactBuffer = contacts;
+		count = contactSolver.ConvexToSaticStaticBvhContactsNodeDescrete(treeNode);
+		separationDistance = ndMax(contactSolver.m_separationDistance, ndFloat32(0.0f));
+		for (ndInt32 i = 0; i < count; ++i)
+		{
+			contacts[i].m_shapeInstance0 = subShape0;
+		}
+	}
+	return count;
+}
+
 ndInt32 ndContactSolver::CompoundToStaticHeightfieldContactsDiscrete()
 {
 	ndContact* const contactJoint = m_contact;
@@ -30,6 +30,7 @@ class ndPlane;
 class ndBodyKinematic;
 class ndContactNotify;
 class ndPolygonMeshDesc;
+class ndShapeConvexPolygon;
 
 //D_MSV_NEWTON_ALIGN_32
 class ndMinkFace
@@ -62,6 +63,19 @@ class ndContactSolver: public ndDownHeap<ndMinkFace *, ndFloat32>
 	public: 
 	class ndBoxBoxDistance2;
 
+	// a pair of overlapping leaves of a compound pair, with the contacts it generated
+	class ndCompoundChildPair
+	{
+		public:
+		ndShapeInstance* m_subShape0;
+		ndShapeInstance* m_subShape1;
+		const ndAabbPolygonSoup::ndNode* m_treeNode;
+		ndFloat32 m_separationDistance;
+		ndInt32 m_contactStart;
+		ndInt32 m_contactCount;
+		ndInt32 m_threadIndex;
+	};
+
 	D_COLLISION_API ndContactSolver();
 	~ndContactSolver() {}
 
@@ -91,6 +105,15 @@ class ndContactSolver: public ndDownHeap<ndMinkFace *, ndFloat32>
 	ndInt32 CompoundToStaticHeightfieldContactsDiscrete(); // done
 	ndInt32 CalculatePolySoupToHullContactsDescrete(ndPolygonMeshDesc& data); // done
 	ndInt32 ConvexToSaticStaticBvhContactsNodeDescrete(const ndAabbPolygonSoup::ndNode* const node); // done
+	ndInt32 CompoundChildContactsDiscrete(ndShapeInstance* const subShape0, ndShapeInstance* const subShape1, const ndAabbPolygonSoup::ndNode* const treeNode, ndInt32 contactCount, ndFloat32& separationDistance);
+	void AddCompoundChildPair(ndShapeInstance* const subShape0, ndShapeInstance* const subShape1, const ndAabbPolygonSoup::ndNode* const treeNode);
+
+	ndInt32 PrimitiveContactsDiscrete();
+	ndInt32 BoxToBoxContactsDiscrete();
+	ndInt32 SphereToBoxContactsDiscrete(bool sphereIsShape0);
+	ndInt32 CapsuleToCapsuleContactsDiscrete();
+	ndInt32 RoundedCoresContactsDiscrete(const ndVector& core0, ndFloat32 radius0, const ndVector& core1, ndFloat32 radius1);
+	ndInt32 PrimitiveToPolygonContactsDiscrete(const ndShapeConvexPolygon* const polygon);
 
 	ndInt32 ConvexContactsContinue(); // done
 	ndInt32 CompoundContactsContinue(); // done
@@ -157,6 +180,7 @@ class ndContactSolver: public ndDownHeap<ndMinkFace *, ndFloat32>
 	dgFaceFreeList* m_freeFace;
 	ndContactNotify* m_notification;
 	ndContactPoint* m_contactBuffer;
+	ndArray<ndCompoundChildPair>* m_childPairs;
 	ndFloat32 m_timestep;
 	ndFloat32 m_skinMargin;
 	ndFloat32 m_separationDistance;
@@ -27,27 +27,36 @@
 #include "ndShapeInstance.h"
 #include "ndConvexCastNotify.h"
 
+void ndConvexCastNotify::SetCastingBody(ndBodyKinematic& castingBody, const ndShapeInstance& castingInstance, const ndMatrix& globalOrigin, const ndVector& globalDest)
+{
+	castingBody.SetCollisionShape(castingInstance);
+	castingBody.SetMatrix(globalOrigin);
+	castingBody.SetMassMatrix(ndVector::m_one);
+	castingBody.SetVelocity(globalDest - globalOrigin.m_posit);
+
+	ndShapeInstance& shape0 = castingBody.GetCollisionShape();
+	shape0.SetGlobalMatrix(shape0.GetLocalMatrix() * castingBody.GetMatrix());
+}
+
 bool ndConvexCastNotify::CastShape(const ndShapeInstance& castingInstance, const ndMatrix& globalOrigin, const ndVector& globalDest, ndBodyKinematic* const targetBody)
+{
+	ndBodyKinematic body0;
+	SetCastingBody(body0, castingInstance, globalOrigin, globalDest);
+	return CastShape(castingInstance, &body0, targetBody, 0);
+}
+
+bool ndConvexCastNotify::CastShape(const ndShapeInstance& castingInstance, ndBodyKinematic* const castingBody, ndBodyKinematic* const targetBody, ndInt32 threadIndex)
 {
 	ndAssert(m_cachedScene);
 	ndContact contactJoint;
-	ndBodyKinematic body0;
 	ndContactNotify notify(m_cachedScene);
 	ndFixSizeArray<ndContactPoint, D_MAX_CONTATCS> contactBuffer;
 	contactBuffer.SetCount(D_MAX_CONTATCS);
 	
-	body0.SetCollisionShape(castingInstance);
-	body0.SetMatrix(globalOrigin);
-	body0.SetMassMatrix(ndVector::m_one);
-	body0.SetVelocity(globalDest - globalOrigin.m_posit);
-	
-	contactJoint.SetBodies(&body0, targetBody);
-	
-	ndShapeInstance& shape0 = body0.GetCollisionShape();
-	shape0.SetGlobalMatrix(shape0.GetLocalMatrix() * body0.GetMatrix());
+	contactJoint.SetBodies(castingBody, targetBody);
 	
 	m_contacts.SetCount(0);
-	ndContactSolver contactSolver(&contactJoint, &notify, ndFloat32(1.0f), 0);
+	ndContactSolver contactSolver(&contactJoint, &notify, ndFloat32(1.0f), threadIndex);
 	contactSolver.m_contactBuffer = &contactBuffer[0];
 	
 	m_param = ndFloat32(1.2f);
@@ -75,6 +75,11 @@ class ndConvexCastNotify : public ndClassAlloc
 
 	D_COLLISION_API bool CastShape(const ndShapeInstance& castingInstance, const ndMatrix& globalOrigin, const ndVector& globalDest, ndBodyKinematic* const targetBody);
 	D_COLLISION_API bool CastShape(const ndShapeInstance& castingInstance, const ndMatrix& globalOrigin, const ndVector& globalDest, const ndShapeInstance& targetShape, const ndMatrix& targetMatrix);
+
+	// cast a proxy body set by SetCastingBody, so that a query against many targets builds it only once.
+	// threadIndex selects the scene scratch used by the static mesh queries.
+	D_COLLISION_API static void SetCastingBody(ndBodyKinematic& castingBody, const ndShapeInstance& castingInstance, const ndMatrix& globalOrigin, const ndVector& globalDest);
+	D_COLLISION_API bool CastShape(const ndShapeInstance& castingInstance, ndBodyKinematic* const castingBody, ndBodyKinematic* const targetBody, ndInt32 threadIndex);
 	
 	ndVector m_normal;
 	ndVector m_closestPoint0;
@@ -86,4 +91,15 @@ class ndConvexCastNotify : public ndClassAlloc
 	D_MEMORY_ALIGN_FIXUP
 } D_GCC_NEWTON_ALIGN_32;
 
+// closest contact of one shape of a batched convex cast, m_body is null when the shape reached its destination
+D_MSV_NEWTON_ALIGN_32
+class ndConvexCastHit
+{
+	public:
+	ndVector m_point;
+	ndVector m_normal;
+	const ndBodyKinematic* m_body;
+	ndFloat32 m_param;
+} D_GCC_NEWTON_ALIGN_32;
+
 #endif
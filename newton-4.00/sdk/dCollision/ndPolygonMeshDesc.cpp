@@ -68,8 +68,9 @@ ndPolygonMeshDesc::ndPolygonMeshDesc(ndContactSolver& proxy, bool ccdMode)
 	//}
 
 	ndScene* const scene = proxy.m_notification->m_scene;
-	m_staticMeshQuery = &scene->m_staticMeshQuery[proxy.m_threadId];
-	m_proceduralStaticMeshFaceQuery = &scene->m_proceduralStaticMeshQuery[proxy.m_threadId];
+	ndScene::ndThreadLocalData* const threadData = scene->m_threadLocalData[proxy.m_threadId];
+	m_staticMeshQuery = &threadData->m_staticMeshQuery;
+	m_proceduralStaticMeshFaceQuery = &threadData->m_proceduralStaticMeshQuery;
 	Init();
 }
 
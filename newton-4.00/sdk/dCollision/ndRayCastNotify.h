@@ -54,6 +54,18 @@ class ndRayCastNotify : public ndClassAlloc
 	D_MEMORY_ALIGN_FIXUP
 } D_GCC_NEWTON_ALIGN_32;
 
+// closest hit of one ray of a batched ray cast, m_body is null when the ray missed
+D_MSV_NEWTON_ALIGN_32
+class ndRayCastHit
+{
+	public:
+	ndVector m_point;
+	ndVector m_normal;
+	const ndBodyKinematic* m_body;
+	ndInt64 m_shapeId;
+	ndFloat32 m_param;
+} D_GCC_NEWTON_ALIGN_32;
+
 D_MSV_NEWTON_ALIGN_32
 class ndRayCastClosestHitCallback: public ndRayCastNotify
 {
@@ -40,6 +40,9 @@
 
 #define D_CONTACT_DELAY_FRAMES		4
 #define D_NARROW_PHASE_DIST			ndFloat32 (0.2f)
+#define D_SEPARATION_CACHE_DIST		ndFloat32 (1.0f / 64.0f)
+#define D_COMPOUND_SPLIT_CHILDREN	32
+#define D_COMPOUND_CHILD_BATCH		8
 #define D_CONTACT_TRANSLATION_ERROR	ndFloat32 (1.0e-3f)
 #define D_CONTACT_ANGULAR_ERROR		(ndFloat32 (0.25f * ndDegreeToRad))
 
@@ -47,35 +50,123 @@ ndVector ndScene::m_velocTol(ndFloat32(1.0e-16f));
 ndVector ndScene::m_angularContactError2(D_CONTACT_ANGULAR_ERROR * D_CONTACT_ANGULAR_ERROR);
 ndVector ndScene::m_linearContactError2(D_CONTACT_TRANSLATION_ERROR * D_CONTACT_TRANSLATION_ERROR);
 
+// entry of the sorted stack of the ray and convex cast queries, either a wide node or a body
+class ndSceneQueryEntry
+{
+	public:
+	const ndBvhWideNode* m_node;
+	ndBodyKinematic* m_body;
+	ndFloat32 m_dist;
+};
+
+// closest hit notify of the batched ray casts, with the per ray material filter
+class ndRayCastBatchNotify : public ndRayCastClosestHitCallback
+{
+	public:
+	ndRayCastBatchNotify(ndUnsigned64 filterMask)
+		:ndRayCastClosestHitCallback()
+		,m_filterMask(filterMask)
+	{
+	}
+
+	ndUnsigned32 OnRayPrecastAction(const ndBody* const body, const ndShapeInstance* const shape)
+	{
+		const ndUnsigned64 userId = ndUnsigned64(shape->m_shapeMaterial.m_userId);
+		if (userId && !(userId & m_filterMask))
+		{
+			return 0;
+		}
+		return ndRayCastClosestHitCallback::OnRayPrecastAction(body, shape);
+	}
+
+	ndUnsigned64 m_filterMask;
+};
+
+// collects the bodies of one query of a batched overlap into the worker scratch
+class ndOverlapBatchNotify : public ndBodiesInAabbNotify
+{
+	public:
+	ndOverlapBatchNotify(ndArray<const ndBody*>& bodies)
+		:ndBodiesInAabbNotify()
+		,m_bodies(bodies)
+	{
+	}
+
+	void Reset()
+	{
+	}
+
+	void OnOverlap(const ndBody* const body)
+	{
+		m_bodies.PushBack(body);
+	}
+
+	ndArray<const ndBody*>& m_bodies;
+};
+
+// closest contact notify of the batched convex casts
+class ndConvexCastBatchNotify : public ndConvexCastNotify
+{
+	public:
+	ndConvexCastBatchNotify()
+		:ndConvexCastNotify()
+	{
+	}
+
+	ndUnsigned32 OnRayPrecastAction(const ndBody* const, const ndShapeInstance* const)
+	{
+		return 1;
+	}
+};
+
+// interleave the low ten bits of x with two zero bits
+static ndUnsigned64 ndMortonSpread(ndUnsigned64 x)
+{
+	x &= 0x3ff;
+	x = (x | (x << 16)) & 0x30000ff;
+	x = (x | (x << 8)) & 0x300f00f;
+	x = (x | (x << 4)) & 0x30c30c3;
+	x = (x | (x << 2)) & 0x9249249;
+	return x;
+}
+
 ndScene::ndScene()
 	:ndThreadPool("newtonWorker")
 	,m_bodyList()
 	,m_particleSetList()
 	,m_contactArray()
 	,m_bvhSceneManager()
-	,m_scratchBuffer(1024 * sizeof (void*))
+	,m_staticBvhSceneManager()
+	,m_frameArena()
 	,m_sceneBodyArray(1024)
 	,m_activeConstraintArray(1024)
 	,m_specialUpdateList()
 	,m_newPairs(1024)
+	,m_continueContactArray(256)
+	,m_compoundContactArray(64)
+	,m_compoundChildBatchArray(256)
+	,m_threadLocalData()
 	,m_lock()
 	,m_rootNode(nullptr)
+	,m_staticRootNode(nullptr)
 	,m_sentinelBody(nullptr)
 	,m_contactNotifyCallback(new ndContactNotify(nullptr))
 	,m_backgroundThread(nullptr)
+	,m_contactScratchArray(nullptr)
 	,m_timestep(ndFloat32 (0.0f))
 	,m_lru(D_CONTACT_DELAY_FRAMES)
 	,m_frameNumber(0)
 	,m_subStepNumber(0)
 	,m_forceBalanceSceneCounter(0)
+	,m_forceBalanceStaticSceneCounter(0)
+	,m_incrementalBvhRefit(false)
+	,m_staticSceneMoved(false)
+	,m_speculativeContacts(false)
 {
 	m_sentinelBody = new ndBodySentinel;
 	m_contactNotifyCallback->m_scene = this;
 
-	for (ndInt32 i = 0; i < D_MAX_THREADS_COUNT; ++i)
-	{
-		m_partialNewPairs[i].Resize(256);
-	}
+	SetThreadCount(GetThreadCount());
 	ndAssert(ndMemory::CheckMemory(this));
 }
 
@@ -85,32 +176,43 @@ ndScene::ndScene(const ndScene& src)
 	,m_particleSetList()
 	,m_contactArray(src.m_contactArray)
 	,m_bvhSceneManager(src.m_bvhSceneManager)
-	,m_scratchBuffer()
+	,m_staticBvhSceneManager(src.m_staticBvhSceneManager)
+	,m_frameArena()
 	,m_sceneBodyArray()
 	,m_activeConstraintArray()
 	,m_specialUpdateList()
 	,m_newPairs(1024)
+	,m_continueContactArray(256)
+	,m_compoundContactArray(64)
+	,m_compoundChildBatchArray(256)
+	,m_threadLocalData()
 	,m_lock()
 	,m_rootNode(nullptr)
+	,m_staticRootNode(nullptr)
 	,m_sentinelBody(nullptr)
 	,m_contactNotifyCallback(nullptr)
 	,m_backgroundThread(nullptr)
+	,m_contactScratchArray(nullptr)
 	,m_timestep(ndFloat32(0.0f))
 	,m_lru(src.m_lru)
 	,m_frameNumber(src.m_frameNumber)
 	,m_subStepNumber(src.m_subStepNumber)
 	,m_forceBalanceSceneCounter(0)
+	,m_forceBalanceStaticSceneCounter(0)
+	,m_incrementalBvhRefit(src.m_incrementalBvhRefit)
+	,m_staticSceneMoved(false)
+	,m_speculativeContacts(false)
 {
 	ndScene* const stealData = (ndScene*)&src;
 
 	SetThreadCount(src.GetThreadCount());
 	//m_backgroundThread.SetThreadCount(m_backgroundThread.GetThreadCount());
 
-	m_scratchBuffer.Swap(stealData->m_scratchBuffer);
 	m_sceneBodyArray.Swap(stealData->m_sceneBodyArray);
 	m_activeConstraintArray.Swap(stealData->m_activeConstraintArray);
 
 	ndSwap(m_rootNode, stealData->m_rootNode);
+	ndSwap(m_staticRootNode, stealData->m_staticRootNode);
 	ndSwap(m_sentinelBody, stealData->m_sentinelBody);
 	ndSwap(m_contactNotifyCallback, stealData->m_contactNotifyCallback);
 	m_contactNotifyCallback->m_scene = this;
@@ -144,10 +246,6 @@ ndScene::ndScene(const ndScene& src)
 		ndAssert (body->GetContactMap().SanityCheck());
 	}
 
-	for (ndInt32 i = 0; i < D_MAX_THREADS_COUNT; ++i)
-	{
-		m_partialNewPairs[i].Resize(256);
-	}
 	ndAssert(ndMemory::CheckMemory(this));
 }
 
@@ -160,9 +258,29 @@ ndScene::~ndScene()
 	{
 		delete m_contactNotifyCallback;
 	}
+	for (ndInt32 i = ndInt32(m_threadLocalData.GetCount()) - 1; i >= 0; --i)
+	{
+		delete m_threadLocalData[i];
+	}
 	ndFreeListAlloc::Flush();
 }
 
+void ndScene::SetThreadCount(ndInt32 count)
+{
+	ndThreadPool::SetThreadCount(count);
+
+	const ndInt32 threadCount = GetThreadCount();
+	for (ndInt32 i = ndInt32(m_threadLocalData.GetCount()) - 1; i >= threadCount; --i)
+	{
+		delete m_threadLocalData[i];
+	}
+	for (ndInt32 i = ndInt32(m_threadLocalData.GetCount()); i < threadCount; ++i)
+	{
+		m_threadLocalData.PushBack(new ndThreadLocalData);
+	}
+	m_threadLocalData.SetCount(threadCount);
+}
+
 void ndScene::Sync()
 {
 	ndThreadPool::Sync();
@@ -219,17 +337,47 @@ void ndScene::SetContactNotify(ndContactNotify* const notify)
 
 void ndScene::DebugScene(ndSceneTreeNotiFy* const notify)
 {
-	const ndBvhNodeArray& array = m_bvhSceneManager.GetNodeArray();
-	for (ndInt32 i = 0; i < array.GetCount(); ++i)
+	const ndBvhNodeArray* const arrays[] = { &m_bvhSceneManager.GetNodeArray(), &m_staticBvhSceneManager.GetNodeArray() };
+	for (ndInt32 j = 0; j < ndInt32(sizeof(arrays) / sizeof(arrays[0])); ++j)
 	{
-		ndBvhNode* const node = array[i];
-		if (node->GetAsSceneBodyNode())
+		const ndBvhNodeArray& array = *arrays[j];
+		for (ndInt32 i = 0; i < array.GetCount(); ++i)
 		{
-			notify->OnDebugNode(node);
+			ndBvhNode* const node = array[i];
+			if (node->GetAsSceneBodyNode())
+			{
+				notify->OnDebugNode(node);
+			}
 		}
 	}
 }
 
+ndBvhSceneManager& ndScene::GetBvhSceneManager(const ndBodyKinematic* const body)
+{
+	return body->m_staticSceneTree ? m_staticBvhSceneManager : m_bvhSceneManager;
+}
+
+const ndBvhSceneManager& ndScene::GetBvhSceneManager(const ndBodyKinematic* const body) const
+{
+	return body->m_staticSceneTree ? m_staticBvhSceneManager : m_bvhSceneManager;
+}
+
+static bool IsBodyAtRest(ndBodyKinematic* const body)
+{
+	if (body->GetAsBodyKinematicSpecial())
+	{
+		return false;
+	}
+	if (body->GetInvMass() != ndFloat32(0.0f))
+	{
+		return body->GetSleepState();
+	}
+	// a body with infinite mass that has a velocity is a kinematic body, it moves every step.
+	const ndVector veloc(body->GetVelocity());
+	const ndVector omega(body->GetOmega());
+	return (veloc.DotProduct(veloc).GetScalar() + omega.DotProduct(omega).GetScalar()) == ndFloat32(0.0f);
+}
+
 bool ndScene::AddBody(const ndSharedPtr<ndBody>& body)
 {
 	ndBodyKinematic* const kinematicBody = body->GetAsBodyKinematic();
@@ -242,14 +390,27 @@ bool ndScene::AddBody(const ndSharedPtr<ndBody>& body)
 			m_contactNotifyCallback->OnBodyAdded(kinematicBody);
 			kinematicBody->UpdateCollisionMatrix();
 
-			m_rootNode = m_bvhSceneManager.AddBody(kinematicBody, m_rootNode);
+			// bodies with infinite mass that are not driven by a velocity go to the static tree, 
+			// which is only rebuilt when bodies are added or removed from it.
+			const bool isStatic = (kinematicBody->GetInvMass() == ndFloat32(0.0f)) && IsBodyAtRest(kinematicBody);
+			kinematicBody->m_sceneTreeMoved = 0;
+			kinematicBody->m_staticSceneTree = isStatic ? 1 : 0;
+			if (kinematicBody->m_staticSceneTree)
+			{
+				m_staticRootNode = m_staticBvhSceneManager.AddBody(kinematicBody, m_staticRootNode);
+				m_forceBalanceStaticSceneCounter = 0;
+			}
+			else
+			{
+				m_rootNode = m_bvhSceneManager.AddBody(kinematicBody, m_rootNode);
+				m_forceBalanceSceneCounter = 0;
+			}
+
 			if (kinematicBody->GetAsBodyKinematicSpecial())
 			{
 				kinematicBody->m_spetialUpdateNode = m_specialUpdateList.Append(kinematicBody);
 			}
 
-			m_forceBalanceSceneCounter = 0;
-
 			return true;
 		}
 	}
@@ -279,15 +440,23 @@ bool ndScene::RemoveBody(const ndSharedPtr<ndBody>& body)
 	ndBodyKinematic* const kinematicBody = body->GetAsBodyKinematic();
 	if (kinematicBody)
 	{
-		m_forceBalanceSceneCounter = 0;
-		m_bvhSceneManager.RemoveBody(kinematicBody);
+		if (kinematicBody->m_staticSceneTree)
+		{
+			m_forceBalanceStaticSceneCounter = 0;
+		}
+		else
+		{
+			m_forceBalanceSceneCounter = 0;
+		}
+		GetBvhSceneManager(kinematicBody).RemoveBody(kinematicBody);
 
 		//ndAssert(0);
 		ndBodyKinematic::ndContactMap& contactMap = kinematicBody->GetContactMap();
-		while (contactMap.GetRoot())
+		while (contactMap.GetCount())
 		{
-			ndContact* const contact = contactMap.GetRoot()->GetInfo();
-			m_contactArray.DetachContact(contact);
+			ndBodyKinematic::ndContactMap::Iterator it(contactMap);
+			it.Begin();
+			m_contactArray.DetachContact(*it);
 		}
 
 		ndBodyListView::ndNode* const sceneNode = kinematicBody->m_sceneNode;
@@ -314,25 +483,145 @@ bool ndScene::RemoveBody(const ndSharedPtr<ndBody>& body)
 	return false;
 }
 
-void ndScene::BalanceScene()
+ndBvhNode* ndScene::BalanceSceneTree(ndBvhSceneManager& bvhSceneManager, ndBvhNode* rootNode, ndUnsigned32& forceBalanceCounter, bool periodicRebuild)
+{
+	if (bvhSceneManager.GetNodeArray().GetCount())
+	{
+		if (m_incrementalBvhRefit)
+		{
+			// only rebuild from scratch when bodies were added or removed, or when the tree is too degraded to patch.
+			bool rebuild = !forceBalanceCounter;
+			if (!rebuild && rootNode && rootNode->GetAsSceneTreeNode())
+			{
+				rebuild = !bvhSceneManager.RebuildDegradedSubtrees(*this, rootNode);
+			}
+			if (rebuild)
+			{
+				rootNode = bvhSceneManager.BuildBvhTree(*this);
+				if (rootNode)
+				{
+					bvhSceneManager.InitSahCost(*this);
+				}
+				forceBalanceCounter = 1;
+			}
+		}
+		else
+		{
+			if (!forceBalanceCounter)
+			{
+				rootNode = bvhSceneManager.BuildBvhTree(*this);
+			}
+			const ndUnsigned32 sceneUpdatePeriod = 64;
+			if (periodicRebuild)
+			{
+				forceBalanceCounter = (forceBalanceCounter < sceneUpdatePeriod) ? forceBalanceCounter + 1 : 0;
+			}
+			else
+			{
+				forceBalanceCounter = 1;
+			}
+		}
+		ndAssert(!rootNode || !rootNode->m_parent);
+	}
+	return rootNode;
+}
+
+void ndScene::MoveToSceneTree(ndBodyKinematic* const body, bool staticTree)
+{
+	// both trees are patched in place, only the paths to the moved leaf are flagged, 
+	// so that the rebalance rebuilds the subtrees that degraded instead of the whole trees.
+	if (staticTree)
+	{
+		m_rootNode = m_bvhSceneManager.RemoveBody(body, m_rootNode);
+		m_staticRootNode = m_staticBvhSceneManager.AddBody(body, m_staticRootNode);
+		m_staticBvhSceneManager.MarkSahDirty(m_staticBvhSceneManager.GetLeafNode(body));
+	}
+	else
+	{
+		m_staticRootNode = m_staticBvhSceneManager.RemoveBody(body, m_staticRootNode);
+		m_rootNode = m_bvhSceneManager.AddBody(body, m_rootNode);
+		m_bvhSceneManager.MarkSahDirty(m_bvhSceneManager.GetLeafNode(body));
+	}
+	body->m_staticSceneTree = staticTree ? 1 : 0;
+}
+
+void ndScene::MigrateSceneTreeBodies()
 {
 	D_TRACKTIME();
-	UpdateBodyList();
-	if (m_bvhSceneManager.GetNodeArray().GetCount() > 2)
+	// the pass only runs every few frames, so that a body that falls asleep 
+	// and wakes up in quick succession does not rebuild both trees every frame.
+	if (m_lru % D_SCENE_TREE_MIGRATION_PERIOD)
+	{
+		return;
+	}
+
+	bool migrated = false;
+	const ndArray<ndBodyKinematic*>& view = GetActiveBodyArray();
+	for (ndInt32 i = ndInt32(view.GetCount()) - 2; i >= 0; --i)
+	{
+		ndBodyKinematic* const body = view[i];
+		const bool atRest = !body->m_sceneTreeMoved && IsBodyAtRest(body);
+		body->m_sceneTreeMoved = 0;
+		if (body->m_staticSceneTree != ndUnsigned32(atRest))
+		{
+			MoveToSceneTree(body, atRest);
+			migrated = true;
+		}
+	}
+
+	if (migrated)
 	{
-		if (!m_forceBalanceSceneCounter)
+		// a tree that is about to be rebuilt does not need its layers, 
+		// and one that the insertions made too deep is rebuilt from scratch.
+		if (m_forceBalanceSceneCounter)
 		{
-			m_rootNode = m_bvhSceneManager.BuildBvhTree(*this);
+			if (m_rootNode && (m_rootNode->m_depthLevel >= D_BVH_MAX_PARTIAL_REBUILD_DEPTH))
+			{
+				m_forceBalanceSceneCounter = 0;
+			}
+			else
+			{
+				m_bvhSceneManager.UpdateNodeLayers(*this, m_rootNode);
+			}
+		}
+		if (m_forceBalanceStaticSceneCounter)
+		{
+			if (m_staticRootNode && (m_staticRootNode->m_depthLevel >= D_BVH_MAX_PARTIAL_REBUILD_DEPTH))
+			{
+				m_forceBalanceStaticSceneCounter = 0;
+			}
+			else
+			{
+				m_staticBvhSceneManager.UpdateNodeLayers(*this, m_staticRootNode);
+			}
 		}
-		const ndInt32 sceneUpdatePeriod = 64;
-		m_forceBalanceSceneCounter = (m_forceBalanceSceneCounter < sceneUpdatePeriod) ? m_forceBalanceSceneCounter + 1 : 0;
-		ndAssert(!m_rootNode || !m_rootNode->m_parent);
 	}
+}
+
+void ndScene::BalanceScene()
+{
+	D_TRACKTIME();
+	UpdateBodyList();
+	MigrateSceneTreeBodies();
+	m_rootNode = BalanceSceneTree(m_bvhSceneManager, m_rootNode, m_forceBalanceSceneCounter, true);
+
+	// the static tree only goes stale if some of its bodies were moved by the application.
+	const bool staticScenePeriodicRebuild = m_staticSceneMoved;
+	if (m_forceBalanceStaticSceneCounter == 0)
+	{
+		m_staticSceneMoved = false;
+	}
+	m_staticRootNode = BalanceSceneTree(m_staticBvhSceneManager, m_staticRootNode, m_forceBalanceStaticSceneCounter, staticScenePeriodicRebuild);
 
 	if (!m_bodyList.GetCount())
 	{
 		m_rootNode = nullptr;
+		m_staticRootNode = nullptr;
 	}
+
+	// the queries issued while applying forces see the new topology
+	m_bvhSceneManager.UpdateWideTree(*this, m_rootNode, false);
+	m_staticBvhSceneManager.UpdateWideTree(*this, m_staticRootNode, false);
 }
 
 void ndScene::UpdateTransformNotify(ndInt32 threadIndex, ndBodyKinematic* const body)
@@ -381,7 +670,7 @@ bool ndScene::ValidateContactCache(ndContact* const contact, const ndVector& tim
 	return false;
 }
 
-void ndScene::CalculateJointContacts(ndInt32 threadIndex, ndContact* const contact)
+bool ndScene::CalculateJointContacts(ndInt32 threadIndex, ndContact* const contact)
 {
 	ndBodyKinematic* const body0 = contact->GetBody0();
 	ndBodyKinematic* const body1 = contact->GetBody1();
@@ -456,6 +745,7 @@ void ndScene::CalculateJointContacts(ndInt32 threadIndex, ndContact* const conta
 			contact->m_maxDof = 0;
 		}
 	}
+	return processContacts;
 }
 
 void ndScene::ProcessContacts(ndInt32, ndInt32 contactCount, ndContactSolver* const contactSolver)
@@ -473,15 +763,15 @@ void ndScene::ProcessContacts(ndInt32, ndInt32 contactCount, ndContactSolver* co
 	contact->m_material = m_contactNotifyCallback->GetMaterial(contact, body0->GetCollisionShape(), body1->GetCollisionShape());
 	const ndContactPoint* const contactArray = contactSolver->m_contactBuffer;
 	
-	ndInt32 count = 0;
-	ndVector cachePosition[D_MAX_CONTATCS];
-	ndContactPointList::ndNode* nodes[D_MAX_CONTATCS];
 	ndContactPointList& contactPointList = contact->m_contacPointsList;
-	for (ndContactPointList::ndNode* contactNode = contactPointList.GetFirst(); contactNode; contactNode = contactNode->GetNext()) 
-	{
-		nodes[count] = contactNode;
-		cachePosition[count] = contactNode->GetInfo().m_point;
-		count++;
+	ndInt32 count = contactPointList.GetCount();
+	ndInt32 cacheIndex[D_MAX_CONTACT_POINTS];
+	ndVector cachePosition[D_MAX_CONTACT_POINTS];
+	ndAssert(count <= D_MAX_CONTACT_POINTS);
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		cacheIndex[i] = i;
+		cachePosition[i] = contactPointList[i].m_point;
 	}
 	
 	const ndVector& v0 = body0->m_veloc;
@@ -523,38 +813,67 @@ void ndScene::ProcessContacts(ndInt32, ndInt32 contactCount, ndContactSolver* co
 		ndAssert(ndAbs(controlNormal.DotProduct(controlDir0.CrossProduct(controlDir1)).GetScalar() - ndFloat32(1.0f)) < ndFloat32(1.0e-3f));
 	}
 	
-	ndFloat32 maxImpulse = ndFloat32(-1.0f);
-	for (ndInt32 i = 0; i < contactCount; ++i) 
+	// match the new points to last frame's points on the same features, so that 
+	// the solver can warm start from the forces they carried. a point matches 
+	// when both sub shape ids agree, the normal did not swing, and it moved 
+	// less than the match distance.
+	ndInt32 matchIndex[D_MAX_CONTACT_POINTS];
+	ndAssert(contactCount <= D_MAX_CONTACT_POINTS);
+	for (ndInt32 i = 0; i < contactCount; ++i)
 	{
 		ndInt32 index = -1;
-		ndFloat32 min = ndFloat32(1.0e20f);
-		ndContactPointList::ndNode* contactNode = nullptr;
-		for (ndInt32 j = 0; j < count; ++j) 
-		{
-			ndVector v(ndVector::m_triplexMask & (cachePosition[j] - contactArray[i].m_point));
-			ndAssert(v.m_w == ndFloat32(0.0f));
-			diff = v.DotProduct(v).GetScalar();
-			if (diff < min) 
+		ndFloat32 min = D_CONTACT_MATCH_DISTANCE * D_CONTACT_MATCH_DISTANCE;
+		for (ndInt32 j = 0; j < count; ++j)
+		{
+			const ndContactMaterial& cachePoint = contactPointList[cacheIndex[j]];
+			if ((cachePoint.m_shapeId0 == contactArray[i].m_shapeId0) && (cachePoint.m_shapeId1 == contactArray[i].m_shapeId1))
 			{
-				index = j;
-				min = diff;
-				contactNode = nodes[j];
+				ndVector v(ndVector::m_triplexMask & (cachePosition[j] - contactArray[i].m_point));
+				ndAssert(v.m_w == ndFloat32(0.0f));
+				diff = v.DotProduct(v).GetScalar();
+				if ((diff < min) && (cachePoint.m_normal.DotProduct(contactArray[i].m_normal).GetScalar() > ndFloat32(0.9f)))
+				{
+					index = j;
+					min = diff;
+				}
 			}
 		}
-	
-		if (contactNode) 
+
+		matchIndex[i] = -1;
+		if (index != -1)
 		{
+			matchIndex[i] = cacheIndex[index];
 			count--;
-			ndAssert(index != -1);
-			nodes[index] = nodes[count];
+			cacheIndex[index] = cacheIndex[count];
 			cachePosition[index] = cachePosition[count];
 		}
+	}
+
+	ndFloat32 maxImpulse = ndFloat32(-1.0f);
+	for (ndInt32 i = 0; i < contactCount; ++i) 
+	{
+		ndContactMaterial* contactPoint = nullptr;
+		ndVector oldDir0(ndVector::m_zero);
+		ndVector oldDir1(ndVector::m_zero);
+		if (matchIndex[i] != -1) 
+		{
+			contactPoint = &contactPointList[matchIndex[i]];
+			oldDir0 = contactPoint->m_dir0;
+			oldDir1 = contactPoint->m_dir1;
+		}
+		else if (count)
+		{
+			// recycle an unmatched old point, it starts cold
+			count--;
+			contactPoint = &contactPointList[cacheIndex[count]];
+			contactPoint->m_dir0_Force.Clear();
+			contactPoint->m_dir1_Force.Clear();
+			contactPoint->m_normal_Force.Clear();
+		}
 		else 
 		{
-			contactNode = contactPointList.Append();
+			contactPoint = &contactPointList.Append()->GetInfo();
 		}
-
-		ndContactMaterial* const contactPoint = &contactNode->GetInfo();
 	
 		ndAssert(ndCheckFloat(contactArray[i].m_point.m_x));
 		ndAssert(ndCheckFloat(contactArray[i].m_point.m_y));
@@ -575,6 +894,7 @@ void ndScene::ProcessContacts(ndInt32, ndInt32 contactCount, ndContactSolver* co
 		contactPoint->m_shapeId0 = contactArray[i].m_shapeId0;
 		contactPoint->m_shapeId1 = contactArray[i].m_shapeId1;
 		contactPoint->m_material = *contact->m_material;
+		contactPoint->m_speculative = false;
 	
 		if (staticMotion) 
 		{
@@ -643,11 +963,36 @@ void ndScene::ProcessContacts(ndInt32, ndInt32 contactCount, ndContactSolver* co
 		ndAssert(contactPoint->m_dir0.m_w == ndFloat32(0.0f));
 		ndAssert(contactPoint->m_dir0.m_w == ndFloat32(0.0f));
 		ndAssert(contactPoint->m_normal.m_w == ndFloat32(0.0f));
+
+		if (matchIndex[i] != -1)
+		{
+			// the friction basis follows the sliding direction, carry 
+			// the friction forces history over to the new basis.
+			ndForceImpactPair& force0 = contactPoint->m_dir0_Force;
+			ndForceImpactPair& force1 = contactPoint->m_dir1_Force;
+			for (ndInt32 j = 0; j < ndInt32(sizeof(force0.m_initialGuess) / sizeof(force0.m_initialGuess[0])); ++j)
+			{
+				const ndVector friction(oldDir0.Scale(force0.m_initialGuess[j]) + oldDir1.Scale(force1.m_initialGuess[j]));
+				force0.m_initialGuess[j] = friction.DotProduct(contactPoint->m_dir0).GetScalar();
+				force1.m_initialGuess[j] = friction.DotProduct(contactPoint->m_dir1).GetScalar();
+			}
+		}
 	}
 	
+	// remove the old points that were not matched, from the back so that the indices stay valid
+	for (ndInt32 i = 1; i < count; ++i)
+	{
+		const ndInt32 index = cacheIndex[i];
+		ndInt32 j = i - 1;
+		for (; (j >= 0) && (cacheIndex[j] < index); --j)
+		{
+			cacheIndex[j + 1] = cacheIndex[j];
+		}
+		cacheIndex[j + 1] = index;
+	}
 	for (ndInt32 i = 0; i < count; ++i) 
 	{
-		contactPointList.Remove(nodes[i]);
+		contactPointList.Remove(cacheIndex[i]);
 	}
 	
 	//contact->m_maxDof = ndUnsigned32(3 * contactPointList.GetCount());
@@ -655,58 +1000,53 @@ void ndScene::ProcessContacts(ndInt32, ndInt32 contactCount, ndContactSolver* co
 	m_contactNotifyCallback->OnContactCallback(contact, m_timestep);
 }
 
-void ndScene::SubmitPairs(ndBvhLeafNode* const leafNode, ndBvhNode* const node, bool forward, ndInt32 threadId)
+void ndScene::SubmitPairs(ndBvhLeafNode* const leafNode, const ndBvhWideNode* const root, ndInt64 forwardId, ndInt32 threadId)
 {
-	ndBvhNode* pool[D_SCENE_MAX_STACK_DEPTH];
+	const ndBvhWideNode* pool[D_SCENE_MAX_STACK_DEPTH];
 
-	ndBodyKinematic* const body0 = leafNode->GetBody() ? leafNode->GetBody() : nullptr;
+	ndBodyKinematic* const body0 = leafNode->m_body;
 	ndAssert(body0);
 
-	const ndVector boxP0(leafNode->m_minBox);
-	const ndVector boxP1(leafNode->m_maxBox);
+	const ndBvhWideBox box(leafNode->m_minBox, leafNode->m_maxBox);
 	const ndUnsigned8 test0 = ndUnsigned8(!body0->m_equilibrium);
-	const ndUnsigned8 fowardTest = forward ? ndUnsigned8(1) : ndUnsigned8(0);
 
 	ndBodyNotify* const notify = body0->GetNotifyCallback();
 
-	pool[0] = node;
+	pool[0] = root;
 	ndInt32 stack = 1;
 	while (stack && (stack < (D_SCENE_MAX_STACK_DEPTH - 16)))
 	{
 		stack--;
-		ndBvhNode* const rootNode = pool[stack];
-		if (ndOverlapTest(rootNode->m_minBox, rootNode->m_maxBox, boxP0, boxP1)) 
+		const ndBvhWideNode* const node = pool[stack];
+		const ndInt32 mask = node->OverlapTest(box);
+		for (ndInt32 i = 0; i < node->m_count; ++i)
 		{
-			if (rootNode->GetAsSceneBodyNode()) 
+			if (mask & (1 << i))
 			{
-				ndAssert(!rootNode->GetRight());
-				ndAssert(!rootNode->GetLeft());
-				
-				ndBodyKinematic* const body1 = rootNode->GetBody();
-				ndAssert(body1);
-				const ndUnsigned8 test = ndUnsigned8((body1->m_sceneEquilibrium | fowardTest) & (test0 | ndUnsigned8(!body1->m_equilibrium)));
-				if (test)
+				ndBodyKinematic* const body1 = node->m_body[i];
+				if (body1)
 				{
-					//if (notify->OnSceneAabbOverlap(body1))
-					if (!notify || notify->OnSceneAabbOverlap(body1))
+					if (body1 != body0)
 					{
-						AddPair(body0, body1, threadId);
+						// bodies with a larger id than the forward id are tested as if they were moving
+						const ndUnsigned8 fowardTest = ndUnsigned8(ndInt64(body1->m_uniqueId) > forwardId);
+						const ndUnsigned8 test = ndUnsigned8((body1->m_sceneEquilibrium | fowardTest) & (test0 | ndUnsigned8(!body1->m_equilibrium)));
+						if (test)
+						{
+							if (!notify || notify->OnSceneAabbOverlap(body1))
+							{
+								AddPair(body0, body1, threadId);
+							}
+						}
 					}
 				}
-			}
-			else 
-			{
-				ndBvhInternalNode* const tmpNode = rootNode->GetAsSceneTreeNode();
-				ndAssert(tmpNode->m_left);
-				ndAssert(tmpNode->m_right);
-		
-				pool[stack] = tmpNode->m_left;
-				stack++;
-				ndAssert(stack < ndInt32(sizeof(pool) / sizeof(pool[0])));
-		
-				pool[stack] = tmpNode->m_right;
-				stack++;
-				ndAssert(stack < ndInt32(sizeof(pool) / sizeof(pool[0])));
+				else
+				{
+					ndAssert(node->m_child[i]);
+					pool[stack] = node->m_child[i];
+					stack++;
+					ndAssert(stack < ndInt32(sizeof(pool) / sizeof(pool[0])));
+				}
 			}
 		}
 	}
@@ -714,6 +1054,7 @@ void ndScene::SubmitPairs(ndBvhLeafNode* const leafNode, ndBvhNode* const node,
 	if (stack)
 	{
 		m_forceBalanceSceneCounter = 0;
+		m_forceBalanceStaticSceneCounter = 0;
 	}
 }
 
@@ -746,49 +1087,23 @@ ndJointBilateralConstraint* ndScene::FindBilateralJoint(ndBodyKinematic* const b
 
 void ndScene::FindCollidingPairs(ndBodyKinematic* const body, ndInt32 threadId)
 {
-	ndBvhLeafNode* const bodyNode = m_bvhSceneManager.GetLeafNode(body);
-	ndAssert(bodyNode->GetAsSceneBodyNode());
-	for (ndBvhNode* ptr = bodyNode; ptr->m_parent; ptr = ptr->m_parent)
-	{
-		ndBvhInternalNode* const parent = ptr->m_parent->GetAsSceneTreeNode();
-		ndAssert(!parent->GetAsSceneBodyNode());
-		ndBvhNode* const sibling = parent->m_right;
-		if (sibling != ptr)
-		{
-			SubmitPairs(bodyNode, sibling, true, threadId);
-		}
-	}
-}
-
-void ndScene::FindCollidingPairsForward(ndBodyKinematic* const body, ndInt32 threadId)
-{
-	ndBvhLeafNode* const bodyNode = m_bvhSceneManager.GetLeafNode(body);
+	// each pair is reported once: in its own tree a body tests the bodies with a larger id as if 
+	// they were moving, and the ones with a smaller id only if they did not move. across trees, 
+	// bodies in the dynamics tree test all static bodies, and static bodies only test the dynamics 
+	// bodies that did not move.
+	const ndBvhSceneManager& bvhSceneManager = GetBvhSceneManager(body);
+	ndBvhLeafNode* const bodyNode = bvhSceneManager.GetLeafNode(body);
 	ndAssert(bodyNode->GetAsSceneBodyNode());
-	for (ndBvhNode* ptr = bodyNode; ptr->m_parent; ptr = ptr->m_parent)
+	const ndBvhWideNode* const root = bvhSceneManager.GetWideRoot();
+	if (root)
 	{
-		ndBvhInternalNode* const parent = ptr->m_parent->GetAsSceneTreeNode();
-		ndAssert(!parent->GetAsSceneBodyNode());
-		ndBvhNode* const sibling = parent->m_right;
-		if (sibling != ptr)
-		{
-			SubmitPairs(bodyNode, sibling, true, threadId);
-		}
+		SubmitPairs(bodyNode, root, ndInt64(body->m_uniqueId), threadId);
 	}
-}
 
-void ndScene::FindCollidingPairsBackward(ndBodyKinematic* const body, ndInt32 threadId)
-{
-	ndBvhLeafNode* const bodyNode = m_bvhSceneManager.GetLeafNode(body);
-	ndAssert(bodyNode->GetAsSceneBodyNode());
-	for (ndBvhNode* ptr = bodyNode; ptr->m_parent; ptr = ptr->m_parent)
+	const ndBvhWideNode* const otherRoot = body->m_staticSceneTree ? m_bvhSceneManager.GetWideRoot() : m_staticBvhSceneManager.GetWideRoot();
+	if (otherRoot)
 	{
-		ndBvhInternalNode* const parent = ptr->m_parent->GetAsSceneTreeNode();
-		ndAssert(!parent->GetAsSceneBodyNode());
-		ndBvhNode* const sibling = parent->m_left;
-		if (sibling != ptr)
-		{
-			SubmitPairs(bodyNode, sibling, false, threadId);
-		}
+		SubmitPairs(bodyNode, otherRoot, body->m_staticSceneTree ? ndInt64(0xffffffff) : ndInt64(-1), threadId);
 	}
 }
 
@@ -826,6 +1141,25 @@ void ndScene::UpdateTransform()
 	ParallelExecute(TransformUpdate);
 }
 
+ndFloat32 ndScene::ClosingSpeedBound(const ndContact* const contact) const
+{
+	const ndBodyKinematic* const body0 = contact->GetBody0();
+	const ndBodyKinematic* const body1 = contact->GetBody1();
+	const ndShapeInstance& shape0 = body0->GetCollisionShape();
+	const ndShapeInstance& shape1 = body1->GetCollisionShape();
+
+	const ndVector veloc0(body0->GetVelocity());
+	const ndVector veloc1(body1->GetVelocity());
+
+	const ndVector veloc(veloc1 - veloc0);
+	const ndVector omega0(body0->GetOmega());
+	const ndVector omega1(body1->GetOmega());
+	const ndVector scale(ndFloat32(1.0f), ndFloat32(3.5f) * shape0.GetBoxMaxRadius(), ndFloat32(3.5f) * shape1.GetBoxMaxRadius(), ndFloat32(0.0f));
+	const ndVector velocMag2(veloc.DotProduct(veloc).GetScalar(), omega0.DotProduct(omega0).GetScalar(), omega1.DotProduct(omega1).GetScalar(), ndFloat32(0.0f));
+	const ndVector velocMag(velocMag2.GetMax(ndVector::m_epsilon).InvSqrt() * velocMag2 * scale);
+	return velocMag.AddHorizontal().GetScalar() + ndFloat32(0.5f);
+}
+
 void ndScene::CalculateContacts(ndInt32 threadIndex, ndContact* const contact)
 {
 	const ndUnsigned32 lru = m_lru - D_CONTACT_DELAY_FRAMES;
@@ -849,39 +1183,58 @@ void ndScene::CalculateContacts(ndInt32 threadIndex, ndContact* const contact)
 			contact->m_positAcc = ndVector::m_zero;
 			contact->m_rotationAcc = ndQuaternion();
 
+			// the separation of two convex shapes is exact, so the pair can skip the narrow phase 
+			// until the conservative bound of their relative motion could close the gap. 
+			// compounds and meshes only report an estimate, so they keep the wider margin.
+			ndShapeInstance& shape0 = body0->GetCollisionShape();
+			ndShapeInstance& shape1 = body1->GetCollisionShape();
+			const bool exactSeparation = shape0.GetShape()->GetAsShapeConvex() && shape1.GetShape()->GetAsShapeConvex() && !(contact->m_material->m_flags & m_disableSeparationCache);
+			const ndFloat32 narrowPhaseDist = exactSeparation ? D_SEPARATION_CACHE_DIST : D_NARROW_PHASE_DIST;
+
 			ndFloat32 distance = contact->m_separationDistance;
-			if (distance >= D_NARROW_PHASE_DIST)
+			if (distance >= narrowPhaseDist)
 			{
-				const ndVector veloc0(body0->GetVelocity());
-				const ndVector veloc1(body1->GetVelocity());
-				
-				const ndVector veloc(veloc1 - veloc0);
-				const ndVector omega0(body0->GetOmega());
-				const ndVector omega1(body1->GetOmega());
-				const ndShapeInstance* const collision0 = &body0->GetCollisionShape();
-				const ndShapeInstance* const collision1 = &body1->GetCollisionShape();
-				const ndVector scale(ndFloat32(1.0f), ndFloat32(3.5f) * collision0->GetBoxMaxRadius(), ndFloat32(3.5f) * collision1->GetBoxMaxRadius(), ndFloat32(0.0f));
-				const ndVector velocMag2(veloc.DotProduct(veloc).GetScalar(), omega0.DotProduct(omega0).GetScalar(), omega1.DotProduct(omega1).GetScalar(), ndFloat32(0.0f));
-				const ndVector velocMag(velocMag2.GetMax(ndVector::m_epsilon).InvSqrt() * velocMag2 * scale);
-				const ndFloat32 speed = velocMag.AddHorizontal().GetScalar() + ndFloat32(0.5f);
-				
-				distance -= speed * m_timestep;
+				distance -= ClosingSpeedBound(contact) * m_timestep;
 				contact->m_separationDistance = distance;
 			}
-			if (distance < D_NARROW_PHASE_DIST)
+			ndThreadLocalData* const threadData = m_threadLocalData[threadIndex];
+			if (distance < narrowPhaseDist)
 			{
-				CalculateJointContacts(threadIndex, contact);
-				if (contact->m_maxDof || contact->m_isIntersetionTestOnly)
+				threadData->m_narrowPhasePairs++;
+				const ndUnsigned32 testOnly = body0->m_contactTestOnly | body1->m_contactTestOnly;
+				if ((body0->m_continueCollision | body1->m_continueCollision) & !testOnly)
+				{
+					// pairs of fast bodies are solved in their own batch, so that 
+					// a few expensive time of impact queries do not land on one thread.
+					threadData->m_continueContacts.PushBack(contact);
+				}
+				else if (IsLargeCompoundPair(contact))
+				{
+					// the child pairs of large compounds are spread over all threads in their own stage
+					threadData->m_compoundContacts.PushBack(contact);
+				}
+				else
 				{
-					contact->SetActive(true);
-					contact->m_timeOfImpact = ndFloat32(1.0e10f);
+					const bool processContacts = CalculateJointContacts(threadIndex, contact);
+					if (m_speculativeContacts && processContacts && !testOnly && !(contact->m_maxDof || contact->m_isIntersetionTestOnly))
+					{
+						// the contacts of a collide once update are used by all its sub steps, 
+						// so a pair that is apart but closing in gets speculative points for the gap.
+						CalculateTimeOfImpactContacts(threadIndex, contact);
+					}
+					if (contact->m_maxDof || contact->m_isIntersetionTestOnly)
+					{
+						contact->SetActive(true);
+						contact->m_timeOfImpact = ndFloat32(1.0e10f);
+					}
 				}
 				contact->m_sceneLru = m_lru;
 			}
 			else
 			{
-				const ndBvhLeafNode* const bodyNode0 = m_bvhSceneManager.GetLeafNode(contact->GetBody0());
-				const ndBvhLeafNode* const bodyNode1 = m_bvhSceneManager.GetLeafNode(contact->GetBody1());
+				threadData->m_skippedPairs++;
+				const ndBvhLeafNode* const bodyNode0 = GetBvhSceneManager(contact->GetBody0()).GetLeafNode(contact->GetBody0());
+				const ndBvhLeafNode* const bodyNode1 = GetBvhSceneManager(contact->GetBody1()).GetLeafNode(contact->GetBody1());
 				ndAssert(bodyNode0 && bodyNode0->GetAsSceneBodyNode());
 				ndAssert(bodyNode1 && bodyNode1->GetAsSceneBodyNode());
 				if (ndOverlapTest(bodyNode0->m_minBox, bodyNode0->m_maxBox, bodyNode1->m_minBox, bodyNode1->m_maxBox)) 
@@ -912,8 +1265,8 @@ void ndScene::CalculateContacts(ndInt32 threadIndex, ndContact* const contact)
 
 	if (!contact->m_isDead && (body0->m_equilibrium & body1->m_equilibrium & !contact->IsActive()))
 	{
-		const ndBvhLeafNode* const bodyNode0 = m_bvhSceneManager.GetLeafNode(contact->GetBody0());
-		const ndBvhLeafNode* const bodyNode1 = m_bvhSceneManager.GetLeafNode(contact->GetBody1());
+		const ndBvhLeafNode* const bodyNode0 = GetBvhSceneManager(contact->GetBody0()).GetLeafNode(contact->GetBody0());
+		const ndBvhLeafNode* const bodyNode1 = GetBvhSceneManager(contact->GetBody1()).GetLeafNode(contact->GetBody1());
 		ndAssert(bodyNode0->GetAsSceneBodyNode());
 		ndAssert(bodyNode1->GetAsSceneBodyNode());
 		if (!ndOverlapTest(bodyNode0->m_minBox, bodyNode0->m_maxBox, bodyNode1->m_minBox, bodyNode1->m_maxBox))
@@ -932,79 +1285,92 @@ void ndScene::UpdateSpecial()
 	}
 }
 
-bool ndScene::ConvexCast(ndConvexCastNotify& callback, const ndBvhNode** stackPool, ndFloat32* const stackDistance, ndInt32 stack, const ndFastRay& ray, const ndShapeInstance& convexShape, const ndMatrix& globalOrigin, const ndVector& globalDest) const
+bool ndScene::ConvexCast(ndConvexCastNotify& callback, const ndFastRay& ray, ndBodyKinematic* const castingBody, const ndShapeInstance& convexShape, const ndMatrix& globalOrigin, const ndVector& globalDest, ndInt32 threadIndex) const
 {
 	ndVector boxP0;
 	ndVector boxP1;
 
 	ndAssert(globalOrigin.TestOrthogonal());
 	convexShape.CalculateAabb(globalOrigin, boxP0, boxP1);
+
+	// the proxy body of the casting shape is shared by all the candidates
+	ndConvexCastNotify::SetCastingBody(*castingBody, convexShape, globalOrigin, globalDest);
 	
 	callback.m_contacts.SetCount(0);
 	callback.m_param = ndFloat32(1.2f);
 	callback.m_cachedScene = (ndScene*)this;
-	while (stack && (stack < (D_SCENE_MAX_STACK_DEPTH - 4)))
+
+	ndInt32 stack = 0;
+	ndSceneQueryEntry stackPool[D_SCENE_MAX_STACK_DEPTH];
+	auto PushEntry = [&stackPool, &stack](const ndBvhWideNode* const node, ndBodyKinematic* const body, ndFloat32 dist)
+	{
+		ndInt32 j = stack;
+		for (; j && (dist > stackPool[j - 1].m_dist); j--)
+		{
+			stackPool[j] = stackPool[j - 1];
+		}
+		stackPool[j].m_node = node;
+		stackPool[j].m_body = body;
+		stackPool[j].m_dist = dist;
+		stack++;
+		ndAssert(stack < D_SCENE_MAX_STACK_DEPTH);
+	};
+
+	const ndBvhNode* const rootNodes[] = { m_rootNode, m_staticRootNode };
+	const ndBvhWideNode* const wideRoots[] = { m_bvhSceneManager.GetWideRoot(), m_staticBvhSceneManager.GetWideRoot() };
+	for (ndInt32 i = 0; i < ndInt32(sizeof(rootNodes) / sizeof(rootNodes[0])); ++i)
+	{
+		if (rootNodes[i] && wideRoots[i])
+		{
+			const ndVector minBox(rootNodes[i]->m_minBox - boxP1);
+			const ndVector maxBox(rootNodes[i]->m_maxBox - boxP0);
+			PushEntry(wideRoots[i], nullptr, ray.BoxIntersect(minBox, maxBox));
+		}
+	}
+
+	const ndBvhWideRay wideRay(ray, boxP0, boxP1);
+	while (stack && (stack < (D_SCENE_MAX_STACK_DEPTH - D_BVH_WIDE_NODE_CHILDREN)))
 	{
 		stack--;
-		ndFloat32 dist = stackDistance[stack];
-		
-		if (dist > callback.m_param)
+		const ndSceneQueryEntry entry(stackPool[stack]);
+		if (entry.m_dist > callback.m_param)
 		{
 			break;
 		}
-		else 
+
+		ndBodyKinematic* const body = entry.m_body;
+		if (body) 
 		{
-			const ndBvhNode* const me = stackPool[stack];
-		
-			ndBody* const body = me->GetBody();
-			if (body) 
+			if (callback.OnRayPrecastAction (body, &convexShape)) 
 			{
-				if (callback.OnRayPrecastAction (body, &convexShape)) 
+				// save contacts and try new set
+				ndConvexCastNotify savedNotification(callback);
+				callback.m_contacts.SetCount(0);
+				if (callback.CastShape(convexShape, castingBody, body, threadIndex))
 				{
-					// save contacts and try new set
-					ndConvexCastNotify savedNotification(callback);
-					ndBodyKinematic* const kinBody = body->GetAsBodyKinematic();
-					callback.m_contacts.SetCount(0);
-					if (callback.CastShape(convexShape, globalOrigin, globalDest, kinBody))
+					// found new contacts, see how the are managed
+					if (ndAbs(savedNotification.m_param - callback.m_param) < ndFloat32(-1.0e-3f))
 					{
-						// found new contacts, see how the are managed
-						if (ndAbs(savedNotification.m_param - callback.m_param) < ndFloat32(-1.0e-3f))
+						// merge contact
+						for (ndInt32 i = 0; i < savedNotification.m_contacts.GetCount(); ++i)
 						{
-							// merge contact
-							for (ndInt32 i = 0; i < savedNotification.m_contacts.GetCount(); ++i)
+							const ndContactPoint& contact = savedNotification.m_contacts[i];
+							bool newPoint = true;
+							for (ndInt32 j = callback.m_contacts.GetCount() - 1; j >= 0; ++j)
 							{
-								const ndContactPoint& contact = savedNotification.m_contacts[i];
-								bool newPoint = true;
-								for (ndInt32 j = callback.m_contacts.GetCount() - 1; j >= 0; ++j)
-								{
-									const ndVector diff(callback.m_contacts[j].m_point - contact.m_point);
-									ndFloat32 mag2 = diff.DotProduct(diff & ndVector::m_triplexMask).GetScalar();
-									newPoint = newPoint & (mag2 > ndFloat32(1.0e-5f));
-								}
-								if (newPoint && (callback.m_contacts.GetCount() < callback.m_contacts.GetCapacity()))
-								{
-									callback.m_contacts.PushBack(contact);
-								}
+								const ndVector diff(callback.m_contacts[j].m_point - contact.m_point);
+								ndFloat32 mag2 = diff.DotProduct(diff & ndVector::m_triplexMask).GetScalar();
+								newPoint = newPoint & (mag2 > ndFloat32(1.0e-5f));
 							}
-						}
-						else if (callback.m_param > savedNotification.m_param)
-						{
-							// restore contacts
-							callback.m_normal = savedNotification.m_normal;
-							callback.m_closestPoint0 = savedNotification.m_closestPoint0;
-							callback.m_closestPoint1 = savedNotification.m_closestPoint1;
-							callback.m_param = savedNotification.m_param;
-							for (ndInt32 i = 0; i < savedNotification.m_contacts.GetCount(); ++i)
+							if (newPoint && (callback.m_contacts.GetCount() < callback.m_contacts.GetCapacity()))
 							{
-								callback.m_contacts[i] = savedNotification.m_contacts[i];
+								callback.m_contacts.PushBack(contact);
 							}
 						}
 					}
-					else
+					else if (callback.m_param > savedNotification.m_param)
 					{
-						// no new contacts restore old ones,
-						// in theory it should no copy, by the notification may change
-						// the previous found contacts
+						// restore contacts
 						callback.m_normal = savedNotification.m_normal;
 						callback.m_closestPoint0 = savedNotification.m_closestPoint0;
 						callback.m_closestPoint1 = savedNotification.m_closestPoint1;
@@ -1014,55 +1380,37 @@ bool ndScene::ConvexCast(ndConvexCastNotify& callback, const ndBvhNode** stackPo
 							callback.m_contacts[i] = savedNotification.m_contacts[i];
 						}
 					}
-
-					if (callback.m_param < ndFloat32 (1.0e-8f)) 
-					{
-						break;
-					}
 				}
-			}
-			else 
-			{
+				else
 				{
-					const ndBvhNode* const left = me->GetLeft();
-					ndAssert(left);
-					const ndVector minBox(left->m_minBox - boxP1);
-					const ndVector maxBox(left->m_maxBox - boxP0);
-					ndFloat32 dist1 = ray.BoxIntersect(minBox, maxBox);
-					if (dist1 < callback.m_param)
+					// no new contacts restore old ones,
+					// in theory it should no copy, by the notification may change
+					// the previous found contacts
+					callback.m_normal = savedNotification.m_normal;
+					callback.m_closestPoint0 = savedNotification.m_closestPoint0;
+					callback.m_closestPoint1 = savedNotification.m_closestPoint1;
+					callback.m_param = savedNotification.m_param;
+					for (ndInt32 i = 0; i < savedNotification.m_contacts.GetCount(); ++i)
 					{
-						ndInt32 j = stack;
-						for (; j && (dist1 > stackDistance[j - 1]); j--)
-						{
-							stackPool[j] = stackPool[j - 1];
-							stackDistance[j] = stackDistance[j - 1];
-						}
-						stackPool[j] = left;
-						stackDistance[j] = dist1;
-						stack++;
-						ndAssert(stack < D_SCENE_MAX_STACK_DEPTH);
+						callback.m_contacts[i] = savedNotification.m_contacts[i];
 					}
 				}
-		
+
+				if (callback.m_param < ndFloat32 (1.0e-8f)) 
 				{
-					const ndBvhNode* const right = me->GetRight();
-					ndAssert(right);
-					const ndVector minBox(right->m_minBox - boxP1);
-					const ndVector maxBox = right->m_maxBox - boxP0;
-					ndFloat32 dist1 = ray.BoxIntersect(minBox, maxBox);
-					if (dist1 < callback.m_param)
-					{
-						ndInt32 j = stack;
-						for (; j && (dist1 > stackDistance[j - 1]); j--) 
-						{
-							stackPool[j] = stackPool[j - 1];
-							stackDistance[j] = stackDistance[j - 1];
-						}
-						stackPool[j] = right;
-						stackDistance[j] = dist1;
-						stack++;
-						ndAssert(stack < D_SCENE_MAX_STACK_DEPTH);
-					}
+					break;
+				}
+			}
+		}
+		else 
+		{
+			const ndBvhWideNode* const node = entry.m_node;
+			const ndVector dist(node->RayDistance(wideRay));
+			for (ndInt32 i = 0; i < node->m_count; ++i)
+			{
+				if (dist[i] < callback.m_param)
+				{
+					PushEntry(node->m_child[i], node->m_body[i], dist[i]);
 				}
 			}
 		}
@@ -1072,70 +1420,67 @@ bool ndScene::ConvexCast(ndConvexCastNotify& callback, const ndBvhNode** stackPo
 	return callback.m_contacts.GetCount() > 0;
 }
 
-bool ndScene::RayCast(ndRayCastNotify& callback, const ndBvhNode** stackPool, ndFloat32* const stackDistance, ndInt32 stack, const ndFastRay& ray) const
+bool ndScene::RayCast(ndRayCastNotify& callback, const ndFastRay& ray) const
 {
-	bool state = false;
-	while (stack && (stack < (D_SCENE_MAX_STACK_DEPTH - 4)))
+	ndInt32 stack = 0;
+	ndSceneQueryEntry stackPool[D_SCENE_MAX_STACK_DEPTH];
+	auto PushEntry = [&stackPool, &stack](const ndBvhWideNode* const node, ndBodyKinematic* const body, ndFloat32 dist)
+	{
+		// keep the stack sorted, the closest entry on top
+		ndInt32 j = stack;
+		for (; j && (dist > stackPool[j - 1].m_dist); j--)
+		{
+			stackPool[j] = stackPool[j - 1];
+		}
+		stackPool[j].m_node = node;
+		stackPool[j].m_body = body;
+		stackPool[j].m_dist = dist;
+		stack++;
+		ndAssert(stack < D_SCENE_MAX_STACK_DEPTH);
+	};
+
+	const ndBvhNode* const rootNodes[] = { m_rootNode, m_staticRootNode };
+	const ndBvhWideNode* const wideRoots[] = { m_bvhSceneManager.GetWideRoot(), m_staticBvhSceneManager.GetWideRoot() };
+	for (ndInt32 i = 0; i < ndInt32(sizeof(rootNodes) / sizeof(rootNodes[0])); ++i)
+	{
+		if (rootNodes[i] && wideRoots[i])
+		{
+			PushEntry(wideRoots[i], nullptr, ray.BoxIntersect(rootNodes[i]->m_minBox, rootNodes[i]->m_maxBox));
+		}
+	}
+
+	bool state = false;
+	const ndBvhWideRay wideRay(ray);
+	while (stack && (stack < (D_SCENE_MAX_STACK_DEPTH - D_BVH_WIDE_NODE_CHILDREN)))
 	{
 		stack--;
-		ndFloat32 dist = stackDistance[stack];
-		if (dist > callback.m_param)
+		const ndSceneQueryEntry entry(stackPool[stack]);
+		if (entry.m_dist > callback.m_param)
 		{
 			break;
 		}
-		else
+
+		ndBodyKinematic* const body = entry.m_body;
+		if (body)
 		{
-			const ndBvhNode* const me = stackPool[stack];
-			ndAssert(me);
-			ndBodyKinematic* const body = me->GetBody();
-			if (body)
+			if (body->RayCast(callback, ray, callback.m_param))
 			{
-				ndAssert(!me->GetLeft());
-				ndAssert(!me->GetRight());
-
-				if (body->RayCast(callback, ray, callback.m_param))
+				state = true;
+				if (callback.m_param < ndFloat32(1.0e-8f))
 				{
-					state = true;
-					if (callback.m_param < ndFloat32(1.0e-8f))
-					{
-						break;
-					}
+					break;
 				}
 			}
-			else
+		}
+		else
+		{
+			const ndBvhWideNode* const node = entry.m_node;
+			const ndVector dist(node->RayDistance(wideRay));
+			for (ndInt32 i = 0; i < node->m_count; ++i)
 			{
-				const ndBvhNode* const left = me->GetLeft();
-				ndAssert(left);
-				ndFloat32 dist1 = ray.BoxIntersect(left->m_minBox, left->m_maxBox);
-				if (dist1 < callback.m_param)
+				if (dist[i] < callback.m_param)
 				{
-					ndInt32 j = stack;
-					for (; j && (dist1 > stackDistance[j - 1]); j--)
-					{
-						stackPool[j] = stackPool[j - 1];
-						stackDistance[j] = stackDistance[j - 1];
-					}
-					stackPool[j] = left;
-					stackDistance[j] = dist1;
-					stack++;
-					ndAssert(stack < D_SCENE_MAX_STACK_DEPTH);
-				}
-	
-				const ndBvhNode* const right = me->GetRight();
-				ndAssert(right);
-				dist1 = ray.BoxIntersect(right->m_minBox, right->m_maxBox);
-				if (dist1 < callback.m_param)
-				{
-					ndInt32 j = stack;
-					for (; j && (dist1 > stackDistance[j - 1]); j--)
-					{
-						stackPool[j] = stackPool[j - 1];
-						stackDistance[j] = stackDistance[j - 1];
-					}
-					stackPool[j] = right;
-					stackDistance[j] = dist1;
-					stack++;
-					ndAssert(stack < D_SCENE_MAX_STACK_DEPTH);
+					PushEntry(node->m_child[i], node->m_body[i], dist[i]);
 				}
 			}
 		}
@@ -1146,24 +1491,33 @@ bool ndScene::RayCast(ndRayCastNotify& callback, const ndBvhNode** stackPool, nd
 void ndScene::BodiesInAabb(ndBodiesInAabbNotify& callback, const ndVector& minBox, const ndVector& maxBox) const
 {
 	callback.Reset();
-	if (m_rootNode)
-	{
-		const ndBvhNode* stackPool[D_SCENE_MAX_STACK_DEPTH];
-		stackPool[0] = m_rootNode;
-		ndInt32 stack = 1;
-		while (stack && (stack < (D_SCENE_MAX_STACK_DEPTH - 4)))
-		{
-			stack--;
-			
-			const ndBvhNode* const rootNode = stackPool[stack];
-			ndAssert(rootNode);
-			if (ndOverlapTest(rootNode->m_minBox, rootNode->m_maxBox, minBox, maxBox))
+	ValidateWideTrees();
+
+	ndInt32 stack = 0;
+	const ndBvhWideNode* stackPool[D_SCENE_MAX_STACK_DEPTH];
+	const ndBvhWideNode* const wideRoots[] = { m_bvhSceneManager.GetWideRoot(), m_staticBvhSceneManager.GetWideRoot() };
+	for (ndInt32 i = 0; i < ndInt32(sizeof(wideRoots) / sizeof(wideRoots[0])); ++i)
+	{
+		if (wideRoots[i])
+		{
+			stackPool[stack] = wideRoots[i];
+			stack++;
+		}
+	}
+
+	const ndBvhWideBox box(minBox, maxBox);
+	while (stack && (stack < (D_SCENE_MAX_STACK_DEPTH - D_BVH_WIDE_NODE_CHILDREN)))
+	{
+		stack--;
+		const ndBvhWideNode* const node = stackPool[stack];
+		const ndInt32 mask = node->OverlapTest(box);
+		for (ndInt32 i = 0; i < node->m_count; ++i)
+		{
+			if (mask & (1 << i))
 			{
-				ndBodyKinematic* const body = rootNode->GetBody();
+				ndBodyKinematic* const body = node->m_body[i];
 				if (body)
 				{
-					ndAssert(!rootNode->GetLeft());
-					ndAssert(!rootNode->GetRight());
 					if (ndOverlapTest(body->m_minAabb, body->m_maxAabb, minBox, maxBox))
 					{
 						callback.OnOverlap(body);
@@ -1171,15 +1525,8 @@ void ndScene::BodiesInAabb(ndBodiesInAabbNotify& callback, const ndVector& minBo
 				}
 				else
 				{
-					const ndBvhNode* const left = rootNode->GetLeft();
-					ndAssert(left);
-					stackPool[stack] = left;
-					stack++;
-					ndAssert(stack < D_SCENE_MAX_STACK_DEPTH);
-
-					const ndBvhNode* const right = rootNode->GetRight();
-					ndAssert(right);
-					stackPool[stack] = right;
+					ndAssert(node->m_child[i]);
+					stackPool[stack] = node->m_child[i];
 					stack++;
 					ndAssert(stack < D_SCENE_MAX_STACK_DEPTH);
 				}
@@ -1207,14 +1554,18 @@ void ndScene::Cleanup()
 	}
 
 	m_bvhSceneManager.CleanUp();
+	m_staticBvhSceneManager.CleanUp();
 	m_contactArray.DeleteAllContacts();
 
 	ndFreeListAlloc::Flush();
 	m_sceneBodyArray.Resize(1024);
 	m_activeConstraintArray.Resize(1024);
-	m_scratchBuffer.Resize(1024 * sizeof(void*));
+	m_frameArena.Release();
+	m_contactScratchArray = nullptr;
+	m_continueContactArray.SetCount(0);
+	m_compoundContactArray.SetCount(0);
+	m_compoundChildBatchArray.SetCount(0);
 
-	m_scratchBuffer.SetCount(0);
 	m_sceneBodyArray.SetCount(0);
 	m_activeConstraintArray.SetCount(0);
 }
@@ -1226,52 +1577,241 @@ bool ndScene::RayCast(ndRayCastNotify& callback, const ndVector& globalOrigin, c
 
 	bool state = false;
 	callback.m_param = ndFloat32(1.2f);
-	if (m_rootNode)
+	ValidateWideTrees();
+	if (m_rootNode || m_staticRootNode)
 	{
 		const ndVector segment(p1 - p0);
 		ndFloat32 dist2 = segment.DotProduct(segment).GetScalar();
 		if (dist2 > ndFloat32(1.0e-8f))
 		{
-			ndFloat32 distance[D_SCENE_MAX_STACK_DEPTH];
-			const ndBvhNode* stackPool[D_SCENE_MAX_STACK_DEPTH];
-
 			ndFastRay ray(p0, p1);
-
-			stackPool[0] = m_rootNode;
-			distance[0] = ray.BoxIntersect(m_rootNode->m_minBox, m_rootNode->m_maxBox);
-			state = RayCast(callback, stackPool, distance, 1, ray);
+			state = RayCast(callback, ray);
 		}
 	}
 	return state;
 }
 
+void ndScene::RayCastBatch(const ndVector* const origins, const ndVector* const dests, const ndUnsigned64* const filterMasks, ndInt32 count, ndRayCastHit* const hits)
+{
+	D_TRACKTIME();
+	if (!count)
+	{
+		return;
+	}
+	ValidateWideTrees();
+
+	ndVector minBox(ndFloat32(1.0e15f));
+	ndVector maxBox(ndFloat32(-1.0e15f));
+	const ndBvhNode* const rootNodes[] = { m_rootNode, m_staticRootNode };
+	for (ndInt32 i = 0; i < ndInt32(sizeof(rootNodes) / sizeof(rootNodes[0])); ++i)
+	{
+		if (rootNodes[i])
+		{
+			minBox = minBox.GetMin(rootNodes[i]->m_minBox);
+			maxBox = maxBox.GetMax(rootNodes[i]->m_maxBox);
+		}
+	}
+
+	// sort the rays by direction octant and by the morton code of their origin, so that the rays 
+	// cast in a row by each worker walk the same branches of the trees while they are in cache. 
+	// the key is 3 bits of octant, 30 bits of morton code and 31 bits of ray index.
+	ndArray<ndUnsigned64> rayOrder;
+	rayOrder.SetCount(count);
+	const ndVector boxSize((maxBox - minBox) & ndVector::m_triplexMask);
+	const ndVector scale(ndVector(ndFloat32(1023.0f)) * boxSize.GetMax(ndVector(ndFloat32(1.0e-3f))).Reciproc());
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		const ndVector dir(dests[i] - origins[i]);
+		const ndUnsigned64 octant = ndUnsigned64((dir.m_x < ndFloat32(0.0f)) ? 1 : 0) | ndUnsigned64((dir.m_y < ndFloat32(0.0f)) ? 2 : 0) | ndUnsigned64((dir.m_z < ndFloat32(0.0f)) ? 4 : 0);
+		const ndVector cell(((origins[i] - minBox) * scale).GetMax(ndVector::m_zero).GetMin(ndVector(ndFloat32(1023.0f))));
+		const ndUnsigned64 morton = ndMortonSpread(ndUnsigned64(cell.m_x)) | (ndMortonSpread(ndUnsigned64(cell.m_y)) << 1) | (ndMortonSpread(ndUnsigned64(cell.m_z)) << 2);
+		rayOrder[i] = (((octant << 30) | morton) << 31) | ndUnsigned64(i);
+	}
+
+	class ndCompareKey
+	{
+		public:
+		ndCompareKey(void*)
+		{
+		}
+
+		ndInt32 Compare(const ndUnsigned64 elementA, const ndUnsigned64 elementB) const
+		{
+			if (elementA < elementB)
+			{
+				return -1;
+			}
+			else if (elementA > elementB)
+			{
+				return 1;
+			}
+			return 0;
+		}
+	};
+	ndSort<ndUnsigned64, ndCompareKey>(&rayOrder[0], count, nullptr);
+
+	auto CastRays = [this, origins, dests, filterMasks, hits, &rayOrder](ndInt32, ndInt32 i)
+	{
+		const ndInt32 index = ndInt32(rayOrder[i] & 0x7fffffff);
+		ndRayCastHit& hit = hits[index];
+		hit.m_body = nullptr;
+		hit.m_shapeId = 0;
+		hit.m_param = ndFloat32(1.0f);
+		hit.m_point = dests[index];
+		hit.m_normal = ndVector::m_zero;
+
+		const ndVector p0(origins[index] & ndVector::m_triplexMask);
+		const ndVector p1(dests[index] & ndVector::m_triplexMask);
+		const ndVector segment(p1 - p0);
+		if (segment.DotProduct(segment).GetScalar() > ndFloat32(1.0e-8f))
+		{
+			ndRayCastBatchNotify callback(filterMasks ? filterMasks[index] : ndUnsigned64(-1));
+			callback.m_param = ndFloat32(1.2f);
+			const ndFastRay ray(p0, p1);
+			if (RayCast(callback, ray) && (callback.m_param < ndFloat32(1.0f)))
+			{
+				hit.m_point = callback.m_contact.m_point;
+				hit.m_normal = callback.m_contact.m_normal;
+				hit.m_body = callback.m_contact.m_body0;
+				hit.m_shapeId = callback.m_contact.m_shapeId0;
+				hit.m_param = callback.m_param;
+			}
+		}
+		hit.m_point.m_w = ndFloat32(1.0f);
+	};
+	ParallelFor(0, count, D_WORKER_BATCH_SIZE, CastRays);
+}
+
+void ndScene::OverlapBatch(const ndVector* const minBoxes, const ndVector* const maxBoxes, ndInt32 count, ndArray<const ndBody*>& bodies, ndInt32* const bodyStart)
+{
+	D_TRACKTIME();
+	bodyStart[0] = 0;
+	bodies.SetCount(0);
+	if (!count)
+	{
+		return;
+	}
+	ValidateWideTrees();
+
+	// each query writes its bodies to the scratch of the worker that ran it, 
+	// the lists are then packed in query order. the scratch belongs to this 
+	// call, so concurrent batches do not overwrite each other.
+	ndFixSizeArray<ndArray<const ndBody*>, D_MAX_THREADS_COUNT> overlapBodies;
+	overlapBodies.SetCount(GetThreadCount());
+	ndArray<ndInt32> queryThread;
+	ndArray<ndInt32> queryOffset;
+	queryThread.SetCount(count);
+	queryOffset.SetCount(count);
+	auto FindOverlaps = [this, minBoxes, maxBoxes, bodyStart, &overlapBodies, &queryThread, &queryOffset](ndInt32 threadIndex, ndInt32 i)
+	{
+		ndArray<const ndBody*>& scratch = overlapBodies[threadIndex];
+		const ndInt32 offset = ndInt32(scratch.GetCount());
+		ndOverlapBatchNotify notify(scratch);
+		BodiesInAabb(notify, minBoxes[i], maxBoxes[i]);
+		queryThread[i] = threadIndex;
+		queryOffset[i] = offset;
+		bodyStart[i + 1] = ndInt32(scratch.GetCount()) - offset;
+	};
+	ParallelFor(0, count, D_WORKER_BATCH_SIZE, FindOverlaps);
+
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		bodyStart[i + 1] += bodyStart[i];
+	}
+	bodies.SetCount(bodyStart[count]);
+
+	auto PackOverlaps = [bodyStart, &bodies, &overlapBodies, &queryThread, &queryOffset](ndInt32, ndInt32 i)
+	{
+		const ndArray<const ndBody*>& scratch = overlapBodies[queryThread[i]];
+		const ndInt32 offset = queryOffset[i];
+		const ndInt32 start = bodyStart[i];
+		const ndInt32 bodyCount = bodyStart[i + 1] - start;
+		for (ndInt32 j = 0; j < bodyCount; ++j)
+		{
+			bodies[start + j] = scratch[offset + j];
+		}
+	};
+	ParallelFor(0, count, D_WORKER_BATCH_SIZE, PackOverlaps);
+}
+
+void ndScene::ConvexCastBatch(const ndShapeInstance* const* const shapes, const ndMatrix* const origins, const ndVector* const dests, ndInt32 count, ndConvexCastHit* const hits)
+{
+	D_TRACKTIME();
+	ValidateWideTrees();
+
+	// the proxy bodies of the casting shapes are made here, one per worker, 
+	// making them from the workers would race on the body unique id counter.
+	ndFixSizeArray<ndBodyKinematic*, D_MAX_THREADS_COUNT> castingBodies;
+	for (ndInt32 i = 0; i < GetThreadCount(); ++i)
+	{
+		castingBodies.PushBack(new ndBodyKinematic());
+	}
+
+	// the thread index routes the static mesh face queries to the scratch of each worker
+	auto CastShapes = [this, shapes, origins, dests, hits, &castingBodies](ndInt32 threadIndex, ndInt32 i)
+	{
+		ndConvexCastHit& hit = hits[i];
+		hit.m_point = dests[i];
+		hit.m_point.m_w = ndFloat32(1.0f);
+		hit.m_normal = ndVector::m_zero;
+		hit.m_body = nullptr;
+		hit.m_param = ndFloat32(1.0f);
+
+		ndConvexCastBatchNotify callback;
+		const ndVector velocA((dests[i] - origins[i].m_posit) & ndVector::m_triplexMask);
+		const ndFastRay ray(ndVector::m_zero, velocA);
+		if (ConvexCast(callback, ray, castingBodies[threadIndex], *shapes[i], origins[i], dests[i], threadIndex) && (callback.m_param < ndFloat32(1.0f)))
+		{
+			const ndContactPoint& contact = callback.m_contacts[0];
+			hit.m_point = contact.m_point;
+			hit.m_point.m_w = ndFloat32(1.0f);
+			hit.m_normal = contact.m_normal;
+			hit.m_body = contact.m_body1;
+			hit.m_param = callback.m_param;
+		}
+	};
+	ParallelFor(0, count, D_WORKER_BATCH_SIZE / 4, CastShapes);
+
+	for (ndInt32 i = 0; i < castingBodies.GetCount(); ++i)
+	{
+		delete castingBodies[i];
+	}
+}
+
 bool ndScene::ConvexCast(ndConvexCastNotify& callback, const ndShapeInstance& convexShape, const ndMatrix& globalOrigin, const ndVector& globalDest) const
 {
 	bool state = false;
 	callback.m_param = ndFloat32(1.2f);
-	if (m_rootNode)
+	ValidateWideTrees();
+	if (m_rootNode || m_staticRootNode)
 	{
-		ndVector boxP0;
-		ndVector boxP1;
-		ndAssert(globalOrigin.TestOrthogonal());
-		convexShape.CalculateAabb(globalOrigin, boxP0, boxP1);
-
-		ndFloat32 distance[D_SCENE_MAX_STACK_DEPTH];
-		const ndBvhNode* stackPool[D_SCENE_MAX_STACK_DEPTH];
-
-		const ndVector velocB(ndVector::m_zero);
 		const ndVector velocA((globalDest - globalOrigin.m_posit) & ndVector::m_triplexMask);
-		const ndVector minBox(m_rootNode->m_minBox - boxP1);
-		const ndVector maxBox(m_rootNode->m_maxBox - boxP0);
 		ndFastRay ray(ndVector::m_zero, velocA);
-
-		stackPool[0] = m_rootNode;
-		distance[0] = ray.BoxIntersect(minBox, maxBox);
-		state = ConvexCast(callback, stackPool, distance, 1, ray, convexShape, globalOrigin, globalDest);
+		ndBodyKinematic castingBody;
+		state = ConvexCast(callback, ray, &castingBody, convexShape, globalOrigin, globalDest, 0);
 	}
 	return state;
 }
 
+void ndScene::ValidateWideTrees() const
+{
+	// bodies added or removed since the last update are not in the wide trees yet
+	if (m_bvhSceneManager.IsWideTreeDirty() || m_staticBvhSceneManager.IsWideTreeDirty())
+	{
+		ndScene* const scene = (ndScene*)this;
+		ndScopeSpinLock lock(scene->m_lock);
+		// another query may have rebuilt them while this one waited for the lock
+		if (m_bvhSceneManager.IsWideTreeDirty())
+		{
+			scene->m_bvhSceneManager.UpdateWideTree(*scene, m_rootNode, false);
+		}
+		if (m_staticBvhSceneManager.IsWideTreeDirty())
+		{
+			scene->m_staticBvhSceneManager.UpdateWideTree(*scene, m_staticRootNode, false);
+		}
+	}
+}
+
 void ndScene::SendBackgroundTask(ndBackgroundTask* const job)
 {
 	if (m_backgroundThread)
@@ -1320,7 +1860,7 @@ void ndScene::AddPair(ndBodyKinematic* const body0, ndBodyKinematic* const body1
 			}
 			if (selfSkelCollidable)
 			{
-				ndArray<ndContactPairs>& particalPairs = m_partialNewPairs[threadId];
+				ndArray<ndContactPairs>& particalPairs = m_threadLocalData[threadId]->m_partialNewPairs;
 				ndContactPairs pair(ndUnsigned32(body0->m_index), ndUnsigned32(body1->m_index));
 				particalPairs.PushBack(pair);
 			}
@@ -1331,63 +1871,33 @@ void ndScene::AddPair(ndBodyKinematic* const body0, ndBodyKinematic* const body1
 void ndScene::FindCollidingPairs()
 {
 	D_TRACKTIME();
-	ndAtomic<ndInt32> iterator0(0);
-	auto FindPairsForward = ndMakeObject::ndFunction([this, &iterator0](ndInt32 threadIndex, ndInt32)
+	auto FindPairs = [this](ndInt32 threadIndex, ndInt32 i)
 	{
-		D_TRACKTIME_NAMED(FindPairsForward);
-		const ndArray<ndBodyKinematic*>& bodyArray = m_sceneBodyArray;
-
-		const ndInt32 count = ndInt32(m_sceneBodyArray.GetCount());
-		for (ndInt32 i = iterator0.fetch_add(D_WORKER_BATCH_SIZE); i < count; i = iterator0.fetch_add(D_WORKER_BATCH_SIZE))
-		{
-			const ndInt32 maxSpan = ((count - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : count - i;
-			for (ndInt32 j = 0; j < maxSpan; ++j)
-			{
-				ndBodyKinematic* const body = bodyArray[i + j];
-				FindCollidingPairsForward(body, threadIndex);
-			}
-		}
-	});
-
-	ndAtomic<ndInt32> iterator1(0);
-	auto FindPairsBackward = ndMakeObject::ndFunction([this, &iterator1](ndInt32 threadIndex, ndInt32)
-	{
-		D_TRACKTIME_NAMED(FindPairsBackward);
-		const ndArray<ndBodyKinematic*>& bodyArray = m_sceneBodyArray;
-
-		const ndInt32 count = ndInt32(m_sceneBodyArray.GetCount());
-		for (ndInt32 i = iterator1.fetch_add(D_WORKER_BATCH_SIZE); i < count; i = iterator1.fetch_add(D_WORKER_BATCH_SIZE))
-		{
-			const ndInt32 maxSpan = ((count - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : count - i;
-			for (ndInt32 j = 0; j < maxSpan; ++j)
-			{
-				ndBodyKinematic* const body = bodyArray[i + j];
-				FindCollidingPairsBackward(body, threadIndex);
-			}
-		}
-	});
+		ndBodyKinematic* const body = m_sceneBodyArray[i];
+		FindCollidingPairs(body, threadIndex);
+	};
 
 	for (ndInt32 i = GetThreadCount() - 1; i >= 0; --i)
 	{
-		m_partialNewPairs[i].SetCount(0);
+		m_threadLocalData[i]->m_partialNewPairs.SetCount(0);
 	}
 
 	const ndInt32 threadCount = GetThreadCount();
 
-	ParallelExecute(FindPairsForward);
-	ParallelExecute(FindPairsBackward);
+	const ndInt32 bodyCount = ndInt32(m_sceneBodyArray.GetCount());
+	ParallelFor(0, bodyCount, D_WORKER_BATCH_SIZE, FindPairs);
 
 	ndInt32 sum = 0;
 	for (ndInt32 i = 0; i < threadCount; ++i)
 	{
-		sum += ndInt32(m_partialNewPairs[i].GetCount());
+		sum += ndInt32(m_threadLocalData[i]->m_partialNewPairs.GetCount());
 	}
 	m_newPairs.SetCount(sum);
 
 	sum = 0;
 	for (ndInt32 i = 0; i < threadCount; ++i)
 	{
-		const ndArray<ndContactPairs>& newPairs = m_partialNewPairs[i];
+		const ndArray<ndContactPairs>& newPairs = m_threadLocalData[i]->m_partialNewPairs;
 		const ndInt32 count = ndInt32(newPairs.GetCount());
 		if (count)
 		{
@@ -1406,6 +1916,62 @@ void ndScene::UpdateBodyList()
 	}
 }
 
+void ndScene::SetIncrementalBvhRefit(bool state)
+{
+	if (state != m_incrementalBvhRefit)
+	{
+		// the cost of each subtree is only tracked in incremental mode, start from a fresh tree.
+		m_incrementalBvhRefit = state;
+		m_forceBalanceSceneCounter = 0;
+		m_forceBalanceStaticSceneCounter = 0;
+	}
+}
+
+void ndScene::GetBvhRebuildCount(ndInt32& fullRebuilds, ndInt32& partialRebuilds) const
+{
+	fullRebuilds = m_bvhSceneManager.GetFullRebuildCount() + m_staticBvhSceneManager.GetFullRebuildCount();
+	partialRebuilds = m_bvhSceneManager.GetPartialRebuildCount() + m_staticBvhSceneManager.GetPartialRebuildCount();
+}
+
+void ndScene::GetStaticBvhRebuildCount(ndInt32& fullRebuilds, ndInt32& partialRebuilds) const
+{
+	fullRebuilds = m_staticBvhSceneManager.GetFullRebuildCount();
+	partialRebuilds = m_staticBvhSceneManager.GetPartialRebuildCount();
+}
+
+ndInt32 ndScene::GetStaticTreeBodyCount() const
+{
+	ndInt32 count = 0;
+	const ndBodyListView& bodyList = GetBodyList();
+	for (ndBodyListView::ndNode* node = bodyList.GetFirst(); node; node = node->GetNext())
+	{
+		const ndBodyKinematic* const body = node->GetInfo()->GetAsBodyKinematic();
+		count += body->m_staticSceneTree ? 1 : 0;
+	}
+	return count;
+}
+
+void ndScene::GetNarrowPhaseCount(ndInt32& narrowPhasePairs, ndInt32& skippedPairs) const
+{
+	narrowPhasePairs = 0;
+	skippedPairs = 0;
+	for (ndInt32 i = ndInt32(m_threadLocalData.GetCount()) - 1; i >= 0; --i)
+	{
+		narrowPhasePairs += m_threadLocalData[i]->m_narrowPhasePairs;
+		skippedPairs += m_threadLocalData[i]->m_skippedPairs;
+	}
+}
+
+void ndScene::GetCompoundPairCount(ndInt32& compoundPairs, ndInt32& childPairs) const
+{
+	childPairs = 0;
+	compoundPairs = ndInt32(m_compoundContactArray.GetCount());
+	for (ndInt32 i = 0; i < compoundPairs; ++i)
+	{
+		childPairs += m_compoundContactArray[i].m_childPairCount;
+	}
+}
+
 void ndScene::ApplyExtForce()
 {
 	D_TRACKTIME();
@@ -1431,6 +1997,174 @@ void ndScene::ApplyExtForce()
 	ParallelExecute(ApplyForce);
 }
 
+void ndScene::PrepareBodyArray()
+{
+	D_TRACKTIME();
+	ndAtomic<ndInt32> iterator(0);
+	auto PrepareBodies = ndMakeObject::ndFunction([this, &iterator](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(PrepareBodies);
+		const ndArray<ndBodyKinematic*>& view = GetActiveBodyArray();
+
+		const ndInt32 count = ndInt32(view.GetCount()) - 1;
+		for (ndInt32 i = iterator.fetch_add(D_WORKER_BATCH_SIZE); i < count; i = iterator.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((count - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : count - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				ndBodyKinematic* const body = view[i + j];
+				body->PrepareStep(i + j);
+			}
+		}
+	});
+	ParallelExecute(PrepareBodies);
+
+	// the solver appends the bilateral joints to the active array and drops the 
+	// resting ones, so each sub step starts again from the contacts of the narrow phase, 
+	// they are still first in the contact array since the last DeleteDeadContacts.
+	ndInt32 activeCount = 0;
+	const ndInt32 contactCount = ndInt32(m_contactArray.GetCount());
+	m_activeConstraintArray.SetCount(contactCount);
+	for (ndInt32 i = 0; i < contactCount; ++i)
+	{
+		ndContact* const contact = m_contactArray[i];
+		if (!(contact->IsActive() && contact->m_maxDof))
+		{
+			break;
+		}
+		m_activeConstraintArray[activeCount] = contact;
+		activeCount++;
+	}
+	m_activeConstraintArray.SetCount(activeCount);
+}
+
+void ndScene::AdvanceContacts()
+{
+	D_TRACKTIME();
+	ndAtomic<ndInt32> iterator(0);
+	auto AdvanceContacts = ndMakeObject::ndFunction([this, &iterator](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(AdvanceContacts);
+		const ndVector timestep(m_timestep);
+		const ndVector half(ndFloat32(0.5f));
+		ndContact** const contactArray = &m_contactArray[0];
+
+		// the points move with the average of the two bodies, and the separation along the 
+		// normal changes by the relative velocity, a penetration that turns negative is a 
+		// gap the solver handles as a speculative contact.
+		const ndInt32 count = ndInt32(m_contactArray.GetCount());
+		for (ndInt32 i = iterator.fetch_add(D_WORKER_BATCH_SIZE); i < count; i = iterator.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((count - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : count - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				ndContact* const contact = contactArray[i + j];
+				const ndBodyKinematic* const body0 = contact->GetBody0();
+				const ndBodyKinematic* const body1 = contact->GetBody1();
+				if (body0->m_equilibrium & body1->m_equilibrium)
+				{
+					continue;
+				}
+
+				// the bodies moved without a narrow phase, so the cached separation has to 
+				// shrink by the same bound the narrow phase uses, or a pair could skip it.
+				if (contact->m_separationDistance > ndFloat32(0.0f))
+				{
+					contact->m_separationDistance -= ClosingSpeedBound(contact) * m_timestep;
+				}
+
+				if (contact->IsActive() && contact->m_maxDof)
+				{
+					const ndVector com0(body0->m_globalCentreOfMass);
+					const ndVector com1(body1->m_globalCentreOfMass);
+					const ndVector veloc0(body0->m_veloc & ndVector::m_triplexMask);
+					const ndVector veloc1(body1->m_veloc & ndVector::m_triplexMask);
+					const ndVector omega0(body0->m_omega & ndVector::m_triplexMask);
+					const ndVector omega1(body1->m_omega & ndVector::m_triplexMask);
+					for (ndContactPointList::ndNode* node = contact->m_contacPointsList.GetFirst(); node; node = node->GetNext())
+					{
+						ndContactMaterial& point = node->GetInfo();
+						const ndVector pointVeloc0(veloc0 + omega0.CrossProduct(point.m_point - com0));
+						const ndVector pointVeloc1(veloc1 + omega1.CrossProduct(point.m_point - com1));
+						const ndVector separationStep(point.m_normal.DotProduct(pointVeloc0 - pointVeloc1) * timestep);
+						point.m_penetration -= separationStep.GetScalar();
+						point.m_speculative = point.m_penetration < ndFloat32(0.0f);
+						point.m_point += ((pointVeloc0 + pointVeloc1) * half * timestep) & ndVector::m_triplexMask;
+					}
+				}
+			}
+		}
+	});
+	ParallelExecute(AdvanceContacts);
+}
+
+void ndScene::UpdateBodyBoxes()
+{
+	D_TRACKTIME();
+	ndAtomic<ndInt32> iterator(0);
+	ndAtomic<ndInt32> refitCount(0);
+	ndAtomic<ndInt32> staticRefitCount(0);
+	auto UpdateBodyBoxes = ndMakeObject::ndFunction([this, &iterator, &refitCount, &staticRefitCount](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(UpdateBodyBoxes);
+		const ndArray<ndBodyKinematic*>& view = GetActiveBodyArray();
+
+		ndInt32 refit = 0;
+		ndInt32 staticRefit = 0;
+		const ndInt32 count = ndInt32(view.GetCount()) - 1;
+		for (ndInt32 i = iterator.fetch_add(D_WORKER_BATCH_SIZE); i < count; i = iterator.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((count - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : count - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				ndBodyKinematic* const body = view[i + j];
+				if (body->m_equilibrium)
+				{
+					continue;
+				}
+
+				body->UpdateCollisionMatrix();
+				ndBvhSceneManager& bvhSceneManager = GetBvhSceneManager(body);
+				ndBvhLeafNode* const bodyNode = (ndBvhLeafNode*)bvhSceneManager.GetNodeArray()[body->m_bodyNodeIndex];
+				ndAssert(bodyNode->GetAsSceneBodyNode());
+				ndAssert(bodyNode->m_body == body);
+
+				// the node box usually still covers the sweep of the colliding sub step, 
+				// it and its parents are only refitted when the body left it.
+				if (!ndBoxInclusionTest(body->m_minAabb, body->m_maxAabb, bodyNode->m_minBox, bodyNode->m_maxBox))
+				{
+					bodyNode->SetAabb(body->m_minAabb, body->m_maxAabb);
+					if (m_incrementalBvhRefit)
+					{
+						bvhSceneManager.MarkSahDirty(bodyNode);
+					}
+					for (ndBvhInternalNode* parent = (ndBvhInternalNode*)bodyNode->m_parent; parent; parent = (ndBvhInternalNode*)parent->m_parent)
+					{
+						ndAssert(parent->GetAsSceneTreeNode());
+						ndScopeSpinLock lock(parent->m_lock);
+						const ndVector minBox(parent->m_left->m_minBox.GetMin(parent->m_right->m_minBox));
+						const ndVector maxBox(parent->m_left->m_maxBox.GetMax(parent->m_right->m_maxBox));
+						if (ndBoxInclusionTest(minBox, maxBox, parent->m_minBox, parent->m_maxBox))
+						{
+							break;
+						}
+						parent->m_minBox = minBox;
+						parent->m_maxBox = maxBox;
+					}
+					staticRefit += body->m_staticSceneTree;
+					refit += 1 - body->m_staticSceneTree;
+				}
+			}
+		}
+		refitCount.fetch_add(refit);
+		staticRefitCount.fetch_add(staticRefit);
+	});
+	ParallelExecute(UpdateBodyBoxes);
+
+	m_bvhSceneManager.UpdateWideTree(*this, m_rootNode, refitCount.load() != 0);
+	m_staticBvhSceneManager.UpdateWideTree(*this, m_staticRootNode, staticRefitCount.load() != 0);
+}
+
 void ndScene::InitBodyArray()
 {
 	D_TRACKTIME();
@@ -1440,7 +2174,6 @@ void ndScene::InitBodyArray()
 		D_TRACKTIME_NAMED(BuildBodyArray);
 		const ndArray<ndBodyKinematic*>& view = GetActiveBodyArray();
 
-		ndBvhNodeArray& array = m_bvhSceneManager.GetNodeArray();
 		const ndInt32 count = ndInt32(view.GetCount()) - 1;
 		for (ndInt32 i = iterator.fetch_add(D_WORKER_BATCH_SIZE); i < count; i = iterator.fetch_add(D_WORKER_BATCH_SIZE))
 		{
@@ -1454,19 +2187,46 @@ void ndScene::InitBodyArray()
 				ndUnsigned8 moving = ndUnsigned8(!body->m_equilibrium);
 				if (moving | sceneForceUpdate)
 				{
-					ndBvhLeafNode* const bodyNode = (ndBvhLeafNode*)array[body->m_bodyNodeIndex];
+					ndBvhSceneManager& bvhSceneManager = GetBvhSceneManager(body);
+					ndBvhLeafNode* const bodyNode = (ndBvhLeafNode*)bvhSceneManager.GetNodeArray()[body->m_bodyNodeIndex];
 					ndAssert(bodyNode->GetAsSceneBodyNode());
 					ndAssert(bodyNode->m_body == body);
 					ndAssert(!bodyNode->GetLeft());
 					ndAssert(!bodyNode->GetRight());
 
 					body->UpdateCollisionMatrix();
-					const ndInt32 test = ndBoxInclusionTest(body->m_minAabb, body->m_maxAabb, bodyNode->m_minBox, bodyNode->m_maxBox);
+					ndVector minAabb(body->m_minAabb);
+					ndVector maxAabb(body->m_maxAabb);
+					if (body->m_continueCollision || m_speculativeContacts)
+					{
+						// the node box covers the sweep of the step, so the broad phase finds 
+						// the pairs that the continue collision has to test, the body keeps its own box.
+						const ndVector step(body->m_veloc.Scale(m_timestep) & ndVector::m_triplexMask);
+						minAabb += step.GetMin(ndVector::m_zero);
+						maxAabb += step.GetMax(ndVector::m_zero);
+					}
+					const ndInt32 test = ndBoxInclusionTest(minAabb, maxAabb, bodyNode->m_minBox, bodyNode->m_maxBox);
 					if (!test)
 					{
-						bodyNode->SetAabb(body->m_minAabb, body->m_maxAabb);
+						bodyNode->SetAabb(minAabb, maxAabb);
+						if (m_incrementalBvhRefit)
+						{
+							bvhSceneManager.MarkSahDirty(bodyNode);
+						}
 					}
 					sceneEquilibrium = ndUnsigned8(!sceneForceUpdate & (test != 0));
+					body->m_sceneTreeMoved = ndUnsigned8(body->m_sceneTreeMoved | moving | (test == 0));
+				}
+				if (sceneForceUpdate)
+				{
+					// a body placed by the application did not move by its velocity, 
+					// so the separation distance cached on its contacts is no longer valid.
+					ndBodyKinematic::ndContactMap::Iterator it(body->m_contactList);
+					for (it.Begin(); it; it++)
+					{
+						ndContact* const contact = *it;
+						contact->m_separationDistance = ndFloat32(0.0f);
+					}
 				}
 				body->m_sceneForceUpdate = 0;
 				body->m_sceneEquilibrium = sceneEquilibrium;
@@ -1501,18 +2261,28 @@ void ndScene::InitBodyArray()
 		m_sceneBodyArray.SetCount(movingBodyCount);
 	}
 
-	if (m_rootNode && m_rootNode->GetAsSceneTreeNode())
+	ndInt32 staticMovingBodyCount = 0;
+	for (ndInt32 i = 0; i < movingBodyCount; ++i)
 	{
-		const ndInt32 bodyCount = m_bodyList.GetCount();
-		const ndInt32 cutoffCount = (ndExp2(bodyCount) + 1) * movingBodyCount;
-		if (cutoffCount < bodyCount)
+		staticMovingBodyCount += m_sceneBodyArray[i]->m_staticSceneTree;
+	}
+	m_staticSceneMoved = m_staticSceneMoved || (staticMovingBodyCount != 0);
+
+	const bool dynamicTree = m_rootNode && m_rootNode->GetAsSceneTreeNode();
+	const bool staticTree = m_staticRootNode && m_staticRootNode->GetAsSceneTreeNode();
+	if (dynamicTree || staticTree)
+	{
+		// the static tree is always refitted by walking up from the few bodies that moved.
+		const ndInt32 bodyCount = ndInt32(m_bvhSceneManager.GetNodeArray().GetCount()) / 2;
+		const ndInt32 cutoffCount = (ndExp2(bodyCount) + 1) * (movingBodyCount - staticMovingBodyCount);
+		const bool lightRefit = cutoffCount < bodyCount;
+		if (lightRefit || staticMovingBodyCount)
 		{
 			ndAtomic<ndInt32> iterator1(0);
-			auto UpdateSceneBvh = ndMakeObject::ndFunction([this, &iterator1](ndInt32, ndInt32)
+			auto UpdateSceneBvh = ndMakeObject::ndFunction([this, &iterator1, lightRefit](ndInt32, ndInt32)
 			{
 				D_TRACKTIME_NAMED(UpdateSceneBvh);
 				const ndArray<ndBodyKinematic*>& view = m_sceneBodyArray;
-				ndBvhNodeArray& array = m_bvhSceneManager.GetNodeArray();
 
 				const ndInt32 count = ndInt32(view.GetCount());
 				for (ndInt32 i = iterator1.fetch_add(D_WORKER_BATCH_SIZE); i < count; i = iterator1.fetch_add(D_WORKER_BATCH_SIZE))
@@ -1521,24 +2291,25 @@ void ndScene::InitBodyArray()
 					for (ndInt32 j = 0; j < maxSpan; ++j)
 					{
 						ndBodyKinematic* const body = view[i + j];
-						ndBvhLeafNode* const bodyNode = (ndBvhLeafNode*)array[body->m_bodyNodeIndex];
-						ndAssert(bodyNode->GetAsSceneBodyNode());
-						ndAssert(bodyNode->GetBody() == body);
-
-						const ndBvhNode* const root = (m_rootNode->GetLeft() && m_rootNode->GetRight()) ? nullptr : m_rootNode;
-						ndAssert(root == nullptr);
-						for (ndBvhInternalNode* parent = (ndBvhInternalNode*)bodyNode->m_parent; parent != root; parent = (ndBvhInternalNode*)parent->m_parent)
+						if (lightRefit || body->m_staticSceneTree)
 						{
-							ndAssert(parent->GetAsSceneTreeNode());
-							ndScopeSpinLock lock(parent->m_lock);
-							const ndVector minBox(parent->m_left->m_minBox.GetMin(parent->m_right->m_minBox));
-							const ndVector maxBox(parent->m_left->m_maxBox.GetMax(parent->m_right->m_maxBox));
-							if (ndBoxInclusionTest(minBox, maxBox, parent->m_minBox, parent->m_maxBox))
+							ndBvhLeafNode* const bodyNode = (ndBvhLeafNode*)GetBvhSceneManager(body).GetNodeArray()[body->m_bodyNodeIndex];
+							ndAssert(bodyNode->GetAsSceneBodyNode());
+							ndAssert(bodyNode->GetBody() == body);
+
+							for (ndBvhInternalNode* parent = (ndBvhInternalNode*)bodyNode->m_parent; parent; parent = (ndBvhInternalNode*)parent->m_parent)
 							{
-								break;
+								ndAssert(parent->GetAsSceneTreeNode());
+								ndScopeSpinLock lock(parent->m_lock);
+								const ndVector minBox(parent->m_left->m_minBox.GetMin(parent->m_right->m_minBox));
+								const ndVector maxBox(parent->m_left->m_maxBox.GetMax(parent->m_right->m_maxBox));
+								if (ndBoxInclusionTest(minBox, maxBox, parent->m_minBox, parent->m_maxBox))
+								{
+									break;
+								}
+								parent->m_minBox = minBox;
+								parent->m_maxBox = maxBox;
 							}
-							parent->m_minBox = minBox;
-							parent->m_maxBox = maxBox;
 						}
 					}
 				}
@@ -1547,11 +2318,15 @@ void ndScene::InitBodyArray()
 			D_TRACKTIME_NAMED(UpdateSceneBvhLight);
 			ParallelExecute(UpdateSceneBvh);
 		}
-		else
+
+		if (!lightRefit && dynamicTree)
 		{
 			m_bvhSceneManager.UpdateScene(*this);
 		}
 	}
+
+	m_bvhSceneManager.UpdateWideTree(*this, m_rootNode, movingBodyCount > staticMovingBodyCount);
+	m_staticBvhSceneManager.UpdateWideTree(*this, m_staticRootNode, staticMovingBodyCount != 0);
 	
 	ndBodyKinematic* const sentinelBody = m_sentinelBody;
 	sentinelBody->PrepareStep(ndInt32(GetActiveBodyArray().GetCount()) - 1);
@@ -1571,9 +2346,9 @@ void ndScene::CreateNewContacts()
 {
 	D_TRACKTIME();
 	const ndInt32 contactCount = ndInt32(m_contactArray.GetCount());
-	m_scratchBuffer.SetCount(ndInt32((contactCount + m_newPairs.GetCount() + 16) * sizeof(ndContact*)));
-
-	ndContact** const tmpJointsArray = (ndContact**)&m_scratchBuffer[0];
+	// the array is also used by CalculateContacts and DeleteDeadContacts for this sub step
+	m_contactScratchArray = m_frameArena.Alloc<ndContact*>(ndInt32(contactCount + m_newPairs.GetCount() + 16));
+	ndContact** const tmpJointsArray = m_contactScratchArray;
 
 	ndAtomic<ndInt32> iterator(0);
 	auto CreateNewContacts = ndMakeObject::ndFunction([this, &iterator, tmpJointsArray](ndInt32, ndInt32)
@@ -1623,34 +2398,375 @@ void ndScene::CalculateContacts()
 {
 	D_TRACKTIME();
 	m_activeConstraintArray.SetCount(0);
+	m_continueContactArray.SetCount(0);
+	m_compoundContactArray.SetCount(0);
+	for (ndInt32 i = ndInt32(m_threadLocalData.GetCount()) - 1; i >= 0; --i)
+	{
+		m_threadLocalData[i]->m_narrowPhasePairs = 0;
+		m_threadLocalData[i]->m_skippedPairs = 0;
+		m_threadLocalData[i]->m_continueContacts.SetCount(0);
+		m_threadLocalData[i]->m_compoundContacts.SetCount(0);
+	}
+
 	ndScopeSpinLock lock(m_contactArray.GetLock());
 	const ndInt32 contactCount = ndInt32(m_contactArray.GetCount() + m_newPairs.GetCount());
 	m_contactArray.SetCount(contactCount);
 	if (contactCount)
 	{
-		ndContact** const tmpJointsArray = (ndContact**)&m_scratchBuffer[0];
+		ndAssert(m_contactScratchArray);
+		ndContact** const tmpJointsArray = m_contactScratchArray;
 
-		ndAtomic<ndInt32> iterator(0);
-		auto CalculateContactPoints = ndMakeObject::ndFunction([this, &iterator, tmpJointsArray](ndInt32 threadIndex, ndInt32)
+		auto CalculateContactPoints = [this, tmpJointsArray](ndInt32 threadIndex, ndInt32 i)
 		{
-			D_TRACKTIME_NAMED(CalculateContactPoints);
+			ndContact* const contact = tmpJointsArray[i];
+			ndAssert(contact);
+			if (!contact->m_isDead)
+			{
+				CalculateContacts(threadIndex, contact);
+			}
+		};
+		// contacts cost varies a lot (compounds, meshes), so use small chunks and let idle threads steal
+		ParallelFor(0, contactCount, D_WORKER_BATCH_SIZE / 4, CalculateContactPoints);
+
+		ndInt32 sum = 0;
+		for (ndInt32 i = ndInt32(m_threadLocalData.GetCount()) - 1; i >= 0; --i)
+		{
+			sum += ndInt32(m_threadLocalData[i]->m_continueContacts.GetCount());
+		}
+		m_continueContactArray.SetCount(sum);
 
-			const ndInt32 jointCount = ndInt32(m_contactArray.GetCount());
-			for (ndInt32 i = iterator.fetch_add(D_WORKER_BATCH_SIZE); i < jointCount; i = iterator.fetch_add(D_WORKER_BATCH_SIZE))
+		sum = 0;
+		for (ndInt32 i = ndInt32(m_threadLocalData.GetCount()) - 1; i >= 0; --i)
+		{
+			const ndArray<ndContact*>& continueContacts = m_threadLocalData[i]->m_continueContacts;
+			const ndInt32 count = ndInt32(continueContacts.GetCount());
+			if (count)
 			{
-				const ndInt32 maxSpan = ((jointCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : jointCount - i;
-				for (ndInt32 j = 0; j < maxSpan; ++j)
+				ndMemCpy(&m_continueContactArray[sum], &continueContacts[0], count);
+				sum += count;
+			}
+		}
+
+		for (ndInt32 i = ndInt32(m_threadLocalData.GetCount()) - 1; i >= 0; --i)
+		{
+			const ndArray<ndContact*>& compoundContacts = m_threadLocalData[i]->m_compoundContacts;
+			for (ndInt32 j = 0; j < ndInt32(compoundContacts.GetCount()); ++j)
+			{
+				ndCompoundContact compoundContact;
+				compoundContact.m_contact = compoundContacts[j];
+				compoundContact.m_separationDistance = ndFloat32(0.0f);
+				compoundContact.m_childPairStart = 0;
+				compoundContact.m_childPairCount = 0;
+				compoundContact.m_threadIndex = 0;
+				compoundContact.m_processContacts = 0;
+				m_compoundContactArray.PushBack(compoundContact);
+			}
+		}
+	}
+}
+
+bool ndScene::IsLargeCompoundPair(const ndContact* const contact) const
+{
+	// only the pairs solved by a compound traversal, compound against compound or against a static bvh mesh
+	const ndBodyKinematic* const body0 = contact->GetBody0();
+	const ndBodyKinematic* const body1 = contact->GetBody1();
+	if (body0->m_contactTestOnly | body1->m_contactTestOnly)
+	{
+		return false;
+	}
+
+	ndShape* const shape0 = (ndShape*)body0->GetCollisionShape().GetShape();
+	ndShape* const shape1 = (ndShape*)body1->GetCollisionShape().GetShape();
+	ndShapeCompound* const compound0 = shape0->GetAsShapeCompound();
+	if (!compound0)
+	{
+		return false;
+	}
+
+	ndInt32 childCount = ndInt32(compound0->GetTree().GetCount());
+	ndShapeCompound* const compound1 = shape1->GetAsShapeCompound();
+	if (compound1)
+	{
+		childCount += ndInt32(compound1->GetTree().GetCount());
+	}
+	else if (!shape1->GetAsShapeStaticBVH())
+	{
+		return false;
+	}
+	return childCount >= D_COMPOUND_SPLIT_CHILDREN;
+}
+
+void ndScene::CalculateCompoundContacts()
+{
+	D_TRACKTIME();
+	m_compoundChildBatchArray.SetCount(0);
+	const ndInt32 compoundCount = ndInt32(m_compoundContactArray.GetCount());
+	if (compoundCount)
+	{
+		for (ndInt32 i = ndInt32(m_threadLocalData.GetCount()) - 1; i >= 0; --i)
+		{
+			m_threadLocalData[i]->m_compoundChildPairs.SetCount(0);
+			m_threadLocalData[i]->m_compoundChildContacts.SetCount(0);
+		}
+
+		// one thread walks both trees of a pair and collects the overlapping leaves
+		auto FindChildPairs = [this](ndInt32 threadIndex, ndInt32 i)
+		{
+			CalculateCompoundChildPairs(threadIndex, m_compoundContactArray[i]);
+		};
+		ParallelFor(0, compoundCount, 1, FindChildPairs);
+
+		for (ndInt32 i = 0; i < compoundCount; ++i)
+		{
+			const ndCompoundContact& compoundContact = m_compoundContactArray[i];
+			for (ndInt32 j = 0; j < compoundContact.m_childPairCount; j += D_COMPOUND_CHILD_BATCH)
+			{
+				ndCompoundChildBatch batch;
+				batch.m_compoundIndex = i;
+				batch.m_childPairStart = compoundContact.m_childPairStart + j;
+				batch.m_childPairCount = ndMin(compoundContact.m_childPairCount - j, ndInt32(D_COMPOUND_CHILD_BATCH));
+				m_compoundChildBatchArray.PushBack(batch);
+			}
+		}
+
+		// the narrow phase of the child pairs is the expensive part, so a large pair 
+		// is shared by all threads instead of stalling the one that found it
+		const ndInt32 batchCount = ndInt32(m_compoundChildBatchArray.GetCount());
+		if (batchCount)
+		{
+			auto CalculateChildContacts = [this](ndInt32 threadIndex, ndInt32 i)
+			{
+				CalculateCompoundChildContacts(threadIndex, m_compoundChildBatchArray[i]);
+			};
+			ParallelFor(0, batchCount, 1, CalculateChildContacts);
+		}
+
+		auto MergeChildContacts = [this](ndInt32 threadIndex, ndInt32 i)
+		{
+			MergeCompoundChildContacts(threadIndex, m_compoundContactArray[i]);
+		};
+		ParallelFor(0, compoundCount, 1, MergeChildContacts);
+	}
+}
+
+void ndScene::CalculateCompoundChildPairs(ndInt32 threadIndex, ndCompoundContact& compoundContact)
+{
+	ndContact* const contact = compoundContact.m_contact;
+	ndArray<ndContactSolver::ndCompoundChildPair>& childPairs = m_threadLocalData[threadIndex]->m_compoundChildPairs;
+
+	compoundContact.m_threadIndex = threadIndex;
+	compoundContact.m_childPairStart = ndInt32(childPairs.GetCount());
+	compoundContact.m_processContacts = m_contactNotifyCallback->OnAabbOverlap(contact, m_timestep) ? 1 : 0;
+	if (compoundContact.m_processContacts)
+	{
+		ndContactSolver contactSolver(contact, m_contactNotifyCallback, m_timestep, threadIndex);
+		contactSolver.m_separatingVector = contact->m_separatingVector;
+		contactSolver.m_childPairs = &childPairs;
+		contactSolver.CompoundContactsDiscrete();
+		compoundContact.m_separationDistance = contactSolver.m_separationDistance;
+	}
+	compoundContact.m_childPairCount = ndInt32(childPairs.GetCount()) - compoundContact.m_childPairStart;
+}
+
+void ndScene::CalculateCompoundChildContacts(ndInt32 threadIndex, const ndCompoundChildBatch& batch)
+{
+	const ndCompoundContact& compoundContact = m_compoundContactArray[batch.m_compoundIndex];
+	ndContact* const contact = compoundContact.m_contact;
+	ndArray<ndContactSolver::ndCompoundChildPair>& childPairs = m_threadLocalData[compoundContact.m_threadIndex]->m_compoundChildPairs;
+	ndArray<ndContactPoint>& childContacts = m_threadLocalData[threadIndex]->m_compoundChildContacts;
+
+	ndContactSolver contactSolver(contact, m_contactNotifyCallback, m_timestep, threadIndex);
+	contactSolver.m_separatingVector = contact->m_separatingVector;
+	for (ndInt32 i = 0; i < batch.m_childPairCount; ++i)
+	{
+		ndContactSolver::ndCompoundChildPair& pair = childPairs[batch.m_childPairStart + i];
+		const ndInt32 start = ndInt32(childContacts.GetCount());
+		childContacts.SetCount(start + D_MAX_CONTATCS);
+		contactSolver.m_contactBuffer = &childContacts[start];
+		pair.m_contactCount = contactSolver.CompoundChildContactsDiscrete(pair.m_subShape0, pair.m_subShape1, pair.m_treeNode, 0, pair.m_separationDistance);
+		pair.m_contactStart = start;
+		pair.m_threadIndex = threadIndex;
+		childContacts.SetCount(start + pair.m_contactCount);
+	}
+}
+
+void ndScene::MergeCompoundChildContacts(ndInt32 threadIndex, const ndCompoundContact& compoundContact)
+{
+	ndContact* const contact = compoundContact.m_contact;
+	if (compoundContact.m_processContacts)
+	{
+		const ndArray<ndContactSolver::ndCompoundChildPair>& childPairs = m_threadLocalData[compoundContact.m_threadIndex]->m_compoundChildPairs;
+
+		ndContactPoint contactBuffer[D_MAX_CONTATCS];
+		ndContactSolver contactSolver(contact, m_contactNotifyCallback, m_timestep, threadIndex);
+		contactSolver.m_separatingVector = contact->m_separatingVector;
+		contactSolver.m_contactBuffer = contactBuffer;
+
+		// accumulate in the order of the traversal, so the result does not depend on the thread count
+		ndInt32 count = 0;
+		ndFloat32 closestDist = compoundContact.m_separationDistance * compoundContact.m_separationDistance;
+		for (ndInt32 i = 0; i < compoundContact.m_childPairCount; ++i)
+		{
+			const ndContactSolver::ndCompoundChildPair& pair = childPairs[compoundContact.m_childPairStart + i];
+			closestDist = ndMin(closestDist, pair.m_separationDistance * pair.m_separationDistance);
+			const ndInt32 childCount = ndMin(pair.m_contactCount, D_MAX_CONTATCS - count);
+			if (childCount)
+			{
+				const ndArray<ndContactPoint>& childContacts = m_threadLocalData[pair.m_threadIndex]->m_compoundChildContacts;
+				ndMemCpy(&contactBuffer[count], &childContacts[pair.m_contactStart], childCount);
+				count += childCount;
+				if (count > (D_MAX_CONTATCS - 2 * (D_CONSTRAINT_MAX_ROWS / 3)))
 				{
-					ndContact* const contact = tmpJointsArray[i + j];
-					ndAssert(contact);
-					if (!contact->m_isDead)
-					{
-						CalculateContacts(threadIndex, contact);
-					}
+					count = contactSolver.PruneContacts(count, 16);
 				}
 			}
-		});
-		ParallelExecute(CalculateContactPoints);
+		}
+		if (count > 1)
+		{
+			count = contactSolver.PruneContacts(count, 16);
+		}
+
+		contact->m_timeOfImpact = m_timestep;
+		contact->m_separationDistance = ndSqrt(closestDist);
+		if (count)
+		{
+			contact->SetActive(true);
+			ndAssert(count <= (D_CONSTRAINT_MAX_ROWS / 3));
+			ProcessContacts(threadIndex, count, &contactSolver);
+			ndAssert(contact->m_maxDof);
+			contact->m_isIntersetionTestOnly = 0;
+		}
+		else
+		{
+			contact->m_maxDof = 0;
+		}
+	}
+
+	if (contact->m_maxDof)
+	{
+		contact->SetActive(true);
+		contact->m_timeOfImpact = ndFloat32(1.0e10f);
+	}
+}
+
+void ndScene::CalculateContinueContacts()
+{
+	D_TRACKTIME();
+	const ndInt32 contactCount = ndInt32(m_continueContactArray.GetCount());
+	if (contactCount)
+	{
+		auto CalculateContactPoints = [this](ndInt32 threadIndex, ndInt32 i)
+		{
+			CalculateContinueContacts(threadIndex, m_continueContactArray[i]);
+		};
+		// every pair can be an expensive time of impact query, so hand them out one at the time
+		ParallelFor(0, contactCount, 1, CalculateContactPoints);
+
+		// a body can be in many of these pairs, so they are woken up after the workers are done
+		for (ndInt32 i = 0; i < contactCount; ++i)
+		{
+			ndContact* const contact = m_continueContactArray[i];
+			if (contact->m_maxDof || contact->m_isIntersetionTestOnly)
+			{
+				ndBodyKinematic* const body0 = contact->GetBody0();
+				ndBodyKinematic* const body1 = contact->GetBody1();
+				ndAssert(body0->GetInvMass() > ndFloat32(0.0f));
+				body0->m_equilibrium = 0;
+				if (body1->GetInvMass() > ndFloat32(0.0f))
+				{
+					body1->m_equilibrium = 0;
+				}
+			}
+		}
+	}
+}
+
+void ndScene::CalculateContinueContacts(ndInt32 threadIndex, ndContact* const contact)
+{
+	ndAssert(!contact->m_isDead);
+	ndAssert(!contact->IsActive());
+
+	// the discrete contacts come first, only pairs that are apart can tunnel
+	if (CalculateJointContacts(threadIndex, contact) && !(contact->m_maxDof || contact->m_isIntersetionTestOnly))
+	{
+		CalculateTimeOfImpactContacts(threadIndex, contact);
+	}
+
+	if (contact->m_maxDof || contact->m_isIntersetionTestOnly)
+	{
+		contact->SetActive(true);
+	}
+}
+
+void ndScene::CalculateTimeOfImpactContacts(ndInt32 threadIndex, ndContact* const contact)
+{
+	ndBodyKinematic* const body0 = contact->GetBody0();
+	ndBodyKinematic* const body1 = contact->GetBody1();
+	ndShapeInstance* const instance0 = &body0->GetCollisionShape();
+	ndShapeInstance* const instance1 = &body1->GetCollisionShape();
+
+	// the continue solver sweeps a convex shape against convex, compound and static mesh shapes
+	ndShape* const shape0 = instance0->GetShape();
+	ndShape* const shape1 = instance1->GetShape();
+	if (!shape0->GetAsShapeConvex() || shape0->GetAsShapeNull() || shape1->GetAsShapeNull())
+	{
+		return;
+	}
+	if (!(shape1->GetAsShapeConvex() || shape1->GetAsShapeCompound() || shape1->GetAsShapeStaticMesh()))
+	{
+		return;
+	}
+
+	// the linear motion of the step can not reach the other shape
+	const ndVector relVeloc(body0->GetVelocity() - body1->GetVelocity());
+	const ndFloat32 step2 = relVeloc.DotProduct(relVeloc & ndVector::m_triplexMask).GetScalar() * m_timestep * m_timestep;
+	const ndFloat32 separation = contact->m_separationDistance;
+	if (step2 <= separation * separation)
+	{
+		return;
+	}
+
+	// not all continue queries fill the shape of the points
+	ndContactPoint contactBuffer[D_MAX_CONTATCS];
+	for (ndInt32 i = 0; i < D_MAX_CONTACT_POINTS; ++i)
+	{
+		contactBuffer[i].m_shapeInstance0 = instance0;
+		contactBuffer[i].m_shapeInstance1 = instance1;
+		contactBuffer[i].m_shapeId0 = 0;
+		contactBuffer[i].m_shapeId1 = 0;
+	}
+
+	ndContactSolver contactSolver(contact, m_contactNotifyCallback, m_timestep, threadIndex);
+	contactSolver.m_separatingVector = contact->m_separatingVector;
+	contactSolver.m_contactBuffer = contactBuffer;
+
+	const ndVector separatingVector(contact->m_separatingVector);
+	const ndInt32 count = ndMin(contactSolver.CalculateContactsContinue(), ndInt32(D_MAX_CONTACT_POINTS));
+	const ndFloat32 timeOfImpact = contactSolver.m_timestep;
+
+	// the next steps use the discrete separation, not the one at the time of impact
+	contact->m_separationDistance = separation;
+	contact->m_separatingVector = separatingVector;
+	if (count && (timeOfImpact < m_timestep))
+	{
+		// the points are on the shapes at the time of impact, the closing 
+		// speed times the time of impact is the gap the solver can close.
+		for (ndInt32 i = 0; i < count; ++i)
+		{
+			ndContactPoint& point = contactBuffer[i];
+			const ndFloat32 closingSpeed = ndMax(-point.m_normal.DotProduct(relVeloc).GetScalar(), ndFloat32(0.0f));
+			point.m_body0 = body0;
+			point.m_body1 = body1;
+			point.m_penetration = -ndMax(closingSpeed * timeOfImpact - D_PENETRATION_TOL, ndFloat32(0.0f));
+		}
+		ProcessContacts(threadIndex, count, &contactSolver);
+		contact->m_timeOfImpact = timeOfImpact;
+
+		ndContactPointList& contactPointList = contact->m_contacPointsList;
+		for (ndInt32 i = contactPointList.GetCount() - 1; i >= 0; --i)
+		{
+			contactPointList[i].m_speculative = true;
+		}
 	}
 }
 
@@ -1689,7 +2805,8 @@ void ndScene::DeleteDeadContacts()
 	if (m_contactArray.GetCount())
 	{
 		D_TRACKTIME();
-		ndContact** const tmpJointsArray = (ndContact**)&m_scratchBuffer[0];
+		ndAssert(m_contactScratchArray);
+		ndContact** const tmpJointsArray = m_contactScratchArray;
 		ndCountingSort<ndContact*, ndJointActive, 2>(*this, tmpJointsArray, &m_contactArray[0], ndInt32(m_contactArray.GetCount()), prefixScan, nullptr);
 		if (prefixScan[m_dead + 1] != prefixScan[m_dead])
 		{
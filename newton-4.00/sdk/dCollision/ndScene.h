@@ -29,12 +29,15 @@
 #include "ndPolygonMeshDesc.h"
 
 #define D_SCENE_MAX_STACK_DEPTH		256
+#define D_SCENE_TREE_MIGRATION_PERIOD	64
 
 class ndWorld;
 class ndScene;
 class ndContact;
+class ndRayCastHit;
 class ndRayCastNotify;
 class ndContactNotify;
+class ndConvexCastHit;
 class ndConvexCastNotify;
 class ndBodiesInAabbNotify;
 class ndJointBilateralConstraint;
@@ -71,6 +74,56 @@ class ndScene : public ndThreadPool
 		ndUnsigned32 m_body1;
 	};
 
+	// a compound pair with many children, its child pairs are found by one thread 
+	// and then handed out in batches to all threads
+	class ndCompoundContact
+	{
+		public:
+		ndContact* m_contact;
+		ndFloat32 m_separationDistance;
+		ndInt32 m_childPairStart;
+		ndInt32 m_childPairCount;
+		ndInt32 m_threadIndex;
+		ndInt32 m_processContacts;
+	};
+
+	class ndCompoundChildBatch
+	{
+		public:
+		ndInt32 m_compoundIndex;
+		ndInt32 m_childPairStart;
+		ndInt32 m_childPairCount;
+	};
+
+	// scratch data owned by each worker, allocated when the thread count changes
+	class ndThreadLocalData: public ndClassAlloc
+	{
+		public:
+		ndThreadLocalData()
+			:ndClassAlloc()
+			,m_partialNewPairs(256)
+			,m_continueContacts(64)
+			,m_compoundContacts(64)
+			,m_compoundChildPairs(256)
+			,m_compoundChildContacts(256)
+			,m_staticMeshQuery()
+			,m_proceduralStaticMeshQuery()
+			,m_narrowPhasePairs(0)
+			,m_skippedPairs(0)
+		{
+		}
+
+		ndArray<ndContactPairs> m_partialNewPairs;
+		ndArray<ndContact*> m_continueContacts;
+		ndArray<ndContact*> m_compoundContacts;
+		ndArray<ndContactSolver::ndCompoundChildPair> m_compoundChildPairs;
+		ndArray<ndContactPoint> m_compoundChildContacts;
+		ndPolygonMeshDesc::ndStaticMeshFaceQuery m_staticMeshQuery;
+		ndPolygonMeshDesc::ndProceduralStaticMeshFaceQuery m_proceduralStaticMeshQuery;
+		ndInt32 m_narrowPhasePairs;
+		ndInt32 m_skippedPairs;
+	};
+
 	public:
 	D_COLLISION_API virtual ~ndScene();
 	D_COLLISION_API bool ValidateScene();
@@ -98,9 +151,22 @@ class ndScene : public ndThreadPool
 	D_COLLISION_API virtual bool RayCast(ndRayCastNotify& callback, const ndVector& globalOrigin, const ndVector& globalDest) const;
 	D_COLLISION_API virtual bool ConvexCast(ndConvexCastNotify& callback, const ndShapeInstance& convexShape, const ndMatrix& globalOrigin, const ndVector& globalDest) const;
 
+	// closest hit of each ray from origins[i] to dests[i], spread across the worker threads.
+	// a shape is skipped when its material user id is not zero and shares no bit with filterMasks[i],
+	// filterMasks can be null. the caller must have the workers running, see ndWorld::RayCastBatch.
+	D_COLLISION_API void RayCastBatch(const ndVector* const origins, const ndVector* const dests, const ndUnsigned64* const filterMasks, ndInt32 count, ndRayCastHit* const hits);
+
+	// bodies overlapping each box, the bodies of box i are bodies[bodyStart[i]] to bodies[bodyStart[i + 1] - 1], 
+	// bodyStart must have count + 1 entries. 
+	D_COLLISION_API void OverlapBatch(const ndVector* const minBoxes, const ndVector* const maxBoxes, ndInt32 count, ndArray<const ndBody*>& bodies, ndInt32* const bodyStart);
+
+	// closest contact of each convex shape swept from origins[i] to dests[i]
+	D_COLLISION_API void ConvexCastBatch(const ndShapeInstance* const* const shapes, const ndMatrix* const origins, const ndVector* const dests, ndInt32 count, ndConvexCastHit* const hits);
+
 	D_COLLISION_API void SendBackgroundTask(ndBackgroundTask* const job);
 
 	ndInt32 GetThreadCount() const;
+	D_COLLISION_API virtual void SetThreadCount(ndInt32 count);
 
 	virtual ndWorld* GetWorld() const;
 	const ndBodyListView& GetBodyList() const;
@@ -112,12 +178,27 @@ class ndScene : public ndThreadPool
 	ndArray<ndConstraint*>& GetActiveContactArray();
 	const ndArray<ndConstraint*>& GetActiveContactArray() const;
 
-	ndArray<ndUnsigned8>& GetScratchBuffer();
+	ndFrameArena& GetFrameArena();
 
 	ndFloat32 GetTimestep() const;
 	void SetTimestep(ndFloat32 timestep);
 	ndBodyKinematic* GetSentinelBody() const;
 
+	// by default the broad phase trees are rebuilt from scratch every few frames, in incremental mode
+	// they are only refitted, and the subtrees whose surface area cost degraded are rebuilt on their own.
+	// bodies at rest live in a separate tree that is only rebuilt when it changes, 
+	// bodies move between the two trees as they come to rest or start moving again.
+	bool GetIncrementalBvhRefit() const;
+	D_COLLISION_API void SetIncrementalBvhRefit(bool state);
+	D_COLLISION_API void GetBvhRebuildCount(ndInt32& fullRebuilds, ndInt32& partialRebuilds) const;
+	D_COLLISION_API void GetStaticBvhRebuildCount(ndInt32& fullRebuilds, ndInt32& partialRebuilds) const;
+	D_COLLISION_API ndInt32 GetStaticTreeBodyCount() const;
+
+	// pairs that ran the narrow phase in the last sub step, and pairs that skipped it because
+	// the separation distance cached by the previous narrow phase can not have closed yet.
+	D_COLLISION_API void GetNarrowPhaseCount(ndInt32& narrowPhasePairs, ndInt32& skippedPairs) const;
+	D_COLLISION_API void GetCompoundPairCount(ndInt32& compoundPairs, ndInt32& childPairs) const;
+
 	protected:
 	D_COLLISION_API ndScene();
 	D_COLLISION_API ndScene(const ndScene& src);
@@ -125,17 +206,28 @@ class ndScene : public ndThreadPool
 
 	const ndContactArray& GetContactArray() const;
 	void FindCollidingPairs(ndBodyKinematic* const body, ndInt32 threadId);
-	void FindCollidingPairsForward(ndBodyKinematic* const body, ndInt32 threadId);
-	void FindCollidingPairsBackward(ndBodyKinematic* const body, ndInt32 threadId);
 	void AddPair(ndBodyKinematic* const body0, ndBodyKinematic* const body1, ndInt32 threadId);
-	void SubmitPairs(ndBvhLeafNode* const bodyNode, ndBvhNode* const node, bool forward, ndInt32 threadId);
-
-	void CalculateJointContacts(ndInt32 threadIndex, ndContact* const contact);
+	void SubmitPairs(ndBvhLeafNode* const bodyNode, const ndBvhWideNode* const root, ndInt64 forwardId, ndInt32 threadId);
+
+	ndBvhSceneManager& GetBvhSceneManager(const ndBodyKinematic* const body);
+	const ndBvhSceneManager& GetBvhSceneManager(const ndBodyKinematic* const body) const;
+	ndBvhNode* BalanceSceneTree(ndBvhSceneManager& bvhSceneManager, ndBvhNode* rootNode, ndUnsigned32& forceBalanceCounter, bool periodicRebuild);
+	void MoveToSceneTree(ndBodyKinematic* const body, bool staticTree);
+	void MigrateSceneTreeBodies();
+
+	bool CalculateJointContacts(ndInt32 threadIndex, ndContact* const contact);
+	void CalculateTimeOfImpactContacts(ndInt32 threadIndex, ndContact* const contact);
+	bool IsLargeCompoundPair(const ndContact* const contact) const;
+	ndFloat32 ClosingSpeedBound(const ndContact* const contact) const;
+	void CalculateCompoundChildPairs(ndInt32 threadIndex, ndCompoundContact& compoundContact);
+	void CalculateCompoundChildContacts(ndInt32 threadIndex, const ndCompoundChildBatch& batch);
+	void MergeCompoundChildContacts(ndInt32 threadIndex, const ndCompoundContact& compoundContact);
 	void ProcessContacts(ndInt32 threadIndex, ndInt32 contactCount, ndContactSolver* const contactSolver);
 
 	ndJointBilateralConstraint* FindBilateralJoint(ndBodyKinematic* const body0, ndBodyKinematic* const body1) const;
-	bool RayCast(ndRayCastNotify& callback, const ndBvhNode** stackPool, ndFloat32* const distance, ndInt32 stack, const ndFastRay& ray) const;
-	bool ConvexCast(ndConvexCastNotify& callback, const ndBvhNode** stackPool, ndFloat32* const distance, ndInt32 stack, const ndFastRay& ray, const ndShapeInstance& convexShape, const ndMatrix& globalOrigin, const ndVector& globalDest) const;
+	void ValidateWideTrees() const;
+	bool RayCast(ndRayCastNotify& callback, const ndFastRay& ray) const;
+	bool ConvexCast(ndConvexCastNotify& callback, const ndFastRay& ray, ndBodyKinematic* const castingBody, const ndShapeInstance& convexShape, const ndMatrix& globalOrigin, const ndVector& globalDest, ndInt32 threadIndex) const;
 
 	// call from sub steps update
 	D_COLLISION_API virtual void ApplyExtForce();
@@ -146,10 +238,20 @@ class ndScene : public ndThreadPool
 	D_COLLISION_API virtual void UpdateTransform();
 	D_COLLISION_API virtual void CreateNewContacts();
 	D_COLLISION_API virtual void CalculateContacts();
+	D_COLLISION_API virtual void CalculateContinueContacts();
+	D_COLLISION_API virtual void CalculateCompoundContacts();
 	D_COLLISION_API virtual void FindCollidingPairs();
 	D_COLLISION_API virtual void DeleteDeadContacts();
 
+	// sub steps that do not run the collision system, they only prepare the bodies 
+	// for the solver and move the contacts of the last narrow phase with the bodies.
+	// after the last one the collision matrices and the broad phase boxes are refreshed.
+	D_COLLISION_API virtual void PrepareBodyArray();
+	D_COLLISION_API virtual void AdvanceContacts();
+	D_COLLISION_API virtual void UpdateBodyBoxes();
+
 	D_COLLISION_API virtual void CalculateContacts(ndInt32 threadIndex, ndContact* const contact);
+	D_COLLISION_API virtual void CalculateContinueContacts(ndInt32 threadIndex, ndContact* const contact);
 	D_COLLISION_API virtual void UpdateTransformNotify(ndInt32 threadIndex, ndBodyKinematic* const body);
 
 	D_COLLISION_API virtual void ParticleUpdate(ndFloat32 timestep);
@@ -160,26 +262,34 @@ class ndScene : public ndThreadPool
 	ndBodyList m_particleSetList;
 	ndContactArray m_contactArray;
 	ndBvhSceneManager m_bvhSceneManager;
-	ndArray<ndUnsigned8> m_scratchBuffer;
+	ndBvhSceneManager m_staticBvhSceneManager;
+	ndFrameArena m_frameArena;
 	ndArray<ndBodyKinematic*> m_sceneBodyArray;
 	ndArray<ndConstraint*> m_activeConstraintArray;
 	ndSpecialList<ndBodyKinematic> m_specialUpdateList;
 	ndArray<ndContactPairs> m_newPairs;
-	ndArray<ndContactPairs> m_partialNewPairs[D_MAX_THREADS_COUNT];
-	ndPolygonMeshDesc::ndStaticMeshFaceQuery m_staticMeshQuery[D_MAX_THREADS_COUNT];
-	ndPolygonMeshDesc::ndProceduralStaticMeshFaceQuery m_proceduralStaticMeshQuery[D_MAX_THREADS_COUNT];
+	ndArray<ndContact*> m_continueContactArray;
+	ndArray<ndCompoundContact> m_compoundContactArray;
+	ndArray<ndCompoundChildBatch> m_compoundChildBatchArray;
+	ndArray<ndThreadLocalData*> m_threadLocalData;
 
 	ndSpinLock m_lock;
 	ndBvhNode* m_rootNode;
+	ndBvhNode* m_staticRootNode;
 	ndBodyKinematic* m_sentinelBody;
 	ndContactNotify* m_contactNotifyCallback;
 	ndThreadBackgroundWorker* m_backgroundThread;
+	ndContact** m_contactScratchArray;
 	
 	ndFloat32 m_timestep;
 	ndUnsigned32 m_lru;
 	ndUnsigned32 m_frameNumber;
 	ndUnsigned32 m_subStepNumber;
 	ndUnsigned32 m_forceBalanceSceneCounter;
+	ndUnsigned32 m_forceBalanceStaticSceneCounter;
+	bool m_incrementalBvhRefit;
+	bool m_staticSceneMoved;
+	bool m_speculativeContacts;
 	D_MEMORY_ALIGN_FIXUP
 
 	static ndVector m_velocTol;
@@ -219,9 +329,9 @@ inline ndInt32 ndScene::GetThreadCount() const
 	return pool.GetThreadCount();
 }
 
-inline ndArray<ndUnsigned8>& ndScene::GetScratchBuffer()
+inline ndFrameArena& ndScene::GetFrameArena()
 {
-	return m_scratchBuffer;
+	return m_frameArena;
 }
 
 inline const ndBodyList& ndScene::GetParticleList() const
@@ -274,4 +384,9 @@ inline ndBodyKinematic* ndScene::GetSentinelBody() const
 	return m_sentinelBody;
 }
 
+inline bool ndScene::GetIncrementalBvhRefit() const
+{
+	return m_incrementalBvhRefit;
+}
+
 #endif
@@ -831,12 +831,16 @@ ndInt32 ndShapeConvexPolygon::CalculateContactToConvexHullDescrete(const ndShape
 	}
 	else
 	{
-		if (needSkirts)
+		count = contactSolver.PrimitiveToPolygonContactsDiscrete(this);
+		if (count < 0)
 		{
-			GenerateConvexCap(parentMesh);
+			if (needSkirts)
+			{
+				GenerateConvexCap(parentMesh);
+			}
+			m_vertexCount = ndUnsigned16(m_count);
+			count = contactSolver.ConvexToConvexContactsDiscrete();
 		}
-		m_vertexCount = ndUnsigned16(m_count);
-		count = contactSolver.ConvexToConvexContactsDiscrete();
 		ndAssert(contactSolver.m_intersectionTestOnly || (count >= 0));
 		if (count >= 1)
 		{
@@ -60,6 +60,8 @@ class ndShapeSphere: public ndShapeConvex
 	static ndInt32 m_shapeRefCount;
 	static ndVector m_unitSphere[];
 	static ndConvexSimplexEdge m_edgeArray[];
+
+	friend class ndContactSolver;
 } D_GCC_NEWTON_ALIGN_32;
 
 
@@ -63,13 +63,17 @@ ndShapeStatic_bvh::ndShapeStatic_bvh()
 	ndAssert(ndMemory::CheckMemory(this));
 }
 
-ndShapeStatic_bvh::ndShapeStatic_bvh(const ndPolygonSoupBuilder& builder)
+ndShapeStatic_bvh::ndShapeStatic_bvh(const ndPolygonSoupBuilder& builder, bool compressed)
 	:ndShapeStaticMesh(m_boundingBoxHierachy)
 	,ndAabbPolygonSoup()
 	,m_trianglesCount(0)
 {
 	Create(builder);
 	CalculateAdjacent();
+	if (compressed)
+	{
+		Compress();
+	}
 
 	ndVector p0;
 	ndVector p1;
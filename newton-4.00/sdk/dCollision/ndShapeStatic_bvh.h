@@ -32,7 +32,7 @@ class ndShapeStatic_bvh: public ndShapeStaticMesh, public ndAabbPolygonSoup
 	D_CLASS_REFLECTION(ndShapeStatic_bvh,ndShapeStaticMesh)
 
 	D_COLLISION_API ndShapeStatic_bvh();
-	D_COLLISION_API ndShapeStatic_bvh(const ndPolygonSoupBuilder& builder);
+	D_COLLISION_API ndShapeStatic_bvh(const ndPolygonSoupBuilder& builder, bool compressed = false);
 	D_COLLISION_API virtual ~ndShapeStatic_bvh();
 	D_COLLISION_API void *operator new (size_t size);
 	D_COLLISION_API void operator delete (void* ptr);
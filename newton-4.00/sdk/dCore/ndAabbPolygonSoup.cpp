@@ -30,6 +30,8 @@
 #include "ndPolygonSoupBuilder.h"
 
 #define DG_STACK_DEPTH 512
+#define D_COMPRESSED_BLOCK_SIZE 64
+#define D_COMPRESSED_FACE_MAX_INDEX (2 * (1 << DG_INDEX_COUNT_BITS) + 3)
 
 D_MSV_NEWTON_ALIGN_32
 class ndAabbPolygonSoup::ndNodeBuilder: public ndAabbPolygonSoup::ndNode
@@ -229,12 +231,110 @@ class ndAabbPolygonSoup::ndSplitInfo
 	ndVector m_p1;
 };
 
+static ndInt32 ndPackedBitCount(ndUnsigned32 value)
+{
+	ndInt32 bits = 1;
+	for (value >>= 1; value; value >>= 1)
+	{
+		bits++;
+	}
+	return bits;
+}
+
+static void ndPackBits(ndUnsigned32* const words, ndUnsigned32& bitOffset, ndUnsigned32 value, ndInt32 bits)
+{
+	const ndUnsigned64 mask = (ndUnsigned64(1) << bits) - 1;
+	const ndUnsigned64 data = (ndUnsigned64(value) & mask) << (bitOffset & 31);
+	const ndUnsigned32 index = bitOffset >> 5;
+	words[index] |= ndUnsigned32(data);
+	words[index + 1] |= ndUnsigned32(data >> 32);
+	bitOffset += ndUnsigned32(bits);
+}
+
+static inline ndUnsigned32 ndUnpackBits(const ndUnsigned32* const words, ndUnsigned32& bitOffset, ndInt32 bits)
+{
+	const ndUnsigned32 index = bitOffset >> 5;
+	const ndUnsigned64 data = (ndUnsigned64(words[index + 1]) << 32) | ndUnsigned64(words[index]);
+	const ndUnsigned64 mask = (ndUnsigned64(1) << bits) - 1;
+	const ndUnsigned32 value = ndUnsigned32((data >> (bitOffset & 31)) & mask);
+	bitOffset += ndUnsigned32(bits);
+	return value;
+}
+
+static void ndQuantizeChildBox(ndAabbPolygonSoup::ndCompressedNode& node, ndInt32 child, const ndVector& origin, const ndVector& step, const ndVector& p0, const ndVector& p1)
+{
+	ndUnsigned16* const box = node.m_box[child];
+	for (ndInt32 i = 0; i < 3; ++i)
+	{
+		ndFloat32 q0 = ndFloat32(0.0f);
+		ndFloat32 q1 = ndFloat32(0.0f);
+		if (step[i] > ndFloat32(0.0f))
+		{
+			q0 = ndClamp(ndFloor((p0[i] - origin[i]) / step[i]), ndFloat32(0.0f), ndFloat32(0xffff));
+			q1 = ndClamp(ndCeil((p1[i] - origin[i]) / step[i]), q0, ndFloat32(0xffff));
+		}
+		box[i] = ndUnsigned16(q0);
+		box[i + 3] = ndUnsigned16(q1);
+	}
+
+	// grow the quantized box until the decoded box contains the source box
+	for (bool grow = true; grow; )
+	{
+		ndVector q0;
+		ndVector q1;
+		grow = false;
+		node.GetChildAabb(child, origin, step, q0, q1);
+		for (ndInt32 i = 0; i < 3; ++i)
+		{
+			if ((q0[i] > p0[i]) && box[i])
+			{
+				box[i]--;
+				grow = true;
+			}
+			if ((q1[i] < p1[i]) && (box[i + 3] < 0xffff))
+			{
+				box[i + 3]++;
+				grow = true;
+			}
+		}
+	}
+}
+
+static inline void ndPushCompressedEntry(
+	const ndAabbPolygonSoup::ndCompressedNode** const stackPool, ndFloat32* const distance, 
+	ndVector* const stackBox0, ndVector* const stackBox1, ndInt32& stack,
+	const ndAabbPolygonSoup::ndCompressedNode* const node, ndFloat32 dist, const ndVector& p0, const ndVector& p1)
+{
+	ndInt32 j = stack;
+	for (; j && (dist > distance[j - 1]); j--)
+	{
+		stackPool[j] = stackPool[j - 1];
+		distance[j] = distance[j - 1];
+		stackBox0[j] = stackBox0[j - 1];
+		stackBox1[j] = stackBox1[j - 1];
+	}
+	ndAssert(stack < DG_STACK_DEPTH);
+	stackPool[j] = node;
+	distance[j] = dist;
+	stackBox0[j] = p0;
+	stackBox1[j] = p1;
+	stack++;
+}
+
 ndAabbPolygonSoup::ndAabbPolygonSoup ()
 	:ndPolygonSoupDatabase()
 	,m_aabb(nullptr)
 	,m_indices(nullptr)
 	,m_nodesCount(0)
 	,m_indexCount(0)
+	,m_compressedNodes(nullptr)
+	,m_compressedNodesBuffer(nullptr)
+	,m_packedFaces(nullptr)
+	,m_compressedNodesCount(0)
+	,m_packedFacesCount(0)
+	,m_packedIndexBits(0)
+	,m_packedAttributeBits(0)
+	,m_packedFaceSizeBits(0)
 {
 }
 
@@ -243,8 +343,31 @@ ndAabbPolygonSoup::~ndAabbPolygonSoup ()
 	if (m_aabb) 
 	{
 		ndMemory::Free(m_aabb);
+	}
+	if (m_indices)
+	{
 		ndMemory::Free(m_indices);
 	}
+	if (m_compressedNodesBuffer)
+	{
+		ndMemory::Free(m_compressedNodesBuffer);
+		ndMemory::Free(m_packedFaces);
+	}
+}
+
+bool ndAabbPolygonSoup::IsCompressed() const
+{
+	return m_compressedNodes ? true : false;
+}
+
+size_t ndAabbPolygonSoup::GetMemorySize() const
+{
+	size_t size = sizeof(ndTriplex) * size_t(m_vertexCount) + sizeof(ndNode) * size_t(m_nodesCount) + sizeof(ndInt32) * size_t(m_indexCount);
+	if (m_compressedNodes)
+	{
+		size += sizeof(ndCompressedNode) * size_t(m_compressedNodesCount) + sizeof(ndUnsigned32) * size_t(m_packedFacesCount);
+	}
+	return size;
 }
 
 ndFloat32 ndAabbPolygonSoup::CalculateFaceMaxDiagonal (const ndVector* const vertex, ndInt32 indexCount, const ndInt32* const indexArray) const
@@ -295,6 +418,7 @@ void ndAabbPolygonSoup::GetAABB (ndVector& p0, ndVector& p1) const
 
 void ndAabbPolygonSoup::CalculateAdjacent ()
 {
+	ndAssert(!m_compressedNodes);
 	ndVector p0;
 	ndVector p1;
 	GetAABB (p0, p1);
@@ -767,15 +891,354 @@ void ndAabbPolygonSoup::Create (const ndPolygonSoupBuilder& builder)
 	}
 }
 
+void ndAabbPolygonSoup::Compress()
+{
+	if (!m_aabb || m_compressedNodes)
+	{
+		return;
+	}
+
+	const ndTriplex* const vertexArray = (ndTriplex*)m_localVertex;
+	const ndUnsigned32 edgeIndexMask = ndUnsigned32(~D_CONCAVE_EDGE_MASK);
+
+	// keep only the points and normals used by the faces, 
+	// the node box corners are replaced by the quantized boxes.
+	ndStack<ndInt32> vertexMap(m_vertexCount);
+	for (ndInt32 i = 0; i < m_vertexCount; ++i)
+	{
+		vertexMap[i] = -1;
+	}
+
+	ndUnsigned32 maxAttribute = 0;
+	ndUnsigned32 maxFaceSize = 0;
+	for (ndInt32 i = 0; i < m_nodesCount; ++i)
+	{
+		const ndNode* const node = &m_aabb[i];
+		for (ndInt32 k = 0; k < 2; ++k)
+		{
+			const ndNode::ndLeafNodePtr& child = k ? node->m_right : node->m_left;
+			if (child.IsLeaf() && child.GetCount())
+			{
+				const ndInt32 vCount = ndInt32(child.GetCount());
+				const ndInt32* const face = &m_indices[child.GetIndex()];
+				for (ndInt32 j = 0; j < vCount; ++j)
+				{
+					vertexMap[face[j]] = 0;
+					const ndUnsigned32 edgeIndex = ndUnsigned32(face[vCount + 2 + j]) & edgeIndexMask;
+					if (edgeIndex != edgeIndexMask)
+					{
+						vertexMap[ndInt32(edgeIndex)] = 0;
+					}
+				}
+				vertexMap[face[vCount + 1]] = 0;
+				maxAttribute = ndMax(maxAttribute, ndUnsigned32(face[vCount]));
+				maxFaceSize = ndMax(maxFaceSize, ndUnsigned32(face[2 * vCount + 2]));
+			}
+		}
+	}
+
+	ndInt32 vertexCount = 0;
+	for (ndInt32 i = 0; i < m_vertexCount; ++i)
+	{
+		if (vertexMap[i] == 0)
+		{
+			vertexMap[i] = vertexCount;
+			vertexCount++;
+		}
+	}
+
+	// the all ones index code marks an edge without adjacent normal
+	m_packedIndexBits = ndPackedBitCount(ndUnsigned32(vertexCount));
+	m_packedAttributeBits = ndPackedBitCount(maxAttribute);
+	m_packedFaceSizeBits = ndPackedBitCount(maxFaceSize);
+	const ndUnsigned32 invalidIndex = (ndUnsigned32(1) << m_packedIndexBits) - 1;
+
+	// lay out the nodes in blocks of one cache line. each block holds a sub tree 
+	// grown from its root by opening the child with the largest surface first. 
+	// sub trees smaller than a block share a block with other small sub trees.
+	const ndInt32 blockSize = ndInt32(D_COMPRESSED_BLOCK_SIZE / sizeof(ndCompressedNode));
+	ndStack<ndInt32> nodeSlot(m_nodesCount);
+	ndArray<ndInt32> subTreeRoots;
+	ndArray<ndInt32> blockFill;
+	ndArray<ndInt32> openBlocks;
+	subTreeRoots.PushBack(0);
+	for (ndInt32 r = 0; r < subTreeRoots.GetCount(); ++r)
+	{
+		ndInt32 subTree[D_COMPRESSED_BLOCK_SIZE];
+		ndInt32 candidates[D_COMPRESSED_BLOCK_SIZE];
+		ndInt32 subTreeCount = 0;
+		ndInt32 candidatesCount = 1;
+		candidates[0] = subTreeRoots[r];
+		while (candidatesCount && (subTreeCount < blockSize))
+		{
+			ndInt32 best = 0;
+			ndFloat32 bestArea = ndFloat32(-1.0f);
+			for (ndInt32 j = 0; j < candidatesCount; ++j)
+			{
+				ndVector p0;
+				ndVector p1;
+				GetNodeAabb(&m_aabb[candidates[j]], p0, p1);
+				const ndVector size(p1 - p0);
+				const ndFloat32 area = size.DotProduct(size.ShiftTripleRight()).GetScalar();
+				if (area > bestArea)
+				{
+					best = j;
+					bestArea = area;
+				}
+			}
+			const ndNode* const node = &m_aabb[candidates[best]];
+			subTree[subTreeCount] = candidates[best];
+			subTreeCount++;
+			candidatesCount--;
+			candidates[best] = candidates[candidatesCount];
+			if (!node->m_left.IsLeaf())
+			{
+				candidates[candidatesCount] = ndInt32(node->m_left.m_node);
+				candidatesCount++;
+			}
+			if (!node->m_right.IsLeaf())
+			{
+				candidates[candidatesCount] = ndInt32(node->m_right.m_node);
+				candidatesCount++;
+			}
+		}
+		for (ndInt32 j = 0; j < candidatesCount; ++j)
+		{
+			subTreeRoots.PushBack(candidates[j]);
+		}
+
+		ndInt32 block = -1;
+		for (ndInt32 j = 0; j < openBlocks.GetCount(); ++j)
+		{
+			if ((blockFill[openBlocks[j]] + subTreeCount) <= blockSize)
+			{
+				block = openBlocks[j];
+				openBlocks[j] = openBlocks[openBlocks.GetCount() - 1];
+				openBlocks.SetCount(openBlocks.GetCount() - 1);
+				break;
+			}
+		}
+		if (block < 0)
+		{
+			block = ndInt32(blockFill.GetCount());
+			blockFill.PushBack(0);
+		}
+		for (ndInt32 j = 0; j < subTreeCount; ++j)
+		{
+			nodeSlot[subTree[j]] = block * blockSize + blockFill[block];
+			blockFill[block]++;
+		}
+		if (blockFill[block] < blockSize)
+		{
+			openBlocks.PushBack(block);
+		}
+	}
+	ndAssert(nodeSlot[0] == 0);
+
+	m_compressedNodesCount = ndInt32(blockFill.GetCount()) * blockSize;
+	m_compressedNodesBuffer = ndMemory::Malloc(sizeof(ndCompressedNode) * size_t(m_compressedNodesCount) + D_COMPRESSED_BLOCK_SIZE);
+	m_compressedNodes = (ndCompressedNode*)((size_t(m_compressedNodesBuffer) + D_COMPRESSED_BLOCK_SIZE - 1) & ~size_t(D_COMPRESSED_BLOCK_SIZE - 1));
+	memset(m_compressedNodes, 0, sizeof(ndCompressedNode) * size_t(m_compressedNodesCount));
+
+	// pack the faces in node layout order, each face record starts at a word boundary.
+	// record format: i0, i1, i2, ... , id, normal, e0Normal, e1Normal, e2Normal, ..., faceSize
+	ndStack<ndInt32> slotNode(m_compressedNodesCount);
+	for (ndInt32 i = 0; i < m_compressedNodesCount; ++i)
+	{
+		slotNode[i] = -1;
+	}
+	for (ndInt32 i = 0; i < m_nodesCount; ++i)
+	{
+		slotNode[nodeSlot[i]] = i;
+	}
+
+	ndStack<ndUnsigned32> faceStart(m_nodesCount * 2);
+	ndUnsigned32 wordCount = 0;
+	for (ndInt32 slot = 0; slot < m_compressedNodesCount; ++slot)
+	{
+		const ndInt32 i = slotNode[slot];
+		if (i >= 0)
+		{
+			const ndNode* const node = &m_aabb[i];
+			for (ndInt32 k = 0; k < 2; ++k)
+			{
+				const ndNode::ndLeafNodePtr& child = k ? node->m_right : node->m_left;
+				faceStart[i * 2 + k] = wordCount;
+				if (child.IsLeaf() && child.GetCount())
+				{
+					const ndInt32 vCount = ndInt32(child.GetCount());
+					const ndInt32 bits = vCount * (2 * m_packedIndexBits + 1) + m_packedIndexBits + m_packedAttributeBits + m_packedFaceSizeBits;
+					wordCount += ndUnsigned32((bits + 31) / 32);
+				}
+			}
+		}
+	}
+	ndAssert(wordCount < ndUnsigned32(1 << (32 - DG_INDEX_COUNT_BITS - 1)));
+
+	m_packedFacesCount = ndInt32(wordCount + 1);
+	m_packedFaces = (ndUnsigned32*)ndMemory::Malloc(sizeof(ndUnsigned32) * size_t(m_packedFacesCount));
+	memset(m_packedFaces, 0, sizeof(ndUnsigned32) * size_t(m_packedFacesCount));
+	for (ndInt32 i = 0; i < m_nodesCount; ++i)
+	{
+		const ndNode* const node = &m_aabb[i];
+		for (ndInt32 k = 0; k < 2; ++k)
+		{
+			const ndNode::ndLeafNodePtr& child = k ? node->m_right : node->m_left;
+			if (child.IsLeaf() && child.GetCount())
+			{
+				const ndInt32 vCount = ndInt32(child.GetCount());
+				const ndInt32* const face = &m_indices[child.GetIndex()];
+				ndUnsigned32 bitOffset = faceStart[i * 2 + k] * 32;
+				for (ndInt32 j = 0; j < vCount; ++j)
+				{
+					ndPackBits(m_packedFaces, bitOffset, ndUnsigned32(vertexMap[face[j]]), m_packedIndexBits);
+				}
+				ndPackBits(m_packedFaces, bitOffset, ndUnsigned32(face[vCount]), m_packedAttributeBits);
+				ndPackBits(m_packedFaces, bitOffset, ndUnsigned32(vertexMap[face[vCount + 1]]), m_packedIndexBits);
+				for (ndInt32 j = 0; j < vCount; ++j)
+				{
+					const ndUnsigned32 edge = ndUnsigned32(face[vCount + 2 + j]);
+					const ndUnsigned32 edgeIndex = edge & edgeIndexMask;
+					const ndUnsigned32 code = (edgeIndex == edgeIndexMask) ? invalidIndex : ndUnsigned32(vertexMap[ndInt32(edgeIndex)]);
+					ndPackBits(m_packedFaces, bitOffset, code | ((edge >> 31) << m_packedIndexBits), m_packedIndexBits + 1);
+				}
+				ndPackBits(m_packedFaces, bitOffset, ndUnsigned32(face[2 * vCount + 2]), m_packedFaceSizeBits);
+			}
+		}
+	}
+
+	// quantize the child boxes top down, relative to the decoded box of the parent.
+	// nodes are enumerated breadth first, so a parent is always decoded before its children.
+	ndStack<ndVector> decodedBox0(m_nodesCount);
+	ndStack<ndVector> decodedBox1(m_nodesCount);
+	GetNodeAabb(m_aabb, decodedBox0[0], decodedBox1[0]);
+	for (ndInt32 i = 0; i < m_nodesCount; ++i)
+	{
+		const ndNode* const node = &m_aabb[i];
+		ndCompressedNode& compressedNode = m_compressedNodes[nodeSlot[i]];
+		const ndVector origin(decodedBox0[i]);
+		const ndVector step(ndCompressedNode::CalculateStep(decodedBox0[i], decodedBox1[i]));
+		for (ndInt32 k = 0; k < 2; ++k)
+		{
+			const ndNode::ndLeafNodePtr& child = k ? node->m_right : node->m_left;
+			if (child.IsLeaf())
+			{
+				const ndUnsigned32 vCount = child.GetCount();
+				ndVector p0(origin);
+				ndVector p1(origin);
+				if (vCount)
+				{
+					// same padding as the leaf boxes of the builder
+					const ndInt32* const face = &m_indices[child.GetIndex()];
+					p0 = ndVector(ndFloat32(1.0e15f));
+					p1 = ndVector(ndFloat32(-1.0e15f));
+					for (ndInt32 j = 0; j < ndInt32(vCount); ++j)
+					{
+						const ndVector p(ndVector(&vertexArray[face[j]].m_x) & ndVector::m_triplexMask);
+						p0 = p0.GetMin(p);
+						p1 = p1.GetMax(p);
+					}
+					p0 = (p0 - ndVector(ndFloat32(1.0e-3f))) & ndVector::m_triplexMask;
+					p1 = (p1 + ndVector(ndFloat32(1.0e-3f))) & ndVector::m_triplexMask;
+				}
+				ndQuantizeChildBox(compressedNode, k, origin, step, p0, p1);
+				compressedNode.m_child[k] = 0x80000000 | (vCount << (32 - DG_INDEX_COUNT_BITS - 1)) | faceStart[i * 2 + k];
+			}
+			else
+			{
+				const ndInt32 childIndex = ndInt32(child.m_node);
+				ndAssert(childIndex > i);
+				ndVector p0;
+				ndVector p1;
+				GetNodeAabb(&m_aabb[childIndex], p0, p1);
+				ndQuantizeChildBox(compressedNode, k, origin, step, p0, p1);
+				compressedNode.GetChildAabb(k, origin, step, decodedBox0[childIndex], decodedBox1[childIndex]);
+				compressedNode.m_child[k] = ndUnsigned32(nodeSlot[childIndex]);
+			}
+		}
+	}
+
+	// the vertex array keeps the used points and normals, followed by the two root box corners.
+	ndVector rootP0;
+	ndVector rootP1;
+	GetNodeAabb(m_aabb, rootP0, rootP1);
+	ndTriplex* const compressedVertex = (ndTriplex*)ndMemory::Malloc(sizeof(ndTriplex) * size_t(vertexCount + 2));
+	for (ndInt32 i = 0; i < m_vertexCount; ++i)
+	{
+		if (vertexMap[i] >= 0)
+		{
+			compressedVertex[vertexMap[i]] = vertexArray[i];
+		}
+	}
+	compressedVertex[vertexCount].m_x = rootP0.m_x;
+	compressedVertex[vertexCount].m_y = rootP0.m_y;
+	compressedVertex[vertexCount].m_z = rootP0.m_z;
+	compressedVertex[vertexCount + 1].m_x = rootP1.m_x;
+	compressedVertex[vertexCount + 1].m_y = rootP1.m_y;
+	compressedVertex[vertexCount + 1].m_z = rootP1.m_z;
+
+	ndMemory::Free(m_localVertex);
+	ndMemory::Free(m_indices);
+	ndMemory::Free(m_aabb);
+	m_localVertex = &compressedVertex[0].m_x;
+	m_vertexCount = vertexCount + 2;
+	m_indices = nullptr;
+	m_indexCount = 0;
+
+	// a root without children stands for the whole hierarchy in the node interface
+	m_nodesCount = 1;
+	m_aabb = (ndNode*)ndMemory::Malloc(sizeof(ndNode));
+	new (m_aabb) ndNode();
+	m_aabb->m_indexBox0 = vertexCount;
+	m_aabb->m_indexBox1 = vertexCount + 1;
+	m_aabb->m_left = ndNode::ndLeafNodePtr(0, 0);
+	m_aabb->m_right = ndNode::ndLeafNodePtr(0, 0);
+}
+
+void ndAabbPolygonSoup::UnpackFace(ndUnsigned32 faceStart, ndInt32 indexCount, ndInt32* const face) const
+{
+	// decode a packed face record to the index format: 
+	// i0, i1, i2, ... , id, normal, e0Normal, e1Normal, e2Normal, ..., faceSize
+	const ndUnsigned32 invalidIndex = (ndUnsigned32(1) << m_packedIndexBits) - 1;
+	ndUnsigned32 bitOffset = faceStart * 32;
+	for (ndInt32 j = 0; j < indexCount; ++j)
+	{
+		face[j] = ndInt32(ndUnpackBits(m_packedFaces, bitOffset, m_packedIndexBits));
+	}
+	face[indexCount] = ndInt32(ndUnpackBits(m_packedFaces, bitOffset, m_packedAttributeBits));
+	face[indexCount + 1] = ndInt32(ndUnpackBits(m_packedFaces, bitOffset, m_packedIndexBits));
+	for (ndInt32 j = 0; j < indexCount; ++j)
+	{
+		const ndUnsigned32 code = ndUnpackBits(m_packedFaces, bitOffset, m_packedIndexBits + 1);
+		const ndUnsigned32 edgeIndex = code & invalidIndex;
+		const ndUnsigned32 edgeMask = (code >> m_packedIndexBits) << 31;
+		face[indexCount + 2 + j] = ndInt32(((edgeIndex == invalidIndex) ? ndUnsigned32(~D_CONCAVE_EDGE_MASK) : edgeIndex) | edgeMask);
+	}
+	face[2 * indexCount + 2] = ndInt32(ndUnpackBits(m_packedFaces, bitOffset, m_packedFaceSizeBits));
+}
+
 void ndAabbPolygonSoup::Serialize (const char* const path) const
 {
 	FILE* const file = fopen(path, "wb");
 	if (file)
 	{
+		// a compressed hierarchy is saved with a negative node count
+		const ndInt32 indexCount = m_compressedNodes ? m_packedFacesCount : m_indexCount;
+		const ndInt32 nodesCount = m_compressedNodes ? -m_compressedNodesCount : m_nodesCount;
 		fwrite(&m_vertexCount, sizeof(ndInt32), 1, file);
-		fwrite(&m_indexCount, sizeof(ndInt32), 1, file);
-		fwrite(&m_nodesCount, sizeof(ndInt32), 1, file);
-		if (m_aabb)
+		fwrite(&indexCount, sizeof(ndInt32), 1, file);
+		fwrite(&nodesCount, sizeof(ndInt32), 1, file);
+		if (m_compressedNodes)
+		{
+			fwrite(&m_packedIndexBits, sizeof(ndInt32), 1, file);
+			fwrite(&m_packedAttributeBits, sizeof(ndInt32), 1, file);
+			fwrite(&m_packedFaceSizeBits, sizeof(ndInt32), 1, file);
+			fwrite(m_localVertex, sizeof(ndTriplex) * m_vertexCount, 1, file);
+			fwrite(m_packedFaces, sizeof(ndUnsigned32) * m_packedFacesCount, 1, file);
+			fwrite(m_compressedNodes, sizeof(ndCompressedNode) * m_compressedNodesCount, 1, file);
+			fwrite(m_aabb, sizeof(ndNode), 1, file);
+		}
+		else if (m_aabb)
 		{
 			fwrite(m_localVertex, sizeof(ndTriplex) * m_vertexCount, 1, file);
 			fwrite(m_indices, sizeof(ndInt32) * m_indexCount, 1, file);
@@ -797,7 +1260,31 @@ void ndAabbPolygonSoup::Deserialize (const char* const path)
 		readValues = fread(&m_indexCount, sizeof(ndInt32), 1, file);
 		readValues = fread(&m_nodesCount, sizeof(ndInt32), 1, file);
 
-		if (m_vertexCount) 
+		if (m_vertexCount && (m_nodesCount < 0))
+		{
+			m_compressedNodesCount = -m_nodesCount;
+			m_packedFacesCount = m_indexCount;
+			m_nodesCount = 1;
+			m_indexCount = 0;
+			ndAssert((m_compressedNodesCount % ndInt32(D_COMPRESSED_BLOCK_SIZE / sizeof(ndCompressedNode))) == 0);
+
+			readValues = fread(&m_packedIndexBits, sizeof(ndInt32), 1, file);
+			readValues = fread(&m_packedAttributeBits, sizeof(ndInt32), 1, file);
+			readValues = fread(&m_packedFaceSizeBits, sizeof(ndInt32), 1, file);
+
+			m_localVertex = (ndFloat32*)ndMemory::Malloc(sizeof(ndTriplex) * m_vertexCount);
+			m_packedFaces = (ndUnsigned32*)ndMemory::Malloc(sizeof(ndUnsigned32) * m_packedFacesCount);
+			m_compressedNodesBuffer = ndMemory::Malloc(sizeof(ndCompressedNode) * size_t(m_compressedNodesCount) + D_COMPRESSED_BLOCK_SIZE);
+			m_compressedNodes = (ndCompressedNode*)((size_t(m_compressedNodesBuffer) + D_COMPRESSED_BLOCK_SIZE - 1) & ~size_t(D_COMPRESSED_BLOCK_SIZE - 1));
+			m_aabb = (ndNode*)ndMemory::Malloc(sizeof(ndNode));
+			m_indices = nullptr;
+
+			readValues = fread(m_localVertex, sizeof(ndTriplex) * m_vertexCount, 1, file);
+			readValues = fread(m_packedFaces, sizeof(ndUnsigned32) * m_packedFacesCount, 1, file);
+			readValues = fread(m_compressedNodes, sizeof(ndCompressedNode) * m_compressedNodesCount, 1, file);
+			readValues = fread(m_aabb, sizeof(ndNode), 1, file);
+		}
+		else if (m_vertexCount) 
 		{
 			m_localVertex = (ndFloat32*)ndMemory::Malloc(sizeof(ndTriplex) * m_vertexCount);
 			m_indices = (ndInt32*)ndMemory::Malloc(sizeof(ndInt32) * m_indexCount);
@@ -820,6 +1307,11 @@ void ndAabbPolygonSoup::Deserialize (const char* const path)
 
 ndVector ndAabbPolygonSoup::ForAllSectorsSupportVertex (const ndVector& dir) const
 {
+	if (m_compressedNodes)
+	{
+		return ForAllSectorsSupportVertexCompressed(dir);
+	}
+
 	ndVector supportVertex (ndFloat32 (0.0f));
 	if (m_aabb) 
 	{
@@ -968,6 +1460,12 @@ ndVector ndAabbPolygonSoup::ForAllSectorsSupportVertex (const ndVector& dir) con
 
 void ndAabbPolygonSoup::ForAllSectorsRayHit (const ndFastRay& raySrc, ndFloat32 maxParam, ndRayIntersectCallback callback, void* const context) const
 {
+	if (m_compressedNodes)
+	{
+		ForAllSectorsRayHitCompressed(raySrc, maxParam, callback, context);
+		return;
+	}
+
 	const ndNode *stackPool[DG_STACK_DEPTH];
 	ndFloat32 distance[DG_STACK_DEPTH];
 	ndFastRay ray (raySrc);
@@ -1076,7 +1574,11 @@ void ndAabbPolygonSoup::ForAllSectors (const ndFastAabb& obbAabbInfo, const ndVe
 	ndAssert (ndAbs(ndAbs(obbAabbInfo[0][2]) - obbAabbInfo.m_absDir[2][0]) < ndFloat32 (1.0e-4f));
 	ndAssert (ndAbs(ndAbs(obbAabbInfo[1][2]) - obbAabbInfo.m_absDir[2][1]) < ndFloat32 (1.0e-4f));
 
-	if (m_aabb) 
+	if (m_compressedNodes)
+	{
+		ForAllSectorsCompressed(obbAabbInfo, boxDistanceTravel, callback, context);
+	}
+	else if (m_aabb) 
 	{
 		ndFloat32 distance[DG_STACK_DEPTH];
 		const ndNode* stackPool[DG_STACK_DEPTH];
@@ -1310,7 +1812,13 @@ void ndAabbPolygonSoup::ForThisSector(const ndAabbPolygonSoup::ndNode* const nod
 	ndAssert(ndAbs(ndAbs(obbAabbInfo[0][2]) - obbAabbInfo.m_absDir[2][0]) < ndFloat32(1.0e-4f));
 	ndAssert(ndAbs(ndAbs(obbAabbInfo[1][2]) - obbAabbInfo.m_absDir[2][1]) < ndFloat32(1.0e-4f));
 
-	if (m_aabb)
+	if (m_compressedNodes)
+	{
+		// the root is the only node of the compressed layout
+		ndAssert(node == m_aabb);
+		ForAllSectorsCompressed(obbAabbInfo, boxDistanceTravel, callback, context);
+	}
+	else if (m_aabb)
 	{
 		const ndInt32 stride = sizeof(ndTriplex) / sizeof(ndFloat32);
 		const ndTriplex* const vertexArray = (ndTriplex*)m_localVertex;
@@ -1465,3 +1973,273 @@ void ndAabbPolygonSoup::ForThisSector(const ndAabbPolygonSoup::ndNode* const nod
 		}
 	}
 }
+
+ndVector ndAabbPolygonSoup::ForAllSectorsSupportVertexCompressed(const ndVector& dir) const
+{
+	ndInt32 face[D_COMPRESSED_FACE_MAX_INDEX];
+	ndVector stackBox0[DG_STACK_DEPTH];
+	ndVector stackBox1[DG_STACK_DEPTH];
+	ndFloat32 aabbProjection[DG_STACK_DEPTH];
+	const ndCompressedNode* stackPool[DG_STACK_DEPTH];
+
+	ndInt32 stack = 1;
+	stackPool[0] = m_compressedNodes;
+	aabbProjection[0] = ndFloat32(1.0e10f);
+	GetNodeAabb(m_aabb, stackBox0[0], stackBox1[0]);
+	const ndTriplex* const vertexArray = (ndTriplex*)m_localVertex;
+
+	ndFloat32 maxProj = ndFloat32(-1.0e20f);
+	ndVector supportVertex(ndFloat32(0.0f));
+	const ndInt32 ix = (dir[0] > ndFloat32(0.0f)) ? 1 : 0;
+	const ndInt32 iy = (dir[1] > ndFloat32(0.0f)) ? 1 : 0;
+	const ndInt32 iz = (dir[2] > ndFloat32(0.0f)) ? 1 : 0;
+
+	while (stack)
+	{
+		stack--;
+		if (aabbProjection[stack] > maxProj)
+		{
+			const ndCompressedNode* const me = stackPool[stack];
+			const ndVector origin(stackBox0[stack]);
+			const ndVector step(ndCompressedNode::CalculateStep(stackBox0[stack], stackBox1[stack]));
+			const ndInt32 stackBase = stack;
+			for (ndInt32 i = 0; i < 2; ++i)
+			{
+				ndVector box[2];
+				me->GetChildAabb(i, origin, step, box[0], box[1]);
+				const ndVector supportPoint(box[ix].m_x, box[iy].m_y, box[iz].m_z, ndFloat32(0.0f));
+				const ndFloat32 boxSupportDist = supportPoint.DotProduct(dir).GetScalar();
+				if (me->IsLeaf(i))
+				{
+					const ndInt32 vCount = ndInt32(me->GetCount(i));
+					if (vCount && (boxSupportDist > maxProj))
+					{
+						UnpackFace(me->GetIndex(i), vCount, face);
+						for (ndInt32 j = 0; j < vCount; ++j)
+						{
+							const ndVector p(ndVector(&vertexArray[face[j]].m_x) & ndVector::m_triplexMask);
+							const ndFloat32 dist = p.DotProduct(dir).GetScalar();
+							if (dist > maxProj)
+							{
+								maxProj = dist;
+								supportVertex = p;
+							}
+						}
+					}
+				}
+				else
+				{
+					ndAssert(stack < DG_STACK_DEPTH);
+					stackPool[stack] = me->GetNode(i, m_compressedNodes);
+					aabbProjection[stack] = boxSupportDist;
+					stackBox0[stack] = box[0];
+					stackBox1[stack] = box[1];
+					stack++;
+				}
+			}
+
+			// visit the child with the larger support first
+			if (((stack - stackBase) == 2) && (aabbProjection[stackBase] > aabbProjection[stackBase + 1]))
+			{
+				ndSwap(stackPool[stackBase], stackPool[stackBase + 1]);
+				ndSwap(aabbProjection[stackBase], aabbProjection[stackBase + 1]);
+				ndSwap(stackBox0[stackBase], stackBox0[stackBase + 1]);
+				ndSwap(stackBox1[stackBase], stackBox1[stackBase + 1]);
+			}
+		}
+	}
+	return supportVertex;
+}
+
+void ndAabbPolygonSoup::ForAllSectorsRayHitCompressed(const ndFastRay& raySrc, ndFloat32 maxParam, ndRayIntersectCallback callback, void* const context) const
+{
+	ndInt32 face[D_COMPRESSED_FACE_MAX_INDEX];
+	ndVector stackBox0[DG_STACK_DEPTH];
+	ndVector stackBox1[DG_STACK_DEPTH];
+	ndFloat32 distance[DG_STACK_DEPTH];
+	const ndCompressedNode* stackPool[DG_STACK_DEPTH];
+	ndFastRay ray(raySrc);
+
+	ndInt32 stack = 1;
+	const ndTriplex* const vertexArray = (ndTriplex*)m_localVertex;
+
+	stackPool[0] = m_compressedNodes;
+	GetNodeAabb(m_aabb, stackBox0[0], stackBox1[0]);
+	distance[0] = ray.BoxIntersect(stackBox0[0], stackBox1[0]);
+	while (stack)
+	{
+		stack--;
+		if (distance[stack] > maxParam)
+		{
+			break;
+		}
+
+		const ndCompressedNode* const me = stackPool[stack];
+		const ndVector origin(stackBox0[stack]);
+		const ndVector step(ndCompressedNode::CalculateStep(stackBox0[stack], stackBox1[stack]));
+		for (ndInt32 i = 0; i < 2; ++i)
+		{
+			ndVector p0;
+			ndVector p1;
+			me->GetChildAabb(i, origin, step, p0, p1);
+			if (me->IsLeaf(i))
+			{
+				const ndInt32 vCount = ndInt32(me->GetCount(i));
+				if (vCount && (ray.BoxIntersect(p0, p1) < maxParam))
+				{
+					UnpackFace(me->GetIndex(i), vCount, face);
+					const ndFloat32 param = callback(context, &vertexArray[0].m_x, sizeof(ndTriplex), face, vCount);
+					ndAssert(param >= ndFloat32(0.0f));
+					if (param < maxParam)
+					{
+						maxParam = param;
+						if (maxParam == ndFloat32(0.0f))
+						{
+							return;
+						}
+					}
+				}
+			}
+			else
+			{
+				const ndFloat32 dist1 = ray.BoxIntersect(p0, p1);
+				if (dist1 < maxParam)
+				{
+					ndPushCompressedEntry(stackPool, distance, stackBox0, stackBox1, stack, me->GetNode(i, m_compressedNodes), dist1, p0, p1);
+				}
+			}
+		}
+	}
+}
+
+void ndAabbPolygonSoup::ForAllSectorsCompressed(const ndFastAabb& obbAabbInfo, const ndVector& boxDistanceTravel, ndAaabbIntersectCallback callback, void* const context) const
+{
+	ndInt32 face[D_COMPRESSED_FACE_MAX_INDEX];
+	ndVector stackBox0[DG_STACK_DEPTH];
+	ndVector stackBox1[DG_STACK_DEPTH];
+	ndFloat32 distance[DG_STACK_DEPTH];
+	const ndCompressedNode* stackPool[DG_STACK_DEPTH];
+
+	const ndInt32 stride = sizeof(ndTriplex) / sizeof(ndFloat32);
+	const ndTriplex* const vertexArray = (ndTriplex*)m_localVertex;
+
+	ndInt32 stack = 1;
+	stackPool[0] = m_compressedNodes;
+	GetNodeAabb(m_aabb, stackBox0[0], stackBox1[0]);
+
+	ndAssert(boxDistanceTravel.m_w == ndFloat32(0.0f));
+	if (boxDistanceTravel.DotProduct(boxDistanceTravel).GetScalar() < ndFloat32(1.0e-8f))
+	{
+		distance[0] = ndNode::BoxPenetration(obbAabbInfo, stackBox0[0], stackBox1[0]);
+		if (distance[0] <= ndFloat32(0.0f))
+		{
+			obbAabbInfo.m_separationDistance = ndMin(obbAabbInfo.m_separationDistance[0], -distance[0]);
+		}
+		while (stack)
+		{
+			stack--;
+			if (distance[stack] > ndFloat32(0.0f))
+			{
+				const ndCompressedNode* const me = stackPool[stack];
+				const ndVector origin(stackBox0[stack]);
+				const ndVector step(ndCompressedNode::CalculateStep(stackBox0[stack], stackBox1[stack]));
+				for (ndInt32 i = 0; i < 2; ++i)
+				{
+					ndVector p0;
+					ndVector p1;
+					me->GetChildAabb(i, origin, step, p0, p1);
+					if (me->IsLeaf(i))
+					{
+						const ndInt32 vCount = ndInt32(me->GetCount(i));
+						if (vCount > 0)
+						{
+							// the face box rejects the face before its record is read
+							ndFloat32 dist1 = ndNode::BoxPenetration(obbAabbInfo, p0, p1);
+							if (dist1 > ndFloat32(0.0f))
+							{
+								UnpackFace(me->GetIndex(i), vCount, face);
+								ndVector faceNormal(&vertexArray[face[vCount + 1]].m_x);
+								faceNormal = faceNormal & ndVector::m_triplexMask;
+								dist1 = obbAabbInfo.PolygonBoxDistance(faceNormal, vCount, face, stride, &vertexArray[0].m_x);
+							}
+							if (dist1 > ndFloat32(0.0f))
+							{
+								obbAabbInfo.m_separationDistance = ndFloat32(0.0f);
+								ndAssert(vCount >= 3);
+								if (callback(context, &vertexArray[0].m_x, sizeof(ndTriplex), face, vCount, dist1) == m_stopSearch)
+								{
+									return;
+								}
+							}
+							else
+							{
+								obbAabbInfo.m_separationDistance = ndMin(obbAabbInfo.m_separationDistance[0], -dist1);
+							}
+						}
+					}
+					else
+					{
+						const ndFloat32 dist1 = ndNode::BoxPenetration(obbAabbInfo, p0, p1);
+						if (dist1 > ndFloat32(0.0f))
+						{
+							ndPushCompressedEntry(stackPool, distance, stackBox0, stackBox1, stack, me->GetNode(i, m_compressedNodes), dist1, p0, p1);
+						}
+						else
+						{
+							obbAabbInfo.m_separationDistance = ndMin(obbAabbInfo.m_separationDistance[0], -dist1);
+						}
+					}
+				}
+			}
+		}
+	}
+	else
+	{
+		ndFastRay ray(ndVector::m_zero, boxDistanceTravel);
+		ndFastRay obbRay(ndVector::m_zero, obbAabbInfo.UnrotateVector(boxDistanceTravel));
+		distance[0] = ndNode::BoxIntersect(ray, obbRay, obbAabbInfo, stackBox0[0], stackBox1[0]);
+		while (stack)
+		{
+			stack--;
+			if (distance[stack] < ndFloat32(1.0f))
+			{
+				const ndCompressedNode* const me = stackPool[stack];
+				const ndVector origin(stackBox0[stack]);
+				const ndVector step(ndCompressedNode::CalculateStep(stackBox0[stack], stackBox1[stack]));
+				for (ndInt32 i = 0; i < 2; ++i)
+				{
+					ndVector p0;
+					ndVector p1;
+					me->GetChildAabb(i, origin, step, p0, p1);
+					const ndFloat32 dist1 = ndNode::BoxIntersect(ray, obbRay, obbAabbInfo, p0, p1);
+					if (dist1 < ndFloat32(1.0f))
+					{
+						if (me->IsLeaf(i))
+						{
+							const ndInt32 vCount = ndInt32(me->GetCount(i));
+							if (vCount > 0)
+							{
+								UnpackFace(me->GetIndex(i), vCount, face);
+								ndVector faceNormal(&vertexArray[face[vCount + 1]].m_x);
+								faceNormal = faceNormal & ndVector::m_triplexMask;
+								const ndFloat32 hitDistance = obbAabbInfo.PolygonBoxRayDistance(faceNormal, vCount, face, stride, &vertexArray[0].m_x, ray);
+								if (hitDistance < ndFloat32(1.0f))
+								{
+									ndAssert(vCount >= 3);
+									if (callback(context, &vertexArray[0].m_x, sizeof(ndTriplex), face, vCount, hitDistance) == m_stopSearch)
+									{
+										return;
+									}
+								}
+							}
+						}
+						else
+						{
+							ndPushCompressedEntry(stackPool, distance, stackBox0, stackBox1, stack, me->GetNode(i, m_compressedNodes), dist1, p0, p1);
+						}
+					}
+				}
+			}
+		}
+	}
+}
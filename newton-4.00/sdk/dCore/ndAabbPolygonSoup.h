@@ -133,6 +133,20 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 			ndVector p1 (&vertexArray[m_indexBox1].m_x);
 			p0 = p0 & ndVector::m_triplexMask;
 			p1 = p1 & ndVector::m_triplexMask;
+			return BoxPenetration(obb, p0, p1);
+		}
+
+		inline ndFloat32 BoxIntersect (const ndFastRay& ray, const ndFastRay& obbRay, const ndFastAabb& obb, const ndTriplex* const vertexArray) const
+		{
+			ndVector p0 (&vertexArray[m_indexBox0].m_x);
+			ndVector p1 (&vertexArray[m_indexBox1].m_x);
+			p0 = p0 & ndVector::m_triplexMask;
+			p1 = p1 & ndVector::m_triplexMask;
+			return BoxIntersect(ray, obbRay, obb, p0, p1);
+		}
+
+		static inline ndFloat32 BoxPenetration (const ndFastAabb& obb, const ndVector& p0, const ndVector& p1)
+		{
 			ndVector minBox (p0 - obb.m_p1);
 			ndVector maxBox (p1 - obb.m_p0);
 			ndAssert(maxBox.m_x >= minBox.m_x);
@@ -173,13 +187,8 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 			return	dist.GetScalar();
 		}
 
-		inline ndFloat32 BoxIntersect (const ndFastRay& ray, const ndFastRay& obbRay, const ndFastAabb& obb, const ndTriplex* const vertexArray) const
+		static inline ndFloat32 BoxIntersect (const ndFastRay& ray, const ndFastRay& obbRay, const ndFastAabb& obb, const ndVector& p0, const ndVector& p1)
 		{
-			ndVector p0 (&vertexArray[m_indexBox0].m_x);
-			ndVector p1 (&vertexArray[m_indexBox1].m_x);
-			p0 = p0 & ndVector::m_triplexMask;
-			p1 = p1 & ndVector::m_triplexMask;
-
 			ndVector minBox (p0 - obb.m_p1);
 			ndVector maxBox (p1 - obb.m_p0);
 			ndFloat32 dist = ray.BoxIntersect(minBox, maxBox);
@@ -207,6 +216,63 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 		ndLeafNodePtr m_right;
 	};
 
+	/// Node of the compressed layout.
+	/// It holds the boxes of its two children quantized to 16 bits relative to its own box, 
+	/// and the two child links. A leaf child link points to a packed face record, and its box 
+	/// is the box of that face.
+	class ndCompressedNode
+	{
+		public:
+		inline ndUnsigned32 IsLeaf (ndInt32 child) const
+		{
+			return m_child[child] & 0x80000000;
+		}
+
+		inline ndUnsigned32 GetCount (ndInt32 child) const
+		{
+			ndAssert (IsLeaf(child));
+			return (m_child[child] & (~0x80000000)) >> (32 - DG_INDEX_COUNT_BITS - 1);
+		}
+
+		inline ndUnsigned32 GetIndex (ndInt32 child) const
+		{
+			ndAssert (IsLeaf(child));
+			return m_child[child] & (~(-(1 << (32 - DG_INDEX_COUNT_BITS - 1))));
+		}
+
+		inline const ndCompressedNode* GetNode (ndInt32 child, const ndCompressedNode* const root) const
+		{
+			ndAssert (!IsLeaf(child));
+			return root + m_child[child];
+		}
+
+		// the quantization step of the children of a node with box p0, p1. 
+		// it is slightly inflated so that the largest quantized value covers p1.
+		static inline ndVector CalculateStep (const ndVector& p0, const ndVector& p1)
+		{
+			const ndVector scale (ndFloat32 (1.00001f) / ndFloat32 (0xffff));
+			return ((p1 - p0) * scale) & ndVector::m_triplexMask;
+		}
+
+		inline void GetChildAabb (ndInt32 child, const ndVector& origin, const ndVector& step, ndVector& p0, ndVector& p1) const
+		{
+			const ndUnsigned16* const box = m_box[child];
+			ndVector q0 (ndVector::m_zero);
+			ndVector q1 (ndVector::m_zero);
+			q0.m_x = ndFloat32 (box[0]);
+			q0.m_y = ndFloat32 (box[1]);
+			q0.m_z = ndFloat32 (box[2]);
+			q1.m_x = ndFloat32 (box[3]);
+			q1.m_y = ndFloat32 (box[4]);
+			q1.m_z = ndFloat32 (box[5]);
+			p0 = origin + q0 * step;
+			p1 = origin + q1 * step;
+		}
+
+		ndUnsigned16 m_box[2][6];
+		ndUnsigned32 m_child[2];
+	};
+
 	class ndSplitInfo;
 	class ndNodeBuilder;
 
@@ -219,12 +285,19 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 	/// Reads a previously saved database binary file named path.
 	D_CORE_API virtual void Deserialize (const char* const path);
 
+	/// Returns true if the hierarchy uses the compressed node and face layout.
+	D_CORE_API bool IsCompressed () const;
+
+	/// Returns the size in bytes of the vertex, face and node arrays.
+	D_CORE_API size_t GetMemorySize () const;
+
 	protected:
 	D_CORE_API ndAabbPolygonSoup ();
 	D_CORE_API virtual ~ndAabbPolygonSoup ();
 
 	D_CORE_API void Create (const ndPolygonSoupBuilder& builder);
 	D_CORE_API void CalculateAdjacent ();
+	D_CORE_API void Compress ();
 	D_CORE_API virtual ndVector ForAllSectorsSupportVertex(const ndVector& dir) const;
 	D_CORE_API virtual void ForAllSectorsRayHit (const ndFastRay& ray, ndFloat32 maxT, ndRayIntersectCallback callback, void* const context) const;
 	D_CORE_API virtual void ForAllSectors (const ndFastAabb& obbAabb, const ndVector& boxDistanceTravel, ndFloat32 maxT, ndAaabbIntersectCallback callback, void* const context) const;
@@ -232,6 +305,7 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 
 	public:
 	/// Get the root node of the hierarchy.
+	/// In the compressed layout the root has no child nodes, and its sector covers the whole mesh.
 	inline ndNode* GetRootNode() const
 	{
 		return m_aabb;
@@ -264,11 +338,26 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 	ndNodeBuilder* BuildTopDown (ndNodeBuilder* const leafArray, ndInt32 firstBox, ndInt32 lastBox, ndNodeBuilder** const allocator) const;
 	ndFloat32 CalculateFaceMaxDiagonal (const ndVector* const vertex, ndInt32 indexCount, const ndInt32* const indexArray) const;
 	static ndIntersectStatus CalculateAllFaceEdgeNormals(void* const context, const ndFloat32* const polygon, ndInt32 strideInBytes, const ndInt32* const indexArray, ndInt32 indexCount, ndFloat32 hitDistance);
+
+	void UnpackFace (ndUnsigned32 faceStart, ndInt32 indexCount, ndInt32* const face) const;
+	ndVector ForAllSectorsSupportVertexCompressed (const ndVector& dir) const;
+	void ForAllSectorsRayHitCompressed (const ndFastRay& ray, ndFloat32 maxT, ndRayIntersectCallback callback, void* const context) const;
+	void ForAllSectorsCompressed (const ndFastAabb& obbAabb, const ndVector& boxDistanceTravel, ndAaabbIntersectCallback callback, void* const context) const;
 	
 	ndNode* m_aabb;
 	ndInt32* m_indices;
 	ndInt32 m_nodesCount;
 	ndInt32 m_indexCount;
+
+	// compressed layout, m_aabb is then a single proxy root node with no children
+	ndCompressedNode* m_compressedNodes;
+	void* m_compressedNodesBuffer;
+	ndUnsigned32* m_packedFaces;
+	ndInt32 m_compressedNodesCount;
+	ndInt32 m_packedFacesCount;
+	ndInt32 m_packedIndexBits;
+	ndInt32 m_packedAttributeBits;
+	ndInt32 m_packedFaceSizeBits;
 	friend class ndContactSolver;
 };
 
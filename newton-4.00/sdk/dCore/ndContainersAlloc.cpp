@@ -27,7 +27,13 @@
 #include "ndContainersAlloc.h"
 #include "ndThreadSyncUtils.h"
 
-#define D_FREELIST_DICTIONARY_SIZE 64
+#define D_FREELIST_DICTIONARY_SIZE	64
+
+// each thread keeps a small magazine of free nodes per size class, 
+// it refills from and spills to the global dictionary in batches,
+// so that only one in D_FREELIST_CACHE_BATCH operations takes the global lock.
+#define D_FREELIST_CACHE_SIZE		64
+#define D_FREELIST_CACHE_BATCH		(D_FREELIST_CACHE_SIZE / 2)
 
 class ndFreeListEntry
 {
@@ -38,18 +44,120 @@ class ndFreeListEntry
 class ndFreeListHeader
 {
 	public:
+	ndFreeListEntry* Pop()
+	{
+		ndAssert(m_count > 0);
+		m_count--;
+		ndFreeListEntry* const self = m_headPointer;
+		m_headPointer = self->m_next;
+		return self;
+	}
+
+	void Push(ndFreeListEntry* const self)
+	{
+		self->m_next = m_headPointer;
+		m_count++;
+		m_headPointer = self;
+	}
+
 	ndInt32 m_count;
 	ndInt32 m_schunkSize;
 	ndFreeListEntry* m_headPointer;
 };
 
-class ndFreeListDictionary: public ndFixSizeArray<ndFreeListHeader, D_FREELIST_DICTIONARY_SIZE>
+class ndFreeListHeaderArray: public ndFixSizeArray<ndFreeListHeader, D_FREELIST_DICTIONARY_SIZE>
 {
 	public:
-	ndFreeListDictionary()
+	ndFreeListHeaderArray()
 		:ndFixSizeArray<ndFreeListHeader, D_FREELIST_DICTIONARY_SIZE>()
+	{
+	}
+
+	ndFreeListHeader* FindEntry(ndInt32 size)
+	{
+		ndInt32 i0 = 0;
+		ndInt32 i1 = GetCount() - 1;
+		ndFreeListHeaderArray& me = *this;
+		while ((i1 - i0 > 4))
+		{
+			ndInt32 mid = (i1 + i0) / 2;
+			if (me[mid].m_schunkSize <= size)
+			{
+				i0 = mid;
+			}
+			else
+			{
+				i1 = mid;
+			}
+		}
+
+		for (ndInt32 i = i0; i <= i1; ++i)
+		{
+			if (me[i].m_schunkSize == size)
+			{
+				return &me[i];
+			}
+		}
+
+		#ifdef _DEBUG
+			for (ndInt32 i = 0; i < GetCount(); ++i)
+			{
+				ndAssert(me[i].m_schunkSize != size);
+			}
+		#endif
+
+		ndFreeListHeader header;
+		header.m_count = 0;
+		header.m_schunkSize = size;
+		header.m_headPointer = nullptr;
+		PushBack(header);
+		ndInt32 index = GetCount() - 1;
+		for (ndInt32 i = GetCount() - 2; i >= 0; --i)
+		{
+			if (size < me[i].m_schunkSize)
+			{
+				me[i + 1] = me[i];
+				me[i + 0] = header;
+				index = i;
+			}
+			else
+			{
+				break;
+			}
+		}
+		return &me[index];
+	}
+};
+
+class ndFreeListDictionary: public ndFreeListHeaderArray
+{
+	class ndScopeCountedLock
+	{
+		public:
+		ndScopeCountedLock(ndFreeListDictionary& dictionary)
+			:m_dictionary(dictionary)
+		{
+			if (!m_dictionary.m_lock.TryLock())
+			{
+				m_dictionary.m_lock.Lock();
+				m_dictionary.m_statistics.m_lockContentions++;
+			}
+		}
+
+		~ndScopeCountedLock()
+		{
+			m_dictionary.m_lock.Unlock();
+		}
+
+		ndFreeListDictionary& m_dictionary;
+	};
+
+	public:
+	ndFreeListDictionary()
+		:ndFreeListHeaderArray()
 		,m_lock()
 	{
+		ResetStatistics();
 	}
 
 	~ndFreeListDictionary()
@@ -75,43 +183,35 @@ class ndFreeListDictionary: public ndFixSizeArray<ndFreeListHeader, D_FREELIST_D
 		header->m_headPointer = nullptr;
 	}
 
-	void* Malloc(ndInt32 size)
+	// move up to count free nodes of the cache size class from the dictionary to the cache 
+	void Refill(ndFreeListHeader& cache, ndInt32 count, ndFreeListAlloc::ndStatistics& threadStats)
 	{
+		ndScopeCountedLock lock(*this);
+		Publish(threadStats);
+		m_statistics.m_refills++;
+		ndFreeListHeader* const header = FindEntry(cache.m_schunkSize);
+		ndAssert(header->m_count >= 0);
+		for (ndInt32 i = ndMin(count, header->m_count); i > 0; --i)
 		{
-			ndScopeSpinLock lock(m_lock);
-			ndFreeListHeader* const header = FindEntry(ndInt32(ndMemory::CalculateBufferSize(size_t(size))));
-			ndAssert(header->m_count >= 0);
-			if (header->m_count)
-			{
-				header->m_count--;
-				ndFreeListEntry* const self = header->m_headPointer;
-				header->m_headPointer = self->m_next;
-
-				#if defined (D_MEMORY_SANITY_CHECK) && defined(_DEBUG)
-				ndAssert(ndMemory::CheckMemory(self));
-				#endif
-				return self;
-			}
+			ndFreeListEntry* const self = header->Pop();
+			#if defined (D_MEMORY_SANITY_CHECK) && defined(_DEBUG)
+			ndAssert(ndMemory::CheckMemory(self));
+			#endif
+			cache.Push(self);
 		}
-		void* const ptr = ndMemory::Malloc(size_t(size));
-		ndAssert(ndMemory::GetSize(ptr) == ndMemory::CalculateBufferSize(size_t(size)));
-		return ptr;
 	}
 
-	void Free(void* const ptr)
+	// move up to count free nodes from the cache back to the dictionary
+	void Spill(ndFreeListHeader& cache, ndInt32 count, ndFreeListAlloc::ndStatistics& threadStats)
 	{
-		ndScopeSpinLock lock(m_lock);
-		#if defined (D_MEMORY_SANITY_CHECK) && defined(_DEBUG)
-		ndAssert(ndMemory::CheckMemory(ptr));
-		#endif
-
-		ndFreeListHeader* const header = FindEntry(ndInt32(ndMemory::GetSize(ptr)));
-		ndAssert(header);
-		ndFreeListEntry* const self = (ndFreeListEntry*)ptr;
-
-		self->m_next = header->m_headPointer;
-		header->m_count++;
-		header->m_headPointer = self;
+		ndScopeCountedLock lock(*this);
+		Publish(threadStats);
+		m_statistics.m_spills++;
+		ndFreeListHeader* const header = FindEntry(cache.m_schunkSize);
+		for (ndInt32 i = ndMin(count, cache.m_count); i > 0; --i)
+		{
+			header->Push(cache.Pop());
+		}
 	}
 
 	void Flush()
@@ -133,86 +233,168 @@ class ndFreeListDictionary: public ndFixSizeArray<ndFreeListHeader, D_FREELIST_D
 		Flush(header);
 	}
 
+	void GetStatistics(ndFreeListAlloc::ndStatistics& stats)
+	{
+		ndScopeSpinLock lock(m_lock);
+		stats = m_statistics;
+	}
+
+	void ResetStatistics()
+	{
+		ndScopeSpinLock lock(m_lock);
+		m_statistics.m_cacheHits = 0;
+		m_statistics.m_cacheMisses = 0;
+		m_statistics.m_refills = 0;
+		m_statistics.m_spills = 0;
+		m_statistics.m_lockContentions = 0;
+	}
+
 	private:
-	ndFreeListHeader* FindEntry(ndInt32 size)
+	// thread counters are only merged when the thread already holds the lock
+	void Publish(ndFreeListAlloc::ndStatistics& threadStats)
 	{
-		ndInt32 i0 = 0;
-		ndInt32 i1 = GetCount() - 1;
-		ndFreeListDictionary& me = *this;
-		while ((i1 - i0 > 4))
+		m_statistics.m_cacheHits += threadStats.m_cacheHits;
+		m_statistics.m_cacheMisses += threadStats.m_cacheMisses;
+		threadStats.m_cacheHits = 0;
+		threadStats.m_cacheMisses = 0;
+	}
+
+	ndFreeListAlloc::ndStatistics m_statistics;
+	ndSpinLock m_lock;
+};
+
+class ndFreeListThreadCache: public ndFreeListHeaderArray
+{
+	public:
+	ndFreeListThreadCache()
+		:ndFreeListHeaderArray()
+	{
+		m_statistics.m_cacheHits = 0;
+		m_statistics.m_cacheMisses = 0;
+		m_statistics.m_refills = 0;
+		m_statistics.m_spills = 0;
+		m_statistics.m_lockContentions = 0;
+	}
+
+	~ndFreeListThreadCache()
+	{
+		Flush();
+	}
+
+	static ndFreeListThreadCache& GetCache()
+	{
+		static thread_local ndFreeListThreadCache cache;
+		return cache;
+	}
+
+	void* Malloc(ndInt32 size)
+	{
+		ndFreeListHeader* const header = FindEntry(ndInt32(ndMemory::CalculateBufferSize(size_t(size))));
+		ndAssert(header->m_count >= 0);
+		if (header->m_count)
 		{
-			ndInt32 mid = (i1 + i0) / 2;
-			if (me[mid].m_schunkSize <= size)
-			{
-				i0 = mid;
-			}
-			else
-			{
-				i1 = mid;
-			}
+			m_statistics.m_cacheHits++;
+		}
+		else
+		{
+			m_statistics.m_cacheMisses++;
+			ndFreeListDictionary::GetHeader().Refill(*header, D_FREELIST_CACHE_BATCH, m_statistics);
 		}
 
-		for (ndInt32 i = i0; i <= i1; ++i)
+		if (header->m_count)
 		{
-			if (me[i].m_schunkSize == size)
-			{
-				return &me[i];
-			}
+			return header->Pop();
 		}
+		void* const ptr = ndMemory::Malloc(size_t(size));
+		ndAssert(ndMemory::GetSize(ptr) == ndMemory::CalculateBufferSize(size_t(size)));
+		return ptr;
+	}
 
-		#ifdef _DEBUG
-			for (ndInt32 i = 0; i < GetCount(); ++i)
-			{
-				ndAssert(me[i].m_schunkSize != size);
-			}
+	void Free(void* const ptr)
+	{
+		#if defined (D_MEMORY_SANITY_CHECK) && defined(_DEBUG)
+		ndAssert(ndMemory::CheckMemory(ptr));
 		#endif
 
-		ndFreeListHeader header;
-		header.m_count = 0;
-		header.m_schunkSize = size;
-		header.m_headPointer = nullptr;
-		PushBack(header);
-		ndInt32 index = GetCount() - 1;
-		for (ndInt32 i = GetCount() - 2; i >= 0; --i)
+		ndFreeListHeader* const header = FindEntry(ndInt32(ndMemory::GetSize(ptr)));
+		ndAssert(header);
+		header->Push((ndFreeListEntry*)ptr);
+		if (header->m_count >= D_FREELIST_CACHE_SIZE)
 		{
-			if (size < me[i].m_schunkSize)
-			{
-				me[i + 1] = me[i];
-				me[i + 0] = header;
-				index = i;
-			}
-			else
+			ndFreeListDictionary::GetHeader().Spill(*header, D_FREELIST_CACHE_BATCH, m_statistics);
+		}
+	}
+
+	// return all cached nodes to the dictionary
+	void Flush()
+	{
+		ndFreeListDictionary& dictionary = ndFreeListDictionary::GetHeader();
+		ndFreeListThreadCache& me = *this;
+		for (ndInt32 i = 0; i < GetCount(); ++i)
+		{
+			if (me[i].m_count)
 			{
-				break;
+				dictionary.Spill(me[i], me[i].m_count, m_statistics);
 			}
 		}
-		return &me[index];
 	}
 
-	ndSpinLock m_lock;
+	void Flush(ndInt32 size)
+	{
+		ndFreeListHeader* const header = FindEntry(ndInt32(ndMemory::CalculateBufferSize(size_t(size))));
+		if (header->m_count)
+		{
+			ndFreeListDictionary::GetHeader().Spill(*header, header->m_count, m_statistics);
+		}
+	}
+
+	ndFreeListAlloc::ndStatistics m_statistics;
 };
 
 void ndFreeListAlloc::Flush()
 {
+	// only the calling thread cache can be released here, 
+	// the worker caches return their nodes when the threads terminate.
+	ndFreeListThreadCache::GetCache().Flush();
 	ndFreeListDictionary& dictionary = ndFreeListDictionary::GetHeader();
 	dictionary.Flush();
 }
 
 void* ndFreeListAlloc::operator new (size_t size)
 {
-	ndFreeListDictionary& dictionary = ndFreeListDictionary::GetHeader();
-	return dictionary.Malloc(ndInt32 (size));
+	ndFreeListThreadCache& cache = ndFreeListThreadCache::GetCache();
+	return cache.Malloc(ndInt32 (size));
 }
 
 void ndFreeListAlloc::operator delete (void* ptr)
 {
-	ndFreeListDictionary& dictionary = ndFreeListDictionary::GetHeader();
-	dictionary.Free(ptr);
+	ndFreeListThreadCache& cache = ndFreeListThreadCache::GetCache();
+	cache.Free(ptr);
 }
 
 void ndFreeListAlloc::Flush(ndInt32 size)
 {
+	ndFreeListThreadCache::GetCache().Flush(size);
 	ndFreeListDictionary& dictionary = ndFreeListDictionary::GetHeader();
 	dictionary.Flush(size);
 }
 
+void ndFreeListAlloc::GetStatistics(ndStatistics& stats)
+{
+	ndFreeListDictionary& dictionary = ndFreeListDictionary::GetHeader();
+	dictionary.GetStatistics(stats);
+
+	// add the counters the calling thread has not published yet
+	const ndStatistics& threadStats = ndFreeListThreadCache::GetCache().m_statistics;
+	stats.m_cacheHits += threadStats.m_cacheHits;
+	stats.m_cacheMisses += threadStats.m_cacheMisses;
+}
+
+void ndFreeListAlloc::ResetStatistics()
+{
+	ndFreeListThreadCache& cache = ndFreeListThreadCache::GetCache();
+	cache.m_statistics.m_cacheHits = 0;
+	cache.m_statistics.m_cacheMisses = 0;
+	ndFreeListDictionary& dictionary = ndFreeListDictionary::GetHeader();
+	dictionary.ResetStatistics();
+}
@@ -44,9 +44,26 @@ class ndContainersAlloc: public ndClassAlloc
 class ndFreeListAlloc
 {
 	public:
+	/// allocation counters of the free list caches.
+	/// m_cacheHits counts allocations served from the calling thread cache, 
+	/// m_cacheMisses the ones that had to go to the shared dictionary.
+	/// m_lockContentions counts the times a thread found the shared dictionary locked.
+	/// counters of other threads are merged in batches, so they may lag a little.
+	class ndStatistics
+	{
+		public:
+		ndUnsigned64 m_cacheHits;
+		ndUnsigned64 m_cacheMisses;
+		ndUnsigned64 m_refills;
+		ndUnsigned64 m_spills;
+		ndUnsigned64 m_lockContentions;
+	};
+
 	ndFreeListAlloc();
 	D_CORE_API static void Flush();
 	D_CORE_API static void Flush(ndInt32 size);
+	D_CORE_API static void ResetStatistics();
+	D_CORE_API static void GetStatistics(ndStatistics& stats);
 	D_CORE_API void *operator new (size_t size);
 	D_CORE_API void operator delete (void* ptr);
 };
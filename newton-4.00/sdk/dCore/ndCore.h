@@ -49,6 +49,7 @@
 #include <ndSemaphore.h>
 #include <ndSharedPtr.h>
 #include <ndClassAlloc.h>
+#include <ndFrameArena.h>
 #include <ndThreadPool.h>
 #include <ndIsoSurface.h>
 #include <ndQuaternion.h>
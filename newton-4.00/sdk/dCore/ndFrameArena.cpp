@@ -0,0 +1,123 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndUtils.h"
+#include "ndMemory.h"
+#include "ndFrameArena.h"
+
+ndFrameArena::ndFrameArena()
+	:ndClassAlloc()
+	,m_buffer(nullptr)
+	,m_overflow(nullptr)
+	,m_offset(0)
+	,m_capacity(0)
+	,m_maxCapacity(size_t(1) << 31)
+	,m_peakSize(0)
+	,m_overflowCount(0)
+	,m_lock()
+{
+}
+
+ndFrameArena::~ndFrameArena()
+{
+	Release();
+}
+
+void* ndFrameArena::Alloc(size_t sizeInBytes)
+{
+	const size_t size = (sizeInBytes + D_FRAME_ARENA_ALIGNMENT - 1) & ~size_t(D_FRAME_ARENA_ALIGNMENT - 1);
+	const size_t offset = size_t(m_offset.fetch_add(ndUnsigned64(size)));
+	if ((offset + size) <= m_capacity)
+	{
+		return &m_buffer[offset];
+	}
+	return OverflowAlloc(size);
+}
+
+void* ndFrameArena::OverflowAlloc(size_t sizeInBytes)
+{
+	// the block header is padded so that the returned buffer keeps the arena alignment
+	ndUnsigned8* const ptr = (ndUnsigned8*)ndMemory::Malloc(sizeInBytes + D_FRAME_ARENA_ALIGNMENT);
+	ndUnsigned8* const buffer = ptr + D_FRAME_ARENA_ALIGNMENT;
+
+	ndOverflowBlock* const block = (ndOverflowBlock*)ptr;
+	ndScopeSpinLock lock(m_lock);
+	block->m_next = m_overflow;
+	m_overflow = block;
+	m_overflowCount++;
+	return buffer;
+}
+
+void ndFrameArena::FreeOverflow()
+{
+	ndOverflowBlock* next;
+	for (ndOverflowBlock* block = m_overflow; block; block = next)
+	{
+		next = block->m_next;
+		ndMemory::Free(block);
+	}
+	m_overflow = nullptr;
+}
+
+void ndFrameArena::Reset()
+{
+	const size_t usedSize = GetUsedSize();
+	m_peakSize = ndMax(m_peakSize, usedSize);
+	FreeOverflow();
+
+	const size_t maxCapacity = ndMax(m_maxCapacity, size_t(D_FRAME_ARENA_ALIGNMENT));
+	if ((usedSize > m_capacity) && (m_capacity < maxCapacity))
+	{
+		// grow with some slack, so that small fluctuations do not reallocate every frame.
+		size_t capacity = ndMax(size_t(D_FRAME_ARENA_DEFAULT_SIZE), usedSize + usedSize / 4);
+		capacity = ndMin(capacity, maxCapacity);
+		if (m_buffer)
+		{
+			ndMemory::Free(m_buffer);
+		}
+		m_buffer = (ndUnsigned8*)ndMemory::Malloc(capacity);
+		m_capacity = capacity;
+	}
+	m_offset.store(0);
+}
+
+void ndFrameArena::Release()
+{
+	FreeOverflow();
+	if (m_buffer)
+	{
+		ndMemory::Free(m_buffer);
+	}
+	m_buffer = nullptr;
+	m_capacity = 0;
+	m_offset.store(0);
+}
+
+void ndFrameArena::SetMaxCapacity(size_t sizeInBytes)
+{
+	m_maxCapacity = sizeInBytes;
+	if (m_capacity > m_maxCapacity)
+	{
+		ndAssert(!GetUsedSize());
+		Release();
+	}
+}
@@ -0,0 +1,135 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __ND_FRAME_ARENA_H_
+#define __ND_FRAME_ARENA_H_
+
+#include "ndCoreStdafx.h"
+#include "ndTypes.h"
+#include "ndClassAlloc.h"
+#include "ndThreadSyncUtils.h"
+
+#define D_FRAME_ARENA_ALIGNMENT		32
+#define D_FRAME_ARENA_DEFAULT_SIZE	(256 * 1024)
+
+/// Linear memory arena for transient data that only lives for one update.
+/// \brief Allocations are a thread safe bump of an offset into one block, 
+/// nothing is freed until Reset is called at the end of the frame.
+/// Requests that do not fit in the block are served from the heap and 
+/// released on Reset, the next Reset grows the block to the high water 
+/// mark, so after a few frames all allocations come from the block.
+class ndFrameArena: public ndClassAlloc
+{
+	public:
+	D_CORE_API ndFrameArena();
+	D_CORE_API ~ndFrameArena();
+
+	/// Allocate a buffer aligned to D_FRAME_ARENA_ALIGNMENT bytes, valid until the next Reset.
+	D_CORE_API void* Alloc(size_t sizeInBytes);
+
+	/// Allocate an uninitialized array of count items, valid until the next Reset.
+	template <class T>
+	T* Alloc(ndInt32 count);
+
+	/// Release all frame allocations and resize the block to fit the frame high water mark.
+	/// must not be called while other threads are allocating. 
+	D_CORE_API void Reset();
+
+	/// Free the block, the next frame starts from scratch.
+	D_CORE_API void Release();
+
+	/// Bytes allocated so far this frame.
+	size_t GetUsedSize() const;
+
+	/// Size of the current block.
+	size_t GetCapacity() const;
+
+	/// The largest number of bytes used by any frame since the last ResetPeakSize.
+	size_t GetPeakSize() const;
+	void ResetPeakSize();
+
+	/// Upper bound for the size of the block, frames that need more 
+	/// than this spill the excess to the heap instead.
+	size_t GetMaxCapacity() const;
+	D_CORE_API void SetMaxCapacity(size_t sizeInBytes);
+
+	/// Number of allocations that did not fit in the block since the last ResetPeakSize.
+	ndUnsigned64 GetOverflowCount() const;
+
+	private:
+	void* OverflowAlloc(size_t sizeInBytes);
+	void FreeOverflow();
+
+	class ndOverflowBlock
+	{
+		public:
+		ndOverflowBlock* m_next;
+	};
+
+	ndUnsigned8* m_buffer;
+	ndOverflowBlock* m_overflow;
+	ndAtomic<ndUnsigned64> m_offset;
+	size_t m_capacity;
+	size_t m_maxCapacity;
+	size_t m_peakSize;
+	ndUnsigned64 m_overflowCount;
+	ndSpinLock m_lock;
+};
+
+template <class T>
+inline T* ndFrameArena::Alloc(ndInt32 count)
+{
+	ndAssert(count >= 0);
+	return (T*)Alloc(size_t(count) * sizeof(T));
+}
+
+inline size_t ndFrameArena::GetUsedSize() const
+{
+	return size_t(m_offset.load());
+}
+
+inline size_t ndFrameArena::GetCapacity() const
+{
+	return m_capacity;
+}
+
+inline size_t ndFrameArena::GetPeakSize() const
+{
+	return ndMax(m_peakSize, GetUsedSize());
+}
+
+inline void ndFrameArena::ResetPeakSize()
+{
+	m_peakSize = 0;
+	m_overflowCount = 0;
+}
+
+inline size_t ndFrameArena::GetMaxCapacity() const
+{
+	return m_maxCapacity;
+}
+
+inline ndUnsigned64 ndFrameArena::GetOverflowCount() const
+{
+	return m_overflowCount;
+}
+
+#endif
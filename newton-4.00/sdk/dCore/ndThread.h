@@ -78,6 +78,9 @@ class ndThread
 	D_CORE_API virtual void ThreadFunctionCallback();
 
 	ndThreadName m_name;
+
+	private:
+	static void ThreadEntry(ndThread* const thread);
 };
 
 #endif
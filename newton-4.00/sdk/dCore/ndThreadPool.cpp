@@ -26,10 +26,14 @@
 #include "ndThreadPool.h"
 #include "ndThreadSyncUtils.h"
 
+static thread_local ndThreadPool* g_currentThreadPool = nullptr;
+static thread_local ndInt32 g_currentThreadIndex = 0;
+
 ndThreadPool::ndWorker::ndWorker()
 	:ndThread()
 	,m_owner(nullptr)
 	,m_task(nullptr)
+	,m_busyTime(0)
 	,m_threadIndex(0)
 #ifdef D_USE_SYNC_SEMAPHORE
 	,m_taskReady()
@@ -74,7 +78,13 @@ void ndThreadPool::ndWorker::ThreadFunction()
 	while (!m_taskReady.Wait() && m_task)
 	{
 		//D_TRACKTIME();
+		g_currentThreadPool = m_owner;
+		g_currentThreadIndex = m_threadIndex + 1;
+		const ndUnsigned64 startTime = ndGetTimeInMicroseconds();
 		m_task->Execute();
+		m_busyTime += ndGetTimeInMicroseconds() - startTime;
+		g_currentThreadPool = nullptr;
+		g_currentThreadIndex = 0;
 		m_task = nullptr;
 	}
 #else
@@ -87,7 +97,13 @@ void ndThreadPool::ndWorker::ThreadFunction()
 			//D_TRACKTIME();
 			if (m_task)
 			{
+				g_currentThreadPool = m_owner;
+				g_currentThreadIndex = m_threadIndex + 1;
+				const ndUnsigned64 startTime = ndGetTimeInMicroseconds();
 				m_task->Execute();
+				m_busyTime += ndGetTimeInMicroseconds() - startTime;
+				g_currentThreadPool = nullptr;
+				g_currentThreadIndex = 0;
 			}
 			iterations = 0;
 			m_taskReady = 0;
@@ -114,6 +130,7 @@ ndThreadPool::ndThreadPool(const char* const baseName)
 	:ndSyncMutex()
 	,ndThread()
 	,m_workers(nullptr)
+	,m_busyTime(0)
 	,m_count(0)
 {
 	char name[256];
@@ -127,6 +144,44 @@ ndThreadPool::~ndThreadPool()
 	SetThreadCount(0);
 }
 
+ndThreadPool* ndThreadPool::GetCurrentThreadPool()
+{
+	return g_currentThreadPool;
+}
+
+ndInt32 ndThreadPool::GetCurrentThreadIndex()
+{
+	return g_currentThreadIndex;
+}
+
+void ndThreadPool::SetCurrentThread(ndThreadPool* const pool, ndInt32 threadIndex)
+{
+	g_currentThreadPool = pool;
+	g_currentThreadIndex = threadIndex;
+}
+
+ndUnsigned64 ndThreadPool::GetBusyTime(ndInt32 threadIndex) const
+{
+	ndAssert(threadIndex >= 0);
+	ndAssert(threadIndex < GetThreadCount());
+	#ifdef D_USE_THREAD_EMULATION
+	return threadIndex ? 0 : m_busyTime;
+	#else
+	return threadIndex ? m_workers[threadIndex - 1].m_busyTime : m_busyTime;
+	#endif
+}
+
+void ndThreadPool::ResetBusyTime()
+{
+	m_busyTime = 0;
+	#ifndef D_USE_THREAD_EMULATION
+	for (ndInt32 i = 0; i < m_count; ++i)
+	{
+		m_workers[i].m_busyTime = 0;
+	}
+	#endif
+}
+
 ndInt32 ndThreadPool::GetMaxThreads()
 {
 	#ifdef D_USE_THREAD_EMULATION
@@ -141,8 +196,9 @@ void ndThreadPool::SetThreadCount(ndInt32 count)
 #ifdef D_USE_THREAD_EMULATION
 	m_count = ndClamp(count, 1, D_MAX_THREADS_COUNT) - 1;
 #else
-	ndInt32 maxThread = GetMaxThreads();
-	count = ndClamp(count, 1, maxThread) - 1;
+	// GetMaxThreads is only the suggested count for this machine,
+	// a pool can be over subscribed up to D_MAX_THREADS_COUNT threads.
+	count = ndClamp(count, 1, D_MAX_THREADS_COUNT) - 1;
 	if (count != m_count)
 	{
 		if (m_workers)
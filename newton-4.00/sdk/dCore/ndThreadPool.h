@@ -25,16 +25,20 @@
 #include "ndCoreStdafx.h"
 #include "ndTypes.h"
 #include "ndArray.h"
+#include "ndUtils.h"
 #include "ndThread.h"
+#include "ndProfiler.h"
 #include "ndSyncMutex.h"
 #include "ndSemaphore.h"
 #include "ndClassAlloc.h"
 
 //#define	D_USE_SYNC_SEMAPHORE
 
-//#define	D_MAX_THREADS_COUNT	16
-#define	D_MAX_THREADS_COUNT	32
+// upper bound of the thread count, only used to size small stack arrays
+// for per thread scans, persistent per thread data is sized at run time.
+#define	D_MAX_THREADS_COUNT	128
 #define D_WORKER_BATCH_SIZE	32
+#define D_WORKER_CACHE_LINE	64
 
 class ndThreadPool;
 
@@ -79,6 +83,7 @@ class ndThreadPool: public ndSyncMutex, public ndThread
 
 		ndThreadPool* m_owner;
 		ndTask* m_task;
+		ndUnsigned64 m_busyTime;
 		ndInt32 m_threadIndex;
 		#ifdef D_USE_SYNC_SEMAPHORE
 		ndSemaphore m_taskReady;
@@ -96,8 +101,10 @@ class ndThreadPool: public ndSyncMutex, public ndThread
 	D_CORE_API virtual ~ndThreadPool();
 
 	ndInt32 GetThreadCount() const;
+
+	/// suggested thread count for this machine, SetThreadCount accepts up to D_MAX_THREADS_COUNT.
 	D_CORE_API static ndInt32 GetMaxThreads();
-	D_CORE_API void SetThreadCount(ndInt32 count);
+	D_CORE_API virtual void SetThreadCount(ndInt32 count);
 
 	D_CORE_API void TickOne();
 	D_CORE_API void Begin();
@@ -106,11 +113,96 @@ class ndThreadPool: public ndSyncMutex, public ndThread
 	template <typename Function>
 	void ParallelExecute(const Function& ndFunction);
 
+	/// Execute function(threadIndex, index) for every index in [begin, end).
+	/// the range is split in chunks of grain items, each thread start consuming
+	/// its own share of chunks and when it runs out it steals half of the remaining
+	/// chunks from a busy thread, so that a few expensive items do not stall the others.
+	/// a ParallelFor issued from inside a job of this pool runs inline on the calling thread.
+	template <typename Function>
+	void ParallelFor(ndInt32 begin, ndInt32 end, ndInt32 grain, const Function& function);
+
+	/// pool whose job the calling thread is executing, nullptr outside of any job.
+	D_CORE_API static ndThreadPool* GetCurrentThreadPool();
+
+	/// index of the calling thread in the pool returned by GetCurrentThreadPool, zero outside of any job.
+	D_CORE_API static ndInt32 GetCurrentThreadIndex();
+
+	/// microseconds thread threadIndex spent executing jobs since the last ResetBusyTime.
+	D_CORE_API ndUnsigned64 GetBusyTime(ndInt32 threadIndex) const;
+	D_CORE_API void ResetBusyTime();
+
 	private:
+	class ndWorkRange
+	{
+		public:
+		ndWorkRange()
+			:m_range(0)
+		{
+		}
+
+		void Set(ndInt32 front, ndInt32 back)
+		{
+			m_range.store(Pack(front, back));
+		}
+
+		bool PopFront(ndInt32& chunk)
+		{
+			ndUnsigned64 range = m_range.load();
+			for (ndInt32 front = Front(range), back = Back(range); front < back; front = Front(range), back = Back(range))
+			{
+				if (m_range.compare_exchange_weak(range, Pack(front + 1, back)))
+				{
+					chunk = front;
+					return true;
+				}
+				range = m_range.load();
+			}
+			return false;
+		}
+
+		bool StealBack(ndInt32& start, ndInt32& count)
+		{
+			ndUnsigned64 range = m_range.load();
+			for (ndInt32 front = Front(range), back = Back(range); front < back; front = Front(range), back = Back(range))
+			{
+				const ndInt32 half = (back - front + 1) >> 1;
+				if (m_range.compare_exchange_weak(range, Pack(front, back - half)))
+				{
+					start = back - half;
+					count = half;
+					return true;
+				}
+				range = m_range.load();
+			}
+			return false;
+		}
+
+		private:
+		static ndUnsigned64 Pack(ndInt32 front, ndInt32 back)
+		{
+			return (ndUnsigned64(ndUnsigned32(back)) << 32) | ndUnsigned64(ndUnsigned32(front));
+		}
+
+		static ndInt32 Front(ndUnsigned64 range)
+		{
+			return ndInt32(range & 0xffffffff);
+		}
+
+		static ndInt32 Back(ndUnsigned64 range)
+		{
+			return ndInt32(range >> 32);
+		}
+
+		ndAtomic<ndUnsigned64> m_range;
+		char m_padding[D_WORKER_CACHE_LINE - sizeof(ndAtomic<ndUnsigned64>)];
+	};
+
 	D_CORE_API virtual void Release();
 	D_CORE_API virtual void WaitForWorkers();
+	D_CORE_API static void SetCurrentThread(ndThreadPool* const pool, ndInt32 threadIndex);
 
 	ndWorker* m_workers;
+	ndUnsigned64 m_busyTime;
 	ndInt32 m_count;
 	char m_baseName[32];
 };
@@ -197,11 +289,15 @@ void ndThreadPool::ParallelExecute(const Function& callback)
 	if (m_count > 0)
 	{
 		#ifdef	D_USE_THREAD_EMULATION
+		ndThreadPool* const callingPool = GetCurrentThreadPool();
+		const ndInt32 callingThreadIndex = GetCurrentThreadIndex();
 		for (ndInt32 i = 0; i < threadCount; ++i)
 		{
 			ndTaskImplement<Function>* const job = &jobsArray[i];
+			SetCurrentThread(this, i);
 			callback(job->m_threadIndex, job->m_threadCount);
 		}
+		SetCurrentThread(callingPool, callingThreadIndex);
 		#else
 		for (ndInt32 i = 0; i < m_count; ++i)
 		{
@@ -209,16 +305,98 @@ void ndThreadPool::ParallelExecute(const Function& callback)
 			m_workers[i].ExecuteTask(job);
 		}
 	
+		ndThreadPool* const callingPool = GetCurrentThreadPool();
+		const ndInt32 callingThreadIndex = GetCurrentThreadIndex();
+		SetCurrentThread(this, 0);
+		const ndUnsigned64 startTime = ndGetTimeInMicroseconds();
 		ndTaskImplement<Function>* const job = &jobsArray[0];
 		callback(job->m_threadIndex, job->m_threadCount);
+		m_busyTime += ndGetTimeInMicroseconds() - startTime;
+		SetCurrentThread(callingPool, callingThreadIndex);
 		WaitForWorkers();
 		#endif
 	}
 	else
 	{
+		// the caller may be a worker of another pool, so present it as thread zero of this one
+		ndThreadPool* const callingPool = GetCurrentThreadPool();
+		const ndInt32 callingThreadIndex = GetCurrentThreadIndex();
+		SetCurrentThread(this, 0);
+		const ndUnsigned64 startTime = ndGetTimeInMicroseconds();
 		ndTaskImplement<Function>* const job = &jobsArray[0];
 		callback(job->m_threadIndex, job->m_threadCount);
+		m_busyTime += ndGetTimeInMicroseconds() - startTime;
+		SetCurrentThread(callingPool, callingThreadIndex);
+	}
+}
+
+template <typename Function>
+void ndThreadPool::ParallelFor(ndInt32 begin, ndInt32 end, ndInt32 grain, const Function& function)
+{
+	if (begin >= end)
+	{
+		return;
+	}
+
+	grain = ndMax(grain, 1);
+	const ndInt32 chunksCount = (end - begin + grain - 1) / grain;
+	const bool nestedCall = (GetCurrentThreadPool() == this);
+	if (nestedCall || (chunksCount == 1) || !m_count)
+	{
+		// nested call, a single chunk or no workers, just do the work on the calling thread
+		ndThreadPool* const callingPool = GetCurrentThreadPool();
+		const ndInt32 callingThreadIndex = GetCurrentThreadIndex();
+		const ndInt32 threadIndex = nestedCall ? callingThreadIndex : 0;
+		SetCurrentThread(this, threadIndex);
+		for (ndInt32 i = begin; i < end; ++i)
+		{
+			function(threadIndex, i);
+		}
+		SetCurrentThread(callingPool, callingThreadIndex);
+		return;
 	}
+
+	const ndInt32 threadCount = GetThreadCount();
+	ndWorkRange* const ranges = ndAlloca(ndWorkRange, threadCount);
+	for (ndInt32 i = 0; i < threadCount; ++i)
+	{
+		const ndStartEnd startEnd(chunksCount, i, threadCount);
+		new (&ranges[i]) ndWorkRange();
+		ranges[i].Set(startEnd.m_start, startEnd.m_end);
+	}
+
+	auto ExecuteChunks = ndMakeObject::ndFunction([begin, end, grain, ranges, &function](ndInt32 threadIndex, ndInt32 threadCount)
+	{
+		D_TRACKTIME_NAMED(ParallelFor);
+		ndWorkRange& ownRange = ranges[threadIndex];
+		for (bool hasWork = true; hasWork; )
+		{
+			ndInt32 chunk;
+			while (ownRange.PopFront(chunk))
+			{
+				const ndInt32 start = begin + chunk * grain;
+				const ndInt32 stop = ndMin(start + grain, end);
+				for (ndInt32 i = start; i < stop; ++i)
+				{
+					function(threadIndex, i);
+				}
+			}
+
+			hasWork = false;
+			for (ndInt32 i = 1; (i < threadCount) && !hasWork; ++i)
+			{
+				ndInt32 start;
+				ndInt32 count;
+				ndWorkRange& victim = ranges[(threadIndex + i) % threadCount];
+				if (victim.StealBack(start, count))
+				{
+					ownRange.Set(start, start + count);
+					hasWork = true;
+				}
+			}
+		}
+	});
+	ParallelExecute(ExecuteChunks);
 }
 
 #endif
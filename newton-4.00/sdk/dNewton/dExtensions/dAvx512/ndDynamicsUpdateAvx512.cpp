@@ -0,0 +1,1046 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndDynamicsUpdateAvx512.h"
+
+// only the code below is compiled for avx512, the inline functions of the sdk 
+// headers keep the base instruction set, so whichever copy the linker keeps 
+// when it merges them with the rest of the engine is safe on any cpu.
+// msvc does not need a flag for the intrinsics.
+#if defined(__clang__)
+	#pragma clang attribute push (__attribute__((target("avx512f,avx512dq,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+	#pragma GCC push_options
+	#pragma GCC target("avx512f,avx512dq,fma")
+#endif
+
+#define D_AVX512_WORK_GROUP				16 
+#define D_AVX512_DEFAULT_BUFFER_SIZE	1024
+#define D_AVX512_ALIGNMENT				64
+
+// the plain forms of the gather, min, max and extract intrinsics start from an 
+// _mm512_undefined_* register that gcc reports as maybe uninitialized, 
+// so this file only uses the masked forms, which take an explicit source.
+#define D_AVX512_LOW_INDEX(x)	_mm512_maskz_extracti64x4_epi64(__mmask8(0xf), x, 0)
+#define D_AVX512_HIGH_INDEX(x)	_mm512_maskz_extracti64x4_epi64(__mmask8(0xf), x, 1)
+
+// nothing in this file can be static data built with avx512 instructions, 
+// since the library is loaded on cpus that never select this solver.
+D_MSV_NEWTON_ALIGN_32
+class ndAvx512Int
+{
+	public:
+	inline ndAvx512Int()
+	{
+	}
+
+	inline ndAvx512Int(const ndInt32 val)
+		:m_type(_mm512_set1_epi32(val))
+	{
+	}
+
+	inline ndAvx512Int(const __m512i type)
+		:m_type(type)
+	{
+	}
+
+	inline ndAvx512Int(const ndAvx512Int& copy)
+		:m_type(copy.m_type)
+	{
+	}
+
+	inline ndAvx512Int(const ndInt32* const baseAddr, const ndAvx512Int& index, __mmask16 mask)
+		:m_type(_mm512_mask_i32gather_epi32(_mm512_setzero_si512(), mask, index.m_type, baseAddr, 4))
+	{
+	}
+
+	inline ndInt32& operator[] (ndInt32 i)
+	{
+		ndAssert(i >= 0);
+		ndAssert(i < D_AVX512_WORK_GROUP);
+		return m_int[i];
+	}
+
+	inline ndAvx512Int& operator= (const ndAvx512Int& A)
+	{
+		m_type = A.m_type;
+		return *this;
+	}
+
+	inline ndAvx512Int operator+ (const ndAvx512Int& A) const
+	{
+		return _mm512_add_epi32(m_type, A.m_type);
+	}
+
+	inline ndAvx512Int operator* (const ndAvx512Int& A) const
+	{
+		return _mm512_mullo_epi32(m_type, A.m_type);
+	}
+
+	inline __mmask16 operator> (const ndAvx512Int& A) const
+	{
+		return _mm512_cmpgt_epi32_mask(m_type, A.m_type);
+	}
+
+	inline ndAvx512Int Select(const ndAvx512Int& data, __mmask16 mask) const
+	{
+		return _mm512_mask_blend_epi32(mask, m_type, data.m_type);
+	}
+
+	static inline ndAvx512Int Ordinals()
+	{
+		return _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+	}
+
+	union
+	{
+		__m512i m_type;
+		ndInt32 m_int[D_AVX512_WORK_GROUP];
+	};
+} D_GCC_NEWTON_ALIGN_32;
+
+#ifdef D_NEWTON_USE_DOUBLE
+	D_MSV_NEWTON_ALIGN_32
+	class ndAvx512Float
+	{
+		public:
+		inline ndAvx512Float()
+		{
+		}
+
+		inline ndAvx512Float(const ndFloat32 val)
+			:m_low(_mm512_set1_pd(val))
+			,m_high(_mm512_set1_pd(val))
+		{
+		}
+
+		inline ndAvx512Float(const __m512d low, const __m512d high)
+			:m_low(low)
+			,m_high(high)
+		{
+		}
+
+		inline ndAvx512Float(const ndAvx512Float& copy)
+			:m_low(copy.m_low)
+			,m_high(copy.m_high)
+		{
+		}
+
+		inline ndAvx512Float(const ndFloat32* const baseAddr, const ndAvx512Int& index)
+			:m_low(_mm512_mask_i32gather_pd(_mm512_setzero_pd(), __mmask8(0xff), D_AVX512_LOW_INDEX(index.m_type), baseAddr, 8))
+			,m_high(_mm512_mask_i32gather_pd(_mm512_setzero_pd(), __mmask8(0xff), D_AVX512_HIGH_INDEX(index.m_type), baseAddr, 8))
+		{
+		}
+
+		// the lanes outside the mask are not read and come out as zero
+		inline ndAvx512Float(const ndFloat32* const baseAddr, const ndAvx512Int& index, __mmask16 mask)
+			:m_low(_mm512_mask_i32gather_pd(_mm512_setzero_pd(), __mmask8(mask), D_AVX512_LOW_INDEX(index.m_type), baseAddr, 8))
+			,m_high(_mm512_mask_i32gather_pd(_mm512_setzero_pd(), __mmask8(mask >> 8), D_AVX512_HIGH_INDEX(index.m_type), baseAddr, 8))
+		{
+		}
+
+		inline void Scatter(ndFloat32* const baseAddr, const ndAvx512Int& index, __mmask16 mask) const
+		{
+			_mm512_mask_i32scatter_pd(baseAddr, __mmask8(mask), D_AVX512_LOW_INDEX(index.m_type), m_low, 8);
+			_mm512_mask_i32scatter_pd(baseAddr, __mmask8(mask >> 8), D_AVX512_HIGH_INDEX(index.m_type), m_high, 8);
+		}
+
+		inline ndFloat32& operator[] (ndInt32 i)
+		{
+			ndAssert(i >= 0);
+			ndAssert(i < D_AVX512_WORK_GROUP);
+			return m_float[i];
+		}
+
+		inline const ndFloat32& operator[] (ndInt32 i) const
+		{
+			ndAssert(i >= 0);
+			ndAssert(i < D_AVX512_WORK_GROUP);
+			return m_float[i];
+		}
+
+		inline ndAvx512Float& operator= (const ndAvx512Float& A)
+		{
+			m_low = A.m_low;
+			m_high = A.m_high;
+			return *this;
+		}
+
+		inline ndAvx512Float operator+ (const ndAvx512Float& A) const
+		{
+			return ndAvx512Float(_mm512_add_pd(m_low, A.m_low), _mm512_add_pd(m_high, A.m_high));
+		}
+
+		inline ndAvx512Float operator- (const ndAvx512Float& A) const
+		{
+			return ndAvx512Float(_mm512_sub_pd(m_low, A.m_low), _mm512_sub_pd(m_high, A.m_high));
+		}
+
+		inline ndAvx512Float operator* (const ndAvx512Float& A) const
+		{
+			return ndAvx512Float(_mm512_mul_pd(m_low, A.m_low), _mm512_mul_pd(m_high, A.m_high));
+		}
+
+		inline ndAvx512Float MulAdd(const ndAvx512Float& A, const ndAvx512Float& B) const
+		{
+			return ndAvx512Float(_mm512_fmadd_pd(A.m_low, B.m_low, m_low), _mm512_fmadd_pd(A.m_high, B.m_high, m_high));
+		}
+
+		inline ndAvx512Float MulSub(const ndAvx512Float& A, const ndAvx512Float& B) const
+		{
+			return ndAvx512Float(_mm512_fnmadd_pd(A.m_low, B.m_low, m_low), _mm512_fnmadd_pd(A.m_high, B.m_high, m_high));
+		}
+
+		inline __mmask16 operator> (const ndAvx512Float& A) const
+		{
+			const __mmask8 low(_mm512_cmp_pd_mask(m_low, A.m_low, _CMP_GT_OQ));
+			const __mmask8 high(_mm512_cmp_pd_mask(m_high, A.m_high, _CMP_GT_OQ));
+			return __mmask16(low | (high << 8));
+		}
+
+		inline __mmask16 operator< (const ndAvx512Float& A) const
+		{
+			const __mmask8 low(_mm512_cmp_pd_mask(m_low, A.m_low, _CMP_LT_OQ));
+			const __mmask8 high(_mm512_cmp_pd_mask(m_high, A.m_high, _CMP_LT_OQ));
+			return __mmask16(low | (high << 8));
+		}
+
+		inline ndAvx512Float Abs() const
+		{
+			return ndAvx512Float(_mm512_abs_pd(m_low), _mm512_abs_pd(m_high));
+		}
+
+		inline ndAvx512Float GetMin(const ndAvx512Float& A) const
+		{
+			return ndAvx512Float(_mm512_maskz_min_pd(__mmask8(0xff), m_low, A.m_low), _mm512_maskz_min_pd(__mmask8(0xff), m_high, A.m_high));
+		}
+
+		inline ndAvx512Float GetMax(const ndAvx512Float& A) const
+		{
+			return ndAvx512Float(_mm512_maskz_max_pd(__mmask8(0xff), m_low, A.m_low), _mm512_maskz_max_pd(__mmask8(0xff), m_high, A.m_high));
+		}
+
+		// zero the lanes outside the mask
+		inline ndAvx512Float Mask(__mmask16 mask) const
+		{
+			return ndAvx512Float(_mm512_maskz_mov_pd(__mmask8(mask), m_low), _mm512_maskz_mov_pd(__mmask8(mask >> 8), m_high));
+		}
+
+		inline ndAvx512Float Select(const ndAvx512Float& data, __mmask16 mask) const
+		{
+			return ndAvx512Float(_mm512_mask_blend_pd(__mmask8(mask), m_low, data.m_low), _mm512_mask_blend_pd(__mmask8(mask >> 8), m_high, data.m_high));
+		}
+
+		inline ndFloat32 GetMax() const
+		{
+			// reduce by halves
+			const __m512d max8(_mm512_maskz_max_pd(__mmask8(0xff), m_low, m_high));
+			const __m256d max4(_mm256_max_pd(_mm512_maskz_extractf64x4_pd(__mmask8(0xf), max8, 0), _mm512_maskz_extractf64x4_pd(__mmask8(0xf), max8, 1)));
+			const __m128d max2(_mm_max_pd(_mm256_castpd256_pd128(max4), _mm256_extractf128_pd(max4, 1)));
+			const __m128d max1(_mm_max_sd(max2, _mm_unpackhi_pd(max2, max2)));
+			return _mm_cvtsd_f64(max1);
+		}
+
+		union
+		{
+			struct
+			{
+				__m512d m_low;
+				__m512d m_high;
+			};
+			ndFloat32 m_float[D_AVX512_WORK_GROUP];
+		};
+	} D_GCC_NEWTON_ALIGN_32;
+
+#else
+	D_MSV_NEWTON_ALIGN_32
+	class ndAvx512Float
+	{
+		public:
+		inline ndAvx512Float()
+		{
+		}
+
+		inline ndAvx512Float(const ndFloat32 val)
+			:m_type(_mm512_set1_ps(val))
+		{
+		}
+
+		inline ndAvx512Float(const __m512 type)
+			:m_type(type)
+		{
+		}
+
+		inline ndAvx512Float(const ndAvx512Float& copy)
+			:m_type(copy.m_type)
+		{
+		}
+
+		inline ndAvx512Float(const ndFloat32* const baseAddr, const ndAvx512Int& index)
+			:m_type(_mm512_mask_i32gather_ps(_mm512_setzero_ps(), __mmask16(0xffff), index.m_type, baseAddr, 4))
+		{
+		}
+
+		// the lanes outside the mask are not read and come out as zero
+		inline ndAvx512Float(const ndFloat32* const baseAddr, const ndAvx512Int& index, __mmask16 mask)
+			:m_type(_mm512_mask_i32gather_ps(_mm512_setzero_ps(), mask, index.m_type, baseAddr, 4))
+		{
+		}
+
+		inline void Scatter(ndFloat32* const baseAddr, const ndAvx512Int& index, __mmask16 mask) const
+		{
+			_mm512_mask_i32scatter_ps(baseAddr, mask, index.m_type, m_type, 4);
+		}
+
+		inline ndFloat32& operator[] (ndInt32 i)
+		{
+			ndAssert(i >= 0);
+			ndAssert(i < D_AVX512_WORK_GROUP);
+			return m_float[i];
+		}
+
+		inline const ndFloat32& operator[] (ndInt32 i) const
+		{
+			ndAssert(i >= 0);
+			ndAssert(i < D_AVX512_WORK_GROUP);
+			return m_float[i];
+		}
+
+		inline ndAvx512Float& operator= (const ndAvx512Float& A)
+		{
+			m_type = A.m_type;
+			return *this;
+		}
+
+		inline ndAvx512Float operator+ (const ndAvx512Float& A) const
+		{
+			return _mm512_add_ps(m_type, A.m_type);
+		}
+
+		inline ndAvx512Float operator- (const ndAvx512Float& A) const
+		{
+			return _mm512_sub_ps(m_type, A.m_type);
+		}
+
+		inline ndAvx512Float operator* (const ndAvx512Float& A) const
+		{
+			return _mm512_mul_ps(m_type, A.m_type);
+		}
+
+		inline ndAvx512Float MulAdd(const ndAvx512Float& A, const ndAvx512Float& B) const
+		{
+			return _mm512_fmadd_ps(A.m_type, B.m_type, m_type);
+		}
+
+		inline ndAvx512Float MulSub(const ndAvx512Float& A, const ndAvx512Float& B) const
+		{
+			return _mm512_fnmadd_ps(A.m_type, B.m_type, m_type);
+		}
+
+		inline __mmask16 operator> (const ndAvx512Float& A) const
+		{
+			return _mm512_cmp_ps_mask(m_type, A.m_type, _CMP_GT_OQ);
+		}
+
+		inline __mmask16 operator< (const ndAvx512Float& A) const
+		{
+			return _mm512_cmp_ps_mask(m_type, A.m_type, _CMP_LT_OQ);
+		}
+
+		inline ndAvx512Float Abs() const
+		{
+			return _mm512_abs_ps(m_type);
+		}
+
+		inline ndAvx512Float GetMin(const ndAvx512Float& A) const
+		{
+			return _mm512_maskz_min_ps(__mmask16(0xffff), m_type, A.m_type);
+		}
+
+		inline ndAvx512Float GetMax(const ndAvx512Float& A) const
+		{
+			return _mm512_maskz_max_ps(__mmask16(0xffff), m_type, A.m_type);
+		}
+
+		// zero the lanes outside the mask
+		inline ndAvx512Float Mask(__mmask16 mask) const
+		{
+			return _mm512_maskz_mov_ps(mask, m_type);
+		}
+
+		inline ndAvx512Float Select(const ndAvx512Float& data, __mmask16 mask) const
+		{
+			return _mm512_mask_blend_ps(mask, m_type, data.m_type);
+		}
+
+		inline ndFloat32 GetMax() const
+		{
+			// reduce by halves
+			const __m256 max8(_mm256_max_ps(_mm512_extractf32x8_ps(m_type, 0), _mm512_extractf32x8_ps(m_type, 1)));
+			const __m128 max4(_mm_max_ps(_mm256_castps256_ps128(max8), _mm256_extractf128_ps(max8, 1)));
+			const __m128 max2(_mm_max_ps(max4, _mm_movehl_ps(max4, max4)));
+			const __m128 max1(_mm_max_ss(max2, _mm_shuffle_ps(max2, max2, 0x55)));
+			return _mm_cvtss_f32(max1);
+		}
+
+		union
+		{
+			__m512 m_type;
+			ndFloat32 m_float[D_AVX512_WORK_GROUP];
+		};
+	} D_GCC_NEWTON_ALIGN_32;
+#endif
+
+D_MSV_NEWTON_ALIGN_32
+class ndAvx512Vector3
+{
+	public:
+	ndAvx512Float m_x;
+	ndAvx512Float m_y;
+	ndAvx512Float m_z;
+} D_GCC_NEWTON_ALIGN_32;
+
+D_MSV_NEWTON_ALIGN_32
+class ndAvx512Vector6
+{
+	public:
+	ndAvx512Vector3 m_linear;
+	ndAvx512Vector3 m_angular;
+} D_GCC_NEWTON_ALIGN_32;
+
+D_MSV_NEWTON_ALIGN_32
+class ndAvx512JacobianPair
+{
+	public:
+	ndAvx512Vector6 m_jacobianM0;
+	ndAvx512Vector6 m_jacobianM1;
+} D_GCC_NEWTON_ALIGN_32;
+
+D_MSV_NEWTON_ALIGN_32
+class ndAvx512MatrixElement
+{
+	public:
+	ndAvx512JacobianPair m_Jt;
+	ndAvx512JacobianPair m_JMinv;
+
+	ndAvx512Float m_force;
+	ndAvx512Float m_diagDamp;
+	ndAvx512Float m_invJinvMJt;
+	ndAvx512Float m_coordenateAccel;
+	ndAvx512Float m_lowerBoundFrictionCoefficent;
+	ndAvx512Float m_upperBoundFrictionCoefficent;
+	ndAvx512Int m_normalForceIndex;
+} D_GCC_NEWTON_ALIGN_32;
+
+// the lanes of a group are joints, the offsets index the scalar arrays of the base solver
+D_MSV_NEWTON_ALIGN_32
+class ndAvx512JointGroup
+{
+	public:
+	ndAvx512Int m_rowStart;
+	ndAvx512Int m_rowCount;
+	ndAvx512Int m_body0Offset;
+	ndAvx512Int m_body1Offset;
+	ndAvx512Int m_jointOffset;
+	ndAvx512Float m_weigh0;
+	ndAvx512Float m_weigh1;
+	ndInt32 m_maxRowCount;
+	__mmask16 m_laneMask;
+} D_GCC_NEWTON_ALIGN_32;
+
+// the sdk heap is only aligned to D_MEMORY_ALIGMNET, so the arrays of 
+// __m512 data over allocate and align the buffer themselves.
+template <class T>
+class ndAvx512Array: public ndClassAlloc
+{
+	public:
+	ndAvx512Array()
+		:ndClassAlloc()
+		,m_array(nullptr)
+		,m_memory(nullptr)
+		,m_count(0)
+		,m_capacity(0)
+	{
+	}
+
+	~ndAvx512Array()
+	{
+		if (m_memory)
+		{
+			ndMemory::Free(m_memory);
+		}
+	}
+
+	ndInt32 GetCount() const
+	{
+		return m_count;
+	}
+
+	// the content is not preserved when the buffer grows
+	void SetCount(ndInt32 count)
+	{
+		if (count > m_capacity)
+		{
+			if (m_memory)
+			{
+				ndMemory::Free(m_memory);
+			}
+			m_capacity = ndMax(count, m_capacity * 2);
+			m_memory = ndMemory::Malloc(size_t(m_capacity) * sizeof(T) + D_AVX512_ALIGNMENT);
+			m_array = (T*)((size_t(m_memory) + D_AVX512_ALIGNMENT - 1) & ~size_t(D_AVX512_ALIGNMENT - 1));
+		}
+		m_count = count;
+	}
+
+	T& operator[] (ndInt32 i)
+	{
+		ndAssert(i >= 0);
+		ndAssert(i < m_count);
+		return m_array[i];
+	}
+
+	const T& operator[] (ndInt32 i) const
+	{
+		ndAssert(i >= 0);
+		ndAssert(i < m_count);
+		return m_array[i];
+	}
+
+	private:
+	T* m_array;
+	void* m_memory;
+	ndInt32 m_count;
+	ndInt32 m_capacity;
+};
+
+class ndAvx512MatrixArray : public ndAvx512Array<ndAvx512MatrixElement>
+{
+};
+
+class ndAvx512JointGroupArray : public ndAvx512Array<ndAvx512JointGroup>
+{
+};
+
+ndDynamicsUpdateAvx512::ndDynamicsUpdateAvx512(ndWorld* const world)
+	:ndDynamicsUpdate(world)
+	,m_groupRowStart(D_AVX512_DEFAULT_BUFFER_SIZE)
+	,m_jointGroups(new ndAvx512JointGroupArray)
+	,m_massMatrix(new ndAvx512MatrixArray)
+{
+}
+
+ndDynamicsUpdateAvx512::~ndDynamicsUpdateAvx512()
+{
+	Clear();
+	m_groupRowStart.Resize(D_AVX512_DEFAULT_BUFFER_SIZE);
+	delete m_jointGroups;
+	delete m_massMatrix;
+}
+
+const char* ndDynamicsUpdateAvx512::GetStringId() const
+{
+	return "avx512";
+}
+
+void ndDynamicsUpdateAvx512::BuildMassMatrix()
+{
+	D_TRACKTIME();
+	ndScene* const scene = m_world->GetScene();
+	const ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
+	const ndInt32 jointCount = ndInt32(jointArray.GetCount());
+	const ndInt32 groupCount = (jointCount + D_AVX512_WORK_GROUP - 1) / D_AVX512_WORK_GROUP;
+
+	// the joints are sorted by rows count, but the group at the boundary 
+	// between the moving and the resting joints may not be.
+	ndInt32 rowCount = 0;
+	m_groupRowStart.SetCount(groupCount + 1);
+	for (ndInt32 i = 0; i < groupCount; ++i)
+	{
+		ndInt32 maxRow = 0;
+		const ndInt32 base = i * D_AVX512_WORK_GROUP;
+		const ndInt32 lanes = ndMin(jointCount - base, ndInt32(D_AVX512_WORK_GROUP));
+		for (ndInt32 j = 0; j < lanes; ++j)
+		{
+			maxRow = ndMax(maxRow, jointArray[base + j]->m_rowCount);
+		}
+		m_groupRowStart[i] = rowCount;
+		rowCount += maxRow;
+	}
+	m_groupRowStart[groupCount] = rowCount;
+	m_jointGroups->SetCount(groupCount);
+	m_massMatrix->SetCount(rowCount);
+
+	ndAtomic<ndInt32> iterator(0);
+	auto BuildMassMatrix = ndMakeObject::ndFunction([this, &iterator, &jointArray, jointCount, groupCount](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(BuildMassMatrix);
+		const ndLeftHandSide* const leftHandSide = &m_leftHandSide[0];
+		const ndRightHandSide* const rightHandSide = &m_rightHandSide[0];
+		const ndFloat32* const lhs = &leftHandSide->m_Jt.m_jacobianM0.m_linear.m_x;
+		const ndFloat32* const rhs = &rightHandSide->m_force;
+		const ndInt32* const rhsInt = (ndInt32*)rhs;
+
+		// the rows are gathered straight from the scalar arrays, in units of the element they read.
+		const ndAvx512Int lhsStride(ndInt32(sizeof(ndLeftHandSide) / sizeof(ndFloat32)));
+		const ndAvx512Int rhsStride(ndInt32(sizeof(ndRightHandSide) / sizeof(ndFloat32)));
+		const ndAvx512Int rhsIntStride(ndInt32(sizeof(ndRightHandSide) / sizeof(ndInt32)));
+		const ndInt32 diagDampOffset = ndInt32(&rightHandSide->m_diagDamp - rhs);
+		const ndInt32 invJinvMJtOffset = ndInt32(&rightHandSide->m_invJinvMJt - rhs);
+		const ndInt32 coordenateAccelOffset = ndInt32(&rightHandSide->m_coordenateAccel - rhs);
+		const ndInt32 lowerBoundOffset = ndInt32(&rightHandSide->m_lowerBoundFrictionCoefficent - rhs);
+		const ndInt32 upperBoundOffset = ndInt32(&rightHandSide->m_upperBoundFrictionCoefficent - rhs);
+		const ndInt32 normalIndexOffset = ndInt32(&rightHandSide->m_normalForceIndex - rhsInt);
+
+		const ndAvx512Int one(1);
+		const ndAvx512Int zero(0);
+		const ndAvx512Int workGroup(D_AVX512_WORK_GROUP);
+		const ndAvx512Int ordinals(ndAvx512Int::Ordinals());
+		ndAvx512JointGroup* const jointGroups = &(*m_jointGroups)[0];
+		ndAvx512MatrixElement* const massMatrix = &(*m_massMatrix)[0];
+
+		for (ndInt32 i = iterator.fetch_add(D_WORKER_BATCH_SIZE); i < groupCount; i = iterator.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((groupCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : groupCount - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				const ndInt32 m = i + j;
+				const ndInt32 base = m * D_AVX512_WORK_GROUP;
+				const ndInt32 lanes = ndMin(jointCount - base, ndInt32(D_AVX512_WORK_GROUP));
+
+				ndAvx512JointGroup& group = jointGroups[m];
+				group.m_rowStart = zero;
+				group.m_rowCount = zero;
+				group.m_body0Offset = zero;
+				group.m_body1Offset = zero;
+				group.m_weigh0 = ndAvx512Float(ndFloat32(0.0f));
+				group.m_weigh1 = ndAvx512Float(ndFloat32(0.0f));
+				group.m_jointOffset = (ndAvx512Int(base) + ordinals) * ndAvx512Int(2 * ndInt32(sizeof(ndJacobian) / sizeof(ndFloat32)));
+				group.m_laneMask = __mmask16((1 << lanes) - 1);
+				group.m_maxRowCount = m_groupRowStart[m + 1] - m_groupRowStart[m];
+				for (ndInt32 k = 0; k < lanes; ++k)
+				{
+					const ndConstraint* const joint = jointArray[base + k];
+					const ndBodyKinematic* const body0 = joint->GetBody0();
+					const ndBodyKinematic* const body1 = joint->GetBody1();
+					group.m_rowStart[k] = joint->m_rowStart;
+					group.m_rowCount[k] = joint->m_rowCount;
+					group.m_body0Offset[k] = body0->m_index * ndInt32(sizeof(ndJacobian) / sizeof(ndFloat32));
+					group.m_body1Offset[k] = body1->m_index * ndInt32(sizeof(ndJacobian) / sizeof(ndFloat32));
+					group.m_weigh0[k] = body0->m_weigh;
+					group.m_weigh1[k] = body1->m_weigh;
+				}
+
+				ndAvx512MatrixElement* const rows = &massMatrix[m_groupRowStart[m]];
+				for (ndInt32 k = 0; k < group.m_maxRowCount; ++k)
+				{
+					const ndAvx512Int row(k);
+					const __mmask16 rowMask = group.m_laneMask & (group.m_rowCount > row);
+					const ndAvx512Int lhsIndex((group.m_rowStart + row) * lhsStride);
+					const ndAvx512Int rhsIndex((group.m_rowStart + row) * rhsStride);
+					const ndAvx512Int rhsIntIndex((group.m_rowStart + row) * rhsIntStride);
+
+					ndAvx512MatrixElement& dst = rows[k];
+					ndAvx512JacobianPair* const pairs = &dst.m_Jt;
+					for (ndInt32 n = 0; n < 2; ++n)
+					{
+						// the Jt and the JMinv pairs are laid out one after the other in both layouts
+						ndAvx512JacobianPair& pair = pairs[n];
+						const ndInt32 pairOffset = n * 16;
+						pair.m_jacobianM0.m_linear.m_x = ndAvx512Float(lhs + pairOffset + 0, lhsIndex, rowMask);
+						pair.m_jacobianM0.m_linear.m_y = ndAvx512Float(lhs + pairOffset + 1, lhsIndex, rowMask);
+						pair.m_jacobianM0.m_linear.m_z = ndAvx512Float(lhs + pairOffset + 2, lhsIndex, rowMask);
+						pair.m_jacobianM0.m_angular.m_x = ndAvx512Float(lhs + pairOffset + 4, lhsIndex, rowMask);
+						pair.m_jacobianM0.m_angular.m_y = ndAvx512Float(lhs + pairOffset + 5, lhsIndex, rowMask);
+						pair.m_jacobianM0.m_angular.m_z = ndAvx512Float(lhs + pairOffset + 6, lhsIndex, rowMask);
+						pair.m_jacobianM1.m_linear.m_x = ndAvx512Float(lhs + pairOffset + 8, lhsIndex, rowMask);
+						pair.m_jacobianM1.m_linear.m_y = ndAvx512Float(lhs + pairOffset + 9, lhsIndex, rowMask);
+						pair.m_jacobianM1.m_linear.m_z = ndAvx512Float(lhs + pairOffset + 10, lhsIndex, rowMask);
+						pair.m_jacobianM1.m_angular.m_x = ndAvx512Float(lhs + pairOffset + 12, lhsIndex, rowMask);
+						pair.m_jacobianM1.m_angular.m_y = ndAvx512Float(lhs + pairOffset + 13, lhsIndex, rowMask);
+						pair.m_jacobianM1.m_angular.m_z = ndAvx512Float(lhs + pairOffset + 14, lhsIndex, rowMask);
+					}
+
+					// a masked lane has zero bounds and zero jacobian, so its force stays zero.
+					dst.m_force = ndAvx512Float(rhs, rhsIndex, rowMask);
+					dst.m_diagDamp = ndAvx512Float(rhs + diagDampOffset, rhsIndex, rowMask);
+					dst.m_invJinvMJt = ndAvx512Float(rhs + invJinvMJtOffset, rhsIndex, rowMask);
+					dst.m_coordenateAccel = ndAvx512Float(rhs + coordenateAccelOffset, rhsIndex, rowMask);
+					dst.m_lowerBoundFrictionCoefficent = ndAvx512Float(rhs + lowerBoundOffset, rhsIndex, rowMask);
+					dst.m_upperBoundFrictionCoefficent = ndAvx512Float(rhs + upperBoundOffset, rhsIndex, rowMask);
+
+					const ndAvx512Int normalIndex(rhsInt + normalIndexOffset, rhsIntIndex, rowMask);
+					dst.m_normalForceIndex = ordinals.Select((normalIndex + one) * workGroup + ordinals, rowMask);
+				}
+			}
+		}
+	});
+
+	if (groupCount)
+	{
+		scene->ParallelExecute(BuildMassMatrix);
+	}
+}
+
+void ndDynamicsUpdateAvx512::CalculateJointsForce()
+{
+	D_TRACKTIME();
+	const ndUnsigned32 passes = m_solverPasses;
+	ndScene* const scene = m_world->GetScene();
+
+	ndArray<ndBodyKinematic*>& bodyArray = scene->GetActiveBodyArray();
+	ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
+	const ndInt32 groupCount = ndInt32(m_jointGroups->GetCount());
+
+	ndAtomic<ndInt32> iterator(0);
+	auto UpdateAcceleration = ndMakeObject::ndFunction([this, &iterator, groupCount](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(UpdateAcceleration);
+		const ndRightHandSide* const rightHandSide = &m_rightHandSide[0];
+		const ndFloat32* const coordenateAccel = &rightHandSide->m_coordenateAccel;
+		const ndAvx512Int rhsStride(ndInt32(sizeof(ndRightHandSide) / sizeof(ndFloat32)));
+		const ndAvx512JointGroup* const jointGroups = &(*m_jointGroups)[0];
+		ndAvx512MatrixElement* const massMatrix = &(*m_massMatrix)[0];
+
+		for (ndInt32 i = iterator.fetch_add(D_WORKER_BATCH_SIZE); i < groupCount; i = iterator.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((groupCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : groupCount - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				const ndInt32 m = i + j;
+				const ndAvx512JointGroup& group = jointGroups[m];
+				ndAvx512MatrixElement* const rows = &massMatrix[m_groupRowStart[m]];
+				for (ndInt32 k = 0; k < group.m_maxRowCount; ++k)
+				{
+					const ndAvx512Int row(k);
+					const __mmask16 rowMask = group.m_laneMask & (group.m_rowCount > row);
+					rows[k].m_coordenateAccel = ndAvx512Float(coordenateAccel, (group.m_rowStart + row) * rhsStride, rowMask);
+				}
+			}
+		}
+	});
+
+	ndAtomic<ndInt32> iterator0(0);
+	auto CalculateJointsForce = ndMakeObject::ndFunction([this, &iterator0, &jointArray, groupCount](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(CalculateJointsForce);
+		ndFloat32* const jointPartialForces = &GetTempInternalForces()[0].m_linear.m_x;
+		const ndFloat32* const internalForces = &GetInternalForces()[0].m_linear.m_x;
+		const ndAvx512JointGroup* const jointGroups = &(*m_jointGroups)[0];
+		ndAvx512MatrixElement* const massMatrix = &(*m_massMatrix)[0];
+
+		auto JointForce = [this, &jointArray, jointPartialForces, internalForces](ndInt32 groupIndex, const ndAvx512JointGroup& group, ndAvx512MatrixElement* const rows)
+		{
+			ndAvx512Vector6 forceM0;
+			ndAvx512Vector6 forceM1;
+			ndAvx512Float normalForce[D_CONSTRAINT_MAX_ROWS + 1];
+
+			const ndAvx512Float zero(ndFloat32(0.0f));
+			const __mmask16 laneMask = group.m_laneMask;
+			const ndAvx512Float preconditioner0(group.m_weigh0);
+			const ndAvx512Float preconditioner1(group.m_weigh1);
+
+			forceM0.m_linear.m_x = ndAvx512Float(internalForces + 0, group.m_body0Offset, laneMask);
+			forceM0.m_linear.m_y = ndAvx512Float(internalForces + 1, group.m_body0Offset, laneMask);
+			forceM0.m_linear.m_z = ndAvx512Float(internalForces + 2, group.m_body0Offset, laneMask);
+			forceM0.m_angular.m_x = ndAvx512Float(internalForces + 4, group.m_body0Offset, laneMask);
+			forceM0.m_angular.m_y = ndAvx512Float(internalForces + 5, group.m_body0Offset, laneMask);
+			forceM0.m_angular.m_z = ndAvx512Float(internalForces + 6, group.m_body0Offset, laneMask);
+
+			forceM1.m_linear.m_x = ndAvx512Float(internalForces + 0, group.m_body1Offset, laneMask);
+			forceM1.m_linear.m_y = ndAvx512Float(internalForces + 1, group.m_body1Offset, laneMask);
+			forceM1.m_linear.m_z = ndAvx512Float(internalForces + 2, group.m_body1Offset, laneMask);
+			forceM1.m_angular.m_x = ndAvx512Float(internalForces + 4, group.m_body1Offset, laneMask);
+			forceM1.m_angular.m_y = ndAvx512Float(internalForces + 5, group.m_body1Offset, laneMask);
+			forceM1.m_angular.m_z = ndAvx512Float(internalForces + 6, group.m_body1Offset, laneMask);
+
+			const ndInt32 rowsCount = group.m_maxRowCount;
+			normalForce[0] = ndAvx512Float(ndFloat32(1.0f));
+			for (ndInt32 j = 0; j < rowsCount; ++j)
+			{
+				normalForce[j + 1] = rows[j].m_force;
+			}
+
+			auto SolveRows = [rows, rowsCount, &normalForce, &forceM0, &forceM1, &preconditioner0, &preconditioner1, &zero]()
+			{
+				ndAvx512Float accNorm(zero);
+				for (ndInt32 j = 0; j < rowsCount; ++j)
+				{
+					const ndAvx512MatrixElement* const row = &rows[j];
+
+					ndAvx512Float a0(row->m_JMinv.m_jacobianM0.m_linear.m_x * forceM0.m_linear.m_x);
+					ndAvx512Float a1(row->m_JMinv.m_jacobianM1.m_linear.m_x * forceM1.m_linear.m_x);
+					a0 = a0.MulAdd(row->m_JMinv.m_jacobianM0.m_angular.m_x, forceM0.m_angular.m_x);
+					a1 = a1.MulAdd(row->m_JMinv.m_jacobianM1.m_angular.m_x, forceM1.m_angular.m_x);
+
+					a0 = a0.MulAdd(row->m_JMinv.m_jacobianM0.m_linear.m_y, forceM0.m_linear.m_y);
+					a1 = a1.MulAdd(row->m_JMinv.m_jacobianM1.m_linear.m_y, forceM1.m_linear.m_y);
+					a0 = a0.MulAdd(row->m_JMinv.m_jacobianM0.m_angular.m_y, forceM0.m_angular.m_y);
+					a1 = a1.MulAdd(row->m_JMinv.m_jacobianM1.m_angular.m_y, forceM1.m_angular.m_y);
+
+					a0 = a0.MulAdd(row->m_JMinv.m_jacobianM0.m_linear.m_z, forceM0.m_linear.m_z);
+					a1 = a1.MulAdd(row->m_JMinv.m_jacobianM1.m_linear.m_z, forceM1.m_linear.m_z);
+					a0 = a0.MulAdd(row->m_JMinv.m_jacobianM0.m_angular.m_z, forceM0.m_angular.m_z);
+					a1 = a1.MulAdd(row->m_JMinv.m_jacobianM1.m_angular.m_z, forceM1.m_angular.m_z);
+
+					ndAvx512Float a(a0 + a1);
+					const ndAvx512Float force(normalForce[j + 1]);
+					a = row->m_coordenateAccel.MulSub(force, row->m_diagDamp) - a;
+					ndAvx512Float f(force.MulAdd(row->m_invJinvMJt, a));
+
+					const ndAvx512Float frictionNormal(&normalForce[0][0], row->m_normalForceIndex);
+					const ndAvx512Float lowerFrictionForce(frictionNormal * row->m_lowerBoundFrictionCoefficent);
+					const ndAvx512Float upperFrictionForce(frictionNormal * row->m_upperBoundFrictionCoefficent);
+
+					a = a.Mask((f < upperFrictionForce) & (f > lowerFrictionForce));
+					accNorm = accNorm.MulAdd(a, a);
+
+					f = f.GetMax(lowerFrictionForce).GetMin(upperFrictionForce);
+					normalForce[j + 1] = f;
+
+					const ndAvx512Float deltaForce(f - force);
+					const ndAvx512Float deltaForce0(deltaForce * preconditioner0);
+					const ndAvx512Float deltaForce1(deltaForce * preconditioner1);
+					forceM0.m_linear.m_x = forceM0.m_linear.m_x.MulAdd(row->m_Jt.m_jacobianM0.m_linear.m_x, deltaForce0);
+					forceM0.m_linear.m_y = forceM0.m_linear.m_y.MulAdd(row->m_Jt.m_jacobianM0.m_linear.m_y, deltaForce0);
+					forceM0.m_linear.m_z = forceM0.m_linear.m_z.MulAdd(row->m_Jt.m_jacobianM0.m_linear.m_z, deltaForce0);
+					forceM0.m_angular.m_x = forceM0.m_angular.m_x.MulAdd(row->m_Jt.m_jacobianM0.m_angular.m_x, deltaForce0);
+					forceM0.m_angular.m_y = forceM0.m_angular.m_y.MulAdd(row->m_Jt.m_jacobianM0.m_angular.m_y, deltaForce0);
+					forceM0.m_angular.m_z = forceM0.m_angular.m_z.MulAdd(row->m_Jt.m_jacobianM0.m_angular.m_z, deltaForce0);
+
+					forceM1.m_linear.m_x = forceM1.m_linear.m_x.MulAdd(row->m_Jt.m_jacobianM1.m_linear.m_x, deltaForce1);
+					forceM1.m_linear.m_y = forceM1.m_linear.m_y.MulAdd(row->m_Jt.m_jacobianM1.m_linear.m_y, deltaForce1);
+					forceM1.m_linear.m_z = forceM1.m_linear.m_z.MulAdd(row->m_Jt.m_jacobianM1.m_linear.m_z, deltaForce1);
+					forceM1.m_angular.m_x = forceM1.m_angular.m_x.MulAdd(row->m_Jt.m_jacobianM1.m_angular.m_x, deltaForce1);
+					forceM1.m_angular.m_y = forceM1.m_angular.m_y.MulAdd(row->m_Jt.m_jacobianM1.m_angular.m_y, deltaForce1);
+					forceM1.m_angular.m_z = forceM1.m_angular.m_z.MulAdd(row->m_Jt.m_jacobianM1.m_angular.m_z, deltaForce1);
+				}
+				return accNorm;
+			};
+
+			const ndFloat32 tol = ndFloat32(0.125f);
+			const ndFloat32 tol2 = tol * tol;
+			ndAvx512Float maxAccel(SolveRows());
+			for (ndInt32 k = 0; (k < 4) && (maxAccel.GetMax() > tol2); ++k)
+			{
+				maxAccel = SolveRows();
+			}
+
+			// the joints between two resting bodies keep the force of the last pass
+			__mmask16 activeMask = laneMask;
+			const ndInt32 block = groupIndex * D_AVX512_WORK_GROUP;
+			for (ndInt32 i = 0; i < D_AVX512_WORK_GROUP; ++i)
+			{
+				if (laneMask & (1 << i))
+				{
+					const ndConstraint* const joint = jointArray[block + i];
+					const ndBodyKinematic* const body0 = joint->GetBody0();
+					const ndBodyKinematic* const body1 = joint->GetBody1();
+					ndAssert(body0);
+					ndAssert(body1);
+					if (body0->m_equilibrium0 & body1->m_equilibrium0)
+					{
+						activeMask = __mmask16(activeMask & ~(1 << i));
+					}
+				}
+			}
+
+			forceM0.m_linear.m_x = zero;
+			forceM0.m_linear.m_y = zero;
+			forceM0.m_linear.m_z = zero;
+			forceM0.m_angular.m_x = zero;
+			forceM0.m_angular.m_y = zero;
+			forceM0.m_angular.m_z = zero;
+
+			forceM1.m_linear.m_x = zero;
+			forceM1.m_linear.m_y = zero;
+			forceM1.m_linear.m_z = zero;
+			forceM1.m_angular.m_x = zero;
+			forceM1.m_angular.m_y = zero;
+			forceM1.m_angular.m_z = zero;
+			for (ndInt32 i = 0; i < rowsCount; ++i)
+			{
+				ndAvx512MatrixElement* const row = &rows[i];
+				const ndAvx512Float force(row->m_force.Select(normalForce[i + 1], activeMask));
+				row->m_force = force;
+
+				forceM0.m_linear.m_x = forceM0.m_linear.m_x.MulAdd(row->m_Jt.m_jacobianM0.m_linear.m_x, force);
+				forceM0.m_linear.m_y = forceM0.m_linear.m_y.MulAdd(row->m_Jt.m_jacobianM0.m_linear.m_y, force);
+				forceM0.m_linear.m_z = forceM0.m_linear.m_z.MulAdd(row->m_Jt.m_jacobianM0.m_linear.m_z, force);
+				forceM0.m_angular.m_x = forceM0.m_angular.m_x.MulAdd(row->m_Jt.m_jacobianM0.m_angular.m_x, force);
+				forceM0.m_angular.m_y = forceM0.m_angular.m_y.MulAdd(row->m_Jt.m_jacobianM0.m_angular.m_y, force);
+				forceM0.m_angular.m_z = forceM0.m_angular.m_z.MulAdd(row->m_Jt.m_jacobianM0.m_angular.m_z, force);
+
+				forceM1.m_linear.m_x = forceM1.m_linear.m_x.MulAdd(row->m_Jt.m_jacobianM1.m_linear.m_x, force);
+				forceM1.m_linear.m_y = forceM1.m_linear.m_y.MulAdd(row->m_Jt.m_jacobianM1.m_linear.m_y, force);
+				forceM1.m_linear.m_z = forceM1.m_linear.m_z.MulAdd(row->m_Jt.m_jacobianM1.m_linear.m_z, force);
+				forceM1.m_angular.m_x = forceM1.m_angular.m_x.MulAdd(row->m_Jt.m_jacobianM1.m_angular.m_x, force);
+				forceM1.m_angular.m_y = forceM1.m_angular.m_y.MulAdd(row->m_Jt.m_jacobianM1.m_angular.m_y, force);
+				forceM1.m_angular.m_z = forceM1.m_angular.m_z.MulAdd(row->m_Jt.m_jacobianM1.m_angular.m_z, force);
+			}
+
+			// the w components of the partial forces were cleared by the jacobian pass and never change.
+			const ndInt32 body1Offset = ndInt32(sizeof(ndJacobian) / sizeof(ndFloat32));
+			forceM0.m_linear.m_x.Scatter(jointPartialForces + 0, group.m_jointOffset, laneMask);
+			forceM0.m_linear.m_y.Scatter(jointPartialForces + 1, group.m_jointOffset, laneMask);
+			forceM0.m_linear.m_z.Scatter(jointPartialForces + 2, group.m_jointOffset, laneMask);
+			forceM0.m_angular.m_x.Scatter(jointPartialForces + 4, group.m_jointOffset, laneMask);
+			forceM0.m_angular.m_y.Scatter(jointPartialForces + 5, group.m_jointOffset, laneMask);
+			forceM0.m_angular.m_z.Scatter(jointPartialForces + 6, group.m_jointOffset, laneMask);
+
+			forceM1.m_linear.m_x.Scatter(jointPartialForces + body1Offset + 0, group.m_jointOffset, laneMask);
+			forceM1.m_linear.m_y.Scatter(jointPartialForces + body1Offset + 1, group.m_jointOffset, laneMask);
+			forceM1.m_linear.m_z.Scatter(jointPartialForces + body1Offset + 2, group.m_jointOffset, laneMask);
+			forceM1.m_angular.m_x.Scatter(jointPartialForces + body1Offset + 4, group.m_jointOffset, laneMask);
+			forceM1.m_angular.m_y.Scatter(jointPartialForces + body1Offset + 5, group.m_jointOffset, laneMask);
+			forceM1.m_angular.m_z.Scatter(jointPartialForces + body1Offset + 6, group.m_jointOffset, laneMask);
+		};
+
+		for (ndInt32 i = iterator0.fetch_add(D_WORKER_BATCH_SIZE); i < groupCount; i = iterator0.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((groupCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : groupCount - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				const ndInt32 m = i + j;
+				JointForce(m, jointGroups[m], &massMatrix[m_groupRowStart[m]]);
+			}
+		}
+	});
+
+	ndAtomic<ndInt32> iterator1(0);
+	auto ApplyJacobianAccumulatePartialForces = ndMakeObject::ndFunction([this, &iterator1, &bodyArray](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(ApplyJacobianAccumulatePartialForces);
+		const ndVector zero(ndVector::m_zero);
+		ndJacobian* const internalForces = &GetInternalForces()[0];
+		const ndInt32* const bodyIndex = &GetJointForceIndexBuffer()[0];
+		const ndJacobian* const jointInternalForces = &GetTempInternalForces()[0];
+		const ndJointBodyPairIndex* const jointBodyPairIndexBuffer = &GetJointBodyPairIndexBuffer()[0];
+
+		const ndInt32 bodyCount = ndInt32(bodyArray.GetCount());
+		for (ndInt32 i = iterator1.fetch_add(D_WORKER_BATCH_SIZE); i < bodyCount; i = iterator1.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((bodyCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : bodyCount - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				ndVector force(zero);
+				ndVector torque(zero);
+				const ndInt32 m = i + j;
+				const ndBodyKinematic* const body = bodyArray[m];
+
+				const ndInt32 startIndex = bodyIndex[m];
+				const ndInt32 mask = body->m_isStatic - 1;
+				const ndInt32 count = mask & (bodyIndex[m + 1] - startIndex);
+				for (ndInt32 k = 0; k < count; ++k)
+				{
+					const ndInt32 index = jointBodyPairIndexBuffer[startIndex + k].m_joint;
+					force += jointInternalForces[index].m_linear;
+					torque += jointInternalForces[index].m_angular;
+				}
+				internalForces[m].m_linear = force;
+				internalForces[m].m_angular = torque;
+			}
+		}
+	});
+
+	ndAtomic<ndInt32> iterator2(0);
+	auto UpdateJointsForce = ndMakeObject::ndFunction([this, &iterator2, groupCount](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(UpdateJointsForce);
+		ndRightHandSide* const rightHandSide = &m_rightHandSide[0];
+		ndFloat32* const force = &rightHandSide->m_force;
+		ndFloat32* const maxImpact = &rightHandSide->m_maxImpact;
+		const ndAvx512Int rhsStride(ndInt32(sizeof(ndRightHandSide) / sizeof(ndFloat32)));
+		const ndAvx512JointGroup* const jointGroups = &(*m_jointGroups)[0];
+		const ndAvx512MatrixElement* const massMatrix = &(*m_massMatrix)[0];
+
+		for (ndInt32 i = iterator2.fetch_add(D_WORKER_BATCH_SIZE); i < groupCount; i = iterator2.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((groupCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : groupCount - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				const ndInt32 m = i + j;
+				const ndAvx512JointGroup& group = jointGroups[m];
+				const ndAvx512MatrixElement* const rows = &massMatrix[m_groupRowStart[m]];
+				for (ndInt32 k = 0; k < group.m_maxRowCount; ++k)
+				{
+					const ndAvx512Int row(k);
+					const __mmask16 rowMask = group.m_laneMask & (group.m_rowCount > row);
+					const ndAvx512Int rhsIndex((group.m_rowStart + row) * rhsStride);
+					const ndAvx512Float impact(maxImpact, rhsIndex, rowMask);
+					rows[k].m_force.Scatter(force, rhsIndex, rowMask);
+					impact.GetMax(rows[k].m_force.Abs()).Scatter(maxImpact, rhsIndex, rowMask);
+				}
+			}
+		}
+	});
+
+	scene->ParallelExecute(UpdateAcceleration);
+	for (ndInt32 i = 0; i < ndInt32(passes); ++i)
+	{
+		iterator0 = 0;
+		iterator1 = 0;
+		scene->ParallelExecute(CalculateJointsForce);
+		scene->ParallelExecute(ApplyJacobianAccumulatePartialForces);
+	}
+	scene->ParallelExecute(UpdateJointsForce);
+}
+
+void ndDynamicsUpdateAvx512::CalculateForces()
+{
+	D_TRACKTIME();
+	if (m_world->GetScene()->GetActiveContactArray().GetCount())
+	{
+		m_firstPassCoef = ndFloat32(0.0f);
+
+		InitSkeletons();
+		for (ndInt32 step = 0; step < 4; step++)
+		{
+			CalculateJointsAcceleration();
+			CalculateJointsForce();
+			UpdateSkeletons();
+			IntegrateBodiesVelocity();
+		}
+
+		UpdateForceFeedback();
+	}
+}
+
+void ndDynamicsUpdateAvx512::Update()
+{
+	D_TRACKTIME();
+	m_timestep = m_world->GetScene()->GetTimestep();
+
+	BuildIsland();
+	IntegrateUnconstrainedBodies();
+	InitWeights();
+	InitBodyArray();
+	InitJacobianMatrix();
+	BuildMassMatrix();
+	CalculateForces();
+	IntegrateBodies();
+	DetermineSleepStates();
+}
+
+#if defined(__clang__)
+	#pragma clang attribute pop
+#elif defined(__GNUC__)
+	#pragma GCC pop_options
+#endif
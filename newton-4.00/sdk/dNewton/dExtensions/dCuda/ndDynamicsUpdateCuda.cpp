@@ -858,7 +858,7 @@ void ndDynamicsUpdateCuda::InitJacobianMatrix()
 				rhs->m_deltaAccel = extenalAcceleration;
 				rhs->m_coordenateAccel += extenalAcceleration;
 				ndAssert(rhs->m_jointFeebackForce);
-				const ndFloat32 force = rhs->m_jointFeebackForce->GetInitialGuess();
+				const ndFloat32 force = isBilateral ? rhs->m_jointFeebackForce->GetInitialGuess() : rhs->m_jointFeebackForce->GetWarmStart();
 
 				rhs->m_force = isBilateral ? ndClamp(force, rhs->m_lowerBoundFrictionCoefficent, rhs->m_upperBoundFrictionCoefficent) : force;
 				rhs->m_maxImpact = ndFloat32(0.0f);
@@ -96,6 +96,7 @@ class ndBodyDynamic: public ndBodyKinematic
 	friend class ndDynamicsUpdate;
 	friend class ndDynamicsUpdateSoa;
 	friend class ndDynamicsUpdateAvx2;
+	friend class ndDynamicsUpdateAvx512;
 	friend class ndDynamicsUpdateSycl;
 	friend class ndDynamicsUpdateCuda;
 } D_GCC_NEWTON_ALIGN_32 ;
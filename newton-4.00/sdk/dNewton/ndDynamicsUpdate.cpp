@@ -33,6 +33,10 @@
 ndDynamicsUpdate::ndDynamicsUpdate(ndWorld* const world)
 	:m_velocTol(ndFloat32(1.0e-8f))
 	,m_islands(D_DEFAULT_BUFFER_SIZE)
+	,m_bodyIsland(D_DEFAULT_BUFFER_SIZE)
+	,m_jointIsland(D_DEFAULT_BUFFER_SIZE)
+	,m_islandJoints(D_DEFAULT_BUFFER_SIZE)
+	,m_jointResidual(D_DEFAULT_BUFFER_SIZE)
 	,m_jointForcesIndex(D_DEFAULT_BUFFER_SIZE)
 	,m_internalForces(D_DEFAULT_BUFFER_SIZE)
 	,m_leftHandSide(D_DEFAULT_BUFFER_SIZE * 4)
@@ -66,6 +70,10 @@ const char* ndDynamicsUpdate::GetStringId() const
 void ndDynamicsUpdate::Clear()
 {
 	m_islands.Resize(D_DEFAULT_BUFFER_SIZE);
+	m_bodyIsland.Resize(D_DEFAULT_BUFFER_SIZE);
+	m_jointIsland.Resize(D_DEFAULT_BUFFER_SIZE);
+	m_islandJoints.Resize(D_DEFAULT_BUFFER_SIZE);
+	m_jointResidual.Resize(D_DEFAULT_BUFFER_SIZE);
 	m_rightHandSide.Resize(D_DEFAULT_BUFFER_SIZE);
 	m_internalForces.Resize(D_DEFAULT_BUFFER_SIZE);
 	m_bodyIslandOrder.Resize(D_DEFAULT_BUFFER_SIZE);
@@ -140,8 +148,7 @@ void ndDynamicsUpdate::SortBodyJointScan()
 	});
 	scene->ParallelExecute(EnumerateJointBodyPairs);
 
-	scene->GetScratchBuffer().SetCount(bodyJointPairs.GetCount() * ndInt32 (sizeof (ndJointBodyPairIndex)));
-	ndJointBodyPairIndex* const tempBuffer = (ndJointBodyPairIndex*)&scene->GetScratchBuffer()[0];
+	ndJointBodyPairIndex* const tempBuffer = scene->GetFrameArena().Alloc<ndJointBodyPairIndex>(ndInt32(bodyJointPairs.GetCount()));
 
 	ndCountingSort<ndJointBodyPairIndex, ndEvaluateKey0, D_MAX_BODY_RADIX_BIT>(*scene, &bodyJointPairs[0], tempBuffer, ndInt32 (bodyJointPairs.GetCount()), nullptr, nullptr);
 	ndCountingSort<ndJointBodyPairIndex, ndEvaluateKey1, D_MAX_BODY_RADIX_BIT>(*scene, tempBuffer, &bodyJointPairs[0], ndInt32 (bodyJointPairs.GetCount()), nullptr, nullptr);
@@ -326,12 +333,13 @@ void ndDynamicsUpdate::SortJointsScan()
 		movingJoints[threadIndex] = activeJointCount;
 	});
 	
-	auto Scan0 = ndMakeObject::ndFunction([&jointArray, &histogram, scene](ndInt32 threadIndex, ndInt32 threadCount)
+	ndConstraint** const tempJointBuffer = scene->GetFrameArena().Alloc<ndConstraint*>(ndInt32(jointArray.GetCount() + 32));
+
+	auto Scan0 = ndMakeObject::ndFunction([&jointArray, &histogram, tempJointBuffer](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME_NAMED(Scan0);
 		ndInt32* const hist = &histogram[threadIndex][0];
-		ndAssert(scene->GetScratchBuffer().GetCount() >= ndInt32 (jointArray.GetCount() * sizeof(ndConstraint*)));
-		ndConstraint** const dstBuffer = (ndConstraint**)&scene->GetScratchBuffer()[0];
+		ndConstraint** const dstBuffer = tempJointBuffer;
 	
 		hist[0] = 0;
 		hist[1] = 0;
@@ -349,12 +357,11 @@ void ndDynamicsUpdate::SortJointsScan()
 		}
 	});
 	
-	auto Sort0 = ndMakeObject::ndFunction([&jointArray, &histogram, scene](ndInt32 threadIndex, ndInt32 threadCount)
+	auto Sort0 = ndMakeObject::ndFunction([&jointArray, &histogram, tempJointBuffer](ndInt32 threadIndex, ndInt32 threadCount)
 	{
 		D_TRACKTIME_NAMED(Sort0);
 		ndInt32* const hist = &histogram[threadIndex][0];
-		ndAssert(scene->GetScratchBuffer().GetCount() >= ndInt32 (jointArray.GetCount() * sizeof (ndConstraint*)));
-		ndConstraint** const dstBuffer = (ndConstraint**)&scene->GetScratchBuffer()[0];
+		ndConstraint** const dstBuffer = tempJointBuffer;
 	
 		const ndStartEnd startEnd(ndInt32 (jointArray.GetCount()), threadIndex, threadCount);
 		for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
@@ -369,9 +376,6 @@ void ndDynamicsUpdate::SortJointsScan()
 		}
 	});
 	
-	scene->GetScratchBuffer().SetCount((jointArray.GetCount() + 32) * ndInt32 (sizeof (ndConstraint*)));
-	ndConstraint** const tempJointBuffer = (ndConstraint**)&scene->GetScratchBuffer()[0];
-	
 	scene->ParallelExecute(MarkFence0);
 	scene->ParallelExecute(MarkFence1);
 	scene->ParallelExecute(Scan0);
@@ -581,6 +585,140 @@ void ndDynamicsUpdate::BuildIsland()
 	}
 }
 
+void ndDynamicsUpdate::BuildJointIslands()
+{
+	D_TRACKTIME();
+	m_islands.SetCount(0);
+	ndScene* const scene = m_world->GetScene();
+	const ndArray<ndBodyKinematic*>& bodyArray = scene->GetActiveBodyArray();
+	const ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
+	const ndInt32 jointCount = ndInt32(jointArray.GetCount());
+	if (!jointCount)
+	{
+		return;
+	}
+
+	ndAtomic<ndInt32> iterator0(0);
+	auto ResetIslands = ndMakeObject::ndFunction([&iterator0, &bodyArray](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(ResetIslands);
+		const ndInt32 bodyCount = ndInt32(bodyArray.GetCount());
+		for (ndInt32 i = iterator0.fetch_add(D_WORKER_BATCH_SIZE); i < bodyCount; i = iterator0.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((bodyCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : bodyCount - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				ndBodyKinematic* const body = bodyArray[i + j];
+				body->m_islandParent = body;
+			}
+		}
+	});
+
+	ndAtomic<ndInt32> iterator1(0);
+	auto UnionIslands = ndMakeObject::ndFunction([this, &iterator1, &jointArray](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(UnionIslands);
+		const ndInt32 jointCount = ndInt32(jointArray.GetCount());
+		for (ndInt32 i = iterator1.fetch_add(D_WORKER_BATCH_SIZE); i < jointCount; i = iterator1.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((jointCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : jointCount - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				// union the dynamic bodies of each joint, static bodies do not connect islands.
+				// a root is always linked under the one with the lower index, so the links never 
+				// make a cycle and each island is rooted at its lowest body, whatever the threads order.
+				const ndConstraint* const joint = jointArray[i + j];
+				ndBodyKinematic* const body0 = joint->GetBody0();
+				ndBodyKinematic* const body1 = joint->GetBody1();
+				if (!(body0->m_isStatic | body1->m_isStatic))
+				{
+					for (bool linked = false; !linked;)
+					{
+						ndBodyKinematic* root0 = FindRootAndSplit(body0);
+						ndBodyKinematic* root1 = FindRootAndSplit(body1);
+						linked = (root0 == root1);
+						if (!linked)
+						{
+							if (root0->m_index < root1->m_index)
+							{
+								ndSwap(root0, root1);
+							}
+							ndBodyKinematic* expected = root0;
+							linked = root0->m_islandParent.compare_exchange_weak(expected, root1);
+						}
+					}
+				}
+			}
+		}
+	});
+
+	ndAtomic<ndInt32> iterator2(0);
+	auto FindJointRoots = ndMakeObject::ndFunction([this, &iterator2, &jointArray](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(FindJointRoots);
+		const ndInt32 jointCount = ndInt32(jointArray.GetCount());
+		for (ndInt32 i = iterator2.fetch_add(D_WORKER_BATCH_SIZE); i < jointCount; i = iterator2.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((jointCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : jointCount - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				const ndConstraint* const joint = jointArray[i + j];
+				ndBodyKinematic* const body0 = joint->GetBody0();
+				ndBodyKinematic* const body1 = joint->GetBody1();
+				m_jointIsland[i + j] = FindRootAndSplit(body0->m_isStatic ? body1 : body0)->m_index;
+			}
+		}
+	});
+
+	const ndInt32 bodyCount = ndInt32(bodyArray.GetCount());
+	m_bodyIsland.SetCount(bodyCount);
+	m_jointIsland.SetCount(jointCount);
+	scene->ParallelExecute(ResetIslands);
+	scene->ParallelExecute(UnionIslands);
+	scene->ParallelExecute(FindJointRoots);
+
+	// only the numbering of the islands is serial, so that it does not depend on the threads.
+	for (ndInt32 i = 0; i < bodyCount; ++i)
+	{
+		m_bodyIsland[i] = -1;
+	}
+	for (ndInt32 i = 0; i < jointCount; ++i)
+	{
+		const ndInt32 rootIndex = m_jointIsland[i];
+		ndInt32 index = m_bodyIsland[rootIndex];
+		if (index == -1)
+		{
+			index = ndInt32(m_islands.GetCount());
+			m_bodyIsland[rootIndex] = index;
+			m_islands.PushBack(ndIsland(bodyArray[rootIndex]));
+		}
+		m_jointIsland[i] = index;
+		m_islands[index].m_count++;
+	}
+
+	// the islands share the passes of the scene, an island that is hard to solve 
+	// can use the passes the others did not, up to a few times the default count.
+	ndInt32 sum = 0;
+	for (ndInt32 i = 0; i < ndInt32(m_islands.GetCount()); ++i)
+	{
+		ndIsland& island = m_islands[i];
+		island.m_start = sum;
+		sum += island.m_count;
+		island.m_count = 0;
+		island.m_maxPasses = ndInt32(m_solverPasses) * D_ISLAND_MAX_PASSES_SCALE;
+	}
+
+	m_islandJoints.SetCount(jointCount);
+	m_jointResidual.SetCount(jointCount);
+	for (ndInt32 i = 0; i < jointCount; ++i)
+	{
+		ndIsland& island = m_islands[m_jointIsland[i]];
+		m_islandJoints[island.m_start + island.m_count] = i;
+		island.m_count++;
+		m_jointResidual[i] = ndFloat32(0.0f);
+	}
+}
+
 void ndDynamicsUpdate::IntegrateUnconstrainedBodies()
 {
 	ndScene* const scene = m_world->GetScene();
@@ -824,13 +962,11 @@ void ndDynamicsUpdate::InitJacobianMatrix()
 	ndBodyKinematic** const bodyArray = &scene->GetActiveBodyArray()[0];
 	ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
 
-	ndAtomic<ndInt32> iterator(0);
-	auto InitJacobianMatrix = ndMakeObject::ndFunction([this, &iterator, &jointArray](ndInt32, ndInt32)
+	auto InitJacobianMatrix = [this, &jointArray](ndInt32, ndInt32 i)
 	{
-		D_TRACKTIME_NAMED(InitJacobianMatrix);
-		ndJacobian* const internalForces = &GetTempInternalForces()[0];
-		auto BuildJacobianMatrix = [this, &internalForces](ndConstraint* const joint, ndInt32 jointIndex)
+		auto BuildJacobianMatrix = [this](ndConstraint* const joint, ndInt32 jointIndex)
 		{
+			ndJacobian* const internalForces = &GetTempInternalForces()[0];
 			ndAssert(joint->GetBody0());
 			ndAssert(joint->GetBody1());
 			const ndBodyKinematic* const body0 = joint->GetBody0();
@@ -878,7 +1014,7 @@ void ndDynamicsUpdate::InitJacobianMatrix()
 				rhs->m_deltaAccel = extenalAcceleration;
 				rhs->m_coordenateAccel += extenalAcceleration;
 				ndAssert(rhs->m_jointFeebackForce);
-				const ndFloat32 force = rhs->m_jointFeebackForce->GetInitialGuess();
+				const ndFloat32 force = isBilateral ? rhs->m_jointFeebackForce->GetInitialGuess() : rhs->m_jointFeebackForce->GetWarmStart();
 
 				rhs->m_force = isBilateral ? ndClamp(force, rhs->m_lowerBoundFrictionCoefficent, rhs->m_upperBoundFrictionCoefficent) : force;
 				rhs->m_maxImpact = ndFloat32(0.0f);
@@ -914,18 +1050,10 @@ void ndDynamicsUpdate::InitJacobianMatrix()
 			outBody1.m_angular = torqueAcc1;
 		};
 
-		const ndInt32 jointCount = ndInt32 (jointArray.GetCount());
-		for (ndInt32 i = iterator.fetch_add(D_WORKER_BATCH_SIZE); i < jointCount; i = iterator.fetch_add(D_WORKER_BATCH_SIZE))
-		{
-			const ndInt32 maxSpan = ((jointCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : jointCount - i;
-			for (ndInt32 j = 0; j < maxSpan; ++j)
-			{
-				ndConstraint* const joint = jointArray[i + j];
-				GetJacobianDerivatives(joint);
-				BuildJacobianMatrix(joint, i + j);
-			}
-		}
-	});
+		ndConstraint* const joint = jointArray[i];
+		GetJacobianDerivatives(joint);
+		BuildJacobianMatrix(joint, i);
+	};
 
 	ndAtomic<ndInt32> iterator1(0);
 	auto InitJacobianAccumulatePartialForces = ndMakeObject::ndFunction([this, &iterator1, &bodyArray](ndInt32, ndInt32)
@@ -973,7 +1101,8 @@ void ndDynamicsUpdate::InitJacobianMatrix()
 		D_TRACKTIME();
 		m_rightHandSide[0].m_force = ndFloat32(1.0f);
 
-		scene->ParallelExecute(InitJacobianMatrix);
+		// joints rows count and skeleton loops make the cost per joint uneven, let idle threads steal
+		scene->ParallelFor(0, ndInt32(jointArray.GetCount()), D_WORKER_BATCH_SIZE / 2, InitJacobianMatrix);
 		scene->ParallelExecute(InitJacobianAccumulatePartialForces);
 	}
 }
@@ -1317,6 +1446,7 @@ void ndDynamicsUpdate::CalculateJointsForce()
 			const ndInt32 rowStart = joint->m_rowStart;
 			const ndInt32 rowsCount = joint->m_rowCount;
 
+			ndFloat32 residual = ndFloat32(0.0f);
 			const ndInt32 resting = body0->m_equilibrium0 & body1->m_equilibrium0;
 			if (!resting)
 			{
@@ -1365,6 +1495,7 @@ void ndDynamicsUpdate::CalculateJointsForce()
 				const ndFloat32 tol = ndFloat32(0.125f);
 				const ndFloat32 tol2 = tol * tol;
 
+				residual = accNorm.GetScalar();
 				ndVector maxAccel(accNorm);
 				for (ndInt32 k = 0; (k < 4) && (maxAccel.GetScalar() > tol2); ++k)
 				{
@@ -1406,6 +1537,8 @@ void ndDynamicsUpdate::CalculateJointsForce()
 				}
 			}
 
+			m_jointResidual[jointIndex] = residual;
+
 			ndVector forceM0(zero);
 			ndVector torqueM0(zero);
 			ndVector forceM1(zero);
@@ -1435,20 +1568,28 @@ void ndDynamicsUpdate::CalculateJointsForce()
 			outBody1.m_angular = torqueM1;
 		};
 
+		// the joints of a converged island keep the partial forces of their last pass.
+		const ndIsland* const islands = &m_islands[0];
+		const ndInt32* const jointIsland = &m_jointIsland[0];
 		const ndInt32 jointCount = ndInt32 (jointArray.GetCount());
 		for (ndInt32 i = iterator0.fetch_add(D_WORKER_BATCH_SIZE); i < jointCount; i = iterator0.fetch_add(D_WORKER_BATCH_SIZE))
 		{
 			const ndInt32 maxSpan = ((jointCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : jointCount - i;
 			for (ndInt32 j = 0; j < maxSpan; ++j)
 			{
-				ndConstraint* const joint = jointArray[i + j];
-				JointForce(joint, i + j);
+				if (!islands[jointIsland[i + j]].m_stepConverged)
+				{
+					ndConstraint* const joint = jointArray[i + j];
+					JointForce(joint, i + j);
+				}
 			}
 		}
 	});
 
 	ndAtomic<ndInt32> iterator1(0);
-	auto ApplyJacobianAccumulatePartialForces = ndMakeObject::ndFunction([this, &iterator1, &bodyArray](ndInt32, ndInt32)
+	ndAtomic<ndInt32> iterator2(0);
+	ndAtomic<ndInt32> activeJoints(0);
+	auto ApplyJacobianAccumulatePartialForces = ndMakeObject::ndFunction([this, &iterator1, &iterator2, &activeJoints, &bodyArray](ndInt32, ndInt32)
 	{
 		D_TRACKTIME_NAMED(ApplyJacobianAccumulatePartialForces);
 		const ndVector zero(ndVector::m_zero);
@@ -1483,14 +1624,98 @@ void ndDynamicsUpdate::CalculateJointsForce()
 				internalForces[m].m_angular = torque;
 			}
 		}
+
+		// the joint residuals are also complete, so the islands are tested in the same job.
+		const ndFloat32 tol = ndFloat32(0.125f);
+		const ndFloat32 tol2 = tol * tol;
+		const ndInt32* const islandJoints = &m_islandJoints[0];
+		const ndFloat32* const jointResidual = &m_jointResidual[0];
+
+		const ndInt32 islandCount = ndInt32(m_islands.GetCount());
+		for (ndInt32 i = iterator2.fetch_add(D_WORKER_BATCH_SIZE); i < islandCount; i = iterator2.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((islandCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : islandCount - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				ndIsland& island = m_islands[i + j];
+				if (!island.m_stepConverged)
+				{
+					ndFloat32 residual = ndFloat32(0.0f);
+					for (ndInt32 k = 0; k < island.m_count; ++k)
+					{
+						residual = ndMax(residual, jointResidual[islandJoints[island.m_start + k]]);
+					}
+
+					island.m_stepPasses++;
+					const bool converged = (residual < tol2) && (island.m_stepPasses >= D_ISLAND_MIN_PASSES);
+					if (converged || (island.m_stepPasses >= island.m_maxPasses))
+					{
+						island.m_stepConverged = 1;
+						island.m_residual = ndMax(island.m_residual, residual);
+						island.m_passes = ndMax(island.m_passes, island.m_stepPasses);
+					}
+					else
+					{
+						activeJoints.fetch_add(island.m_count);
+					}
+				}
+			}
+		}
 	});
 
-	for (ndInt32 i = 0; i < ndInt32(passes); ++i)
+	// each island stops at its own convergence, the islands share a budget of the 
+	// default passes over all their joints, and the passes end when they all converged 
+	// or when the budget can not pay for the joints of the islands still iterating.
+	ndInt32 passJoints = 0;
+	for (ndInt32 i = 0; i < ndInt32(m_islands.GetCount()); ++i)
+	{
+		const ndIsland& island = m_islands[i];
+		passJoints += island.m_stepConverged ? 0 : island.m_count;
+	}
+
+	ndInt32 budget = ndInt32(passes) * passJoints;
+	while (passJoints && (passJoints <= budget))
 	{
+		budget -= passJoints;
 		iterator0 = 0;
 		iterator1 = 0;
+		iterator2 = 0;
+		activeJoints = 0;
 		scene->ParallelExecute(CalculateJointsForce);
 		scene->ParallelExecute(ApplyJacobianAccumulatePartialForces);
+		passJoints = activeJoints.load();
+	}
+
+	if (passJoints)
+	{
+		// out of budget, the islands still iterating keep the residual of their last pass.
+		const ndInt32* const islandJoints = &m_islandJoints[0];
+		const ndFloat32* const jointResidual = &m_jointResidual[0];
+		for (ndInt32 i = 0; i < ndInt32(m_islands.GetCount()); ++i)
+		{
+			ndIsland& island = m_islands[i];
+			if (!island.m_stepConverged)
+			{
+				ndFloat32 residual = ndFloat32(0.0f);
+				for (ndInt32 j = 0; j < island.m_count; ++j)
+				{
+					residual = ndMax(residual, jointResidual[islandJoints[island.m_start + j]]);
+				}
+				island.m_stepConverged = 1;
+				island.m_residual = ndMax(island.m_residual, residual);
+				island.m_passes = ndMax(island.m_passes, island.m_stepPasses);
+			}
+		}
+	}
+}
+
+void ndDynamicsUpdate::ResetIslands()
+{
+	for (ndInt32 i = 0; i < ndInt32(m_islands.GetCount()); ++i)
+	{
+		ndIsland& island = m_islands[i];
+		island.m_stepPasses = 0;
+		island.m_stepConverged = 0;
 	}
 }
 
@@ -1505,6 +1730,7 @@ void ndDynamicsUpdate::CalculateForces()
 		for (ndInt32 step = 0; step < 4; step++)
 		{
 			CalculateJointsAcceleration();
+			ResetIslands();
 			CalculateJointsForce();
 			UpdateSkeletons();
 			IntegrateBodiesVelocity();
@@ -1521,6 +1747,7 @@ void ndDynamicsUpdate::Update()
 	BuildIsland();
 	IntegrateUnconstrainedBodies();
 	InitWeights();
+	BuildJointIslands();
 	InitBodyArray();
 	InitJacobianMatrix();
 	CalculateForces();
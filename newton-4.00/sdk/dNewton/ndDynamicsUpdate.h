@@ -25,6 +25,8 @@
 #include "ndNewtonStdafx.h"
 
 #define D_MAX_BODY_RADIX_BIT		9
+#define D_ISLAND_MIN_PASSES			2
+#define D_ISLAND_MAX_PASSES_SCALE	4
 
 // the solver is a RK order 4, but instead of weighting the intermediate derivative by the usual 1/6, 1/3, 1/3, 1/6 coefficients
 // I am using 1/4, 1/4, 1/4, 1/4.
@@ -58,19 +60,33 @@ class ndDynamicsUpdate : public ndClassAlloc
 		ndBodyKinematic* m_root;
 	};
 
+	// a set of joints connected by dynamic bodies, it is iterated until its own residual 
+	// is under the tolerance, it used its own pass budget, or the passes that all the 
+	// islands share ran out, whatever comes first.
+	// the counters are the worst of the four velocity sub steps of the last update.
 	class ndIsland
 	{
 		public:
 		ndIsland(ndBodyKinematic* const root)
 			:m_start(0)
-			, m_count(0)
-			, m_root(root)
+			,m_count(0)
+			,m_root(root)
+			,m_residual(ndFloat32(0.0f))
+			,m_passes(0)
+			,m_maxPasses(0)
+			,m_stepPasses(0)
+			,m_stepConverged(0)
 		{
 		}
 
 		ndInt32 m_start;
 		ndInt32 m_count;
 		ndBodyKinematic* m_root;
+		ndFloat32 m_residual;
+		ndInt32 m_passes;
+		ndInt32 m_maxPasses;
+		ndInt32 m_stepPasses;
+		ndInt32 m_stepConverged;
 	};
 
 	public:
@@ -83,6 +99,7 @@ class ndDynamicsUpdate : public ndClassAlloc
 	ndVector GetVelocTol() const;
 	ndFloat32 GetTimestepRK() const;
 	ndArray<ndIsland>& GetIslands();
+	const ndArray<ndIsland>& GetIslands() const;
 	ndArray<ndJacobian>& GetInternalForces();
 	ndArray<ndLeftHandSide>& GetLeftHandSide();
 	ndArray<ndInt32>& GetJointForceIndexBuffer();
@@ -91,10 +108,12 @@ class ndDynamicsUpdate : public ndClassAlloc
 	ndArray<ndBodyKinematic*>& GetBodyIslandOrder();
 	ndArray<ndJointBodyPairIndex>& GetJointBodyPairIndexBuffer();
 
-	private:
+	protected:
 	void SortJoints();
 	void SortIslands();
 	void BuildIsland();
+	void BuildJointIslands();
+	void ResetIslands();
 	void InitWeights();
 	void InitBodyArray();
 	void InitSkeletons();
@@ -111,7 +130,6 @@ class ndDynamicsUpdate : public ndClassAlloc
 	void DetermineSleepStates();
 	void GetJacobianDerivatives(ndConstraint* const joint);
 
-	protected:
 	void Clear();
 	virtual void Update();
 	void SortJointsScan();
@@ -120,6 +138,10 @@ class ndDynamicsUpdate : public ndClassAlloc
 
 	ndVector m_velocTol;
 	ndArray<ndIsland> m_islands;
+	ndArray<ndInt32> m_bodyIsland;
+	ndArray<ndInt32> m_jointIsland;
+	ndArray<ndInt32> m_islandJoints;
+	ndArray<ndFloat32> m_jointResidual;
 	ndArray<ndInt32> m_jointForcesIndex;
 	ndArray<ndJacobian> m_internalForces;
 	ndArray<ndLeftHandSide> m_leftHandSide;
@@ -158,6 +180,11 @@ inline ndArray<ndDynamicsUpdate::ndIsland>& ndDynamicsUpdate::GetIslands()
 	return m_islands;
 }
 
+inline const ndArray<ndDynamicsUpdate::ndIsland>& ndDynamicsUpdate::GetIslands() const
+{
+	return m_islands;
+}
+
 inline ndArray<ndJacobian>& ndDynamicsUpdate::GetInternalForces()
 {
 	return m_internalForces;
@@ -200,12 +227,16 @@ inline ndArray<ndInt32>& ndDynamicsUpdate::GetJointForceIndexBuffer()
 
 inline ndBodyKinematic* ndDynamicsUpdate::FindRootAndSplit(ndBodyKinematic* const body)
 {
+	// a node only ever moves its parent further up the tree, 
+	// so many threads can search and split the same path at once.
 	ndBodyKinematic* node = body;
-	while (node->m_islandParent != node)
+	ndBodyKinematic* parent = node->m_islandParent.load();
+	while (parent != node)
 	{
-		ndBodyKinematic* const prev = node;
-		node = node->m_islandParent;
-		prev->m_islandParent = node->m_islandParent;
+		ndBodyKinematic* const grandParent = parent->m_islandParent.load();
+		node->m_islandParent.store(grandParent);
+		node = parent;
+		parent = grandParent;
 	}
 	return node;
 }
@@ -0,0 +1,730 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndWorld.h"
+#include "ndBodyDynamic.h"
+#include "ndSkeletonList.h"
+#include "ndDynamicsUpdateGaussSeidel.h"
+
+#define D_GS_WORK_GROUP				4
+#define D_GS_MAX_COLORS				64
+#define D_GS_BATCH_SIZE				4
+#define D_GS_MIN_PARALLEL_GROUPS	16
+#define D_GS_DEFAULT_BUFFER_SIZE	1024
+
+using namespace ndSoa;
+
+ndDynamicsUpdateGaussSeidel::ndDynamicsUpdateGaussSeidel(ndWorld* const world)
+	:ndDynamicsUpdate(world)
+	,m_ordinals(0, 1, 2, 3)
+	,m_jointColor(D_GS_DEFAULT_BUFFER_SIZE)
+	,m_colorJoints(D_GS_DEFAULT_BUFFER_SIZE)
+	,m_groupRowStart(D_GS_DEFAULT_BUFFER_SIZE)
+	,m_colorGroupStart(D_GS_MAX_COLORS + 2)
+	,m_bodyColorMask(D_GS_DEFAULT_BUFFER_SIZE)
+	,m_soaMassMatrix(D_GS_DEFAULT_BUFFER_SIZE)
+	,m_colorCount(0)
+	,m_serialColor(-1)
+{
+}
+
+ndDynamicsUpdateGaussSeidel::~ndDynamicsUpdateGaussSeidel()
+{
+	Clear();
+
+	m_jointColor.Resize(D_GS_DEFAULT_BUFFER_SIZE);
+	m_colorJoints.Resize(D_GS_DEFAULT_BUFFER_SIZE);
+	m_groupRowStart.Resize(D_GS_DEFAULT_BUFFER_SIZE);
+	m_bodyColorMask.Resize(D_GS_DEFAULT_BUFFER_SIZE);
+	m_soaMassMatrix.Resize(D_GS_DEFAULT_BUFFER_SIZE);
+}
+
+const char* ndDynamicsUpdateGaussSeidel::GetStringId() const
+{
+	return "gauss seidel soa";
+}
+
+void ndDynamicsUpdateGaussSeidel::ColorJoints()
+{
+	D_TRACKTIME();
+	m_colorCount = 0;
+	m_serialColor = -1;
+	m_colorJoints.SetCount(0);
+	m_colorGroupStart.SetCount(1);
+	m_colorGroupStart[0] = 0;
+
+	ndScene* const scene = m_world->GetScene();
+	const ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
+	if (!m_activeJointCount || !jointArray.GetCount())
+	{
+		return;
+	}
+
+	// a Gauss Seidel pass propagates a force through the whole chain of joints,
+	// so it does not need the extra passes the Jacobi solver adds for connectivity.
+	m_solverPasses = ndUnsigned32(ndMax(m_world->GetSolverIterations() / 2, 2));
+
+	const ndInt32 bodyCount = ndInt32(scene->GetActiveBodyArray().GetCount());
+	m_bodyColorMask.SetCount(bodyCount);
+	for (ndInt32 i = 0; i < bodyCount; ++i)
+	{
+		m_bodyColorMask[i] = 0;
+	}
+
+	// greedy coloring, static bodies do not get a color since no joint writes to them.
+	// the joints that do not fit in any color go to a last batch that is solved serially.
+	ndInt32 colorCount[D_GS_MAX_COLORS + 1];
+	for (ndInt32 i = 0; i <= D_GS_MAX_COLORS; ++i)
+	{
+		colorCount[i] = 0;
+	}
+
+	m_jointColor.SetCount(m_activeJointCount);
+	for (ndInt32 i = 0; i < m_activeJointCount; ++i)
+	{
+		const ndConstraint* const joint = jointArray[i];
+		const ndBodyKinematic* const body0 = joint->GetBody0();
+		const ndBodyKinematic* const body1 = joint->GetBody1();
+		const ndUnsigned64 mask0 = body0->m_isStatic ? 0 : m_bodyColorMask[body0->m_index];
+		const ndUnsigned64 mask1 = body1->m_isStatic ? 0 : m_bodyColorMask[body1->m_index];
+		const ndUnsigned64 mask = mask0 | mask1;
+
+		ndInt32 color = 0;
+		for (; (color < D_GS_MAX_COLORS) && (mask & (ndUnsigned64(1) << color)); ++color);
+		if (color < D_GS_MAX_COLORS)
+		{
+			const ndUnsigned64 bit = ndUnsigned64(1) << color;
+			if (!body0->m_isStatic)
+			{
+				m_bodyColorMask[body0->m_index] |= bit;
+			}
+			if (!body1->m_isStatic)
+			{
+				m_bodyColorMask[body1->m_index] |= bit;
+			}
+		}
+		m_jointColor[i] = color;
+		colorCount[color]++;
+	}
+
+	// each color is split in groups of four joints, but the serial batch
+	// gets one joint per group since its joints may share bodies.
+	ndInt32 colorMap[D_GS_MAX_COLORS + 1];
+	ndInt32 groupCount = 0;
+	for (ndInt32 i = 0; i <= D_GS_MAX_COLORS; ++i)
+	{
+		colorMap[i] = groupCount;
+		if (colorCount[i])
+		{
+			if (i == D_GS_MAX_COLORS)
+			{
+				m_serialColor = m_colorCount;
+				groupCount += colorCount[i];
+			}
+			else
+			{
+				groupCount += (colorCount[i] + D_GS_WORK_GROUP - 1) / D_GS_WORK_GROUP;
+			}
+			m_colorCount++;
+			m_colorGroupStart.PushBack(groupCount);
+		}
+	}
+
+	m_colorJoints.SetCount(groupCount * D_GS_WORK_GROUP);
+	for (ndInt32 i = 0; i < ndInt32(m_colorJoints.GetCount()); ++i)
+	{
+		m_colorJoints[i] = -1;
+	}
+
+	for (ndInt32 i = 0; i <= D_GS_MAX_COLORS; ++i)
+	{
+		colorMap[i] *= D_GS_WORK_GROUP;
+	}
+	for (ndInt32 i = 0; i < m_activeJointCount; ++i)
+	{
+		const ndInt32 color = m_jointColor[i];
+		m_colorJoints[colorMap[color]] = i;
+		colorMap[color] += (color == D_GS_MAX_COLORS) ? D_GS_WORK_GROUP : 1;
+	}
+}
+
+void ndDynamicsUpdateGaussSeidel::BuildMassMatrix()
+{
+	D_TRACKTIME();
+	ndScene* const scene = m_world->GetScene();
+	const ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
+	if (!m_colorCount)
+	{
+		return;
+	}
+
+	const ndInt32 groupCount = m_colorGroupStart[m_colorCount];
+	m_groupRowStart.SetCount(groupCount + 1);
+
+	ndInt32 rowCount = 0;
+	for (ndInt32 i = 0; i < groupCount; ++i)
+	{
+		ndInt32 maxRow = 0;
+		m_groupRowStart[i] = rowCount;
+		for (ndInt32 j = 0; j < D_GS_WORK_GROUP; ++j)
+		{
+			const ndInt32 index = m_colorJoints[i * D_GS_WORK_GROUP + j];
+			if (index >= 0)
+			{
+				maxRow = ndMax(maxRow, jointArray[index]->m_rowCount);
+			}
+		}
+		rowCount += maxRow;
+	}
+	m_groupRowStart[groupCount] = rowCount;
+	m_soaMassMatrix.SetCount(rowCount);
+
+	ndAtomic<ndInt32> iterator(0);
+	auto BuildMassMatrix = ndMakeObject::ndFunction([this, &iterator, &jointArray, groupCount](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(BuildMassMatrix);
+		const ndVector zero(ndVector::m_zero);
+		const ndLeftHandSide* const leftHandSide = &m_leftHandSide[0];
+		const ndRightHandSide* const rightHandSide = &m_rightHandSide[0];
+
+		ndLeftHandSide zeroRow;
+		zeroRow.m_Jt.m_jacobianM0.m_linear = zero;
+		zeroRow.m_Jt.m_jacobianM0.m_angular = zero;
+		zeroRow.m_Jt.m_jacobianM1.m_linear = zero;
+		zeroRow.m_Jt.m_jacobianM1.m_angular = zero;
+		zeroRow.m_JMinv = zeroRow.m_Jt;
+
+		for (ndInt32 i = iterator.fetch_add(D_WORKER_BATCH_SIZE); i < groupCount; i = iterator.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((groupCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : groupCount - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				const ndInt32 group = i + j;
+				const ndInt32* const jointIndex = &m_colorJoints[group * D_GS_WORK_GROUP];
+				const ndInt32 soaRowBase = m_groupRowStart[group];
+				const ndInt32 rowsCount = m_groupRowStart[group + 1] - soaRowBase;
+				for (ndInt32 k = 0; k < rowsCount; ++k)
+				{
+					ndVector tmp;
+					const ndLeftHandSide* rows[D_GS_WORK_GROUP];
+					const ndRightHandSide* rhsRows[D_GS_WORK_GROUP];
+					for (ndInt32 n = 0; n < D_GS_WORK_GROUP; ++n)
+					{
+						rows[n] = &zeroRow;
+						rhsRows[n] = nullptr;
+						if (jointIndex[n] >= 0)
+						{
+							const ndConstraint* const joint = jointArray[jointIndex[n]];
+							if (k < joint->m_rowCount)
+							{
+								rows[n] = &leftHandSide[joint->m_rowStart + k];
+								rhsRows[n] = &rightHandSide[joint->m_rowStart + k];
+							}
+						}
+					}
+
+					ndSoaMatrixElement& row = m_soaMassMatrix[soaRowBase + k];
+					ndVector::Transpose4x4(
+						row.m_Jt.m_jacobianM0.m_linear.m_x, row.m_Jt.m_jacobianM0.m_linear.m_y, row.m_Jt.m_jacobianM0.m_linear.m_z, tmp,
+						rows[0]->m_Jt.m_jacobianM0.m_linear, rows[1]->m_Jt.m_jacobianM0.m_linear, rows[2]->m_Jt.m_jacobianM0.m_linear, rows[3]->m_Jt.m_jacobianM0.m_linear);
+					ndVector::Transpose4x4(
+						row.m_Jt.m_jacobianM0.m_angular.m_x, row.m_Jt.m_jacobianM0.m_angular.m_y, row.m_Jt.m_jacobianM0.m_angular.m_z, tmp,
+						rows[0]->m_Jt.m_jacobianM0.m_angular, rows[1]->m_Jt.m_jacobianM0.m_angular, rows[2]->m_Jt.m_jacobianM0.m_angular, rows[3]->m_Jt.m_jacobianM0.m_angular);
+					ndVector::Transpose4x4(
+						row.m_Jt.m_jacobianM1.m_linear.m_x, row.m_Jt.m_jacobianM1.m_linear.m_y, row.m_Jt.m_jacobianM1.m_linear.m_z, tmp,
+						rows[0]->m_Jt.m_jacobianM1.m_linear, rows[1]->m_Jt.m_jacobianM1.m_linear, rows[2]->m_Jt.m_jacobianM1.m_linear, rows[3]->m_Jt.m_jacobianM1.m_linear);
+					ndVector::Transpose4x4(
+						row.m_Jt.m_jacobianM1.m_angular.m_x, row.m_Jt.m_jacobianM1.m_angular.m_y, row.m_Jt.m_jacobianM1.m_angular.m_z, tmp,
+						rows[0]->m_Jt.m_jacobianM1.m_angular, rows[1]->m_Jt.m_jacobianM1.m_angular, rows[2]->m_Jt.m_jacobianM1.m_angular, rows[3]->m_Jt.m_jacobianM1.m_angular);
+
+					ndVector::Transpose4x4(
+						row.m_JMinv.m_jacobianM0.m_linear.m_x, row.m_JMinv.m_jacobianM0.m_linear.m_y, row.m_JMinv.m_jacobianM0.m_linear.m_z, tmp,
+						rows[0]->m_JMinv.m_jacobianM0.m_linear, rows[1]->m_JMinv.m_jacobianM0.m_linear, rows[2]->m_JMinv.m_jacobianM0.m_linear, rows[3]->m_JMinv.m_jacobianM0.m_linear);
+					ndVector::Transpose4x4(
+						row.m_JMinv.m_jacobianM0.m_angular.m_x, row.m_JMinv.m_jacobianM0.m_angular.m_y, row.m_JMinv.m_jacobianM0.m_angular.m_z, tmp,
+						rows[0]->m_JMinv.m_jacobianM0.m_angular, rows[1]->m_JMinv.m_jacobianM0.m_angular, rows[2]->m_JMinv.m_jacobianM0.m_angular, rows[3]->m_JMinv.m_jacobianM0.m_angular);
+					ndVector::Transpose4x4(
+						row.m_JMinv.m_jacobianM1.m_linear.m_x, row.m_JMinv.m_jacobianM1.m_linear.m_y, row.m_JMinv.m_jacobianM1.m_linear.m_z, tmp,
+						rows[0]->m_JMinv.m_jacobianM1.m_linear, rows[1]->m_JMinv.m_jacobianM1.m_linear, rows[2]->m_JMinv.m_jacobianM1.m_linear, rows[3]->m_JMinv.m_jacobianM1.m_linear);
+					ndVector::Transpose4x4(
+						row.m_JMinv.m_jacobianM1.m_angular.m_x, row.m_JMinv.m_jacobianM1.m_angular.m_y, row.m_JMinv.m_jacobianM1.m_angular.m_z, tmp,
+						rows[0]->m_JMinv.m_jacobianM1.m_angular, rows[1]->m_JMinv.m_jacobianM1.m_angular, rows[2]->m_JMinv.m_jacobianM1.m_angular, rows[3]->m_JMinv.m_jacobianM1.m_angular);
+
+					row.m_force = zero;
+					row.m_diagDamp = zero;
+					row.m_invJinvMJt = zero;
+					row.m_coordenateAccel = zero;
+					row.m_normalForceIndex = m_ordinals;
+					row.m_lowerBoundFrictionCoefficent = zero;
+					row.m_upperBoundFrictionCoefficent = zero;
+
+					#ifdef D_NEWTON_USE_DOUBLE
+					ndInt64* const normalIndex = (ndInt64*)&row.m_normalForceIndex[0];
+					#else
+					ndInt32* const normalIndex = (ndInt32*)&row.m_normalForceIndex[0];
+					#endif
+					for (ndInt32 n = 0; n < D_GS_WORK_GROUP; ++n)
+					{
+						const ndRightHandSide* const rhs = rhsRows[n];
+						if (rhs)
+						{
+							// the Jacobi solvers scale the diagonal by the body weights,
+							// here each joint sees the true effective mass of its bodies.
+							const ndJacobian& JtM0 = rows[n]->m_Jt.m_jacobianM0;
+							const ndJacobian& JtM1 = rows[n]->m_Jt.m_jacobianM1;
+							const ndJacobian& JMinvM0 = rows[n]->m_JMinv.m_jacobianM0;
+							const ndJacobian& JMinvM1 = rows[n]->m_JMinv.m_jacobianM1;
+							const ndVector tmpDiag(
+								JMinvM0.m_linear * JtM0.m_linear + JMinvM0.m_angular * JtM0.m_angular +
+								JMinvM1.m_linear * JtM1.m_linear + JMinvM1.m_angular * JtM1.m_angular);
+							const ndFloat32 diag = tmpDiag.AddHorizontal().GetScalar();
+							ndAssert(diag > ndFloat32(0.0f));
+
+							row.m_force[n] = rhs->m_force;
+							row.m_diagDamp[n] = diag * rhs->m_diagonalRegularizer;
+							row.m_invJinvMJt[n] = ndFloat32(1.0f) / (diag * (ndFloat32(1.0f) + rhs->m_diagonalRegularizer));
+							row.m_coordenateAccel[n] = rhs->m_coordenateAccel;
+							normalIndex[n] = (rhs->m_normalForceIndex + 1) * D_GS_WORK_GROUP + n;
+							row.m_lowerBoundFrictionCoefficent[n] = rhs->m_lowerBoundFrictionCoefficent;
+							row.m_upperBoundFrictionCoefficent[n] = rhs->m_upperBoundFrictionCoefficent;
+						}
+					}
+				}
+			}
+		}
+	});
+
+	ndAtomic<ndInt32> iterator1(m_activeJointCount);
+	auto UpdateRestingJoints = ndMakeObject::ndFunction([this, &iterator1, &jointArray](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(UpdateRestingJoints);
+		ndRightHandSide* const rightHandSide = &m_rightHandSide[0];
+		const ndInt32 jointCount = ndInt32(jointArray.GetCount());
+		for (ndInt32 i = iterator1.fetch_add(D_WORKER_BATCH_SIZE); i < jointCount; i = iterator1.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((jointCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : jointCount - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				const ndConstraint* const joint = jointArray[i + j];
+				for (ndInt32 k = 0; k < joint->m_rowCount; ++k)
+				{
+					ndRightHandSide* const rhs = &rightHandSide[joint->m_rowStart + k];
+					rhs->m_maxImpact = ndAbs(rhs->m_force);
+				}
+			}
+		}
+	});
+
+	scene->ParallelExecute(BuildMassMatrix);
+	if (m_activeJointCount < ndInt32(jointArray.GetCount()))
+	{
+		scene->ParallelExecute(UpdateRestingJoints);
+	}
+}
+
+void ndDynamicsUpdateGaussSeidel::AccumulateJointsForce()
+{
+	D_TRACKTIME();
+	ndScene* const scene = m_world->GetScene();
+	const ndArray<ndBodyKinematic*>& bodyArray = scene->GetActiveBodyArray();
+	const ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
+
+	ndAtomic<ndInt32> iterator0(0);
+	auto CalculateJointsPartialForces = ndMakeObject::ndFunction([this, &iterator0, &jointArray](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(CalculateJointsPartialForces);
+		const ndVector zero(ndVector::m_zero);
+		ndJacobian* const jointPartialForces = &GetTempInternalForces()[0];
+		const ndInt32 jointCount = ndInt32(jointArray.GetCount());
+		for (ndInt32 i = iterator0.fetch_add(D_WORKER_BATCH_SIZE); i < jointCount; i = iterator0.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((jointCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : jointCount - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				const ndConstraint* const joint = jointArray[i + j];
+				ndVector forceM0(zero);
+				ndVector torqueM0(zero);
+				ndVector forceM1(zero);
+				ndVector torqueM1(zero);
+				for (ndInt32 k = 0; k < joint->m_rowCount; ++k)
+				{
+					const ndLeftHandSide* const lhs = &m_leftHandSide[joint->m_rowStart + k];
+					const ndVector f(m_rightHandSide[joint->m_rowStart + k].m_force);
+					forceM0 = forceM0.MulAdd(lhs->m_Jt.m_jacobianM0.m_linear, f);
+					torqueM0 = torqueM0.MulAdd(lhs->m_Jt.m_jacobianM0.m_angular, f);
+					forceM1 = forceM1.MulAdd(lhs->m_Jt.m_jacobianM1.m_linear, f);
+					torqueM1 = torqueM1.MulAdd(lhs->m_Jt.m_jacobianM1.m_angular, f);
+				}
+				jointPartialForces[(i + j) * 2 + 0].m_linear = forceM0;
+				jointPartialForces[(i + j) * 2 + 0].m_angular = torqueM0;
+				jointPartialForces[(i + j) * 2 + 1].m_linear = forceM1;
+				jointPartialForces[(i + j) * 2 + 1].m_angular = torqueM1;
+			}
+		}
+	});
+
+	ndAtomic<ndInt32> iterator1(0);
+	auto AccumulatePartialForces = ndMakeObject::ndFunction([this, &iterator1, &bodyArray](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(AccumulatePartialForces);
+		const ndVector zero(ndVector::m_zero);
+		ndJacobian* const internalForces = &GetInternalForces()[0];
+		const ndInt32* const bodyIndex = &GetJointForceIndexBuffer()[0];
+		const ndJacobian* const jointInternalForces = &GetTempInternalForces()[0];
+		const ndJointBodyPairIndex* const jointBodyPairIndexBuffer = &GetJointBodyPairIndexBuffer()[0];
+
+		const ndInt32 bodyCount = ndInt32(bodyArray.GetCount());
+		for (ndInt32 i = iterator1.fetch_add(D_WORKER_BATCH_SIZE); i < bodyCount; i = iterator1.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((bodyCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : bodyCount - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				ndVector force(zero);
+				ndVector torque(zero);
+				const ndInt32 m = i + j;
+				const ndBodyKinematic* const body = bodyArray[m];
+
+				const ndInt32 startIndex = bodyIndex[m];
+				const ndInt32 mask = body->m_isStatic - 1;
+				const ndInt32 count = mask & (bodyIndex[m + 1] - startIndex);
+				for (ndInt32 k = 0; k < count; ++k)
+				{
+					const ndInt32 index = jointBodyPairIndexBuffer[startIndex + k].m_joint;
+					force += jointInternalForces[index].m_linear;
+					torque += jointInternalForces[index].m_angular;
+				}
+				internalForces[m].m_linear = force;
+				internalForces[m].m_angular = torque;
+			}
+		}
+	});
+
+	scene->ParallelExecute(CalculateJointsPartialForces);
+	scene->ParallelExecute(AccumulatePartialForces);
+}
+
+void ndDynamicsUpdateGaussSeidel::SolveColor(ndInt32 color)
+{
+	ndScene* const scene = m_world->GetScene();
+	ndConstraint** const jointArray = &scene->GetActiveContactArray()[0];
+
+	auto JointForce = [this, jointArray](ndInt32 group)
+	{
+		const ndVector zero(ndVector::m_zero);
+		const ndInt32* const jointIndex = &m_colorJoints[group * D_GS_WORK_GROUP];
+		ndJacobian* const internalForces = &m_internalForces[0];
+
+		ndJacobian force0[D_GS_WORK_GROUP];
+		ndJacobian force1[D_GS_WORK_GROUP];
+		ndInt32 bodyIndex0[D_GS_WORK_GROUP];
+		ndInt32 bodyIndex1[D_GS_WORK_GROUP];
+		for (ndInt32 i = 0; i < D_GS_WORK_GROUP; ++i)
+		{
+			bodyIndex0[i] = -1;
+			bodyIndex1[i] = -1;
+			force0[i].m_linear = zero;
+			force0[i].m_angular = zero;
+			force1[i].m_linear = zero;
+			force1[i].m_angular = zero;
+			if (jointIndex[i] >= 0)
+			{
+				const ndConstraint* const joint = jointArray[jointIndex[i]];
+				const ndBodyKinematic* const body0 = joint->GetBody0();
+				const ndBodyKinematic* const body1 = joint->GetBody1();
+				if (!body0->m_isStatic)
+				{
+					bodyIndex0[i] = body0->m_index;
+					force0[i] = internalForces[body0->m_index];
+				}
+				if (!body1->m_isStatic)
+				{
+					bodyIndex1[i] = body1->m_index;
+					force1[i] = internalForces[body1->m_index];
+				}
+			}
+		}
+
+		ndVector tmp;
+		ndSoaVector6 forceM0;
+		ndSoaVector6 forceM1;
+		ndVector::Transpose4x4(forceM0.m_linear.m_x, forceM0.m_linear.m_y, forceM0.m_linear.m_z, tmp,
+			force0[0].m_linear, force0[1].m_linear, force0[2].m_linear, force0[3].m_linear);
+		ndVector::Transpose4x4(forceM0.m_angular.m_x, forceM0.m_angular.m_y, forceM0.m_angular.m_z, tmp,
+			force0[0].m_angular, force0[1].m_angular, force0[2].m_angular, force0[3].m_angular);
+		ndVector::Transpose4x4(forceM1.m_linear.m_x, forceM1.m_linear.m_y, forceM1.m_linear.m_z, tmp,
+			force1[0].m_linear, force1[1].m_linear, force1[2].m_linear, force1[3].m_linear);
+		ndVector::Transpose4x4(forceM1.m_angular.m_x, forceM1.m_angular.m_y, forceM1.m_angular.m_z, tmp,
+			force1[0].m_angular, force1[1].m_angular, force1[2].m_angular, force1[3].m_angular);
+
+		const ndInt32 rowStart = m_groupRowStart[group];
+		const ndInt32 rowsCount = m_groupRowStart[group + 1] - rowStart;
+		ndSoaMatrixElement* const massMatrix = &m_soaMassMatrix[rowStart];
+
+		ndVector normalForce[D_CONSTRAINT_MAX_ROWS + 1];
+		normalForce[0] = ndVector::m_one;
+		for (ndInt32 j = 0; j < rowsCount; ++j)
+		{
+			normalForce[j + 1] = massMatrix[j].m_force;
+		}
+
+		auto SolveRows = [massMatrix, rowsCount, &normalForce, &forceM0, &forceM1, &zero]()
+		{
+			ndVector accNorm(zero);
+			for (ndInt32 j = 0; j < rowsCount; ++j)
+			{
+				const ndSoaMatrixElement* const row = &massMatrix[j];
+
+				ndVector a(row->m_JMinv.m_jacobianM0.m_linear.m_x * forceM0.m_linear.m_x);
+				a = a.MulAdd(row->m_JMinv.m_jacobianM0.m_linear.m_y, forceM0.m_linear.m_y);
+				a = a.MulAdd(row->m_JMinv.m_jacobianM0.m_linear.m_z, forceM0.m_linear.m_z);
+				a = a.MulAdd(row->m_JMinv.m_jacobianM0.m_angular.m_x, forceM0.m_angular.m_x);
+				a = a.MulAdd(row->m_JMinv.m_jacobianM0.m_angular.m_y, forceM0.m_angular.m_y);
+				a = a.MulAdd(row->m_JMinv.m_jacobianM0.m_angular.m_z, forceM0.m_angular.m_z);
+
+				a = a.MulAdd(row->m_JMinv.m_jacobianM1.m_linear.m_x, forceM1.m_linear.m_x);
+				a = a.MulAdd(row->m_JMinv.m_jacobianM1.m_linear.m_y, forceM1.m_linear.m_y);
+				a = a.MulAdd(row->m_JMinv.m_jacobianM1.m_linear.m_z, forceM1.m_linear.m_z);
+				a = a.MulAdd(row->m_JMinv.m_jacobianM1.m_angular.m_x, forceM1.m_angular.m_x);
+				a = a.MulAdd(row->m_JMinv.m_jacobianM1.m_angular.m_y, forceM1.m_angular.m_y);
+				a = a.MulAdd(row->m_JMinv.m_jacobianM1.m_angular.m_z, forceM1.m_angular.m_z);
+
+				const ndVector force(normalForce[j + 1]);
+				a = row->m_coordenateAccel.MulSub(force, row->m_diagDamp) - a;
+				ndVector f(force.MulAdd(row->m_invJinvMJt, a));
+
+				const ndVector frictionNormal(&normalForce[0].m_x, row->m_normalForceIndex.m_i);
+				const ndVector lowerFrictionForce(frictionNormal * row->m_lowerBoundFrictionCoefficent);
+				const ndVector upperFrictionForce(frictionNormal * row->m_upperBoundFrictionCoefficent);
+
+				a = a & (f < upperFrictionForce) & (f > lowerFrictionForce);
+				accNorm = accNorm.MulAdd(a, a);
+
+				f = f.GetMax(lowerFrictionForce).GetMin(upperFrictionForce);
+				normalForce[j + 1] = f;
+
+				// the bodies of a color belong to only one joint, so the force goes straight to them.
+				const ndVector deltaForce(f - force);
+				forceM0.m_linear.m_x = forceM0.m_linear.m_x.MulAdd(row->m_Jt.m_jacobianM0.m_linear.m_x, deltaForce);
+				forceM0.m_linear.m_y = forceM0.m_linear.m_y.MulAdd(row->m_Jt.m_jacobianM0.m_linear.m_y, deltaForce);
+				forceM0.m_linear.m_z = forceM0.m_linear.m_z.MulAdd(row->m_Jt.m_jacobianM0.m_linear.m_z, deltaForce);
+				forceM0.m_angular.m_x = forceM0.m_angular.m_x.MulAdd(row->m_Jt.m_jacobianM0.m_angular.m_x, deltaForce);
+				forceM0.m_angular.m_y = forceM0.m_angular.m_y.MulAdd(row->m_Jt.m_jacobianM0.m_angular.m_y, deltaForce);
+				forceM0.m_angular.m_z = forceM0.m_angular.m_z.MulAdd(row->m_Jt.m_jacobianM0.m_angular.m_z, deltaForce);
+
+				forceM1.m_linear.m_x = forceM1.m_linear.m_x.MulAdd(row->m_Jt.m_jacobianM1.m_linear.m_x, deltaForce);
+				forceM1.m_linear.m_y = forceM1.m_linear.m_y.MulAdd(row->m_Jt.m_jacobianM1.m_linear.m_y, deltaForce);
+				forceM1.m_linear.m_z = forceM1.m_linear.m_z.MulAdd(row->m_Jt.m_jacobianM1.m_linear.m_z, deltaForce);
+				forceM1.m_angular.m_x = forceM1.m_angular.m_x.MulAdd(row->m_Jt.m_jacobianM1.m_angular.m_x, deltaForce);
+				forceM1.m_angular.m_y = forceM1.m_angular.m_y.MulAdd(row->m_Jt.m_jacobianM1.m_angular.m_y, deltaForce);
+				forceM1.m_angular.m_z = forceM1.m_angular.m_z.MulAdd(row->m_Jt.m_jacobianM1.m_angular.m_z, deltaForce);
+			}
+			return accNorm;
+		};
+
+		const ndFloat32 tol = ndFloat32(0.125f);
+		const ndFloat32 tol2 = tol * tol;
+		ndVector maxAccel(SolveRows());
+		for (ndInt32 k = 0; (k < 4) && (maxAccel.GetMax().GetScalar() > tol2); ++k)
+		{
+			maxAccel = SolveRows();
+		}
+
+		for (ndInt32 j = 0; j < rowsCount; ++j)
+		{
+			massMatrix[j].m_force = normalForce[j + 1];
+		}
+
+		ndVector::Transpose4x4(force0[0].m_linear, force0[1].m_linear, force0[2].m_linear, force0[3].m_linear,
+			forceM0.m_linear.m_x, forceM0.m_linear.m_y, forceM0.m_linear.m_z, zero);
+		ndVector::Transpose4x4(force0[0].m_angular, force0[1].m_angular, force0[2].m_angular, force0[3].m_angular,
+			forceM0.m_angular.m_x, forceM0.m_angular.m_y, forceM0.m_angular.m_z, zero);
+		ndVector::Transpose4x4(force1[0].m_linear, force1[1].m_linear, force1[2].m_linear, force1[3].m_linear,
+			forceM1.m_linear.m_x, forceM1.m_linear.m_y, forceM1.m_linear.m_z, zero);
+		ndVector::Transpose4x4(force1[0].m_angular, force1[1].m_angular, force1[2].m_angular, force1[3].m_angular,
+			forceM1.m_angular.m_x, forceM1.m_angular.m_y, forceM1.m_angular.m_z, zero);
+
+		for (ndInt32 i = 0; i < D_GS_WORK_GROUP; ++i)
+		{
+			if (bodyIndex0[i] >= 0)
+			{
+				internalForces[bodyIndex0[i]] = force0[i];
+			}
+			if (bodyIndex1[i] >= 0)
+			{
+				internalForces[bodyIndex1[i]] = force1[i];
+			}
+		}
+	};
+
+	const ndInt32 groupStart = m_colorGroupStart[color];
+	const ndInt32 groupCount = m_colorGroupStart[color + 1] - groupStart;
+	if ((color == m_serialColor) || (groupCount < D_GS_MIN_PARALLEL_GROUPS))
+	{
+		// too little work to wake up the workers, or joints that must go one at a time.
+		for (ndInt32 i = 0; i < groupCount; ++i)
+		{
+			JointForce(groupStart + i);
+		}
+	}
+	else
+	{
+		ndAtomic<ndInt32> iterator(0);
+		auto SolveColorGroups = ndMakeObject::ndFunction([&iterator, &JointForce, groupStart, groupCount](ndInt32, ndInt32)
+		{
+			D_TRACKTIME_NAMED(SolveColorGroups);
+			for (ndInt32 i = iterator.fetch_add(D_GS_BATCH_SIZE); i < groupCount; i = iterator.fetch_add(D_GS_BATCH_SIZE))
+			{
+				const ndInt32 maxSpan = ((groupCount - i) >= D_GS_BATCH_SIZE) ? D_GS_BATCH_SIZE : groupCount - i;
+				for (ndInt32 j = 0; j < maxSpan; ++j)
+				{
+					JointForce(groupStart + i + j);
+				}
+			}
+		});
+		scene->ParallelExecute(SolveColorGroups);
+	}
+}
+
+void ndDynamicsUpdateGaussSeidel::CalculateJointsForce()
+{
+	D_TRACKTIME();
+	ndScene* const scene = m_world->GetScene();
+	const ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
+
+	if (m_world->m_activeSkeletons.GetCount())
+	{
+		// the skeletons add their reaction forces to the bodies after each
+		// sub step, so the joint forces have to be gathered again.
+		AccumulateJointsForce();
+	}
+
+	const ndInt32 groupCount = m_colorGroupStart[m_colorCount];
+
+	ndAtomic<ndInt32> iterator0(0);
+	auto UpdateAcceleration = ndMakeObject::ndFunction([this, &iterator0, &jointArray, groupCount](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(UpdateAcceleration);
+		const ndRightHandSide* const rightHandSide = &m_rightHandSide[0];
+		for (ndInt32 i = iterator0.fetch_add(D_WORKER_BATCH_SIZE); i < groupCount; i = iterator0.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((groupCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : groupCount - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				const ndInt32 group = i + j;
+				const ndInt32* const jointIndex = &m_colorJoints[group * D_GS_WORK_GROUP];
+				ndSoaMatrixElement* const massMatrix = &m_soaMassMatrix[m_groupRowStart[group]];
+				for (ndInt32 k = 0; k < D_GS_WORK_GROUP; ++k)
+				{
+					if (jointIndex[k] >= 0)
+					{
+						const ndConstraint* const joint = jointArray[jointIndex[k]];
+						for (ndInt32 n = 0; n < joint->m_rowCount; ++n)
+						{
+							massMatrix[n].m_coordenateAccel[k] = rightHandSide[joint->m_rowStart + n].m_coordenateAccel;
+						}
+					}
+				}
+			}
+		}
+	});
+
+	ndAtomic<ndInt32> iterator1(0);
+	auto UpdateJointsForce = ndMakeObject::ndFunction([this, &iterator1, &jointArray, groupCount](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(UpdateJointsForce);
+		ndRightHandSide* const rightHandSide = &m_rightHandSide[0];
+		for (ndInt32 i = iterator1.fetch_add(D_WORKER_BATCH_SIZE); i < groupCount; i = iterator1.fetch_add(D_WORKER_BATCH_SIZE))
+		{
+			const ndInt32 maxSpan = ((groupCount - i) >= D_WORKER_BATCH_SIZE) ? D_WORKER_BATCH_SIZE : groupCount - i;
+			for (ndInt32 j = 0; j < maxSpan; ++j)
+			{
+				const ndInt32 group = i + j;
+				const ndInt32* const jointIndex = &m_colorJoints[group * D_GS_WORK_GROUP];
+				const ndSoaMatrixElement* const massMatrix = &m_soaMassMatrix[m_groupRowStart[group]];
+				for (ndInt32 k = 0; k < D_GS_WORK_GROUP; ++k)
+				{
+					if (jointIndex[k] >= 0)
+					{
+						const ndConstraint* const joint = jointArray[jointIndex[k]];
+						for (ndInt32 n = 0; n < joint->m_rowCount; ++n)
+						{
+							ndRightHandSide* const rhs = &rightHandSide[joint->m_rowStart + n];
+							rhs->m_force = massMatrix[n].m_force[k];
+							rhs->m_maxImpact = ndMax(ndAbs(rhs->m_force), rhs->m_maxImpact);
+						}
+					}
+				}
+			}
+		}
+	});
+
+	scene->ParallelExecute(UpdateAcceleration);
+	for (ndUnsigned32 i = 0; i < m_solverPasses; ++i)
+	{
+		for (ndInt32 j = 0; j < m_colorCount; ++j)
+		{
+			SolveColor(j);
+		}
+	}
+	scene->ParallelExecute(UpdateJointsForce);
+}
+
+void ndDynamicsUpdateGaussSeidel::CalculateForces()
+{
+	D_TRACKTIME();
+	if (m_world->GetScene()->GetActiveContactArray().GetCount())
+	{
+		m_firstPassCoef = ndFloat32(0.0f);
+
+		InitSkeletons();
+		for (ndInt32 step = 0; step < 4; step++)
+		{
+			CalculateJointsAcceleration();
+			if (m_colorCount)
+			{
+				CalculateJointsForce();
+			}
+			UpdateSkeletons();
+			IntegrateBodiesVelocity();
+		}
+
+		UpdateForceFeedback();
+	}
+}
+
+void ndDynamicsUpdateGaussSeidel::Update()
+{
+	D_TRACKTIME();
+	m_timestep = m_world->GetScene()->GetTimestep();
+
+	BuildIsland();
+	IntegrateUnconstrainedBodies();
+	InitWeights();
+	ColorJoints();
+	InitBodyArray();
+	InitJacobianMatrix();
+	BuildMassMatrix();
+	CalculateForces();
+	IntegrateBodies();
+	DetermineSleepStates();
+}
@@ -0,0 +1,64 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __ND_WORLD_DYNAMICS_UPDATE_GAUSS_SEIDEL_H__
+#define __ND_WORLD_DYNAMICS_UPDATE_GAUSS_SEIDEL_H__
+
+#include "ndNewtonStdafx.h"
+#include "ndDynamicsUpdateSoa.h"
+
+// the joints are colored so that no two joints of the same color share a dynamic body.
+// the colors are solved one after another, and the joints of one color are solved in parallel
+// in groups of four, each joint applying its forces to the bodies as soon as it is solved.
+// this is a true Gauss Seidel iteration, so it needs far fewer passes than the
+// weighted Jacobi iteration of the other solvers to reach the same stiffness.
+D_MSV_NEWTON_ALIGN_32
+class ndDynamicsUpdateGaussSeidel: public ndDynamicsUpdate
+{
+	public:
+	ndDynamicsUpdateGaussSeidel(ndWorld* const world);
+	virtual ~ndDynamicsUpdateGaussSeidel();
+
+	virtual const char* GetStringId() const;
+
+	protected:
+	virtual void Update();
+
+	private:
+	void ColorJoints();
+	void CalculateForces();
+	void BuildMassMatrix();
+	void CalculateJointsForce();
+	void AccumulateJointsForce();
+	void SolveColor(ndInt32 color);
+
+	ndVector m_ordinals;
+	ndArray<ndInt32> m_jointColor;
+	ndArray<ndInt32> m_colorJoints;
+	ndArray<ndInt32> m_groupRowStart;
+	ndArray<ndInt32> m_colorGroupStart;
+	ndArray<ndUnsigned64> m_bodyColorMask;
+	ndArray<ndSoa::ndSoaMatrixElement> m_soaMassMatrix;
+	ndInt32 m_colorCount;
+	ndInt32 m_serialColor;
+} D_GCC_NEWTON_ALIGN_32;
+
+#endif
@@ -0,0 +1,409 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndWorld.h"
+#include "ndBodyDynamic.h"
+#include "ndSkeletonList.h"
+#include "ndDynamicsUpdateIsland.h"
+
+#define D_ISLAND_MAX_SMALL_JOINTS	64
+#define D_ISLAND_DEFAULT_BUFFER_SIZE	1024
+
+ndDynamicsUpdateIsland::ndDynamicsUpdateIsland(ndWorld* const world)
+	:ndDynamicsUpdate(world)
+	,m_bodySlot(D_ISLAND_DEFAULT_BUFFER_SIZE)
+	,m_islandBodies(D_ISLAND_DEFAULT_BUFFER_SIZE)
+	,m_smallIslands(D_ISLAND_DEFAULT_BUFFER_SIZE)
+	,m_jointBodySlots(D_ISLAND_DEFAULT_BUFFER_SIZE)
+	,m_islandBodyStart(D_ISLAND_DEFAULT_BUFFER_SIZE)
+	,m_islandForces(D_ISLAND_DEFAULT_BUFFER_SIZE)
+	,m_largeIslandCount(0)
+{
+}
+
+ndDynamicsUpdateIsland::~ndDynamicsUpdateIsland()
+{
+	Clear();
+
+	m_bodySlot.Resize(D_ISLAND_DEFAULT_BUFFER_SIZE);
+	m_islandBodies.Resize(D_ISLAND_DEFAULT_BUFFER_SIZE);
+	m_smallIslands.Resize(D_ISLAND_DEFAULT_BUFFER_SIZE);
+	m_jointBodySlots.Resize(D_ISLAND_DEFAULT_BUFFER_SIZE);
+	m_islandBodyStart.Resize(D_ISLAND_DEFAULT_BUFFER_SIZE);
+	m_islandForces.Resize(D_ISLAND_DEFAULT_BUFFER_SIZE);
+}
+
+const char* ndDynamicsUpdateIsland::GetStringId() const
+{
+	return "island";
+}
+
+void ndDynamicsUpdateIsland::ReorderIslands()
+{
+	D_TRACKTIME();
+	m_largeIslandCount = 0;
+	m_smallIslands.SetCount(0);
+	m_islandBodies.SetCount(0);
+	m_islandBodyStart.SetCount(0);
+
+	ndScene* const scene = m_world->GetScene();
+	ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
+	const ndInt32 jointCount = ndInt32(jointArray.GetCount());
+	const ndInt32 islandCount = ndInt32(m_islands.GetCount());
+	if (!islandCount)
+	{
+		return;
+	}
+
+	// move the joints of each island together, each island keeps 
+	// the moving before resting and the rows count order of the joints.
+	ndConstraint** const tempJointBuffer = scene->GetFrameArena().Alloc<ndConstraint*>(jointCount);
+	for (ndInt32 i = 0; i < jointCount; ++i)
+	{
+		tempJointBuffer[i] = jointArray[m_islandJoints[i]];
+	}
+
+	ndInt32 rowCount = 1;
+	for (ndInt32 i = 0; i < jointCount; ++i)
+	{
+		ndConstraint* const joint = tempJointBuffer[i];
+		jointArray[i] = joint;
+		m_islandJoints[i] = i;
+		joint->m_rowStart = rowCount;
+		rowCount += joint->m_rowCount;
+	}
+	ndAssert(rowCount == m_rightHandSide.GetCount());
+
+	// the moving joints are no longer the front of the array, they are 
+	// spread over the islands, so from here on all the joints count as active.
+	m_activeJointCount = jointCount;
+
+	// the joint indices changed, so the body joint pairs have to be enumerated again.
+	SortBodyJointScan();
+
+	const ndInt32 bodyCount = ndInt32(scene->GetActiveBodyArray().GetCount());
+	m_bodySlot.SetCount(bodyCount);
+	for (ndInt32 i = 0; i < bodyCount; ++i)
+	{
+		m_bodySlot[i] = -1;
+	}
+
+	// each dynamic body gets a slot in the body range of its island, static bodies get none.
+	m_jointBodySlots.SetCount(jointCount * 2);
+	m_islandBodyStart.SetCount(islandCount + 1);
+	for (ndInt32 i = 0; i < islandCount; ++i)
+	{
+		const ndIsland& island = m_islands[i];
+		const ndInt32 bodyStart = ndInt32(m_islandBodies.GetCount());
+		m_islandBodyStart[i] = bodyStart;
+		for (ndInt32 j = 0; j < island.m_count; ++j)
+		{
+			const ndInt32 jointIndex = island.m_start + j;
+			const ndConstraint* const joint = jointArray[jointIndex];
+			m_jointIsland[jointIndex] = i;
+
+			const ndBodyKinematic* const bodies[] = { joint->GetBody0(), joint->GetBody1() };
+			for (ndInt32 k = 0; k < 2; ++k)
+			{
+				const ndBodyKinematic* const body = bodies[k];
+				ndInt32 slot = -1;
+				if (!body->m_isStatic)
+				{
+					slot = m_bodySlot[body->m_index];
+					if (slot == -1)
+					{
+						slot = ndInt32(m_islandBodies.GetCount()) - bodyStart;
+						m_bodySlot[body->m_index] = slot;
+						m_islandBodies.PushBack(body->m_index);
+					}
+				}
+				m_jointBodySlots[jointIndex * 2 + k] = slot;
+			}
+		}
+
+		if (island.m_count <= D_ISLAND_MAX_SMALL_JOINTS)
+		{
+			m_smallIslands.PushBack(i);
+		}
+		else
+		{
+			m_largeIslandCount++;
+		}
+	}
+	m_islandBodyStart[islandCount] = ndInt32(m_islandBodies.GetCount());
+	m_islandForces.SetCount(m_islandBodies.GetCount());
+}
+
+void ndDynamicsUpdateIsland::SolveSmallIslands()
+{
+	D_TRACKTIME();
+	ndScene* const scene = m_world->GetScene();
+	const ndInt32 passes = ndInt32(m_solverPasses);
+	const ndArray<ndConstraint*>& jointArray = scene->GetActiveContactArray();
+
+	ndAtomic<ndInt32> iterator(0);
+	auto SolveIslands = ndMakeObject::ndFunction([this, &iterator, &jointArray, passes](ndInt32, ndInt32)
+	{
+		D_TRACKTIME_NAMED(SolveIslands);
+		const ndVector zero(ndVector::m_zero);
+		ndJacobian* const jointPartialForces = &GetTempInternalForces()[0];
+
+		// same weighted Jacobi joint kernel than the default solver, 
+		// but reading the body forces from the slots of the island.
+		auto JointForce = [this, &jointArray, jointPartialForces, &zero](ndInt32 jointIndex, const ndJacobian* const bodyForces)
+		{
+			ndVector accNorm(zero);
+			ndFloat32 residual = ndFloat32(0.0f);
+			const ndConstraint* const joint = jointArray[jointIndex];
+			const ndBodyKinematic* const body0 = joint->GetBody0();
+			const ndBodyKinematic* const body1 = joint->GetBody1();
+			const ndInt32 slot0 = m_jointBodySlots[jointIndex * 2 + 0];
+			const ndInt32 slot1 = m_jointBodySlots[jointIndex * 2 + 1];
+
+			const ndInt32 rowStart = joint->m_rowStart;
+			const ndInt32 rowsCount = joint->m_rowCount;
+
+			const ndInt32 resting = body0->m_equilibrium0 & body1->m_equilibrium0;
+			if (!resting)
+			{
+				const ndVector preconditioner0(body0->m_weigh);
+				const ndVector preconditioner1(body1->m_weigh);
+
+				ndVector forceM0((slot0 >= 0) ? bodyForces[slot0].m_linear : zero);
+				ndVector torqueM0((slot0 >= 0) ? bodyForces[slot0].m_angular : zero);
+				ndVector forceM1((slot1 >= 0) ? bodyForces[slot1].m_linear : zero);
+				ndVector torqueM1((slot1 >= 0) ? bodyForces[slot1].m_angular : zero);
+
+				for (ndInt32 j = 0; j < rowsCount; ++j)
+				{
+					ndRightHandSide* const rhs = &m_rightHandSide[rowStart + j];
+					const ndLeftHandSide* const lhs = &m_leftHandSide[rowStart + j];
+					const ndVector force(rhs->m_force);
+
+					ndVector a(lhs->m_JMinv.m_jacobianM0.m_linear * forceM0);
+					a = a.MulAdd(lhs->m_JMinv.m_jacobianM0.m_angular, torqueM0);
+					a = a.MulAdd(lhs->m_JMinv.m_jacobianM1.m_linear, forceM1);
+					a = a.MulAdd(lhs->m_JMinv.m_jacobianM1.m_angular, torqueM1);
+					a = ndVector(rhs->m_coordenateAccel - rhs->m_force * rhs->m_diagDamp) - a.AddHorizontal();
+
+					ndAssert(rhs->m_normalForceIndexFlat >= 0);
+					ndVector f(force + a.Scale(rhs->m_invJinvMJt));
+					const ndInt32 frictionIndex = rhs->m_normalForceIndexFlat;
+					const ndFloat32 frictionNormal = m_rightHandSide[frictionIndex].m_force;
+					const ndVector lowerFrictionForce(frictionNormal * rhs->m_lowerBoundFrictionCoefficent);
+					const ndVector upperFrictionForce(frictionNormal * rhs->m_upperBoundFrictionCoefficent);
+
+					a = a & (f < upperFrictionForce) & (f > lowerFrictionForce);
+					accNorm = accNorm.MulAdd(a, a);
+
+					f = f.GetMax(lowerFrictionForce).GetMin(upperFrictionForce);
+					rhs->m_force = f.GetScalar();
+
+					const ndVector deltaForce(f - force);
+					const ndVector deltaForce0(deltaForce * preconditioner0);
+					const ndVector deltaForce1(deltaForce * preconditioner1);
+					forceM0 = forceM0.MulAdd(lhs->m_Jt.m_jacobianM0.m_linear, deltaForce0);
+					torqueM0 = torqueM0.MulAdd(lhs->m_Jt.m_jacobianM0.m_angular, deltaForce0);
+					forceM1 = forceM1.MulAdd(lhs->m_Jt.m_jacobianM1.m_linear, deltaForce1);
+					torqueM1 = torqueM1.MulAdd(lhs->m_Jt.m_jacobianM1.m_angular, deltaForce1);
+				}
+
+				const ndFloat32 tol = ndFloat32(0.125f);
+				const ndFloat32 tol2 = tol * tol;
+
+				residual = accNorm.GetScalar();
+				ndVector maxAccel(accNorm);
+				for (ndInt32 k = 0; (k < 4) && (maxAccel.GetScalar() > tol2); ++k)
+				{
+					maxAccel = zero;
+					for (ndInt32 j = 0; j < rowsCount; ++j)
+					{
+						ndRightHandSide* const rhs = &m_rightHandSide[rowStart + j];
+						const ndLeftHandSide* const lhs = &m_leftHandSide[rowStart + j];
+						const ndVector force(rhs->m_force);
+
+						ndVector a(lhs->m_JMinv.m_jacobianM0.m_linear * forceM0);
+						a = a.MulAdd(lhs->m_JMinv.m_jacobianM0.m_angular, torqueM0);
+						a = a.MulAdd(lhs->m_JMinv.m_jacobianM1.m_linear, forceM1);
+						a = a.MulAdd(lhs->m_JMinv.m_jacobianM1.m_angular, torqueM1);
+						a = ndVector(rhs->m_coordenateAccel - rhs->m_force * rhs->m_diagDamp) - a.AddHorizontal();
+
+						ndAssert(rhs->m_normalForceIndexFlat >= 0);
+						ndVector f(force + a.Scale(rhs->m_invJinvMJt));
+						const ndInt32 frictionIndex = rhs->m_normalForceIndexFlat;
+						const ndFloat32 frictionNormal = m_rightHandSide[frictionIndex].m_force;
+						const ndVector lowerFrictionForce(frictionNormal * rhs->m_lowerBoundFrictionCoefficent);
+						const ndVector upperFrictionForce(frictionNormal * rhs->m_upperBoundFrictionCoefficent);
+
+						a = a & (f < upperFrictionForce) & (f > lowerFrictionForce);
+						maxAccel = maxAccel.MulAdd(a, a);
+
+						f = f.GetMax(lowerFrictionForce).GetMin(upperFrictionForce);
+						rhs->m_force = f.GetScalar();
+
+						const ndVector deltaForce(f - force);
+						const ndVector deltaForce0(deltaForce * preconditioner0);
+						const ndVector deltaForce1(deltaForce * preconditioner1);
+						forceM0 = forceM0.MulAdd(lhs->m_Jt.m_jacobianM0.m_linear, deltaForce0);
+						torqueM0 = torqueM0.MulAdd(lhs->m_Jt.m_jacobianM0.m_angular, deltaForce0);
+						forceM1 = forceM1.MulAdd(lhs->m_Jt.m_jacobianM1.m_linear, deltaForce1);
+						torqueM1 = torqueM1.MulAdd(lhs->m_Jt.m_jacobianM1.m_angular, deltaForce1);
+					}
+				}
+			}
+
+			ndVector forceM0(zero);
+			ndVector torqueM0(zero);
+			ndVector forceM1(zero);
+			ndVector torqueM1(zero);
+			for (ndInt32 j = 0; j < rowsCount; ++j)
+			{
+				ndRightHandSide* const rhs = &m_rightHandSide[rowStart + j];
+				const ndLeftHandSide* const lhs = &m_leftHandSide[rowStart + j];
+
+				const ndVector f(rhs->m_force);
+				forceM0 = forceM0.MulAdd(lhs->m_Jt.m_jacobianM0.m_linear, f);
+				torqueM0 = torqueM0.MulAdd(lhs->m_Jt.m_jacobianM0.m_angular, f);
+				forceM1 = forceM1.MulAdd(lhs->m_Jt.m_jacobianM1.m_linear, f);
+				torqueM1 = torqueM1.MulAdd(lhs->m_Jt.m_jacobianM1.m_angular, f);
+				rhs->m_maxImpact = ndMax(ndAbs(f.GetScalar()), rhs->m_maxImpact);
+			}
+
+			ndJacobian& outBody0 = jointPartialForces[jointIndex * 2 + 0];
+			outBody0.m_linear = forceM0;
+			outBody0.m_angular = torqueM0;
+
+			ndJacobian& outBody1 = jointPartialForces[jointIndex * 2 + 1];
+			outBody1.m_linear = forceM1;
+			outBody1.m_angular = torqueM1;
+			return residual;
+		};
+
+		const ndFloat32 tol = ndFloat32(0.125f);
+		const ndFloat32 tol2 = tol * tol;
+		const ndInt32 islandCount = ndInt32(m_smallIslands.GetCount());
+		for (ndInt32 i = iterator++; i < islandCount; i = iterator++)
+		{
+			const ndInt32 islandIndex = m_smallIslands[i];
+			ndIsland& island = m_islands[islandIndex];
+			const ndInt32 bodyStart = m_islandBodyStart[islandIndex];
+			const ndInt32 bodyCount = m_islandBodyStart[islandIndex + 1] - bodyStart;
+			ndJacobian* const bodyForces = &m_islandForces[bodyStart];
+			const ndInt32* const islandBodies = &m_islandBodies[bodyStart];
+
+			for (ndInt32 j = 0; j < bodyCount; ++j)
+			{
+				bodyForces[j] = m_internalForces[islandBodies[j]];
+			}
+
+			ndInt32 pass = 0;
+			ndFloat32 residual = ndFloat32(0.0f);
+			do
+			{
+				residual = ndFloat32(0.0f);
+				for (ndInt32 j = 0; j < island.m_count; ++j)
+				{
+					residual = ndMax(residual, JointForce(island.m_start + j, bodyForces));
+				}
+
+				for (ndInt32 j = 0; j < bodyCount; ++j)
+				{
+					bodyForces[j].m_linear = zero;
+					bodyForces[j].m_angular = zero;
+				}
+				for (ndInt32 j = 0; j < island.m_count; ++j)
+				{
+					const ndInt32 jointIndex = island.m_start + j;
+					for (ndInt32 k = 0; k < 2; ++k)
+					{
+						const ndInt32 slot = m_jointBodySlots[jointIndex * 2 + k];
+						if (slot >= 0)
+						{
+							const ndJacobian& partialForce = jointPartialForces[jointIndex * 2 + k];
+							bodyForces[slot].m_linear += partialForce.m_linear;
+							bodyForces[slot].m_angular += partialForce.m_angular;
+						}
+					}
+				}
+				pass++;
+			} while ((pass < passes) && ((pass < D_ISLAND_MIN_PASSES) || (residual >= tol2)));
+
+			for (ndInt32 j = 0; j < bodyCount; ++j)
+			{
+				m_internalForces[islandBodies[j]] = bodyForces[j];
+			}
+
+			island.m_stepPasses = pass;
+			island.m_stepConverged = 1;
+			island.m_residual = ndMax(island.m_residual, residual);
+			island.m_passes = ndMax(island.m_passes, pass);
+		}
+	});
+
+	if (m_smallIslands.GetCount())
+	{
+		scene->ParallelExecute(SolveIslands);
+	}
+}
+
+void ndDynamicsUpdateIsland::CalculateForces()
+{
+	D_TRACKTIME();
+	if (m_world->GetScene()->GetActiveContactArray().GetCount())
+	{
+		m_firstPassCoef = ndFloat32(0.0f);
+
+		InitSkeletons();
+		for (ndInt32 step = 0; step < 4; step++)
+		{
+			CalculateJointsAcceleration();
+			ResetIslands();
+			SolveSmallIslands();
+			if (m_largeIslandCount)
+			{
+				// the small islands are marked as converged, so the wide passes skip their joints.
+				CalculateJointsForce();
+			}
+			UpdateSkeletons();
+			IntegrateBodiesVelocity();
+		}
+		UpdateForceFeedback();
+	}
+}
+
+void ndDynamicsUpdateIsland::Update()
+{
+	D_TRACKTIME();
+	m_timestep = m_world->GetScene()->GetTimestep();
+
+	BuildIsland();
+	IntegrateUnconstrainedBodies();
+	InitWeights();
+	BuildJointIslands();
+	ReorderIslands();
+	InitBodyArray();
+	InitJacobianMatrix();
+	CalculateForces();
+	IntegrateBodies();
+	DetermineSleepStates();
+}
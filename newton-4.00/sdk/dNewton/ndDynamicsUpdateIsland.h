@@ -0,0 +1,59 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __ND_WORLD_DYNAMICS_UPDATE_ISLAND_H__
+#define __ND_WORLD_DYNAMICS_UPDATE_ISLAND_H__
+
+#include "ndNewtonStdafx.h"
+#include "ndDynamicsUpdate.h"
+
+// the joints are reordered so that the joints and the rows of each island are contiguous,
+// and each island gets a contiguous copy of the forces of its bodies.
+// the small islands are solved start to end by one thread each, with all their data 
+// in the cache of that thread, and the large islands are solved by all threads 
+// together, one pass at a time, like the default solver.
+D_MSV_NEWTON_ALIGN_32
+class ndDynamicsUpdateIsland: public ndDynamicsUpdate
+{
+	public:
+	ndDynamicsUpdateIsland(ndWorld* const world);
+	virtual ~ndDynamicsUpdateIsland();
+
+	virtual const char* GetStringId() const;
+
+	protected:
+	virtual void Update();
+
+	private:
+	void CalculateForces();
+	void ReorderIslands();
+	void SolveSmallIslands();
+
+	ndArray<ndInt32> m_bodySlot;
+	ndArray<ndInt32> m_islandBodies;
+	ndArray<ndInt32> m_smallIslands;
+	ndArray<ndInt32> m_jointBodySlots;
+	ndArray<ndInt32> m_islandBodyStart;
+	ndArray<ndJacobian> m_islandForces;
+	ndInt32 m_largeIslandCount;
+} D_GCC_NEWTON_ALIGN_32;
+
+#endif
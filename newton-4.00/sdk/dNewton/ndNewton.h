@@ -31,6 +31,8 @@
 #include <ndWorld.h>
 #include <ndJointList.h>
 #include <ndWorldScene.h>
+#include <ndWorldScheduler.h>
+#include <ndUpdateStatistics.h>
 #include <ndConstraint.h>
 #include <ndBodyNotify.h>
 #include <ndBodyDynamic.h>
@@ -42,6 +44,7 @@
 #include <ndDynamicsUpdate.h>
 #include <ndSkeletonContainer.h>
 #include <ndDynamicsUpdateSoa.h>
+#include <ndDynamicsUpdateGaussSeidel.h>
 
 #include <dJoints/ndJointGear.h>
 #include <dJoints/ndJointHinge.h>
@@ -0,0 +1,99 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndUpdateStatistics.h"
+
+const char* ndUpdateStatistics::GetPhaseName(ndPhase phase)
+{
+	static const char* const names[] =
+	{
+		"balanceScene",
+		"updateSkeletons",
+		"applyExtForce",
+		"initBodyArray",
+		"findCollidingPairs",
+		"createNewContacts",
+		"calculateContacts",
+		"calculateCompoundContacts",
+		"calculateContinueContacts",
+		"deleteDeadContacts",
+		"advanceContacts",
+		"updateSpecial",
+		"modelUpdate",
+		"solver",
+		"modelPostUpdate",
+		"particleUpdate",
+		"updateTransforms",
+	};
+	ndAssert(sizeof(names) / sizeof(names[0]) == m_phaseCount);
+	return ((phase >= 0) && (phase < m_phaseCount)) ? names[phase] : "";
+}
+
+void ndUpdateStatistics::BeginFrame(ndInt32 threadCount, ndInt32 subSteps)
+{
+	ndFrame& frame = GetCurrentFrame();
+	memset(&frame, 0, sizeof(frame));
+	frame.m_threadCount = threadCount;
+	frame.m_subSteps = subSteps;
+}
+
+void ndUpdateStatistics::EndFrame(ndUnsigned64 frameNumber, ndUnsigned64 startTime, const ndThreadPool& threadPool)
+{
+	ndFrame& frame = GetCurrentFrame();
+	frame.m_frameNumber = frameNumber;
+	frame.m_totalTime = ndUnsigned32(ndGetTimeInMicroseconds() - startTime);
+
+	ndUnsigned64 busyTime = 0;
+	ndUnsigned64 maxBusyTime = 0;
+	for (ndInt32 i = 0; i < threadPool.GetThreadCount(); ++i)
+	{
+		const ndUnsigned64 threadTime = threadPool.GetBusyTime(i);
+		busyTime += threadTime;
+		maxBusyTime = ndMax(maxBusyTime, threadTime);
+	}
+	frame.m_threadsBusyTime = ndUnsigned32(busyTime);
+	frame.m_maxThreadBusyTime = ndUnsigned32(maxBusyTime);
+
+	m_index = (m_index + 1) % D_UPDATE_STATISTICS_FRAMES;
+	m_frameCount = ndMin(m_frameCount + 1, ndInt32(D_UPDATE_STATISTICS_FRAMES));
+}
+
+ndFloat32 ndUpdateStatistics::GetAverageTime(ndPhase phase) const
+{
+	ndUnsigned64 time = 0;
+	for (ndInt32 i = 0; i < m_frameCount; ++i)
+	{
+		time += GetFrame(i).m_phaseTime[phase];
+	}
+	return m_frameCount ? ndFloat32(time) * ndFloat32(1.0e-3f) / ndFloat32(m_frameCount) : ndFloat32(0.0f);
+}
+
+ndFloat32 ndUpdateStatistics::GetAverageTotalTime() const
+{
+	ndUnsigned64 time = 0;
+	for (ndInt32 i = 0; i < m_frameCount; ++i)
+	{
+		time += GetFrame(i).m_totalTime;
+	}
+	return m_frameCount ? ndFloat32(time) * ndFloat32(1.0e-3f) / ndFloat32(m_frameCount) : ndFloat32(0.0f);
+}
@@ -0,0 +1,154 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __ND_UPDATE_STATISTICS_H__
+#define __ND_UPDATE_STATISTICS_H__
+
+#include "ndNewtonStdafx.h"
+
+#define D_UPDATE_STATISTICS_FRAMES	64
+
+/// Always available timing and counters of the world update.
+/// \brief Unlike the D_TRACKTIME profiler zones, these do not require a profiler 
+/// build. The world records the time spent in each phase of the update, 
+/// summed over all sub steps, together with a few counters, in a ring buffer 
+/// of the last D_UPDATE_STATISTICS_FRAMES updates. 
+/// The cost is one clock read per phase and two per parallel job.
+class ndUpdateStatistics
+{
+	public:
+	enum ndPhase
+	{
+		m_balanceScene,
+		m_updateSkeletons,
+		m_applyExtForce,
+		m_initBodyArray,
+		m_findCollidingPairs,
+		m_createNewContacts,
+		m_calculateContacts,
+		m_calculateCompoundContacts,
+		m_calculateContinueContacts,
+		m_deleteDeadContacts,
+		m_advanceContacts,
+		m_updateSpecial,
+		m_modelUpdate,
+		m_solver,
+		m_modelPostUpdate,
+		m_particleUpdate,
+		m_updateTransforms,
+		m_phaseCount,
+	};
+
+	class ndFrame
+	{
+		public:
+		ndUnsigned64 m_frameNumber;
+		ndUnsigned32 m_totalTime;
+		ndUnsigned32 m_phaseTime[m_phaseCount];
+
+		// time all threads spent executing parallel jobs, and the busiest thread
+		ndUnsigned32 m_threadsBusyTime;
+		ndUnsigned32 m_maxThreadBusyTime;
+		ndInt32 m_threadCount;
+
+		// counters of the last sub step
+		ndInt32 m_subSteps;
+		ndInt32 m_solverPasses;
+		ndInt32 m_bodyCount;
+		ndInt32 m_newPairCount;
+		ndInt32 m_contactCount;
+		ndInt32 m_narrowPhaseCount;
+		ndInt32 m_skippedPairCount;
+		ndInt32 m_continuePairCount;
+		ndInt32 m_compoundPairCount;
+		ndInt32 m_compoundChildPairCount;
+		ndInt32 m_activeConstraintCount;
+
+		// joint islands of the last sub step, only filled by the solvers 
+		// that iterate each island to its own convergence.
+		ndInt32 m_islandCount;
+		ndInt32 m_islandMinPasses;
+		ndInt32 m_islandMaxPasses;
+		ndFloat32 m_islandMaxResidual;
+	};
+
+	ndUpdateStatistics();
+
+	/// number of recorded frames, up to D_UPDATE_STATISTICS_FRAMES
+	ndInt32 GetFrameCount() const;
+
+	/// recorded frame, zero is the last completed update. all times are in microseconds.
+	const ndFrame& GetFrame(ndInt32 age) const;
+
+	/// average time of a phase over the recorded frames, in milliseconds
+	D_NEWTON_API ndFloat32 GetAverageTime(ndPhase phase) const;
+
+	/// average total update time over the recorded frames, in milliseconds
+	D_NEWTON_API ndFloat32 GetAverageTotalTime() const;
+
+	D_NEWTON_API static const char* GetPhaseName(ndPhase phase);
+
+	private:
+	void BeginFrame(ndInt32 threadCount, ndInt32 subSteps);
+	void EndFrame(ndUnsigned64 frameNumber, ndUnsigned64 startTime, const ndThreadPool& threadPool);
+	ndUnsigned64 AddPhaseTime(ndPhase phase, ndUnsigned64 startTime);
+	ndFrame& GetCurrentFrame();
+
+	ndFrame m_frames[D_UPDATE_STATISTICS_FRAMES];
+	ndInt32 m_frameCount;
+	ndInt32 m_index;
+
+	friend class ndWorld;
+};
+
+inline ndUpdateStatistics::ndUpdateStatistics()
+	:m_frameCount(0)
+	,m_index(0)
+{
+	memset(m_frames, 0, sizeof(m_frames));
+}
+
+inline ndInt32 ndUpdateStatistics::GetFrameCount() const
+{
+	return m_frameCount;
+}
+
+inline const ndUpdateStatistics::ndFrame& ndUpdateStatistics::GetFrame(ndInt32 age) const
+{
+	ndAssert(age >= 0);
+	ndAssert(age < m_frameCount);
+	return m_frames[(m_index - 1 - age + 2 * D_UPDATE_STATISTICS_FRAMES) % D_UPDATE_STATISTICS_FRAMES];
+}
+
+inline ndUpdateStatistics::ndFrame& ndUpdateStatistics::GetCurrentFrame()
+{
+	return m_frames[m_index];
+}
+
+inline ndUnsigned64 ndUpdateStatistics::AddPhaseTime(ndPhase phase, ndUnsigned64 startTime)
+{
+	const ndUnsigned64 time = ndGetTimeInMicroseconds();
+	ndFrame& frame = GetCurrentFrame();
+	frame.m_phaseTime[phase] += ndUnsigned32(time - startTime);
+	return time;
+}
+
+#endif
@@ -28,6 +28,8 @@
 #include "dModels/ndModel.h"
 #include "ndDynamicsUpdate.h"
 #include "ndDynamicsUpdateSoa.h"
+#include "ndDynamicsUpdateIsland.h"
+#include "ndDynamicsUpdateGaussSeidel.h"
 #include "dModels/ndModelNotify.h"
 #include "ndJointBilateralConstraint.h"
 
@@ -36,12 +38,25 @@
 	#include "ndDynamicsUpdateAvx2.h"
 #endif
 
+#ifdef _D_USE_AVX512_SOLVER
+	#include "ndWorldSceneAvx512.h"
+	#include "ndDynamicsUpdateAvx512.h"
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <intrin.h>
+#endif
+
 #ifdef _D_NEWTON_CUDA
 	#include "ndCudaUtils.h"
 	#include "ndWorldSceneCuda.h"
 	#include "ndDynamicsUpdateCuda.h"
 #endif
 
+// the world whose update runs on the calling thread, the queries issued 
+// from its callbacks can not wait for that same update to finish.
+static thread_local const ndWorld* g_updatingWorld = nullptr;
+
 class ndSkeletonQueue : public ndFixSizeArray<ndSkeletonContainer::ndNode*, 1024 * 4>
 {
 	public:
@@ -115,7 +130,7 @@ ndWorld::ndWorld()
 	,m_subSteps(1)
 	,m_solverMode(ndStandardSolver)
 	,m_solverIterations(4)
-	,m_inUpdate(false)
+	,m_collideOnce(false)
 {
 	// start the engine thread;
 	ndBody::m_uniqueIdCount = 0;
@@ -248,6 +263,16 @@ void ndWorld::SetSubSteps(ndInt32 subSteps)
 	m_subSteps = ndClamp(subSteps, 1, 16);
 }
 
+bool ndWorld::GetCollideOnce() const
+{
+	return m_collideOnce;
+}
+
+void ndWorld::SetCollideOnce(bool state)
+{
+	m_collideOnce = state;
+}
+
 ndScene* ndWorld::GetScene() const
 {
 	return m_scene;
@@ -318,6 +343,16 @@ ndFloat32 ndWorld::GetAverageUpdateTime() const
 	return m_averageUpdateTime;
 }
 
+const ndArray<ndDynamicsUpdate::ndIsland>& ndWorld::GetSolverIslands() const
+{
+	return ((const ndDynamicsUpdate*)m_solver)->GetIslands();
+}
+
+const ndUpdateStatistics& ndWorld::GetUpdateStatistics() const
+{
+	return m_statistics;
+}
+
 ndUnsigned32 ndWorld::GetFrameNumber() const
 {
 	return m_scene->m_frameNumber;
@@ -493,32 +528,49 @@ void ndWorld::ThreadFunction()
 	D_TRACKTIME();
 	ndUnsigned64 timeAcc = ndGetTimeInMicroseconds();
 
-	m_inUpdate = true;
+	const ndWorld* const callerWorld = g_updatingWorld;
+	g_updatingWorld = this;
 	m_scene->Begin();
 	DeleteDeferredObjects();
 
-	//m_inUpdate = true;
-	//m_scene->Begin();
-
 	m_scene->SetTimestep(m_timestep);
 
 	PreUpdate(m_timestep);
 
 	ndInt32 const steps = m_subSteps;
+	m_statistics.BeginFrame(m_scene->GetThreadCount(), steps);
+	m_scene->ResetBusyTime();
+
 	ndFloat32 timestep = m_timestep / (ndFloat32)steps;
 	for (ndInt32 i = 0; i < steps; ++i)
 	{
-		SubStepUpdate(timestep);
+		SubStepUpdate(timestep, i);
 	}
 
 	m_scene->SetTimestep(m_timestep);
 		
+	ndUnsigned64 time = ndGetTimeInMicroseconds();
+	if (m_collideOnce && (steps > 1))
+	{
+		// the sub steps after the first one moved the bodies without the 
+		// collision system, so the queries would see the boxes of the first one.
+		m_scene->UpdateBodyBoxes();
+		time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_initBodyArray, time);
+	}
 	ParticleUpdate(m_timestep);
+	time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_particleUpdate, time);
 		
 	UpdateTransforms();
+	m_statistics.AddPhaseTime(ndUpdateStatistics::m_updateTransforms, time);
+	m_statistics.EndFrame(GetFrameNumber(), timeAcc, *m_scene);
+
 	PostModelTransform();
 	PostUpdate(m_timestep);
-	m_inUpdate = false;
+
+	// all transient buffers of this update are released at once
+	m_scene->m_contactScratchArray = nullptr;
+	m_scene->m_frameArena.Reset();
+	g_updatingWorld = callerWorld;
 
 	m_scene->End();
 	
@@ -542,44 +594,114 @@ void ndWorld::CalculateAverageUpdateTime()
 	}
 }
 
-void ndWorld::SubStepUpdate(ndFloat32 timestep)
+void ndWorld::SubStepUpdate(ndFloat32 timestep, ndInt32 subStep)
 {
 	D_TRACKTIME();
 
 	// do physics step
 	OnSubStepPreUpdate(timestep);
 
-	m_scene->m_lru = m_scene->m_lru + 1;
+	// in collide once mode only the first sub step runs the collision system, 
+	// the contacts it finds have to hold for the motion of the whole update.
+	const bool speculative = m_collideOnce && (m_subSteps > 1);
+	const bool collide = !speculative || (subStep == 0);
+
 	m_scene->SetTimestep(timestep);
+	ndUnsigned64 time = ndGetTimeInMicroseconds();
+	if (collide)
+	{
+		m_scene->m_lru = m_scene->m_lru + 1;
+		m_scene->BalanceScene();
+		time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_balanceScene, time);
+	}
 
-	m_scene->BalanceScene();
 	// update skeletons topologies
 	UpdateSkeletons();
+	time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_updateSkeletons, time);
 
 	m_scene->ApplyExtForce();
-	m_scene->InitBodyArray();
+	time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_applyExtForce, time);
 
-	// update the collision system
-	m_scene->FindCollidingPairs();
-	m_scene->CreateNewContacts();
-	m_scene->CalculateContacts();
-	m_scene->DeleteDeadContacts();
+	ndInt32 newPairCount = 0;
+	if (collide)
+	{
+		m_scene->SetTimestep(speculative ? m_timestep : timestep);
+		m_scene->m_speculativeContacts = speculative;
+
+		m_scene->InitBodyArray();
+		time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_initBodyArray, time);
+
+		// update the collision system
+		m_scene->FindCollidingPairs();
+		time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_findCollidingPairs, time);
+		newPairCount = ndInt32(m_scene->m_newPairs.GetCount());
+		m_scene->CreateNewContacts();
+		time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_createNewContacts, time);
+		m_scene->CalculateContacts();
+		time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_calculateContacts, time);
+		m_scene->CalculateCompoundContacts();
+		time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_calculateCompoundContacts, time);
+		m_scene->CalculateContinueContacts();
+		time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_calculateContinueContacts, time);
+		m_scene->DeleteDeadContacts();
+		time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_deleteDeadContacts, time);
+
+		m_scene->m_speculativeContacts = false;
+		m_scene->SetTimestep(timestep);
+	}
+	else
+	{
+		m_scene->PrepareBodyArray();
+		time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_initBodyArray, time);
+		m_scene->AdvanceContacts();
+		time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_advanceContacts, time);
+	}
 
 	// update all special bodies.
 	m_scene->UpdateSpecial();
+	time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_updateSpecial, time);
 
 	// Update Particle base physics
 	//ParticleUpdate();
 
 	// Update all models
 	ModelUpdate();
+	time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_modelUpdate, time);
 
 	// calculate internal forces, integrate bodies and update matrices.
 	ndAssert(m_solver);
 	m_solver->Update();
+	time = m_statistics.AddPhaseTime(ndUpdateStatistics::m_solver, time);
 
 	// second pass on models
 	ModelPostUpdate();
+	m_statistics.AddPhaseTime(ndUpdateStatistics::m_modelPostUpdate, time);
+
+	ndUpdateStatistics::ndFrame& frame = m_statistics.GetCurrentFrame();
+	frame.m_solverPasses = ndInt32(m_solver->m_solverPasses);
+	frame.m_bodyCount = ndInt32(m_scene->GetActiveBodyArray().GetCount());
+	frame.m_contactCount = ndInt32(m_scene->GetContactArray().GetCount());
+	if (collide)
+	{
+		frame.m_newPairCount = newPairCount;
+		m_scene->GetNarrowPhaseCount(frame.m_narrowPhaseCount, frame.m_skippedPairCount);
+		frame.m_continuePairCount = ndInt32(m_scene->m_continueContactArray.GetCount());
+		m_scene->GetCompoundPairCount(frame.m_compoundPairCount, frame.m_compoundChildPairCount);
+	}
+	frame.m_activeConstraintCount = m_solver->m_activeJointCount;
+
+	const ndArray<ndDynamicsUpdate::ndIsland>& islands = m_solver->GetIslands();
+	frame.m_islandCount = ndInt32(islands.GetCount());
+	frame.m_islandMinPasses = 0;
+	frame.m_islandMaxPasses = 0;
+	frame.m_islandMaxResidual = ndFloat32(0.0f);
+	for (ndInt32 i = 0; i < frame.m_islandCount; ++i)
+	{
+		const ndDynamicsUpdate::ndIsland& island = islands[i];
+		frame.m_islandMinPasses = i ? ndMin(frame.m_islandMinPasses, island.m_passes) : island.m_passes;
+		frame.m_islandMaxPasses = ndMax(frame.m_islandMaxPasses, island.m_passes);
+		frame.m_islandMaxResidual = ndMax(frame.m_islandMaxResidual, island.m_residual);
+	}
 
 
 	OnSubStepPostUpdate(timestep);
@@ -961,6 +1083,101 @@ void ndWorld::BodiesInAabb(ndBodiesInAabbNotify& callback, const ndVector& minBo
 	m_scene->BodiesInAabb(callback, minBox, maxBox);
 }
 
+bool ndWorld::BeginBatchQuery() const
+{
+	if ((g_updatingWorld == this) || (ndThreadPool::GetCurrentThreadPool() == m_scene))
+	{
+		// issued from an update callback, the workers are already running
+		return false;
+	}
+	// any other thread waits for a pending asynchronous update before it reads the scene
+	Sync();
+	m_scene->ndThreadPool::Begin();
+	return true;
+}
+
+void ndWorld::EndBatchQuery(bool startedWorkers) const
+{
+	if (startedWorkers)
+	{
+		m_scene->ndThreadPool::End();
+	}
+}
+
+void ndWorld::RayCastBatch(const ndVector* const origins, const ndVector* const dests, const ndUnsigned64* const filterMasks, ndInt32 count, ndRayCastHit* const hits) const
+{
+	const bool startedWorkers = BeginBatchQuery();
+	m_scene->RayCastBatch(origins, dests, filterMasks, count, hits);
+	EndBatchQuery(startedWorkers);
+}
+
+void ndWorld::OverlapBatch(const ndVector* const minBoxes, const ndVector* const maxBoxes, ndInt32 count, ndArray<const ndBody*>& bodies, ndInt32* const bodyStart) const
+{
+	const bool startedWorkers = BeginBatchQuery();
+	m_scene->OverlapBatch(minBoxes, maxBoxes, count, bodies, bodyStart);
+	EndBatchQuery(startedWorkers);
+}
+
+void ndWorld::ConvexCastBatch(const ndShapeInstance* const* const shapes, const ndMatrix* const origins, const ndVector* const dests, ndInt32 count, ndConvexCastHit* const hits) const
+{
+	const bool startedWorkers = BeginBatchQuery();
+	m_scene->ConvexCastBatch(shapes, origins, dests, count, hits);
+	EndBatchQuery(startedWorkers);
+}
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+static bool ndHasAvx2()
+{
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool fma = (info[2] & (1 << 12)) != 0;
+	if (!(osxsave && fma) || ((_xgetbv(0) & 0x06) != 0x06))
+	{
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+}
+
+static bool ndHasAvx512()
+{
+	if (!ndHasAvx2() || ((_xgetbv(0) & 0xe6) != 0xe6))
+	{
+		return false;
+	}
+	int info[4];
+	__cpuidex(info, 7, 0);
+	const int avx512f_dq = (1 << 16) | (1 << 17);
+	return (info[1] & avx512f_dq) == avx512f_dq;
+}
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+static bool ndHasAvx2()
+{
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+static bool ndHasAvx512()
+{
+	return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+}
+#else
+static bool ndHasAvx2()
+{
+	return false;
+}
+
+static bool ndHasAvx512()
+{
+	return false;
+}
+#endif
+
 void ndWorld::SelectSolver(ndSolverModes solverMode)
 {
 	if (solverMode != m_solverMode)
@@ -980,23 +1197,46 @@ void ndWorld::SelectSolver(ndSolverModes solverMode)
 				break;
 			}
 
-			case ndSimdAvx2Solver:
+			case ndSimdAvx512Solver:
 			{
-				#ifdef _D_USE_AVX2_SOLVER
-					ndWorldScene* const newScene = new ndWorldSceneAvx2(*((ndWorldScene*)m_scene));
+				// the wide solvers are built into the library, but only selected 
+				// when the cpu can run them, otherwise try the next narrower one.
+				#ifdef _D_USE_AVX512_SOLVER
+				if (ndHasAvx512())
+				{
+					ndWorldScene* const newScene = new ndWorldSceneAvx512(*((ndWorldScene*)m_scene));
 					delete m_scene;
 					m_scene = newScene;
 
 					m_solverMode = solverMode;
-					m_solver = new ndDynamicsUpdateAvx2(this);
-				#else
-					ndWorldScene* const newScene = new ndWorldScene(*((ndWorldScene*)m_scene));
+					m_solver = new ndDynamicsUpdateAvx512(this);
+					break;
+				}
+				#endif
+			}
+			// fall through
+
+			case ndSimdAvx2Solver:
+			{
+				#ifdef _D_USE_AVX2_SOLVER
+				if (ndHasAvx2())
+				{
+					ndWorldScene* const newScene = new ndWorldSceneAvx2(*((ndWorldScene*)m_scene));
 					delete m_scene;
 					m_scene = newScene;
 
-					m_solverMode = ndSimdSoaSolver;
-					m_solver = new ndDynamicsUpdateSoa(this);
+					m_solverMode = ndSimdAvx2Solver;
+					m_solver = new ndDynamicsUpdateAvx2(this);
+					break;
+				}
 				#endif
+
+				ndWorldScene* const newScene = new ndWorldScene(*((ndWorldScene*)m_scene));
+				delete m_scene;
+				m_scene = newScene;
+
+				m_solverMode = ndSimdSoaSolver;
+				m_solver = new ndDynamicsUpdateSoa(this);
 				break;
 			}
 
@@ -1032,6 +1272,28 @@ void ndWorld::SelectSolver(ndSolverModes solverMode)
 				break;
 			}
 
+			case ndGaussSeidelSolver:
+			{
+				ndWorldScene* const newScene = new ndWorldScene(*((ndWorldScene*)m_scene));
+				delete m_scene;
+				m_scene = newScene;
+
+				m_solverMode = solverMode;
+				m_solver = new ndDynamicsUpdateGaussSeidel(this);
+				break;
+			}
+
+			case ndIslandSolver:
+			{
+				ndWorldScene* const newScene = new ndWorldScene(*((ndWorldScene*)m_scene));
+				delete m_scene;
+				m_scene = newScene;
+
+				m_solverMode = solverMode;
+				m_solver = new ndDynamicsUpdateIsland(this);
+				break;
+			}
+
 			case ndStandardSolver:
 			default:
 			{
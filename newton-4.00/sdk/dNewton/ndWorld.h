@@ -25,14 +25,18 @@
 #include "ndNewtonStdafx.h"
 #include "ndJointList.h"
 #include "ndSkeletonList.h"
+#include "ndDynamicsUpdate.h"
+#include "ndUpdateStatistics.h"
 #include "dModels/ndModelList.h"
 
 class ndWorld;
 class ndModel;
 class ndJointList;
 class ndBodyDynamic;
+class ndRayCastHit;
 class ndRayCastNotify;
 class ndDynamicsUpdate;
+class ndConvexCastHit;
 class ndConvexCastNotify;
 class ndBodiesInAabbNotify;
 class ndJointBilateralConstraint;
@@ -52,6 +56,9 @@ class ndWorld: public ndClassAlloc
 		ndSimdSoaSolver,
 		ndSimdAvx2Solver,
 		ndCudaSolver,
+		ndGaussSeidelSolver,
+		ndSimdAvx512Solver,
+		ndIslandSolver,
 	};
 
 	D_BASE_CLASS_REFLECTION(ndWorld)
@@ -73,6 +80,12 @@ class ndWorld: public ndClassAlloc
 	D_NEWTON_API ndInt32 GetSubSteps() const;
 	D_NEWTON_API void SetSubSteps(ndInt32 subSteps);
 
+	/// when set, the broad and narrow phase run once per update with speculative contacts that
+	/// cover the whole update, and the sub steps only move those contacts with the bodies and
+	/// run the solver. off by default, it pays off for many sub steps of jointed bodies.
+	D_NEWTON_API bool GetCollideOnce() const;
+	D_NEWTON_API void SetCollideOnce(bool state);
+
 	D_NEWTON_API ndSolverModes GetSelectedSolver() const;
 	D_NEWTON_API void SelectSolver(ndSolverModes solverMode);
 
@@ -108,6 +121,13 @@ class ndWorld: public ndClassAlloc
 	D_NEWTON_API ndUnsigned32 GetSubFrameNumber() const;
 	D_NEWTON_API ndFloat32 GetAverageUpdateTime() const;
 
+	/// per phase timings and counters of the last updates, available in all builds.
+	D_NEWTON_API const ndUpdateStatistics& GetUpdateStatistics() const;
+
+	/// joint islands of the last sub step, with the passes and the residual each one 
+	/// needed to converge. empty for the solvers that do not iterate by island.
+	D_NEWTON_API const ndArray<ndDynamicsUpdate::ndIsland>& GetSolverIslands() const;
+
 	D_NEWTON_API ndContactNotify* GetContactNotify() const;
 	D_NEWTON_API void SetContactNotify(ndContactNotify* const notify);
 
@@ -119,11 +139,25 @@ class ndWorld: public ndClassAlloc
 	D_NEWTON_API bool RayCast(ndRayCastNotify& callback, const ndVector& globalOrigin, const ndVector& globalDest) const;
 	D_NEWTON_API bool ConvexCast(ndConvexCastNotify& callback, const ndShapeInstance& convexShape, const ndMatrix& globalOrigin, const ndVector& globalDest) const;
 
+	/// closest hits of many rays at once, hits[i] receives the result of the ray from origins[i] to dests[i].
+	/// filterMasks can be null, otherwise shapes with a non zero material user id are only hit by
+	/// rays whose mask shares a bit with it. can be called between updates or from update callbacks.
+	D_NEWTON_API void RayCastBatch(const ndVector* const origins, const ndVector* const dests, const ndUnsigned64* const filterMasks, ndInt32 count, ndRayCastHit* const hits) const;
+
+	/// bodies overlapping each box, packed in query order. bodyStart needs count + 1 entries, the bodies 
+	/// of box i are bodies[bodyStart[i]] up to bodies[bodyStart[i + 1] - 1].
+	D_NEWTON_API void OverlapBatch(const ndVector* const minBoxes, const ndVector* const maxBoxes, ndInt32 count, ndArray<const ndBody*>& bodies, ndInt32* const bodyStart) const;
+
+	/// closest contact of each convex shape swept from origins[i] to dests[i].
+	D_NEWTON_API void ConvexCastBatch(const ndShapeInstance* const* const shapes, const ndMatrix* const origins, const ndVector* const dests, ndInt32 count, ndConvexCastHit* const hits) const;
+
 	D_NEWTON_API void CalculateJointContacts(ndContact* const contact);
 
 	private:
 	void ThreadFunction();
 	void DeleteDeferredObjects();
+	bool BeginBatchQuery() const;
+	void EndBatchQuery(bool startedWorkers) const;
 	
 	protected:
 	D_NEWTON_API virtual void UpdateSkeletons();
@@ -159,7 +193,7 @@ class ndWorld: public ndClassAlloc
 	void ModelUpdate();
 	void ModelPostUpdate();
 	void CalculateAverageUpdateTime();
-	void SubStepUpdate(ndFloat32 timestep);
+	void SubStepUpdate(ndFloat32 timestep, ndInt32 subStep);
 	void ParticleUpdate(ndFloat32 timestep);
 
 	bool SkeletonJointTest(ndJointBilateralConstraint* const jointA) const;
@@ -184,22 +218,26 @@ class ndWorld: public ndClassAlloc
 	ndFloat32 m_averageFramesCount;
 	ndFloat32 m_lastExecutionTime;
 	dgSolverProgressiveSleepEntry m_sleepTable[D_SLEEP_ENTRIES];
+	ndUpdateStatistics m_statistics;
 
 	ndInt32 m_subSteps;
 	ndSolverModes m_solverMode;
 	ndInt32 m_solverIterations;
-	bool m_inUpdate;
+	bool m_collideOnce;
 	D_MEMORY_ALIGN_FIXUP
 	
 	friend class ndScene;
 	friend class ndIkSolver;
 	friend class ndWorldScene;
+	friend class ndWorldScheduler;
 	friend class ndBodyDynamic;
 	friend class ndDynamicsUpdate;
 	friend class ndSkeletonContainer;
 	friend class ndModelArticulation;
 	friend class ndDynamicsUpdateSoa;
+	friend class ndDynamicsUpdateGaussSeidel;
 	friend class ndDynamicsUpdateAvx2;
+	friend class ndDynamicsUpdateAvx512;
 	friend class ndDynamicsUpdateCuda;
 } D_GCC_NEWTON_ALIGN_32;
 
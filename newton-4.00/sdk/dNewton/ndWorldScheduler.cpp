@@ -0,0 +1,176 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndWorld.h"
+#include "ndWorldScheduler.h"
+
+ndWorldScheduler::ndWorldScheduler()
+	:ndThreadPool("newtonScheduler")
+	,m_worlds()
+	,m_schedule()
+	,m_timestep(ndFloat32(0.0f))
+	,m_lastExecutionTime(ndFloat32(0.0f))
+{
+	SetThreadCount(GetMaxThreads());
+}
+
+ndWorldScheduler::~ndWorldScheduler()
+{
+	Sync();
+	Finish();
+}
+
+ndInt32 ndWorldScheduler::Find(const ndWorld* const world) const
+{
+	for (ndInt32 i = 0; i < ndInt32(m_worlds.GetCount()); ++i)
+	{
+		if (m_worlds[i].m_world == world)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+ndInt32 ndWorldScheduler::GetWorldCount() const
+{
+	return ndInt32(m_worlds.GetCount());
+}
+
+void ndWorldScheduler::AddWorld(ndWorld* const world, ndInt32 priority)
+{
+	Sync();
+	ndAssert(Find(world) == -1);
+	if (Find(world) == -1)
+	{
+		// the world must be idle, and its phases will run on the scheduler workers
+		world->Sync();
+		world->SetThreadCount(1);
+
+		ndScheduledWorld entry;
+		entry.m_world = world;
+		entry.m_priority = priority;
+		m_worlds.PushBack(entry);
+	}
+}
+
+void ndWorldScheduler::RemoveWorld(ndWorld* const world)
+{
+	Sync();
+	const ndInt32 index = Find(world);
+	ndAssert(index >= 0);
+	if (index >= 0)
+	{
+		m_worlds[index] = m_worlds[m_worlds.GetCount() - 1];
+		m_worlds.SetCount(m_worlds.GetCount() - 1);
+	}
+}
+
+void ndWorldScheduler::SetPriority(ndWorld* const world, ndInt32 priority)
+{
+	Sync();
+	const ndInt32 index = Find(world);
+	ndAssert(index >= 0);
+	if (index >= 0)
+	{
+		m_worlds[index].m_priority = priority;
+	}
+}
+
+void ndWorldScheduler::Sync()
+{
+	ndThreadPool::Sync();
+}
+
+void ndWorldScheduler::Update(ndFloat32 timestep)
+{
+	// wait until previous update complete.
+	Sync();
+
+	m_timestep = timestep;
+	TickOne();
+}
+
+ndFloat32 ndWorldScheduler::GetUpdateTime() const
+{
+	return m_lastExecutionTime;
+}
+
+void ndWorldScheduler::ThreadFunction()
+{
+	D_TRACKTIME();
+	ndUnsigned64 timeAcc = ndGetTimeInMicroseconds();
+
+	class ndCompareWorlds
+	{
+		public:
+		ndCompareWorlds(void* const)
+		{
+		}
+
+		ndInt32 Compare(const ndScheduledWorld& entryA, const ndScheduledWorld& entryB) const
+		{
+			if (entryA.m_priority != entryB.m_priority)
+			{
+				return (entryA.m_priority > entryB.m_priority) ? -1 : 1;
+			}
+			const ndFloat32 timeA = entryA.m_world->GetUpdateTime();
+			const ndFloat32 timeB = entryB.m_world->GetUpdateTime();
+			if (timeA > timeB)
+			{
+				return -1;
+			}
+			return (timeA < timeB) ? 1 : 0;
+		}
+	};
+
+	m_schedule.SetCount(0);
+	for (ndInt32 i = 0; i < ndInt32(m_worlds.GetCount()); ++i)
+	{
+		m_schedule.PushBack(m_worlds[i]);
+	}
+
+	const ndInt32 worldCount = ndInt32(m_schedule.GetCount());
+	if (worldCount)
+	{
+		ndSort<ndScheduledWorld, ndCompareWorlds>(&m_schedule[0], worldCount, nullptr);
+
+		Begin();
+		// one world at the time, in schedule order
+		ndAtomic<ndInt32> iterator(0);
+		auto UpdateWorlds = ndMakeObject::ndFunction([this, &iterator, worldCount](ndInt32, ndInt32)
+		{
+			D_TRACKTIME_NAMED(UpdateWorlds);
+			for (ndInt32 i = iterator.fetch_add(1); i < worldCount; i = iterator.fetch_add(1))
+			{
+				ndWorld* const world = m_schedule[i].m_world;
+				world->m_timestep = m_timestep;
+				world->ThreadFunction();
+			}
+		});
+		ParallelExecute(UpdateWorlds);
+		End();
+	}
+
+	m_lastExecutionTime = ndFloat32(ndGetTimeInMicroseconds() - timeAcc) * ndFloat32(1.0e-6f);
+}
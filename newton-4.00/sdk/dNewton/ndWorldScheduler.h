@@ -0,0 +1,78 @@
+/* Copyright (c) <2003-2022> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __ND_WORLD_SCHEDULER_H__
+#define __ND_WORLD_SCHEDULER_H__
+
+#include "ndNewtonStdafx.h"
+
+class ndWorld;
+
+/// Thread pool shared by many worlds.
+/// \brief Intended for applications that run a large number of small worlds,
+/// for example one world per match in a game server. Instead of each world
+/// owning a scene thread pool, the attached worlds are stepped as tasks on
+/// the scheduler workers, so the process only runs one set of threads.
+/// Each update steps every attached world exactly once. Worlds with higher 
+/// priority are dispatched first, and worlds of equal priority are dispatched
+/// by their last update time, longest first, so that the slow worlds do 
+/// not end up running alone at the end of the frame.
+/// The phases of each world run on the worker that picked it, so attached
+/// worlds are set to run single threaded.
+class ndWorldScheduler: public ndThreadPool
+{
+	class ndScheduledWorld
+	{
+		public:
+		ndWorld* m_world;
+		ndInt32 m_priority;
+	};
+
+	public:
+	D_NEWTON_API ndWorldScheduler();
+	D_NEWTON_API virtual ~ndWorldScheduler();
+
+	/// Attach a world to the scheduler, the world must not be updated by any other means while attached.
+	D_NEWTON_API void AddWorld(ndWorld* const world, ndInt32 priority = 0);
+	D_NEWTON_API void RemoveWorld(ndWorld* const world);
+	D_NEWTON_API void SetPriority(ndWorld* const world, ndInt32 priority);
+	D_NEWTON_API ndInt32 GetWorldCount() const;
+
+	/// Start stepping all attached worlds asynchronously by timestep seconds.
+	D_NEWTON_API void Update(ndFloat32 timestep);
+
+	/// Wait until the last update completes.
+	D_NEWTON_API void Sync();
+
+	/// Time in seconds spent by the last update.
+	D_NEWTON_API ndFloat32 GetUpdateTime() const;
+
+	private:
+	ndInt32 Find(const ndWorld* const world) const;
+	virtual void ThreadFunction();
+
+	ndArray<ndScheduledWorld> m_worlds;
+	ndArray<ndScheduledWorld> m_schedule;
+	ndFloat32 m_timestep;
+	ndFloat32 m_lastExecutionTime;
+};
+
+#endif
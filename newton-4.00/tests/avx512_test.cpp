@@ -0,0 +1,128 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+static void AddFloor(ndWorld& world)
+{
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit.m_y = -0.5f;
+	ndShapeInstance floor(new ndShapeBox(40.0f, 1.0f, 40.0f));
+	ndBodyDynamic* const ground = new ndBodyDynamic();
+	ground->SetMatrix(matrix);
+	ground->SetCollisionShape(floor);
+	world.AddBody(ndSharedPtr<ndBody>(ground));
+}
+
+static ndBodyDynamic* AddBox(ndWorld& world, const ndShapeInstance& box, const ndMatrix& matrix)
+{
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+	body->SetMatrix(matrix);
+	body->SetCollisionShape(box);
+	body->SetMassMatrix(1.0f, box);
+	body->SetAutoSleep(false);
+	world.AddBody(ndSharedPtr<ndBody>(body));
+	return body;
+}
+
+static ndFloat32 SimulatePyramid(ndWorld::ndSolverModes solver, ndWorld::ndSolverModes& selected)
+{
+	ndWorld world;
+	world.SetSubSteps(1);
+	world.SetSolverIterations(4);
+	world.SelectSolver(solver);
+	selected = world.GetSelectedSolver();
+
+	AddFloor(world);
+	const ndInt32 base = 12;
+	ndBodyDynamic* apex = nullptr;
+	ndMatrix matrix(ndGetIdentityMatrix());
+	ndShapeInstance box(new ndShapeBox(1.0f, 1.0f, 1.0f));
+	for (ndInt32 i = 0; i < base; ++i)
+	{
+		for (ndInt32 j = 0; j < base - i; ++j)
+		{
+			matrix.m_posit.m_x = ndFloat32(j) * 1.01f + ndFloat32(i) * 0.505f;
+			matrix.m_posit.m_y = 0.5f + ndFloat32(i);
+			apex = AddBox(world, box, matrix);
+		}
+	}
+
+	for (ndInt32 i = 0; i < 300; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+	}
+	world.Sync();
+	return ndFloat32(base) - 0.5f - apex->GetMatrix().m_posit.m_y;
+}
+
+/* The sixteen wide solver holds a pyramid as well as the four wide solver, or falls back on cpus without avx512. */
+TEST(Avx512, PyramidMatchesSoa)
+{
+	ndWorld::ndSolverModes soaMode;
+	ndWorld::ndSolverModes wideMode;
+	const ndFloat32 soaSag = SimulatePyramid(ndWorld::ndSimdSoaSolver, soaMode);
+	const ndFloat32 wideSag = SimulatePyramid(ndWorld::ndSimdAvx512Solver, wideMode);
+
+	EXPECT_EQ(soaMode, ndWorld::ndSimdSoaSolver);
+	EXPECT_TRUE((wideMode == ndWorld::ndSimdAvx512Solver) || (wideMode == ndWorld::ndSimdAvx2Solver) || (wideMode == ndWorld::ndSimdSoaSolver));
+	EXPECT_LT(wideSag, 0.1f);
+	EXPECT_LT(wideSag, soaSag + 0.01f);
+}
+
+/* A joint count that does not fill the last group, with joints of different row counts, rests in place. */
+TEST(Avx512, PartialGroup)
+{
+	ndWorld world;
+	world.SetSubSteps(2);
+	world.SelectSolver(ndWorld::ndSimdAvx512Solver);
+	if (world.GetSelectedSolver() == ndWorld::ndSimdAvx512Solver)
+	{
+		EXPECT_STREQ(world.GetSolverString(), "avx512");
+	}
+
+	AddFloor(world);
+	ndArray<ndBodyDynamic*> boxes;
+	ndShapeInstance box(new ndShapeBox(0.5f, 0.5f, 0.5f));
+	ndShapeInstance ball(new ndShapeSphere(0.25f));
+	ndMatrix matrix(ndGetIdentityMatrix());
+
+	// 19 boxes and spheres on the floor, and two short stacks, 
+	// so the contacts have 3, 12 and 24 rows and do not fill two groups of 16.
+	for (ndInt32 i = 0; i < 19; ++i)
+	{
+		matrix.m_posit = ndVector(ndFloat32(i % 5) * 1.5f - 3.0f, 0.25f, ndFloat32(i / 5) * 1.5f - 3.0f, 1.0f);
+		boxes.PushBack(AddBox(world, (i & 1) ? ball : box, matrix));
+	}
+	for (ndInt32 i = 0; i < 4; ++i)
+	{
+		matrix.m_posit = ndVector(ndFloat32(i & 1) * 6.0f + 6.0f, 0.25f + ndFloat32(i >> 1) * 0.5f, 6.0f, 1.0f);
+		boxes.PushBack(AddBox(world, box, matrix));
+	}
+
+	for (ndInt32 i = 0; i < 120; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+	}
+	world.Sync();
+
+	for (ndInt32 i = 0; i < boxes.GetCount() - 4; ++i)
+	{
+		EXPECT_NEAR(boxes[i]->GetMatrix().m_posit.m_y, 0.25f, 0.02f);
+	}
+	for (ndInt32 i = boxes.GetCount() - 4; i < boxes.GetCount(); ++i)
+	{
+		const ndFloat32 height = 0.25f + ndFloat32((i - (boxes.GetCount() - 4)) >> 1) * 0.5f;
+		EXPECT_NEAR(boxes[i]->GetMatrix().m_posit.m_y, height, 0.02f);
+	}
+}
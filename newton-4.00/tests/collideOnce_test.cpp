@@ -0,0 +1,124 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+static void AddFloor(ndWorld& world)
+{
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit.m_y = -0.5f;
+	ndShapeInstance floor(new ndShapeBox(40.0f, 1.0f, 40.0f));
+	ndBodyDynamic* const ground = new ndBodyDynamic();
+	ground->SetMatrix(matrix);
+	ground->SetCollisionShape(floor);
+	world.AddBody(ndSharedPtr<ndBody>(ground));
+}
+
+static ndBodyDynamic* AddBox(ndWorld& world, const ndVector& posit, const ndVector& veloc)
+{
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit = posit;
+	ndShapeInstance box(new ndShapeBox(1.0f, 1.0f, 1.0f));
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+	body->SetMatrix(matrix);
+	body->SetCollisionShape(box);
+	body->SetMassMatrix(1.0f, box);
+	body->SetVelocity(veloc);
+	body->SetAutoSleep(false);
+	world.AddBody(ndSharedPtr<ndBody>(body));
+	return body;
+}
+
+/* A tower sub stepped eight times per update stands when it only collides once per update. */
+TEST(CollideOnce, TowerStands)
+{
+	ndWorld world;
+	world.SetSubSteps(8);
+	world.SetCollideOnce(true);
+	EXPECT_TRUE(world.GetCollideOnce());
+	AddFloor(world);
+
+	ndArray<ndBodyDynamic*> tower;
+	for (ndInt32 i = 0; i < 10; ++i)
+	{
+		tower.PushBack(AddBox(world, ndVector(0.0f, 0.5f + ndFloat32(i), 0.0f, 1.0f), ndVector::m_zero));
+	}
+
+	for (ndInt32 i = 0; i < 180; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+	}
+	world.Sync();
+
+	for (ndInt32 i = 0; i < tower.GetCount(); ++i)
+	{
+		const ndVector posit(tower[i]->GetMatrix().m_posit);
+		EXPECT_NEAR(posit.m_y, 0.5f + ndFloat32(i), 0.05f);
+		EXPECT_NEAR(posit.m_x, 0.0f, 0.05f);
+		EXPECT_NEAR(posit.m_z, 0.0f, 0.05f);
+	}
+}
+
+static ndFloat32 DropBox(bool collideOnce)
+{
+	ndWorld world;
+	world.SetSubSteps(8);
+	world.SetCollideOnce(collideOnce);
+	AddFloor(world);
+
+	// fast enough to cover a good part of its size in one update
+	ndBodyDynamic* const box = AddBox(world, ndVector(0.0f, 1.5f, 0.0f, 1.0f), ndVector(0.0f, -20.0f, 0.0f, 0.0f));
+
+	ndFloat32 lowest = 1.0e10f;
+	for (ndInt32 i = 0; i < 60; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+		lowest = ndMin(lowest, ndFloat32(box->GetMatrix().m_posit.m_y));
+	}
+	return 0.5f - lowest;
+}
+
+/* The speculative contacts of the single collision stop a fast box at the floor in the later sub steps. */
+TEST(CollideOnce, FastBoxStopsAtFloor)
+{
+	const ndFloat32 subStepPenetration = DropBox(false);
+	const ndFloat32 collideOncePenetration = DropBox(true);
+	EXPECT_LT(collideOncePenetration, 0.05f);
+	EXPECT_LT(collideOncePenetration, subStepPenetration + 0.02f);
+}
+
+/* The sub steps that do not collide still leave the moving bodies where the ray casts find them. */
+TEST(CollideOnce, RayCastFindsMovingBody)
+{
+	ndWorld world;
+	world.SetSubSteps(8);
+	world.SetCollideOnce(true);
+
+	// a third of its size per update
+	ndBodyDynamic* const box = AddBox(world, ndVector(0.0f, 5.0f, 0.0f, 1.0f), ndVector(20.0f, 0.0f, 0.0f, 0.0f));
+	for (ndInt32 i = 0; i < 10; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+
+		// just inside the leading face, outside the box of the first sub step
+		const ndVector posit(box->GetMatrix().m_posit);
+		ndRayCastClosestHitCallback rayCaster;
+		const ndVector start(posit.m_x + 0.4f, posit.m_y + 5.0f, posit.m_z, 1.0f);
+		const ndVector end(posit.m_x + 0.4f, posit.m_y - 5.0f, posit.m_z, 1.0f);
+		EXPECT_TRUE(world.RayCast(rayCaster, start, end));
+		EXPECT_EQ(rayCaster.m_contact.m_body0, box);
+		EXPECT_NEAR(rayCaster.m_contact.m_point.m_y, posit.m_y + 0.5f, 1.0e-3f);
+	}
+}
@@ -0,0 +1,166 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+static ndShapeInstance MakeBuilding(ndInt32 bricks, ndFloat32 size)
+{
+	ndShapeInstance building(new ndShapeCompound());
+	ndShapeCompound* const compoundShape = building.GetShape()->GetAsShapeCompound();
+	compoundShape->BeginAddRemove();
+	ndShapeInstance brick(new ndShapeBox(size, size, size));
+	for (ndInt32 i = 0; i < bricks * bricks * bricks; ++i)
+	{
+		ndMatrix matrix(ndGetIdentityMatrix());
+		matrix.m_posit.m_x = (ndFloat32(i % bricks) - ndFloat32(bricks - 1) * 0.5f) * size;
+		matrix.m_posit.m_y = (ndFloat32(i / (bricks * bricks)) - ndFloat32(bricks - 1) * 0.5f) * size;
+		matrix.m_posit.m_z = (ndFloat32((i / bricks) % bricks) - ndFloat32(bricks - 1) * 0.5f) * size;
+		brick.SetLocalMatrix(matrix);
+		compoundShape->AddCollision(&brick);
+	}
+	compoundShape->EndAddRemove();
+	return building;
+}
+
+static ndShapeInstance MakeMeshFloor(ndInt32 cells, ndFloat32 cellSize)
+{
+	ndPolygonSoupBuilder meshBuilder;
+	meshBuilder.Begin();
+	const ndFloat32 origin = -ndFloat32(cells) * cellSize * 0.5f;
+	for (ndInt32 i = 0; i < cells * cells; ++i)
+	{
+		const ndFloat32 x = origin + ndFloat32(i % cells) * cellSize;
+		const ndFloat32 z = origin + ndFloat32(i / cells) * cellSize;
+		ndVector face[3];
+		face[0] = ndVector(x, 0.0f, z, 0.0f);
+		face[1] = ndVector(x, 0.0f, z + cellSize, 0.0f);
+		face[2] = ndVector(x + cellSize, 0.0f, z + cellSize, 0.0f);
+		meshBuilder.AddFace(&face[0].m_x, sizeof(ndVector), 3, 0);
+		face[1] = face[2];
+		face[2] = ndVector(x + cellSize, 0.0f, z, 0.0f);
+		meshBuilder.AddFace(&face[0].m_x, sizeof(ndVector), 3, 0);
+	}
+	meshBuilder.End(true);
+	return ndShapeInstance(new ndShapeStatic_bvh(meshBuilder));
+}
+
+static ndBodyDynamic* AddBody(ndWorld& world, const ndShapeInstance& shape, ndFloat32 mass, const ndMatrix& matrix)
+{
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+	body->SetMatrix(matrix);
+	body->SetCollisionShape(shape);
+	if (mass > 0.0f)
+	{
+		body->SetMassMatrix(mass, shape);
+	}
+	world.AddBody(ndSharedPtr<ndBody>(body));
+	return body;
+}
+
+/* The child pairs of a large compound pair, spread over the threads, give the contacts of the inline traversal. */
+TEST(CompoundPairs, MatchInlineTraversal)
+{
+	const ndShapeInstance building(MakeBuilding(4, 0.5f));
+	ndMatrix baseMatrix(ndGetIdentityMatrix());
+	ndMatrix topMatrix(ndYawMatrix(0.3f) * ndRollMatrix(0.05f));
+	topMatrix.m_posit = ndVector(0.3f, 1.95f, 0.2f, 1.0f);
+
+	ndWorld world;
+	world.SetThreadCount(3);
+	ndBodyDynamic* const base = AddBody(world, building, 0.0f, baseMatrix);
+	ndBodyDynamic* const top = AddBody(world, building, 10.0f, topMatrix);
+	world.Update(1.0f / 60.0f);
+	world.Sync();
+
+	const ndUpdateStatistics::ndFrame& frame = world.GetUpdateStatistics().GetFrame(0);
+	EXPECT_EQ(frame.m_compoundPairCount, 1);
+	EXPECT_GT(frame.m_compoundChildPairCount, 0);
+
+	const ndContact* const contact = top->GetContactMap().FindContact(top, base);
+	ASSERT_TRUE(contact != nullptr);
+	const bool topIsBody0 = (contact->GetBody0() == top);
+
+	ndContactNotify notification(nullptr);
+	ndFixSizeArray<ndContactPoint, 16> contacts;
+	ndContactSolver* const solver = new ndContactSolver();
+	if (topIsBody0)
+	{
+		solver->CalculateContacts(&building, topMatrix, ndVector::m_zero, &building, baseMatrix, ndVector::m_zero, contacts, &notification);
+	}
+	else
+	{
+		solver->CalculateContacts(&building, baseMatrix, ndVector::m_zero, &building, topMatrix, ndVector::m_zero, contacts, &notification);
+	}
+	delete solver;
+
+	const ndContactPointList& points = contact->GetContactPoints();
+	ASSERT_GT(contacts.GetCount(), 0);
+	ASSERT_EQ(points.GetCount(), contacts.GetCount());
+	for (ndInt32 i = 0; i < points.GetCount(); ++i)
+	{
+		ndFloat32 closest = 1.0e10f;
+		for (ndInt32 j = 0; j < contacts.GetCount(); ++j)
+		{
+			const ndVector step(points[i].m_point - contacts[j].m_point);
+			closest = ndMin(closest, step.DotProduct(step & ndVector::m_triplexMask).GetScalar());
+		}
+		EXPECT_LT(closest, 1.0e-6f);
+	}
+}
+
+/* A pile of large compounds on a static mesh settles the same way for any thread count. */
+TEST(CompoundPairs, PileIsThreadCountIndependent)
+{
+	const ndShapeInstance building(MakeBuilding(4, 0.5f));
+	const ndShapeInstance floor(MakeMeshFloor(16, 2.0f));
+
+	ndVector posit[2][4];
+	for (ndInt32 pass = 0; pass < 2; ++pass)
+	{
+		ndWorld world;
+		world.SetThreadCount(pass ? 4 : 1);
+		AddBody(world, floor, 0.0f, ndGetIdentityMatrix());
+
+		ndBodyDynamic* bodies[4];
+		for (ndInt32 i = 0; i < 4; ++i)
+		{
+			ndMatrix matrix(ndYawMatrix(ndFloat32(i) * 0.5f));
+			matrix.m_posit = ndVector(ndFloat32(i & 1) * 1.0f, 1.1f + ndFloat32(i) * 2.2f, ndFloat32(i >> 1) * 0.5f, 1.0f);
+			bodies[i] = AddBody(world, building, 10.0f, matrix);
+		}
+
+		ndInt32 compoundPairs = 0;
+		for (ndInt32 i = 0; i < 90; ++i)
+		{
+			world.Update(1.0f / 60.0f);
+			world.Sync();
+			compoundPairs = ndMax(compoundPairs, world.GetUpdateStatistics().GetFrame(0).m_compoundPairCount);
+		}
+		// the bottom building against the mesh and the buildings against each other
+		EXPECT_GE(compoundPairs, 2);
+
+		for (ndInt32 i = 0; i < 4; ++i)
+		{
+			posit[pass][i] = bodies[i]->GetMatrix().m_posit;
+			// nothing sinks through the floor
+			EXPECT_GT(posit[pass][i].m_y, 0.9f);
+		}
+	}
+
+	for (ndInt32 i = 0; i < 4; ++i)
+	{
+		const ndVector error(posit[0][i] - posit[1][i]);
+		EXPECT_LT(error.DotProduct(error & ndVector::m_triplexMask).GetScalar(), 1.0e-8f);
+	}
+}
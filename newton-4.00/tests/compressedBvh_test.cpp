@@ -0,0 +1,208 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include <vector>
+#include <algorithm>
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+static ndFloat32 TerrainHeight(ndFloat32 x, ndFloat32 z)
+{
+	return 0.5f * ndSin(x * 0.37f) * ndCos(z * 0.23f) + 0.1f * ndSin(x * z * 0.05f);
+}
+
+static void BuildTerrain(ndPolygonSoupBuilder& meshBuilder, ndInt32 cells, ndFloat32 cellSize)
+{
+	meshBuilder.Begin();
+	const ndFloat32 origin = -ndFloat32(cells) * cellSize * 0.5f;
+	for (ndInt32 i = 0; i < cells * cells; ++i)
+	{
+		const ndFloat32 x0 = origin + ndFloat32(i % cells) * cellSize;
+		const ndFloat32 z0 = origin + ndFloat32(i / cells) * cellSize;
+		const ndFloat32 x1 = x0 + cellSize;
+		const ndFloat32 z1 = z0 + cellSize;
+		ndVector face[3];
+		face[0] = ndVector(x0, TerrainHeight(x0, z0), z0, 0.0f);
+		face[1] = ndVector(x0, TerrainHeight(x0, z1), z1, 0.0f);
+		face[2] = ndVector(x1, TerrainHeight(x1, z1), z1, 0.0f);
+		meshBuilder.AddFace(&face[0].m_x, sizeof(ndVector), 3, i % 7);
+		face[1] = face[2];
+		face[2] = ndVector(x1, TerrainHeight(x1, z0), z0, 0.0f);
+		meshBuilder.AddFace(&face[0].m_x, sizeof(ndVector), 3, i % 5);
+	}
+	meshBuilder.End(false);
+}
+
+class CompressedBvhFaceCollector : public ndShapeDebugNotify
+{
+	public:
+	void DrawPolygon(ndInt32 vertexCount, const ndVector* const faceArray, const ndEdgeType* const edgeType)
+	{
+		std::vector<ndFloat32> face;
+		for (ndInt32 i = 0; i < vertexCount; ++i)
+		{
+			face.push_back(faceArray[i].m_x);
+			face.push_back(faceArray[i].m_y);
+			face.push_back(faceArray[i].m_z);
+			face.push_back(ndFloat32(edgeType[i]));
+		}
+		m_faces.push_back(face);
+	}
+
+	std::vector<std::vector<ndFloat32>> m_faces;
+};
+
+/* The compressed layout reports the same faces and edge types, and takes less memory. */
+TEST(CompressedBvh, SameFaces)
+{
+	ndPolygonSoupBuilder meshBuilder;
+	BuildTerrain(meshBuilder, 48, 1.0f);
+	const ndShapeInstance plain(new ndShapeStatic_bvh(meshBuilder));
+	const ndShapeInstance compressed(new ndShapeStatic_bvh(meshBuilder, true));
+
+	ndShapeStatic_bvh* const plainShape = ((ndShape*)plain.GetShape())->GetAsShapeStaticBVH();
+	ndShapeStatic_bvh* const compressedShape = ((ndShape*)compressed.GetShape())->GetAsShapeStaticBVH();
+	EXPECT_FALSE(plainShape->IsCompressed());
+	EXPECT_TRUE(compressedShape->IsCompressed());
+	EXPECT_LT(compressedShape->GetMemorySize(), plainShape->GetMemorySize());
+
+	ndVector plainP0;
+	ndVector plainP1;
+	ndVector compressedP0;
+	ndVector compressedP1;
+	plainShape->GetAABB(plainP0, plainP1);
+	compressedShape->GetAABB(compressedP0, compressedP1);
+	EXPECT_EQ(plainP0.m_x, compressedP0.m_x);
+	EXPECT_EQ(plainP1.m_y, compressedP1.m_y);
+
+	CompressedBvhFaceCollector plainFaces;
+	CompressedBvhFaceCollector compressedFaces;
+	plain.DebugShape(ndGetIdentityMatrix(), plainFaces);
+	compressed.DebugShape(ndGetIdentityMatrix(), compressedFaces);
+	std::sort(plainFaces.m_faces.begin(), plainFaces.m_faces.end());
+	std::sort(compressedFaces.m_faces.begin(), compressedFaces.m_faces.end());
+	EXPECT_EQ(plainFaces.m_faces.size(), size_t(48 * 48 * 2));
+	EXPECT_TRUE(plainFaces.m_faces == compressedFaces.m_faces);
+}
+
+/* Ray casts against the compressed layout hit the same face at the same distance. */
+TEST(CompressedBvh, SameRayHits)
+{
+	ndPolygonSoupBuilder meshBuilder;
+	BuildTerrain(meshBuilder, 32, 1.0f);
+
+	ndBodyKinematic plainBody;
+	ndBodyKinematic compressedBody;
+	plainBody.SetCollisionShape(ndShapeInstance(new ndShapeStatic_bvh(meshBuilder)));
+	compressedBody.SetCollisionShape(ndShapeInstance(new ndShapeStatic_bvh(meshBuilder, true)));
+	const ndShapeInstance& plain = plainBody.GetCollisionShape();
+	const ndShapeInstance& compressed = compressedBody.GetCollisionShape();
+
+	ndInt32 hits = 0;
+	for (ndInt32 i = 0; i < 200; ++i)
+	{
+		const ndFloat32 x = ndFloat32(i % 20) * 1.37f - 14.0f;
+		const ndFloat32 z = ndFloat32(i / 20) * 2.91f - 14.0f;
+		const ndVector p0(x, 3.0f, z, 0.0f);
+		const ndVector p1(x + ndFloat32(i % 3) - 1.0f, -3.0f, z + 0.5f, 0.0f);
+
+		ndContactPoint plainContact;
+		ndContactPoint compressedContact;
+		ndRayCastClosestHitCallback plainCaster;
+		ndRayCastClosestHitCallback compressedCaster;
+		const ndFloat32 plainParam = plain.RayCast(plainCaster, p0, p1, &plainBody, plainContact);
+		const ndFloat32 compressedParam = compressed.RayCast(compressedCaster, p0, p1, &compressedBody, compressedContact);
+		EXPECT_EQ(plainParam, compressedParam);
+		if (plainParam < ndFloat32(1.0f))
+		{
+			hits++;
+			EXPECT_EQ(plainContact.m_shapeId0, compressedContact.m_shapeId0);
+			EXPECT_EQ(plainContact.m_normal.m_y, compressedContact.m_normal.m_y);
+		}
+	}
+	EXPECT_GT(hits, 150);
+}
+
+static ndFloat32 DropBoxes(bool compressed)
+{
+	ndPolygonSoupBuilder meshBuilder;
+	BuildTerrain(meshBuilder, 24, 1.0f);
+
+	ndWorld world;
+	world.SetSubSteps(2);
+
+	ndBodyDynamic* const floor = new ndBodyDynamic();
+	floor->SetMatrix(ndGetIdentityMatrix());
+	floor->SetCollisionShape(ndShapeInstance(new ndShapeStatic_bvh(meshBuilder, compressed)));
+	world.AddBody(ndSharedPtr<ndBody>(floor));
+
+	ndShapeInstance box(new ndShapeBox(0.5f, 0.5f, 0.5f));
+	ndArray<ndBodyDynamic*> boxes;
+	for (ndInt32 i = 0; i < 16; ++i)
+	{
+		ndMatrix matrix(ndGetIdentityMatrix());
+		matrix.m_posit = ndVector(ndFloat32(i % 4) * 2.5f - 4.0f, 1.5f, ndFloat32(i / 4) * 2.5f - 4.0f, 1.0f);
+		ndBodyDynamic* const body = new ndBodyDynamic();
+		body->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+		body->SetMatrix(matrix);
+		body->SetCollisionShape(box);
+		body->SetMassMatrix(1.0f, box);
+		world.AddBody(ndSharedPtr<ndBody>(body));
+		boxes.PushBack(body);
+	}
+
+	// a compound exercises the compound against static bvh path
+	ndShapeInstance cluster(new ndShapeCompound());
+	ndShapeCompound* const compoundShape = cluster.GetShape()->GetAsShapeCompound();
+	compoundShape->BeginAddRemove();
+	for (ndInt32 i = 0; i < 8; ++i)
+	{
+		ndMatrix matrix(ndGetIdentityMatrix());
+		matrix.m_posit = ndVector(ndFloat32(i & 1) * 0.5f - 0.25f, ndFloat32((i >> 1) & 1) * 0.5f - 0.25f, ndFloat32(i >> 2) * 0.5f - 0.25f, 1.0f);
+		box.SetLocalMatrix(matrix);
+		compoundShape->AddCollision(&box);
+	}
+	compoundShape->EndAddRemove();
+	box.SetLocalMatrix(ndGetIdentityMatrix());
+
+	ndMatrix clusterMatrix(ndGetIdentityMatrix());
+	clusterMatrix.m_posit = ndVector(6.0f, 2.0f, 6.0f, 1.0f);
+	ndBodyDynamic* const clusterBody = new ndBodyDynamic();
+	clusterBody->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+	clusterBody->SetMatrix(clusterMatrix);
+	clusterBody->SetCollisionShape(cluster);
+	clusterBody->SetMassMatrix(8.0f, cluster);
+	world.AddBody(ndSharedPtr<ndBody>(clusterBody));
+	boxes.PushBack(clusterBody);
+
+	for (ndInt32 i = 0; i < 180; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+	}
+
+	ndFloat32 maxGap = 0.0f;
+	for (ndInt32 i = 0; i < boxes.GetCount(); ++i)
+	{
+		const ndVector posit(boxes[i]->GetMatrix().m_posit);
+		maxGap = ndMax(maxGap, ndAbs(posit.m_y - TerrainHeight(posit.m_x, posit.m_z)));
+	}
+	return maxGap;
+}
+
+/* Boxes and a compound dropped on a compressed mesh come to rest on its surface. */
+TEST(CompressedBvh, BoxesRestOnSurface)
+{
+	const ndFloat32 plainGap = DropBoxes(false);
+	const ndFloat32 compressedGap = DropBoxes(true);
+	EXPECT_LT(plainGap, 0.75f);
+	EXPECT_LT(compressedGap, 0.75f);
+}
@@ -0,0 +1,99 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+static ndBodyDynamic* AddBox(ndWorld& world, ndFloat32 mass, const ndVector& posit)
+{
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit = posit;
+
+	ndShapeInstance box(new ndShapeBox(1.0f, 1.0f, 1.0f));
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+	body->SetMatrix(matrix);
+	body->SetCollisionShape(box);
+	if (mass > 0.0f)
+	{
+		body->SetMassMatrix(mass, box);
+	}
+	world.AddBody(ndSharedPtr<ndBody>(body));
+	return body;
+}
+
+static void CheckContactMaps(const ndWorld& world)
+{
+	const ndBodyListView& bodyList = world.GetBodyList();
+	for (ndBodyListView::ndNode* node = bodyList.GetFirst(); node; node = node->GetNext())
+	{
+		const ndBodyKinematic* const body = node->GetInfo()->GetAsBodyKinematic();
+		const ndBodyKinematic::ndContactMap& contactMap = body->GetContactMap();
+		EXPECT_TRUE(contactMap.SanityCheck());
+
+		ndInt32 count = 0;
+		ndBodyKinematic::ndContactMap::Iterator it(contactMap);
+		for (it.Begin(); it; it++)
+		{
+			const ndContact* const contact = *it;
+			const ndBodyKinematic* const other = (contact->GetBody0() == body) ? contact->GetBody1() : contact->GetBody0();
+			EXPECT_EQ(contactMap.FindContact(body, other), contact);
+			EXPECT_EQ(other->GetContactMap().FindContact(other, body), contact);
+			count++;
+		}
+		EXPECT_EQ(count, contactMap.GetCount());
+	}
+}
+
+/* The per body contact tables stay consistent while a dense pile collides and bodies are removed. */
+TEST(ContactMap, DensePile)
+{
+	ndWorld world;
+	world.SetSubSteps(2);
+
+	ndBodyDynamic* const floor = AddBox(world, 0.0f, ndVector(0.0f, -0.5f, 0.0f, 1.0f));
+	ndShapeInstance floorShape(new ndShapeBox(40.0f, 1.0f, 40.0f));
+	floor->SetCollisionShape(floorShape);
+
+	ndFixSizeArray<ndBodyDynamic*, 256> boxes;
+	for (ndInt32 i = 0; i < 216; ++i)
+	{
+		const ndVector posit(ndFloat32(i % 6) * 1.05f - 3.0f, ndFloat32(i / 36) * 1.05f + 0.55f, ndFloat32((i / 6) % 6) * 1.05f - 3.0f, 1.0f);
+		boxes.PushBack(AddBox(world, 1.0f, posit));
+	}
+
+	for (ndInt32 i = 0; i < 30; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+	}
+	world.Sync();
+
+	// the bottom layer touches the floor and its neighbors
+	EXPECT_GE(floor->GetContactMap().GetCount(), 36);
+	CheckContactMaps(world);
+
+	// removed bodies detach their contacts at the start of the next update
+	for (ndInt32 i = 0; i < boxes.GetCount(); i += 3)
+	{
+		world.RemoveBody(boxes[i]);
+	}
+	world.Update(1.0f / 60.0f);
+	world.Sync();
+	EXPECT_EQ(ndInt32(world.GetBodyList().GetCount()), 1 + 216 - 72);
+	CheckContactMaps(world);
+
+	for (ndInt32 i = 0; i < 10; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+	}
+	world.Sync();
+	CheckContactMaps(world);
+}
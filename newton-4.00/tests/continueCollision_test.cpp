@@ -0,0 +1,67 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+static ndFloat32 ShootThroughWall(const ndShapeInstance& shape, bool continueCollision, ndInt32& continuePairs)
+{
+	ndWorld world;
+	world.SetSubSteps(1);
+	world.SetThreadCount(2);
+
+	ndShapeInstance wallShape(new ndShapeBox(ndFloat32(0.1f), ndFloat32(10.0f), ndFloat32(10.0f)));
+	ndBodyKinematic* const wall = new ndBodyDynamic();
+	wall->SetCollisionShape(wallShape);
+	world.AddBody(ndSharedPtr<ndBody>(wall));
+
+	// at 300 units per second the projectile moves 5 units each step, 
+	// it is never close to the wall at the end of a step
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit.m_x = ndFloat32(-4.0f);
+
+	ndBodyDynamic* const projectile = new ndBodyDynamic();
+	projectile->SetNotifyCallback(new ndBodyNotify(ndBigVector(ndFloat32(0.0f))));
+	projectile->SetCollisionShape(shape);
+	projectile->SetMatrix(matrix);
+	projectile->SetMassMatrix(ndFloat32(1.0f), shape);
+	projectile->SetContinueCollision(continueCollision);
+	projectile->SetVelocity(ndVector(ndFloat32(300.0f), ndFloat32(0.0f), ndFloat32(0.0f), ndFloat32(0.0f)));
+	world.AddBody(ndSharedPtr<ndBody>(projectile));
+
+	continuePairs = 0;
+	const ndUpdateStatistics& statistics = world.GetUpdateStatistics();
+	for (ndInt32 i = 0; i < 10; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+		continuePairs += statistics.GetFrame(0).m_continuePairCount;
+	}
+	return projectile->GetMatrix().m_posit.m_x;
+}
+
+/* A fast projectile tunnels through a thin wall unless it uses continue collision. */
+TEST(ContinueCollision, ProjectileStopsAtWall)
+{
+	ndShapeInstance sphere(new ndShapeSphere(ndFloat32(0.05f)));
+	ndShapeInstance box(new ndShapeBox(ndFloat32(0.1f), ndFloat32(0.1f), ndFloat32(0.1f)));
+
+	ndInt32 continuePairs = 0;
+	EXPECT_TRUE(ShootThroughWall(sphere, false, continuePairs) > ndFloat32(1.0f));
+	EXPECT_EQ(continuePairs, 0);
+
+	EXPECT_TRUE(ShootThroughWall(sphere, true, continuePairs) < ndFloat32(0.0f));
+	EXPECT_TRUE(continuePairs > 0);
+
+	EXPECT_TRUE(ShootThroughWall(box, true, continuePairs) < ndFloat32(0.0f));
+	EXPECT_TRUE(continuePairs > 0);
+}
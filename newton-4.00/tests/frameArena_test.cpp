@@ -0,0 +1,45 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+/* Overflowing a frame must grow the block so the next frame fits, up to the cap. */
+TEST(FrameArena, GrowsToHighWaterMark)
+{
+	ndFrameArena arena;
+	for (ndInt32 i = 0; i < 16; ++i)
+	{
+		ndInt32* const buffer = arena.Alloc<ndInt32>(1000);
+		buffer[999] = i;
+	}
+	EXPECT_EQ(arena.GetOverflowCount(), ndUnsigned64(16));
+	const size_t usedSize = arena.GetUsedSize();
+	arena.Reset();
+
+	EXPECT_TRUE(arena.GetCapacity() >= usedSize);
+	EXPECT_EQ(arena.GetPeakSize(), usedSize);
+	EXPECT_EQ(arena.GetUsedSize(), size_t(0));
+
+	arena.ResetPeakSize();
+	for (ndInt32 i = 0; i < 16; ++i)
+	{
+		arena.Alloc<ndInt32>(1000);
+	}
+	EXPECT_EQ(arena.GetOverflowCount(), ndUnsigned64(0));
+	arena.Reset();
+
+	arena.SetMaxCapacity(1024);
+	EXPECT_EQ(arena.GetCapacity(), size_t(0));
+	arena.Alloc<ndInt32>(1000);
+	arena.Reset();
+	EXPECT_EQ(arena.GetCapacity(), size_t(1024));
+}
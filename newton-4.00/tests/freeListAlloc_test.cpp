@@ -0,0 +1,47 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+class ndFreeListTestNode: public ndContainersFreeListAlloc<ndFreeListTestNode>
+{
+	public:
+	ndFloat32 m_data[13];
+};
+
+/* Recycled nodes must be served from the thread cache without touching the shared lock. */
+TEST(FreeListAlloc, ThreadCacheRecyclesNodes)
+{
+	const ndInt32 count = 1000;
+	ndFreeListTestNode* nodes[count];
+
+	ndFreeListAlloc::ResetStatistics();
+	for (ndInt32 pass = 0; pass < 4; ++pass)
+	{
+		for (ndInt32 i = 0; i < count; ++i)
+		{
+			nodes[i] = new ndFreeListTestNode;
+		}
+		for (ndInt32 i = 0; i < count; ++i)
+		{
+			delete nodes[i];
+		}
+	}
+
+	ndFreeListAlloc::ndStatistics stats;
+	ndFreeListAlloc::GetStatistics(stats);
+	EXPECT_EQ(stats.m_cacheHits + stats.m_cacheMisses, ndUnsigned64(4 * count));
+	EXPECT_TRUE(stats.m_cacheHits > stats.m_cacheMisses);
+	EXPECT_TRUE(stats.m_spills > 0);
+
+	ndFreeListAlloc::Flush();
+}
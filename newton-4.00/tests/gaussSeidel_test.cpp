@@ -0,0 +1,133 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+static void BuildPyramid(ndWorld& world, ndInt32 base, ndArray<ndBodyDynamic*>& boxes)
+{
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit.m_y = -0.5f;
+	ndShapeInstance floor(new ndShapeBox(40.0f, 1.0f, 40.0f));
+	ndBodyDynamic* const ground = new ndBodyDynamic();
+	ground->SetMatrix(matrix);
+	ground->SetCollisionShape(floor);
+	world.AddBody(ndSharedPtr<ndBody>(ground));
+
+	ndShapeInstance box(new ndShapeBox(1.0f, 1.0f, 1.0f));
+	for (ndInt32 i = 0; i < base; ++i)
+	{
+		for (ndInt32 j = 0; j < base - i; ++j)
+		{
+			matrix.m_posit.m_x = ndFloat32(j) * 1.01f + ndFloat32(i) * 0.505f;
+			matrix.m_posit.m_y = 0.5f + ndFloat32(i);
+			ndBodyDynamic* const body = new ndBodyDynamic();
+			body->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+			body->SetMatrix(matrix);
+			body->SetCollisionShape(box);
+			body->SetMassMatrix(1.0f, box);
+			body->SetAutoSleep(false);
+			world.AddBody(ndSharedPtr<ndBody>(body));
+			boxes.PushBack(body);
+		}
+	}
+}
+
+static ndFloat32 SimulatePyramid(ndWorld::ndSolverModes solver, ndInt32& passes)
+{
+	ndWorld world;
+	world.SetSubSteps(1);
+	world.SetSolverIterations(4);
+	world.SelectSolver(solver);
+	EXPECT_EQ(world.GetSelectedSolver(), solver);
+
+	const ndInt32 base = 12;
+	ndArray<ndBodyDynamic*> boxes;
+	BuildPyramid(world, base, boxes);
+	for (ndInt32 i = 0; i < 300; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+	}
+	world.Sync();
+	passes = world.GetUpdateStatistics().GetFrame(0).m_solverPasses;
+
+	// the apex is the most sensitive to the stiffness of the whole pile.
+	const ndBodyDynamic* const apex = boxes[boxes.GetCount() - 1];
+	return ndFloat32(base) - 0.5f - apex->GetMatrix().m_posit.m_y;
+}
+
+/* The colored solver holds a pyramid as well as the Jacobi solver, in fewer passes. */
+TEST(GaussSeidel, PyramidFewerPasses)
+{
+	ndInt32 jacobiPasses = 0;
+	ndInt32 gaussSeidelPasses = 0;
+	const ndFloat32 jacobiSag = SimulatePyramid(ndWorld::ndSimdSoaSolver, jacobiPasses);
+	const ndFloat32 gaussSeidelSag = SimulatePyramid(ndWorld::ndGaussSeidelSolver, gaussSeidelPasses);
+
+	EXPECT_GT(gaussSeidelPasses, 0);
+	EXPECT_LT(gaussSeidelPasses, jacobiPasses);
+	EXPECT_LT(gaussSeidelSag, 0.1f);
+	EXPECT_LT(gaussSeidelSag, jacobiSag + 0.01f);
+}
+
+/* A body touching more joints than there are colors is solved by the serial batch. */
+TEST(GaussSeidel, CrowdedBody)
+{
+	ndWorld world;
+	world.SetSubSteps(2);
+	world.SelectSolver(ndWorld::ndGaussSeidelSolver);
+
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit.m_y = -0.5f;
+	ndShapeInstance floor(new ndShapeBox(40.0f, 1.0f, 40.0f));
+	ndBodyDynamic* const ground = new ndBodyDynamic();
+	ground->SetMatrix(matrix);
+	ground->SetCollisionShape(floor);
+	world.AddBody(ndSharedPtr<ndBody>(ground));
+
+	// a heavy plate carrying a grid of small boxes, more than the 64 colors
+	matrix.m_posit.m_y = 0.25f;
+	ndShapeInstance plateShape(new ndShapeBox(12.0f, 0.5f, 12.0f));
+	ndBodyDynamic* const plate = new ndBodyDynamic();
+	plate->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+	plate->SetMatrix(matrix);
+	plate->SetCollisionShape(plateShape);
+	plate->SetMassMatrix(50.0f, plateShape);
+	world.AddBody(ndSharedPtr<ndBody>(plate));
+
+	ndArray<ndBodyDynamic*> boxes;
+	ndShapeInstance box(new ndShapeBox(0.5f, 0.5f, 0.5f));
+	for (ndInt32 i = 0; i < 100; ++i)
+	{
+		matrix.m_posit = ndVector(ndFloat32(i % 10) * 1.1f - 5.0f, 0.75f, ndFloat32(i / 10) * 1.1f - 5.0f, 1.0f);
+		ndBodyDynamic* const body = new ndBodyDynamic();
+		body->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+		body->SetMatrix(matrix);
+		body->SetCollisionShape(box);
+		body->SetMassMatrix(1.0f, box);
+		body->SetAutoSleep(false);
+		world.AddBody(ndSharedPtr<ndBody>(body));
+		boxes.PushBack(body);
+	}
+
+	for (ndInt32 i = 0; i < 120; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+	}
+	world.Sync();
+
+	EXPECT_STREQ(world.GetSolverString(), "gauss seidel soa");
+	EXPECT_NEAR(plate->GetMatrix().m_posit.m_y, 0.25f, 0.05f);
+	for (ndInt32 i = 0; i < boxes.GetCount(); ++i)
+	{
+		EXPECT_NEAR(boxes[i]->GetMatrix().m_posit.m_y, 0.75f, 0.05f);
+	}
+}
@@ -0,0 +1,106 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+static ndBodyDynamic* AddBox(ndWorld& world, const ndShapeInstance& box, const ndVector& posit)
+{
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit = posit;
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+	body->SetMatrix(matrix);
+	body->SetCollisionShape(box);
+	body->SetMassMatrix(1.0f, box);
+	body->SetAutoSleep(false);
+	world.AddBody(ndSharedPtr<ndBody>(body));
+	return body;
+}
+
+static void SimulateClusters(ndWorld::ndSolverModes solver, ndArray<ndVector>& posits, ndInt32& islandCount)
+{
+	ndWorld world;
+	world.SetSubSteps(2);
+	world.SelectSolver(solver);
+
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit.m_y = -0.5f;
+	ndShapeInstance floor(new ndShapeBox(80.0f, 1.0f, 80.0f));
+	ndBodyDynamic* const ground = new ndBodyDynamic();
+	ground->SetMatrix(matrix);
+	ground->SetCollisionShape(floor);
+	world.AddBody(ndSharedPtr<ndBody>(ground));
+
+	// many small stacks of three boxes, each one an island solved by a single task
+	ndArray<ndBodyDynamic*> boxes;
+	ndShapeInstance box(new ndShapeBox(1.0f, 1.0f, 1.0f));
+	for (ndInt32 i = 0; i < 36; ++i)
+	{
+		const ndFloat32 x = ndFloat32(i % 6) * 3.0f - 30.0f;
+		const ndFloat32 z = ndFloat32(i / 6) * 3.0f - 30.0f;
+		for (ndInt32 j = 0; j < 3; ++j)
+		{
+			boxes.PushBack(AddBox(world, box, ndVector(x, 0.5f + ndFloat32(j), z, 1.0f)));
+		}
+	}
+
+	// and one wide pile, a layer of boxes bridged by a second layer resting on 
+	// the gaps, large enough to be solved by all the threads together
+	for (ndInt32 i = 0; i < 12 * 12; ++i)
+	{
+		boxes.PushBack(AddBox(world, box, ndVector(ndFloat32(i % 12) * 1.01f + 5.0f, 0.5f, ndFloat32(i / 12) * 1.01f + 5.0f, 1.0f)));
+	}
+	for (ndInt32 i = 0; i < 11 * 11; ++i)
+	{
+		boxes.PushBack(AddBox(world, box, ndVector(ndFloat32(i % 11) * 1.01f + 5.505f, 1.5f, ndFloat32(i / 11) * 1.01f + 5.505f, 1.0f)));
+	}
+
+	for (ndInt32 i = 0; i < 120; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+	}
+	world.Sync();
+
+	islandCount = world.GetUpdateStatistics().GetFrame(0).m_islandCount;
+	for (ndInt32 i = 0; i < boxes.GetCount(); ++i)
+	{
+		posits.PushBack(boxes[i]->GetMatrix().m_posit);
+	}
+	if (solver == ndWorld::ndIslandSolver)
+	{
+		EXPECT_STREQ(world.GetSolverString(), "island");
+
+		// the joints are grouped by island, so all of them are reported as active
+		const ndInt32 jointCount = ndInt32(world.GetScene()->GetActiveContactArray().GetCount());
+		EXPECT_EQ(world.GetUpdateStatistics().GetFrame(0).m_activeConstraintCount, jointCount);
+	}
+}
+
+/* The small stacks and the large pile settle where the default solver leaves them. */
+TEST(IslandParallel, SameRestPositions)
+{
+	ndInt32 islands = 0;
+	ndInt32 defaultIslands = 0;
+	ndArray<ndVector> posits;
+	ndArray<ndVector> defaultPosits;
+	SimulateClusters(ndWorld::ndStandardSolver, defaultPosits, defaultIslands);
+	SimulateClusters(ndWorld::ndIslandSolver, posits, islands);
+
+	EXPECT_EQ(islands, 37);
+	EXPECT_EQ(islands, defaultIslands);
+	ASSERT_EQ(posits.GetCount(), defaultPosits.GetCount());
+	for (ndInt32 i = 0; i < posits.GetCount(); ++i)
+	{
+		const ndVector error(posits[i] - defaultPosits[i]);
+		EXPECT_LT(ndSqrt(error.DotProduct(error & ndVector::m_triplexMask).GetScalar()), 0.05f);
+	}
+}
@@ -0,0 +1,136 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+static ndBodyDynamic* AddBox(ndWorld& world, const ndShapeInstance& box, const ndVector& posit, bool autoSleep)
+{
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit = posit;
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+	body->SetMatrix(matrix);
+	body->SetCollisionShape(box);
+	body->SetMassMatrix(1.0f, box);
+	body->SetAutoSleep(autoSleep);
+	world.AddBody(ndSharedPtr<ndBody>(body));
+	return body;
+}
+
+static void BuildScene(ndWorld& world, ndArray<ndBodyDynamic*>& tower, ndArray<ndBodyDynamic*>& debris)
+{
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit.m_y = -0.5f;
+	ndShapeInstance floor(new ndShapeBox(60.0f, 1.0f, 60.0f));
+	ndBodyDynamic* const ground = new ndBodyDynamic();
+	ground->SetMatrix(matrix);
+	ground->SetCollisionShape(floor);
+	world.AddBody(ndSharedPtr<ndBody>(ground));
+
+	// one tall tower, and a field of single boxes far from it
+	ndShapeInstance box(new ndShapeBox(1.0f, 1.0f, 1.0f));
+	for (ndInt32 i = 0; i < 16; ++i)
+	{
+		tower.PushBack(AddBox(world, box, ndVector(0.0f, 0.5f + ndFloat32(i), 0.0f, 1.0f), false));
+	}
+	for (ndInt32 i = 0; i < 24; ++i)
+	{
+		const ndVector posit(ndFloat32(i % 6) * 3.0f + 6.0f, 0.5f, ndFloat32(i / 6) * 3.0f - 6.0f, 1.0f);
+		debris.PushBack(AddBox(world, box, posit, false));
+	}
+}
+
+/* Each island stops at its own convergence, so the debris uses fewer passes than the tower, 
+ * and the passes the debris does not use go to the tower. */
+TEST(IslandSolver, PassesFollowIslandDifficulty)
+{
+	ndWorld world;
+	world.SetSubSteps(2);
+	world.SelectSolver(ndWorld::ndStandardSolver);
+
+	ndArray<ndBodyDynamic*> tower;
+	ndArray<ndBodyDynamic*> debris;
+	BuildScene(world, tower, debris);
+
+	// while the tower settles it takes the passes the debris does not use
+	ndInt32 settlingPasses = 0;
+	for (ndInt32 i = 0; i < 120; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+		settlingPasses = ndMax(settlingPasses, world.GetUpdateStatistics().GetFrame(0).m_islandMaxPasses);
+	}
+
+	const ndArray<ndDynamicsUpdate::ndIsland>& islands = world.GetSolverIslands();
+	ASSERT_EQ(islands.GetCount(), ndInt64(debris.GetCount() + 1));
+
+	ndInt32 towerPasses = 0;
+	ndInt32 maxDebrisPasses = 0;
+	ndInt32 towerIslands = 0;
+	for (ndInt32 i = 0; i < islands.GetCount(); ++i)
+	{
+		const ndDynamicsUpdate::ndIsland& island = islands[i];
+		EXPECT_GT(island.m_passes, 0);
+		EXPECT_LE(island.m_passes, island.m_maxPasses);
+		EXPECT_GE(island.m_residual, 0.0f);
+		if (island.m_count == ndInt32(tower.GetCount()))
+		{
+			towerIslands++;
+			towerPasses = island.m_passes;
+		}
+		else
+		{
+			EXPECT_EQ(island.m_count, 1);
+			maxDebrisPasses = ndMax(maxDebrisPasses, island.m_passes);
+		}
+	}
+	EXPECT_EQ(towerIslands, 1);
+	EXPECT_LE(maxDebrisPasses, 3);
+	EXPECT_GT(towerPasses, maxDebrisPasses);
+
+	// the islands share the solver passes, so the tower got more than the default count
+	const ndInt32 solverPasses = islands[0].m_maxPasses / D_ISLAND_MAX_PASSES_SCALE;
+	EXPECT_GT(settlingPasses, solverPasses);
+
+	const ndUpdateStatistics::ndFrame& frame = world.GetUpdateStatistics().GetFrame(0);
+	EXPECT_EQ(frame.m_islandCount, ndInt32(islands.GetCount()));
+	EXPECT_EQ(frame.m_islandMaxPasses, towerPasses);
+	EXPECT_LE(frame.m_islandMinPasses, maxDebrisPasses);
+
+	// converging early does not cost the tower its stiffness
+	for (ndInt32 i = 0; i < tower.GetCount(); ++i)
+	{
+		EXPECT_NEAR(tower[i]->GetMatrix().m_posit.m_y, 0.5f + ndFloat32(i), 0.05f);
+	}
+	for (ndInt32 i = 0; i < debris.GetCount(); ++i)
+	{
+		EXPECT_NEAR(debris[i]->GetMatrix().m_posit.m_y, 0.5f, 0.01f);
+	}
+}
+
+/* The solvers that do not iterate by island report no islands. */
+TEST(IslandSolver, OtherSolversHaveNoIslands)
+{
+	ndWorld world;
+	world.SelectSolver(ndWorld::ndSimdSoaSolver);
+
+	ndArray<ndBodyDynamic*> tower;
+	ndArray<ndBodyDynamic*> debris;
+	BuildScene(world, tower, debris);
+	for (ndInt32 i = 0; i < 10; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+	}
+	world.Sync();
+	EXPECT_EQ(world.GetSolverIslands().GetCount(), 0);
+	EXPECT_EQ(world.GetUpdateStatistics().GetFrame(0).m_islandCount, 0);
+}
@@ -0,0 +1,108 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+static ndShapeInstance MakeBoxHull(ndFloat32 x, ndFloat32 y, ndFloat32 z)
+{
+	ndFloat32 points[8][3];
+	for (ndInt32 i = 0; i < 8; ++i)
+	{
+		points[i][0] = (i & 1) ? x * 0.5f : -x * 0.5f;
+		points[i][1] = (i & 2) ? y * 0.5f : -y * 0.5f;
+		points[i][2] = (i & 4) ? z * 0.5f : -z * 0.5f;
+	}
+	return ndShapeInstance(new ndShapeConvexHull(8, 3 * sizeof(ndFloat32), 0.0f, &points[0][0]));
+}
+
+static ndInt32 Collide(const ndShapeInstance& shape0, const ndMatrix& matrix0, const ndShapeInstance& shape1, const ndMatrix& matrix1, ndFloat32& penetration)
+{
+	ndContactNotify notification(nullptr);
+	ndFixSizeArray<ndContactPoint, 16> contacts;
+	ndContactSolver* const solver = new ndContactSolver();
+	solver->CalculateContacts(&shape0, matrix0, ndVector::m_zero, &shape1, matrix1, ndVector::m_zero, contacts, &notification);
+	delete solver;
+
+	penetration = 0.0f;
+	for (ndInt32 i = 0; i < contacts.GetCount(); ++i)
+	{
+		penetration = ndMax(penetration, contacts[i].m_penetration);
+	}
+	return contacts.GetCount();
+}
+
+/* Closed form primitive pairs agree with the general convex path. */
+TEST(PrimitiveContacts, MatchGeneralPath)
+{
+	ndSetRandSeed(17);
+	const ndShapeInstance box0(new ndShapeBox(1.0f, 0.5f, 2.0f));
+	const ndShapeInstance box1(new ndShapeBox(0.75f, 1.0f, 1.0f));
+	const ndShapeInstance hull0(MakeBoxHull(1.0f, 0.5f, 2.0f));
+	const ndShapeInstance hull1(MakeBoxHull(0.75f, 1.0f, 1.0f));
+	const ndShapeInstance sphere(new ndShapeSphere(0.4f));
+
+	ndInt32 shallowPairs = 0;
+	for (ndInt32 i = 0; i < 256; ++i)
+	{
+		ndMatrix matrix0(ndPitchMatrix(ndRand() * 6.28f) * ndYawMatrix(ndRand() * 6.28f) * ndRollMatrix(ndRand() * 6.28f));
+		ndMatrix matrix1(ndPitchMatrix(ndRand() * 6.28f) * ndYawMatrix(ndRand() * 6.28f) * ndRollMatrix(ndRand() * 6.28f));
+		matrix0.m_posit = ndVector(ndRand() * 2.0f - 1.0f, ndRand() * 2.0f - 1.0f, ndRand() * 2.0f - 1.0f, 1.0f);
+		matrix1.m_posit = ndVector(ndRand() * 2.0f - 1.0f, ndRand() * 2.0f - 1.0f, ndRand() * 2.0f - 1.0f, 1.0f);
+
+		// deep penetrations are where the general path stops refining, 
+		// the separating axis answer can only be deeper there.
+		ndFloat32 fastPenetration;
+		ndFloat32 hullPenetration;
+		const ndInt32 fastCount = Collide(box0, matrix0, box1, matrix1, fastPenetration);
+		const ndInt32 hullCount = Collide(hull0, matrix0, hull1, matrix1, hullPenetration);
+		EXPECT_EQ(fastCount > 0, hullCount > 0);
+		EXPECT_GE(fastPenetration, hullPenetration - 1.0e-3f);
+		if (hullPenetration < 0.1f)
+		{
+			shallowPairs += hullCount ? 1 : 0;
+			EXPECT_NEAR(fastPenetration, hullPenetration, 2.0e-3f);
+		}
+
+		EXPECT_EQ(Collide(sphere, matrix0, box1, matrix1, fastPenetration), Collide(sphere, matrix0, hull1, matrix1, hullPenetration));
+		EXPECT_NEAR(fastPenetration, hullPenetration, 2.0e-3f);
+	}
+	EXPECT_GT(shallowPairs, 8);
+}
+
+/* Resting primitives produce the expected manifolds. */
+TEST(PrimitiveContacts, RestingManifolds)
+{
+	ndMatrix matrix0(ndGetIdentityMatrix());
+	ndMatrix matrix1(ndGetIdentityMatrix());
+	ndFloat32 penetration;
+
+	const ndShapeInstance sphere(new ndShapeSphere(0.5f));
+	matrix1.m_posit = ndVector(0.9f, 0.0f, 0.0f, 1.0f);
+	EXPECT_EQ(Collide(sphere, matrix0, sphere, matrix1, penetration), 1);
+	EXPECT_NEAR(penetration, 0.1f, 2.0e-3f);
+
+	const ndShapeInstance box(new ndShapeBox(4.0f, 1.0f, 4.0f));
+	const ndShapeInstance cube(new ndShapeBox(1.0f, 1.0f, 1.0f));
+	matrix1.m_posit = ndVector(0.0f, 0.99f, 0.0f, 1.0f);
+	EXPECT_EQ(Collide(box, matrix0, cube, matrix1, penetration), 4);
+	EXPECT_NEAR(penetration, 0.01f, 2.0e-3f);
+
+	matrix1.m_posit = ndVector(0.0f, 0.95f, 0.0f, 1.0f);
+	EXPECT_EQ(Collide(box, matrix0, sphere, matrix1, penetration), 1);
+	EXPECT_NEAR(penetration, 0.05f, 2.0e-3f);
+
+	const ndShapeInstance capsule(new ndShapeCapsule(0.25f, 0.25f, 1.0f));
+	matrix1.m_posit = ndVector(0.25f, 0.45f, 0.0f, 1.0f);
+	EXPECT_EQ(Collide(capsule, matrix0, capsule, matrix1, penetration), 2);
+	EXPECT_NEAR(penetration, 0.05f, 2.0e-3f);
+}
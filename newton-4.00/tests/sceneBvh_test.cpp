@@ -0,0 +1,461 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+static ndBodyDynamic* AddBox(ndWorld& world, ndFloat32 mass, const ndVector& posit)
+{
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit = posit;
+
+	ndShapeInstance box(new ndShapeBox(1.0f, 1.0f, 1.0f));
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetNotifyCallback(new ndBodyNotify(ndVector::m_zero));
+	body->SetMatrix(matrix);
+	body->SetCollisionShape(box);
+	if (mass > 0.0f)
+	{
+		body->SetMassMatrix(mass, box);
+		body->SetAutoSleep(false);
+	}
+	world.AddBody(ndSharedPtr<ndBody>(body));
+	return body;
+}
+
+/* Movers sweeping over a static field only patch the broad phase tree, and ray casts still find them. */
+TEST(SceneBvh, IncrementalRefit)
+{
+	ndWorld world;
+	world.SetSubSteps(1);
+	world.GetScene()->SetIncrementalBvhRefit(true);
+
+	for (ndInt32 i = 0; i < 40 * 40; ++i)
+	{
+		AddBox(world, 0.0f, ndVector(ndFloat32(i % 40) * 2.0f - 40.0f, 0.0f, ndFloat32(i / 40) * 2.0f - 40.0f, 1.0f));
+	}
+
+	ndFixSizeArray<ndBodyDynamic*, 64> movers;
+	for (ndInt32 i = 0; i < 64; ++i)
+	{
+		const ndFloat32 x = ndFloat32(i % 8) * 4.0f - 16.0f;
+		const ndFloat32 z = ndFloat32(i / 8) * 4.0f - 16.0f;
+		ndBodyDynamic* const body = AddBox(world, 1.0f, ndVector(x, 3.0f, z, 1.0f));
+		body->SetVelocity(ndVector((i & 1) ? 6.0f : -6.0f, 0.0f, (i & 2) ? 3.0f : -3.0f, 0.0f));
+		movers.PushBack(body);
+	}
+
+	for (ndInt32 i = 0; i < 240; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+	}
+	world.Sync();
+
+	ndInt32 fullRebuilds;
+	ndInt32 partialRebuilds;
+	world.GetScene()->GetBvhRebuildCount(fullRebuilds, partialRebuilds);
+	EXPECT_TRUE(partialRebuilds > 0);
+	// one build for the static tree, and one for the dynamics tree
+	EXPECT_EQ(fullRebuilds, 2);
+
+	for (ndInt32 i = 0; i < movers.GetCount(); ++i)
+	{
+		const ndVector posit(movers[i]->GetMatrix().m_posit);
+		EXPECT_NEAR(posit.m_y, 3.0f, 1.0e-3f);
+
+		ndRayCastClosestHitCallback rayCaster;
+		const ndVector start(posit + ndVector(0.0f, 5.0f, 0.0f, 0.0f));
+		const ndVector end(posit - ndVector(0.0f, 1.0f, 0.0f, 0.0f));
+		EXPECT_TRUE(world.RayCast(rayCaster, start, end));
+		EXPECT_EQ(rayCaster.m_contact.m_body0, movers[i]);
+	}
+}
+
+/* Bodies in the dynamics tree collide with and rest on bodies from the static tree. */
+TEST(SceneBvh, StaticTreeContacts)
+{
+	ndWorld world;
+	world.SetSubSteps(2);
+
+	for (ndInt32 i = 0; i < 16 * 16; ++i)
+	{
+		AddBox(world, 0.0f, ndVector(ndFloat32(i % 16) - 8.0f, 0.0f, ndFloat32(i / 16) - 8.0f, 1.0f));
+	}
+
+	ndFixSizeArray<ndBodyDynamic*, 16> boxes;
+	for (ndInt32 i = 0; i < 16; ++i)
+	{
+		const ndFloat32 x = ndFloat32(i % 4) * 3.0f - 6.0f;
+		const ndFloat32 z = ndFloat32(i / 4) * 3.0f - 6.0f;
+		ndBodyDynamic* const body = AddBox(world, 1.0f, ndVector(x, 2.0f, z, 1.0f));
+		body->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+		boxes.PushBack(body);
+	}
+
+	for (ndInt32 i = 0; i < 180; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+	}
+	world.Sync();
+
+	for (ndInt32 i = 0; i < boxes.GetCount(); ++i)
+	{
+		const ndVector posit(boxes[i]->GetMatrix().m_posit);
+		EXPECT_NEAR(posit.m_y, 1.0f, 5.0e-2f);
+
+		ndRayCastClosestHitCallback rayCaster;
+		const ndVector start(posit + ndVector(0.25f, 5.0f, 0.25f, 0.0f));
+		const ndVector end(posit + ndVector(0.25f, -5.0f, 0.25f, 0.0f));
+		EXPECT_TRUE(world.RayCast(rayCaster, start, end));
+		EXPECT_EQ(rayCaster.m_contact.m_body0, boxes[i]);
+	}
+
+	// a ray that misses all the dynamics bodies hits the static field
+	ndRayCastClosestHitCallback rayCaster;
+	EXPECT_TRUE(world.RayCast(rayCaster, ndVector(-8.0f, 5.0f, 7.0f, 1.0f), ndVector(-8.0f, -5.0f, 7.0f, 1.0f)));
+	ndAssert(rayCaster.m_contact.m_body0);
+	EXPECT_EQ(rayCaster.m_contact.m_body0->GetInvMass(), 0.0f);
+}
+
+/* Bodies that fall asleep join the static tree, and a kinematic body leaves it while the application drives it. */
+TEST(SceneBvh, StaticTreeMigration)
+{
+	ndWorld world;
+	world.SetSubSteps(2);
+
+	for (ndInt32 i = 0; i < 8 * 8; ++i)
+	{
+		AddBox(world, 0.0f, ndVector(ndFloat32(i % 8) - 4.0f, 0.0f, ndFloat32(i / 8) - 4.0f, 1.0f));
+	}
+	ndBodyDynamic* const kinematic = AddBox(world, 0.0f, ndVector(-4.0f, 2.0f, -4.0f, 1.0f));
+
+	for (ndInt32 i = 0; i < 4; ++i)
+	{
+		ndBodyDynamic* const body = AddBox(world, 1.0f, ndVector(ndFloat32(i) * 2.0f - 3.0f, 1.0f, 2.0f, 1.0f));
+		body->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+		body->SetAutoSleep(true);
+	}
+
+	ndScene* const scene = world.GetScene();
+	EXPECT_EQ(scene->GetStaticTreeBodyCount(), 8 * 8 + 1);
+
+	for (ndInt32 i = 0; i < 3 * D_SCENE_TREE_MIGRATION_PERIOD; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+	}
+	world.Sync();
+	EXPECT_EQ(scene->GetStaticTreeBodyCount(), 8 * 8 + 1 + 4);
+
+	// the application drives the kinematic body across the field
+	const ndVector veloc(3.0f, 0.0f, 0.0f, 0.0f);
+	for (ndInt32 i = 0; i < 2 * D_SCENE_TREE_MIGRATION_PERIOD; ++i)
+	{
+		ndMatrix matrix(kinematic->GetMatrix());
+		matrix.m_posit += veloc.Scale(1.0f / 60.0f);
+		kinematic->SetMatrix(matrix);
+		kinematic->SetVelocity(veloc);
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+	}
+	EXPECT_EQ(scene->GetStaticTreeBodyCount(), 8 * 8 + 4);
+
+	const ndVector posit(kinematic->GetMatrix().m_posit);
+	ndRayCastClosestHitCallback rayCaster;
+	EXPECT_TRUE(world.RayCast(rayCaster, posit + ndVector(0.0f, 5.0f, 0.0f, 0.0f), posit));
+	EXPECT_EQ(rayCaster.m_contact.m_body0, kinematic);
+
+	// once stopped it goes back to the static tree
+	kinematic->SetVelocity(ndVector::m_zero);
+	for (ndInt32 i = 0; i < 2 * D_SCENE_TREE_MIGRATION_PERIOD; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+	}
+	world.Sync();
+	EXPECT_EQ(scene->GetStaticTreeBodyCount(), 8 * 8 + 1 + 4);
+}
+
+/* Bodies moving in and out of the static tree patch both trees in place, the static tree is only built once. */
+TEST(SceneBvh, StaticTreeMigrationInPlace)
+{
+	ndWorld world;
+	world.SetSubSteps(2);
+	world.GetScene()->SetIncrementalBvhRefit(true);
+
+	for (ndInt32 i = 0; i < 8 * 8; ++i)
+	{
+		AddBox(world, 0.0f, ndVector(ndFloat32(i % 8) - 4.0f, 0.0f, ndFloat32(i / 8) - 4.0f, 1.0f));
+	}
+
+	ndFixSizeArray<ndBodyDynamic*, 4> boxes;
+	for (ndInt32 i = 0; i < 4; ++i)
+	{
+		ndBodyDynamic* const body = AddBox(world, 1.0f, ndVector(ndFloat32(i) * 2.0f - 3.0f, 1.0f, 2.0f, 1.0f));
+		body->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+		body->SetAutoSleep(true);
+		boxes.PushBack(body);
+	}
+
+	ndScene* const scene = world.GetScene();
+	ndInt32 staticFullRebuilds;
+	ndInt32 staticPartialRebuilds;
+
+	// the boxes fall asleep and join the static tree
+	for (ndInt32 i = 0; i < 3 * D_SCENE_TREE_MIGRATION_PERIOD; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+	}
+	world.Sync();
+	EXPECT_EQ(scene->GetStaticTreeBodyCount(), 8 * 8 + 4);
+	scene->GetStaticBvhRebuildCount(staticFullRebuilds, staticPartialRebuilds);
+	EXPECT_EQ(staticFullRebuilds, 1);
+
+	// one wakes up and goes back to the dynamics tree
+	boxes[0]->SetVelocity(ndVector(0.0f, 8.0f, 0.0f, 0.0f));
+	for (ndInt32 i = 0; i < D_SCENE_TREE_MIGRATION_PERIOD; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+	}
+	world.Sync();
+	EXPECT_EQ(scene->GetStaticTreeBodyCount(), 8 * 8 + 3);
+	scene->GetStaticBvhRebuildCount(staticFullRebuilds, staticPartialRebuilds);
+	EXPECT_EQ(staticFullRebuilds, 1);
+
+	for (ndInt32 i = 0; i < boxes.GetCount(); ++i)
+	{
+		const ndVector posit(boxes[i]->GetMatrix().m_posit);
+		ndRayCastClosestHitCallback rayCaster;
+		EXPECT_TRUE(world.RayCast(rayCaster, posit + ndVector(0.0f, 5.0f, 0.0f, 0.0f), posit));
+		EXPECT_EQ(rayCaster.m_contact.m_body0, boxes[i]);
+	}
+}
+
+/* Aabb queries and ray casts on the wide trees agree with testing every body one by one. */
+TEST(SceneBvh, WideTreeQueries)
+{
+	ndWorld world;
+	ndSetRandSeed(17);
+
+	ndFixSizeArray<ndBodyDynamic*, 512> bodies;
+	for (ndInt32 i = 0; i < 400; ++i)
+	{
+		const ndVector posit(ndRand() * 40.0f - 20.0f, 0.0f, ndRand() * 40.0f - 20.0f, 1.0f);
+		bodies.PushBack(AddBox(world, 0.0f, posit));
+	}
+	for (ndInt32 i = 0; i < 100; ++i)
+	{
+		const ndVector posit(ndRand() * 40.0f - 20.0f, ndRand() * 10.0f + 1.0f, ndRand() * 40.0f - 20.0f, 1.0f);
+		bodies.PushBack(AddBox(world, 1.0f, posit));
+	}
+	world.Update(1.0f / 60.0f);
+	world.Sync();
+
+	// bodies added after the update are found right away
+	bodies.PushBack(AddBox(world, 1.0f, ndVector(0.0f, 30.0f, 0.0f, 1.0f)));
+
+	for (ndInt32 i = 0; i < 64; ++i)
+	{
+		const ndVector center(ndRand() * 40.0f - 20.0f, ndRand() * 32.0f, ndRand() * 40.0f - 20.0f, 0.0f);
+		const ndVector size(ndVector(ndRand() * 8.0f + 1.0f) & ndVector::m_triplexMask);
+		const ndVector minBox(center - size);
+		const ndVector maxBox(center + size);
+
+		ndBodiesInAabbNotify notify;
+		world.GetScene()->BodiesInAabb(notify, minBox, maxBox);
+
+		ndInt32 count = 0;
+		for (ndInt32 j = 0; j < bodies.GetCount(); ++j)
+		{
+			ndVector p0;
+			ndVector p1;
+			bodies[j]->GetCollisionShape().CalculateAabb(bodies[j]->GetMatrix(), p0, p1);
+			count += ndOverlapTest(p0, p1, minBox, maxBox) ? 1 : 0;
+		}
+		EXPECT_EQ(ndInt32(notify.m_bodyArray.GetCount()), count);
+
+		const ndVector p0(center + ndVector(0.0f, 40.0f, 0.0f, 0.0f));
+		const ndVector p1(center - size);
+		ndRayCastClosestHitCallback sceneCaster;
+		const bool hit = world.RayCast(sceneCaster, p0, p1);
+
+		ndRayCastClosestHitCallback bodyCaster;
+		bodyCaster.m_param = ndFloat32(1.2f);
+		const ndFastRay ray(p0 & ndVector::m_triplexMask, p1 & ndVector::m_triplexMask);
+		for (ndInt32 j = 0; j < bodies.GetCount(); ++j)
+		{
+			bodies[j]->RayCast(bodyCaster, ray, bodyCaster.m_param);
+		}
+		EXPECT_EQ(hit, bodyCaster.m_param < ndFloat32(1.0f));
+		if (hit)
+		{
+			EXPECT_EQ(sceneCaster.m_contact.m_body0, bodyCaster.m_contact.m_body0);
+		}
+	}
+}
+
+class RayCastMaskFilter : public ndRayCastClosestHitCallback
+{
+	public:
+	RayCastMaskFilter(ndUnsigned64 mask)
+		:ndRayCastClosestHitCallback()
+		,m_mask(mask)
+	{
+	}
+
+	ndUnsigned32 OnRayPrecastAction(const ndBody* const, const ndShapeInstance* const shape) override
+	{
+		const ndUnsigned64 userId = ndUnsigned64(shape->m_shapeMaterial.m_userId);
+		return (!userId || (userId & m_mask)) ? 1 : 0;
+	}
+
+	ndUnsigned64 m_mask;
+};
+
+/* Batched ray casts return the same closest hits as single ray casts with the same material filter. */
+TEST(SceneBvh, RayCastBatch)
+{
+	ndWorld world;
+	world.SetThreadCount(2);
+	ndSetRandSeed(23);
+
+	for (ndInt32 i = 0; i < 400; ++i)
+	{
+		const ndVector posit(ndRand() * 40.0f - 20.0f, 0.0f, ndRand() * 40.0f - 20.0f, 1.0f);
+		ndBodyDynamic* const body = AddBox(world, 0.0f, posit);
+		body->GetCollisionShape().m_shapeMaterial.m_userId = (i & 1) ? 2 : 0;
+	}
+	for (ndInt32 i = 0; i < 100; ++i)
+	{
+		const ndVector posit(ndRand() * 40.0f - 20.0f, ndRand() * 10.0f + 1.0f, ndRand() * 40.0f - 20.0f, 1.0f);
+		AddBox(world, 1.0f, posit);
+	}
+	world.Update(1.0f / 60.0f);
+	world.Sync();
+
+	const ndInt32 rayCount = 2000;
+	ndArray<ndVector> origins;
+	ndArray<ndVector> dests;
+	ndArray<ndUnsigned64> masks;
+	ndArray<ndRayCastHit> hits;
+	for (ndInt32 i = 0; i < rayCount; ++i)
+	{
+		origins.PushBack(ndVector(ndRand() * 50.0f - 25.0f, ndRand() * 20.0f + 0.25f, ndRand() * 50.0f - 25.0f, 1.0f));
+		dests.PushBack(ndVector(ndRand() * 50.0f - 25.0f, ndRand() * 4.0f - 3.0f, ndRand() * 50.0f - 25.0f, 1.0f));
+		masks.PushBack((i & 1) ? ndUnsigned64(1) : ndUnsigned64(-1));
+	}
+	hits.SetCount(rayCount);
+	world.RayCastBatch(&origins[0], &dests[0], &masks[0], rayCount, &hits[0]);
+
+	ndInt32 hitCount = 0;
+	for (ndInt32 i = 0; i < rayCount; ++i)
+	{
+		RayCastMaskFilter caster(masks[i]);
+		const bool hit = world.RayCast(caster, origins[i], dests[i]) && (caster.m_param < ndFloat32(1.0f));
+		EXPECT_EQ(hit, hits[i].m_body != nullptr);
+		if (hit && hits[i].m_body)
+		{
+			EXPECT_EQ(caster.m_contact.m_body0, hits[i].m_body);
+			EXPECT_NEAR(caster.m_param, hits[i].m_param, 1.0e-5f);
+			hitCount++;
+		}
+	}
+	EXPECT_GT(hitCount, rayCount / 4);
+}
+
+class ConvexCastClosest : public ndConvexCastNotify
+{
+	public:
+	ndUnsigned32 OnRayPrecastAction(const ndBody* const, const ndShapeInstance* const) override
+	{
+		return 1;
+	}
+};
+
+/* Batched overlaps and convex casts return the same bodies as the single queries, packed in query order. */
+TEST(SceneBvh, OverlapAndConvexCastBatch)
+{
+	ndWorld world;
+	world.SetThreadCount(2);
+	ndSetRandSeed(29);
+
+	for (ndInt32 i = 0; i < 300; ++i)
+	{
+		const ndVector posit(ndRand() * 40.0f - 20.0f, 0.0f, ndRand() * 40.0f - 20.0f, 1.0f);
+		AddBox(world, 0.0f, posit);
+	}
+	for (ndInt32 i = 0; i < 100; ++i)
+	{
+		const ndVector posit(ndRand() * 40.0f - 20.0f, ndRand() * 10.0f + 1.0f, ndRand() * 40.0f - 20.0f, 1.0f);
+		AddBox(world, 1.0f, posit);
+	}
+	world.Update(1.0f / 60.0f);
+	world.Sync();
+
+	const ndInt32 queryCount = 300;
+	ndArray<ndVector> minBoxes;
+	ndArray<ndVector> maxBoxes;
+	for (ndInt32 i = 0; i < queryCount; ++i)
+	{
+		const ndVector center(ndRand() * 40.0f - 20.0f, ndRand() * 12.0f, ndRand() * 40.0f - 20.0f, 0.0f);
+		const ndVector size(ndVector(ndRand() * 4.0f + 0.5f) & ndVector::m_triplexMask);
+		minBoxes.PushBack(center - size);
+		maxBoxes.PushBack(center + size);
+	}
+
+	ndArray<const ndBody*> bodies;
+	ndArray<ndInt32> bodyStart;
+	bodyStart.SetCount(queryCount + 1);
+	world.OverlapBatch(&minBoxes[0], &maxBoxes[0], queryCount, bodies, &bodyStart[0]);
+	EXPECT_EQ(ndInt32(bodies.GetCount()), bodyStart[queryCount]);
+
+	for (ndInt32 i = 0; i < queryCount; ++i)
+	{
+		ndBodiesInAabbNotify notify;
+		world.BodiesInAabb(notify, minBoxes[i], maxBoxes[i]);
+		ASSERT_EQ(ndInt32(notify.m_bodyArray.GetCount()), bodyStart[i + 1] - bodyStart[i]);
+		for (ndInt32 j = 0; j < notify.m_bodyArray.GetCount(); ++j)
+		{
+			EXPECT_EQ(notify.m_bodyArray[j], bodies[bodyStart[i] + j]);
+		}
+	}
+
+	ndShapeInstance sphere(new ndShapeSphere(0.4f));
+	ndShapeInstance box(new ndShapeBox(0.5f, 0.8f, 0.5f));
+	ndArray<const ndShapeInstance*> shapes;
+	ndArray<ndMatrix> origins;
+	ndArray<ndVector> dests;
+	ndArray<ndConvexCastHit> hits;
+	for (ndInt32 i = 0; i < queryCount; ++i)
+	{
+		ndMatrix matrix(ndGetIdentityMatrix());
+		matrix.m_posit = ndVector(ndRand() * 40.0f - 20.0f, 14.0f, ndRand() * 40.0f - 20.0f, 1.0f);
+		shapes.PushBack((i & 1) ? &sphere : &box);
+		origins.PushBack(matrix);
+		dests.PushBack(matrix.m_posit - ndVector(ndRand() * 4.0f - 2.0f, 16.0f, ndRand() * 4.0f - 2.0f, 0.0f));
+	}
+	hits.SetCount(queryCount);
+	world.ConvexCastBatch(&shapes[0], &origins[0], &dests[0], queryCount, &hits[0]);
+
+	ndInt32 hitCount = 0;
+	for (ndInt32 i = 0; i < queryCount; ++i)
+	{
+		ConvexCastClosest caster;
+		const bool hit = world.ConvexCast(caster, *shapes[i], origins[i], dests[i]) && (caster.m_param < ndFloat32(1.0f));
+		EXPECT_EQ(hit, hits[i].m_body != nullptr);
+		if (hit && hits[i].m_body)
+		{
+			EXPECT_EQ(caster.m_contacts[0].m_body1, hits[i].m_body);
+			EXPECT_NEAR(caster.m_param, hits[i].m_param, 1.0e-5f);
+			hitCount++;
+		}
+	}
+	EXPECT_GT(hitCount, queryCount / 4);
+}
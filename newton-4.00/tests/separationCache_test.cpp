@@ -0,0 +1,125 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+class ndSeparationCacheNotify : public ndContactNotify
+{
+	public:
+	ndSeparationCacheNotify()
+		:ndContactNotify(nullptr)
+	{
+		m_material.m_flags = m_material.m_flags | m_disableSeparationCache;
+	}
+
+	ndMaterial* GetMaterial(const ndContact* const, const ndShapeInstance&, const ndShapeInstance&) const
+	{
+		return (ndMaterial*)&m_material;
+	}
+
+	ndMaterial m_material;
+};
+
+static ndBodyDynamic* BuildSlidingSphere(ndWorld& world)
+{
+	ndShapeInstance floorShape(new ndShapeBox(ndFloat32(100.0f), ndFloat32(1.0f), ndFloat32(10.0f)));
+	ndBodyKinematic* const floor = new ndBodyDynamic();
+	floor->SetCollisionShape(floorShape);
+	world.AddBody(ndSharedPtr<ndBody>(floor));
+
+	// a sphere sliding just above the floor, the pair overlaps in the broad phase but never touches
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit.m_x = ndFloat32(-20.0f);
+	matrix.m_posit.m_y = ndFloat32(1.1f);
+
+	ndShapeInstance shape(new ndShapeSphere(ndFloat32(0.5f)));
+	ndBodyDynamic* const sphere = new ndBodyDynamic();
+	sphere->SetNotifyCallback(new ndBodyNotify(ndBigVector(ndFloat32(0.0f))));
+	sphere->SetCollisionShape(shape);
+	sphere->SetMatrix(matrix);
+	sphere->SetMassMatrix(ndFloat32(1.0f), shape);
+	sphere->SetAutoSleep(false);
+	sphere->SetVelocity(ndVector(ndFloat32(1.0f), ndFloat32(0.0f), ndFloat32(0.0f), ndFloat32(0.0f)));
+	world.AddBody(ndSharedPtr<ndBody>(sphere));
+	return sphere;
+}
+
+static bool HasActiveContact(ndBodyDynamic* const body)
+{
+	ndBodyKinematic::ndContactMap::Iterator it(body->GetContactMap());
+	for (it.Begin(); it; it++)
+	{
+		if ((*it)->IsActive())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Separated convex pairs skip the narrow phase until their motion could close the gap. */
+TEST(SeparationCache, SkipsSeparatedPairs)
+{
+	ndWorld world;
+	world.SetSubSteps(1);
+	ndBodyDynamic* const sphere = BuildSlidingSphere(world);
+
+	ndInt32 skipped = 0;
+	ndInt32 narrowPhase = 0;
+	const ndUpdateStatistics& statistics = world.GetUpdateStatistics();
+	for (ndInt32 i = 0; i < 120; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+		skipped += statistics.GetFrame(0).m_skippedPairCount;
+		narrowPhase += statistics.GetFrame(0).m_narrowPhaseCount;
+		EXPECT_FALSE(HasActiveContact(sphere));
+	}
+	EXPECT_TRUE(skipped > narrowPhase);
+	EXPECT_TRUE(narrowPhase > 0);
+	EXPECT_NEAR(sphere->GetMatrix().m_posit.m_y, ndFloat32(1.1f), ndFloat32(1.0e-3f));
+
+	// placing the body by hand right after the narrow phase cached a separation invalidates it
+	do
+	{
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+	} while (!statistics.GetFrame(0).m_narrowPhaseCount);
+
+	ndMatrix matrix(sphere->GetMatrix());
+	matrix.m_posit.m_y = ndFloat32(0.98f);
+	sphere->SetMatrix(matrix);
+	world.Update(1.0f / 60.0f);
+	world.Sync();
+	EXPECT_TRUE(HasActiveContact(sphere));
+}
+
+/* The cache can be disabled per material. */
+TEST(SeparationCache, DisabledByMaterial)
+{
+	ndWorld world;
+	world.SetSubSteps(1);
+	world.SetContactNotify(new ndSeparationCacheNotify);
+	BuildSlidingSphere(world);
+
+	ndInt32 narrowPhase = 0;
+	const ndUpdateStatistics& statistics = world.GetUpdateStatistics();
+	for (ndInt32 i = 0; i < 120; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+		EXPECT_EQ(statistics.GetFrame(0).m_skippedPairCount, 0);
+		narrowPhase += statistics.GetFrame(0).m_narrowPhaseCount;
+	}
+	EXPECT_TRUE(narrowPhase > 0);
+}
@@ -0,0 +1,87 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+/* ParallelFor must visit every index exactly once, including nested calls. */
+TEST(ThreadPool, ParallelForVisitsAllItems)
+{
+	ndWorld world;
+	world.SetThreadCount(4);
+	ndScene* const scene = world.GetScene();
+
+	const ndInt32 itemsCount = 10000;
+	ndArray<ndInt32> visits;
+	visits.SetCount(itemsCount);
+	for (ndInt32 i = 0; i < itemsCount; ++i)
+	{
+		visits[i] = 0;
+	}
+
+	ndAtomic<ndInt32> nestedCount(0);
+	scene->Begin();
+	scene->ParallelFor(0, itemsCount, 7, [&visits, &nestedCount, scene](ndInt32 threadIndex, ndInt32 i)
+	{
+		EXPECT_TRUE(threadIndex >= 0);
+		EXPECT_TRUE(threadIndex < scene->GetThreadCount());
+		visits[i] = visits[i] + 1;
+		if (i % 1000 == 0)
+		{
+			scene->ParallelFor(0, 10, 1, [&nestedCount, threadIndex](ndInt32 nestedThreadIndex, ndInt32)
+			{
+				EXPECT_EQ(nestedThreadIndex, threadIndex);
+				nestedCount.fetch_add(1);
+			});
+		}
+	});
+	scene->End();
+
+	for (ndInt32 i = 0; i < itemsCount; ++i)
+	{
+		EXPECT_EQ(visits[i], 1);
+	}
+	EXPECT_EQ(nestedCount.load(), 100);
+}
+
+/* A job of one pool that calls into another pool is not a nested call of the second pool. */
+TEST(ThreadPool, ParallelForFromAnotherPool)
+{
+	ndWorld world0;
+	ndWorld world1;
+	world0.SetThreadCount(2);
+	world1.SetThreadCount(2);
+	ndScene* const scene0 = world0.GetScene();
+	ndScene* const scene1 = world1.GetScene();
+
+	ndAtomic<ndInt32> visitsCount(0);
+	scene0->Begin();
+	scene1->Begin();
+	scene0->ParallelFor(0, 4, 1, [&visitsCount, scene0, scene1](ndInt32, ndInt32 i)
+	{
+		EXPECT_EQ(ndThreadPool::GetCurrentThreadPool(), scene0);
+		if (i)
+		{
+			return;
+		}
+		scene1->ParallelFor(0, 16, 1, [&visitsCount, scene1](ndInt32 threadIndex, ndInt32)
+		{
+			EXPECT_EQ(ndThreadPool::GetCurrentThreadPool(), scene1);
+			EXPECT_EQ(ndThreadPool::GetCurrentThreadIndex(), threadIndex);
+			visitsCount.fetch_add(1);
+		});
+		EXPECT_EQ(ndThreadPool::GetCurrentThreadPool(), scene0);
+	});
+	scene1->End();
+	scene0->End();
+	EXPECT_EQ(visitsCount.load(), 16);
+	EXPECT_EQ(ndThreadPool::GetCurrentThreadPool(), (ndThreadPool*)nullptr);
+}
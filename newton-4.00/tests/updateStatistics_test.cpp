@@ -0,0 +1,70 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+/* Every update records one statistics frame with its phase times and counters. */
+TEST(UpdateStatistics, RecordsFrames)
+{
+	ndWorld world;
+	world.SetThreadCount(2);
+	world.SetSubSteps(2);
+
+	ndShapeInstance boxShape(new ndShapeBox(ndFloat32(10.0f), ndFloat32(1.0f), ndFloat32(10.0f)));
+	ndBodyKinematic* const floor = new ndBodyDynamic();
+	floor->SetCollisionShape(boxShape);
+	world.AddBody(ndSharedPtr<ndBody>(floor));
+
+	ndShapeInstance shape(new ndShapeSphere(ndFloat32(0.5f)));
+	for (ndInt32 i = 0; i < 4; ++i)
+	{
+		ndMatrix matrix(ndGetIdentityMatrix());
+		matrix.m_posit.m_x = ndFloat32(i * 2 - 3);
+		matrix.m_posit.m_y = ndFloat32(1.0f);
+
+		ndBodyDynamic* const body = new ndBodyDynamic();
+		body->SetNotifyCallback(new ndBodyNotify(ndBigVector(ndFloat32(0.0f), ndFloat32(-10.0f), ndFloat32(0.0f), ndFloat32(0.0f))));
+		body->SetCollisionShape(shape);
+		body->SetMatrix(matrix);
+		body->SetMassMatrix(ndFloat32(1.0f), shape);
+		world.AddBody(ndSharedPtr<ndBody>(body));
+	}
+
+	const ndUpdateStatistics& statistics = world.GetUpdateStatistics();
+	EXPECT_EQ(statistics.GetFrameCount(), 0);
+
+	const ndInt32 frames = D_UPDATE_STATISTICS_FRAMES + 10;
+	for (ndInt32 i = 0; i < frames; ++i)
+	{
+		world.Update(1.0f / 60.0f);
+		world.Sync();
+	}
+
+	EXPECT_EQ(statistics.GetFrameCount(), D_UPDATE_STATISTICS_FRAMES);
+	const ndUpdateStatistics::ndFrame& last = statistics.GetFrame(0);
+	const ndUpdateStatistics::ndFrame& previous = statistics.GetFrame(1);
+	EXPECT_EQ(last.m_frameNumber, previous.m_frameNumber + 1);
+	EXPECT_EQ(last.m_subSteps, 2);
+	EXPECT_EQ(last.m_threadCount, world.GetThreadCount());
+	EXPECT_EQ(last.m_contactCount, 4);
+	EXPECT_TRUE(last.m_bodyCount >= 4);
+	EXPECT_TRUE(last.m_solverPasses > 0);
+
+	ndUnsigned32 phaseTime = 0;
+	for (ndInt32 i = 0; i < ndUpdateStatistics::m_phaseCount; ++i)
+	{
+		phaseTime += last.m_phaseTime[i];
+		EXPECT_TRUE(strlen(ndUpdateStatistics::GetPhaseName(ndUpdateStatistics::ndPhase(i))) > 0);
+	}
+	EXPECT_TRUE(phaseTime <= last.m_totalTime);
+	EXPECT_TRUE(last.m_maxThreadBusyTime <= last.m_threadsBusyTime);
+}
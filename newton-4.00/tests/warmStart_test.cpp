@@ -0,0 +1,67 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+static ndBodyDynamic* BuildStack(ndWorld& world, ndInt32 height)
+{
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit.m_y = -0.5f;
+	ndShapeInstance floor(new ndShapeBox(20.0f, 1.0f, 20.0f));
+	ndBodyDynamic* const ground = new ndBodyDynamic();
+	ground->SetMatrix(matrix);
+	ground->SetCollisionShape(floor);
+	world.AddBody(ndSharedPtr<ndBody>(ground));
+
+	ndBodyDynamic* top = nullptr;
+	ndShapeInstance box(new ndShapeBox(1.0f, 1.0f, 1.0f));
+	for (ndInt32 i = 0; i < height; ++i)
+	{
+		matrix.m_posit.m_y = 0.5f + ndFloat32(i);
+		ndBodyDynamic* const body = new ndBodyDynamic();
+		body->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+		body->SetMatrix(matrix);
+		body->SetCollisionShape(box);
+		body->SetMassMatrix(1.0f, box);
+		body->SetAutoSleep(false);
+		world.AddBody(ndSharedPtr<ndBody>(body));
+		top = body;
+	}
+	return top;
+}
+
+/* Warm started contacts hold a tall stack at the minimum solver iterations. */
+TEST(WarmStart, TallStack)
+{
+	const ndWorld::ndSolverModes solvers[] = { ndWorld::ndStandardSolver, ndWorld::ndSimdSoaSolver };
+	for (ndInt32 i = 0; i < ndInt32(sizeof(solvers) / sizeof(solvers[0])); ++i)
+	{
+		ndWorld world;
+		world.SetSubSteps(1);
+		world.SetSolverIterations(4);
+		world.SelectSolver(solvers[i]);
+
+		const ndInt32 height = 20;
+		ndBodyDynamic* const top = BuildStack(world, height);
+		for (ndInt32 j = 0; j < 300; ++j)
+		{
+			world.Update(1.0f / 60.0f);
+		}
+		world.Sync();
+
+		const ndVector posit(top->GetMatrix().m_posit);
+		EXPECT_NEAR(posit.m_y, ndFloat32(height) - 0.5f, 0.1f);
+		EXPECT_LT(ndAbs(posit.m_x), 0.5f);
+		EXPECT_LT(ndAbs(posit.m_z), 0.5f);
+	}
+}
@@ -0,0 +1,66 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely
+ */
+
+#include "ndNewton.h"
+#include <gtest/gtest.h>
+
+static ndBodyDynamic* AddFallingSphere(ndWorld& world)
+{
+	ndShapeInstance shape(new ndShapeSphere(ndFloat32(0.5f)));
+	ndMatrix matrix(ndGetIdentityMatrix());
+	matrix.m_posit.m_y = ndFloat32(10.0f);
+
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetNotifyCallback(new ndBodyNotify(ndBigVector(ndFloat32(0.0f), ndFloat32(-10.0f), ndFloat32(0.0f), ndFloat32(0.0f))));
+	body->SetCollisionShape(shape);
+	body->SetMatrix(matrix);
+	body->SetMassMatrix(ndFloat32(1.0f), shape);
+	ndSharedPtr<ndBody> bodyPtr(body);
+	world.AddBody(bodyPtr);
+	return body;
+}
+
+/* Worlds attached to a shared scheduler must advance exactly as a world updated on its own. */
+TEST(WorldScheduler, UpdatesAllWorlds)
+{
+	const ndInt32 worldCount = 8;
+	ndWorld reference;
+	ndBodyDynamic* const referenceBody = AddFallingSphere(reference);
+
+	ndWorldScheduler scheduler;
+	ndWorld* worlds[worldCount];
+	ndBodyDynamic* bodies[worldCount];
+	for (ndInt32 i = 0; i < worldCount; ++i)
+	{
+		worlds[i] = new ndWorld();
+		bodies[i] = AddFallingSphere(*worlds[i]);
+		scheduler.AddWorld(worlds[i], i & 1);
+	}
+	EXPECT_EQ(scheduler.GetWorldCount(), worldCount);
+
+	for (ndInt32 i = 0; i < 30; ++i)
+	{
+		reference.Update(1.0f / 60.0f);
+		reference.Sync();
+		scheduler.Update(1.0f / 60.0f);
+		scheduler.Sync();
+	}
+
+	const ndFloat32 referenceHeight = referenceBody->GetMatrix().m_posit.m_y;
+	EXPECT_TRUE(referenceHeight < ndFloat32(9.0f));
+	for (ndInt32 i = 0; i < worldCount; ++i)
+	{
+		EXPECT_EQ(bodies[i]->GetMatrix().m_posit.m_y, referenceHeight);
+		scheduler.RemoveWorld(worlds[i]);
+		delete worlds[i];
+	}
+	EXPECT_EQ(scheduler.GetWorldCount(), 0);
+}